@@ -1,23 +1,1595 @@
+#define _GNU_SOURCE
+
+#define LOG_PREFIX "tetrapol_dump"
 #include <tetrapol/tetrapol.h>
-// TODO: should use only tetrapol.h, but hi-level interface not implemented yet
+#include <tetrapol/cell_cache.h>
+#include <tetrapol/channelizer.h>
+#include <tetrapol/combiner.h>
+#include <tetrapol/demod.h>
+#include <tetrapol/event_ring.h>
+#include <tetrapol/ingest.h>
+// phys_ch_t is used directly, tpol_t does not support zero-copy input
 #include <tetrapol/phys_ch.h>
+#include <tetrapol/log.h>
+#include <tetrapol/misc.h>
+#include <tetrapol/net_index.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <netdb.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_INPUTS 256
+#define NWORKERS_DEFAULT 4
+#define STATS_INTERVAL_DEFAULT 10
+// complex samples read at once in baseband input mode
+#define IQ_BUF_SAMPLES 4096
+// wideband mode, channel spacing and filter of tetrapol_rx.py (Hz)
+#define WB_CH_SPACING 12500
+#define WB_CH_CUTOFF 4650
+#define WB_CH_TRANSITION 697.5
+// wideband mode, samples per channel in one block (20 ms) and queue length
+#define WB_BLOCK_OUT 320
+#define WB_NBLOCKS 8
+// scan mode, traffic channel is detected by majority of voice frames
+#define SCAN_VOICE_FRAMES 50
+// scan mode, min. number of valid frames for channel with signal
+#define SCAN_MIN_FRAMES 10
+
+// parallel replay, signal time of chunk overlap, min. chunk length
+// and number of chunks per thread (for load balancing)
+#define PAR_OVERLAP_SEC 30
+#define PAR_CHUNK_MIN_SEC 300
+#define PAR_CHUNKS_PER_WORKER 4
+
+// combined receivers, frames read from each input at once
+#define COMBINE_CHUNK_FRAMES 10
+
+// size of shared memory event ring
+#define EVENT_RING_SIZE (1 << 22)
+
+// datagrams received by single recvmmsg() call
+#define UDP_BATCH 64
+
+// TETRAPOL frame has 160 bits and lasts 20 ms
+#define FRAME_BITS 160
+#define FRAMES_PER_SEC 50
+
+// interval of feedback datagrams (ms) of single channel
+#define FEEDBACK_INTERVAL_MS 100
+// fraction of measured frequency offset corrected by each AFC step
+#define AFC_GAIN 0.5f
+// AFC is frozen while frames are mostly damaged, estimate is unreliable
+#define AFC_MAX_CRC_ERRS 0.5f
+
+// set on SIGINT
+volatile static int do_exit = 0;
+
+// interval of statistics reports (s), 0 disables reports
+static int stats_interval = 0;
+// path of Prometheus text file with statistics, NULL for stats line only
+static const char *stats_path = NULL;
+// scan mode, max. signal time (s) for channel identification, 0 disables scan
+static int scan_timeout = 0;
+// subscribed TSDU codops, used when codops_set
+static tsdu_filter_t codops;
+static bool codops_set = false;
+// warm start cache, entries are created by main thread only
+static cell_cache_t *cell_cache = NULL;
+static const char *cell_cache_path = NULL;
+// shared memory fan-out of events, single input only (single producer)
+static event_ring_t *event_ring = NULL;
+// index of network configuration, single input only
+static net_index_t *net_index = NULL;
+static const char *net_index_path = NULL;
+// decoding of repeated BCH/PCH/RCH messages is skipped
+static bool dup_suppress = false;
+// notification is printed for each skipped message
+static bool dup_notify = false;
+// connected UDP socket for feedback datagrams, -1 disables feedback
+static int feedback_fd = -1;
+// frequency offset measured by demodulator is corrected (IQ input only)
+static bool afc = false;
+
+/// State of feedback reports of single channel.
+typedef struct {
+    uint16_t ch_id;
+    uint32_t seq;
+    int64_t next;       ///< time of next report (CLOCK_MONOTONIC, ns)
+} feedback_t;
+
+enum {
+    SCAN_PENDING = 0,
+    SCAN_CONTROL,
+    SCAN_TRAFFIC,
+    SCAN_NO_SIGNAL,
+    SCAN_TIMEOUT,
+};
+
+static const char *scan_verdicts[] = {
+    [SCAN_PENDING] = "pending",
+    [SCAN_CONTROL] = "control",
+    [SCAN_TRAFFIC] = "traffic",
+    [SCAN_NO_SIGNAL] = "no_signal",
+    [SCAN_TIMEOUT] = "timeout",
+};
+
+
+static void sigint_handler(int sig)
+{
+    do_exit = 1;
+}
+
+/**
+  Output of voice frames from traffic channel, each frame is written
+  immediately to keep the latency low.
+
+  @param ptr Event writer or NULL for text output.
+  */
+static void voice_sink(const voice_frame_t *vf, void *ptr)
+{
+    event_writer_t *ew = ptr;
+
+    if (event_ring && event_ring_write_voice(event_ring, vf->timestamp,
+                vf->frame_no, vf->crc_ok, vf->data)) {
+        fprintf(stderr, "Failed to publish voice frame\n");
+    }
+
+    if (!ew) {
+        log_printf("VOICE time=%" PRId64 " frame_no=%d crc=%d "
+                "data=%016" PRIx64 "%016" PRIx64 "\n", vf->timestamp,
+                vf->frame_no, vf->crc_ok, vf->data[0], vf->data[1]);
+        return;
+    }
+
+    if (event_write_voice(ew, vf->timestamp, vf->frame_no, vf->crc_ok,
+                vf->data) || event_writer_flush(ew)) {
+        fprintf(stderr, "Failed to write voice frame\n");
+    }
+}
+
+/**
+  Output of TSDUs from control channel.
+
+  @param ptr Event writer or NULL for text output.
+  */
+static void tsdu_sink(const tsdu_t *tsdu, void *ptr)
+{
+    event_writer_t *ew = ptr;
+
+    if (event_ring && event_ring_write_tsdu(event_ring, tsdu)) {
+        fprintf(stderr, "Failed to publish TSDU\n");
+    }
+    if (net_index && net_index_update(net_index, tsdu)) {
+        fprintf(stderr, "Failed to update network index\n");
+    }
+
+    if (ew) {
+        if (event_write_tsdu(ew, tsdu)) {
+            fprintf(stderr, "Failed to write TSDU\n");
+        }
+        return;
+    }
+
+    IF_LOG(INFO) {
+        LOG_("\n");
+        tsdu_print(tsdu);
+    }
+}
+
+static void pch_sink(const pch_data_t *pch_data, void *ptr)
+{
+    IF_LOG(INFO) {
+        LOG_("\n");
+        pch_print(pch_data);
+    }
+}
+
+static void rch_sink(const rch_data_t *rch_data, void *ptr)
+{
+    IF_LOG(INFO) {
+        LOG_("\n");
+        rch_print(rch_data);
+    }
+}
+
+static void dup_sink(int log_ch, int repeats, void *ptr)
+{
+    const char *names[] = { "BCH", "PCH", "RCH", };
+    LOG(INFO, "%s unchanged, seen %d times", names[log_ch], repeats + 1);
+}
+
+/**
+  Register output of all decoded data.
+
+  @param ew Event writer or NULL for text output.
+  */
+static void phys_ch_set_sinks(phys_ch_t *phys_ch, event_writer_t *ew)
+{
+    tetrapol_phys_ch_set_tsdu_sink(phys_ch, tsdu_sink, ew);
+    tetrapol_phys_ch_set_pch_sink(phys_ch, pch_sink, NULL);
+    tetrapol_phys_ch_set_rch_sink(phys_ch, rch_sink, NULL);
+    tetrapol_phys_ch_set_voice_sink(phys_ch, voice_sink, ew);
+    tetrapol_phys_ch_set_dup_suppress(phys_ch, dup_suppress);
+    if (dup_notify) {
+        tetrapol_phys_ch_set_dup_sink(phys_ch, dup_sink, NULL);
+    }
+}
+
+static const char *log_ch_names[] = { "bch", "pch", "rch", "sdch", };
+
+static void cache_sysinfo_sink(const tsdu_d_system_info_t *tsdu, void *ptr)
+{
+    cell_cache_set_sysinfo(ptr, tsdu);
+}
+
+/**
+  Configure decoder by cached values from previous run, cache entry is
+  updated by received system information.
+
+  @param key Cache key, identifies the channel.
+  @return cache entry, NULL when cache is not used
+  */
+static cell_cache_entry_t *phys_ch_warm_start(phys_ch_t *phys_ch,
+        const char *key)
+{
+    if (!cell_cache) {
+        return NULL;
+    }
+    cell_cache_entry_t *entry = cell_cache_get(cell_cache, key, true);
+    if (!entry) {
+        fprintf(stderr, "Failed to create cache entry for %s\n", key);
+        return NULL;
+    }
+
+    if (entry->scr >= 0) {
+        tetrapol_phys_ch_preload_scr(phys_ch, entry->scr);
+    }
+    if (entry->mux_type >= 0) {
+        tetrapol_phys_ch_set_cch_mux_type(phys_ch, entry->mux_type);
+    }
+    tetrapol_phys_ch_set_sysinfo_sink(phys_ch, cache_sysinfo_sink, entry);
+
+    return entry;
+}
+
+/// Store SCR used by decoder at exit.
+static void cache_store_scr(cell_cache_entry_t *entry, phys_ch_t *phys_ch)
+{
+    if (entry) {
+        entry->scr = tetrapol_phys_ch_get_scr(phys_ch);
+    }
+}
+
+static const log_ch_stats_t *log_ch_stats(const phys_ch_stats_t *st, int i)
+{
+    const log_ch_stats_t *chs[] = { &st->bch, &st->pch, &st->rch, &st->sdch, };
+
+    return chs[i];
+}
+
+static uint64_t stats_hist_count(const uint64_t *hist, int nbins)
+{
+    uint64_t n = 0;
+    for (int i = 0; i < nbins; ++i) {
+        n += hist[i];
+    }
+
+    return n;
+}
+
+// upper bound of log2 histogram bin for given fraction of samples
+static uint64_t stats_hist_quantile(const uint64_t *hist, int nbins, double q)
+{
+    const uint64_t n = stats_hist_count(hist, nbins);
+    uint64_t cnt = 0;
+    for (int i = 0; i < nbins; ++i) {
+        cnt += hist[i];
+        if (cnt && cnt >= q * n) {
+            return 2ULL << i;
+        }
+    }
+
+    return 0;
+}
+
+static void stats_print_line(const phys_ch_stats_t *st, const char *label)
+{
+    const uint64_t nblks = st->voice_frames + st->data_frames;
+    char line[1024];
+    int len = snprintf(line, sizeof(line),
+            "[%s] STATS frames=%" PRIu64 " sync_found=%" PRIu64
+            " sync_lost=%" PRIu64 " sync_recovered=%" PRIu64
+            " resyncs=%" PRIu64 " fade_frames=%" PRIu64 " scr=%d scr_lock=%.2fs crc_ok=%.1f%% voice=%" PRIu64
+            " data=%" PRIu64 " time_p50=%" PRIu64 "ns time_p99=%" PRIu64 "ns",
+            label, st->frames, st->sync_found, st->sync_lost,
+            st->sync_recovered, st->resyncs, st->fade_frames, st->scr,
+            (st->scr_lock_time < 0) ? -1.0 : st->scr_lock_time / 1e6,
+            nblks ? 100.0 * st->crc_ok / nblks : 0.0,
+            st->voice_frames, st->data_frames,
+            stats_hist_quantile(st->time_hist, STATS_TIME_BINS, 0.5),
+            stats_hist_quantile(st->time_hist, STATS_TIME_BINS, 0.99));
+    // latency is measured only for input with timestamps (UDP ingest)
+    if (stats_hist_count(st->latency_hist, STATS_LATENCY_BINS)) {
+        len += snprintf(line + len, sizeof(line) - len,
+                " latency_p50=%" PRIu64 "us latency_p99=%" PRIu64 "us",
+                stats_hist_quantile(st->latency_hist, STATS_LATENCY_BINS, 0.5),
+                stats_hist_quantile(st->latency_hist, STATS_LATENCY_BINS, 0.99));
+    }
+    for (int i = 0; i < ARRAY_LEN(log_ch_names); ++i) {
+        const log_ch_stats_t *ch = log_ch_stats(st, i);
+        len += snprintf(line + len, sizeof(line) - len,
+                " %s=%" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64
+                "/%" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64, log_ch_names[i],
+                ch->msgs, ch->data_fr.crc_errs, ch->data_fr.parity_fixes,
+                ch->data_fr.parity_errs, ch->data_fr.seq_errs, ch->fcs_errs,
+                ch->tsdu_errs, ch->dups);
+    }
+    // stats line is written by single call, lines from workers do not mix
+    fprintf(stderr, "%s\n", line);
+}
+
+/**
+  Write statistics in Prometheus text exposition format, file is replaced
+  atomically (suitable for node_exporter textfile collector).
+  */
+static int stats_write_prom(const phys_ch_stats_t *st, const char *label,
+        const char *path)
+{
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= sizeof(tmp_path)) {
+        return -1;
+    }
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        perror(tmp_path);
+        return -1;
+    }
+
+    const struct {
+        const char *name;
+        const char *help;
+        uint64_t val;
+    } counters[] = {
+        { "frames", "Frames received in frame sync", st->frames, },
+        { "sync_found", "Frame synchronization acquired", st->sync_found, },
+        { "sync_lost", "Frame synchronization lost", st->sync_lost, },
+        { "sync_recovered", "Frame sync restored at shifted position",
+            st->sync_recovered, },
+        { "resyncs", "Resyncs forced by input discontinuity", st->resyncs, },
+        { "fade_frames", "Frames skipped in fade while in frame sync",
+            st->fade_frames, },
+        { "voice_frames", "Decoded voice frames", st->voice_frames, },
+        { "data_frames", "Decoded data frames", st->data_frames, },
+        { "tch_data_frames", "Data frames on traffic channel (not decoded)",
+            st->tch_data_frames, },
+        { "hr_data_frames",
+            "Data frames recognized as high rate data (not decoded)",
+            st->hr_data_frames, },
+        { "crc_ok", "Frames without errors with valid CRC", st->crc_ok, },
+    };
+    for (int i = 0; i < ARRAY_LEN(counters); ++i) {
+        fprintf(f, "# HELP tetrapol_%s_total %s\n"
+                "# TYPE tetrapol_%s_total counter\n"
+                "tetrapol_%s_total{input=\"%s\"} %" PRIu64 "\n",
+                counters[i].name, counters[i].help, counters[i].name,
+                counters[i].name, label, counters[i].val);
+    }
+
+    fprintf(f, "# HELP tetrapol_scr Detected SCR, -1 if unknown\n"
+            "# TYPE tetrapol_scr gauge\n"
+            "tetrapol_scr{input=\"%s\"} %d\n", label, st->scr);
+    fprintf(f, "# HELP tetrapol_scr_lock_seconds Signal time of SCR lock, "
+            "-1 if not locked\n"
+            "# TYPE tetrapol_scr_lock_seconds gauge\n"
+            "tetrapol_scr_lock_seconds{input=\"%s\"} %g\n", label,
+            (st->scr_lock_time < 0) ? -1.0 : st->scr_lock_time / 1e6);
+
+    fprintf(f, "# HELP tetrapol_block_nerrs_total Data blocks by number "
+            "of uncorrected errors\n"
+            "# TYPE tetrapol_block_nerrs_total counter\n");
+    for (int i = 0; i < STATS_NERRS_BINS; ++i) {
+        fprintf(f, "tetrapol_block_nerrs_total{input=\"%s\",nerrs=\"%d%s\"} %"
+                PRIu64 "\n", label, i, (i == STATS_NERRS_BINS - 1) ? "+" : "",
+                st->nerrs_hist[i]);
+    }
+
+    fprintf(f, "# HELP tetrapol_frame_process_seconds Frame processing time\n"
+            "# TYPE tetrapol_frame_process_seconds histogram\n");
+    uint64_t cnt = 0;
+    for (int i = 0; i < STATS_TIME_BINS - 1; ++i) {
+        cnt += st->time_hist[i];
+        fprintf(f, "tetrapol_frame_process_seconds_bucket"
+                "{input=\"%s\",le=\"%g\"} %" PRIu64 "\n",
+                label, (2ULL << i) / 1e9, cnt);
+    }
+    cnt += st->time_hist[STATS_TIME_BINS - 1];
+    fprintf(f, "tetrapol_frame_process_seconds_bucket{input=\"%s\",le=\"+Inf\"} %"
+            PRIu64 "\n"
+            "tetrapol_frame_process_seconds_sum{input=\"%s\"} %g\n"
+            "tetrapol_frame_process_seconds_count{input=\"%s\"} %" PRIu64 "\n",
+            label, cnt, label, st->time_sum / 1e9, label, cnt);
+
+    fprintf(f, "# HELP tetrapol_event_latency_seconds Latency from air to "
+            "decoded message, timestamped input only\n"
+            "# TYPE tetrapol_event_latency_seconds histogram\n");
+    cnt = 0;
+    for (int i = 0; i < STATS_LATENCY_BINS - 1; ++i) {
+        cnt += st->latency_hist[i];
+        fprintf(f, "tetrapol_event_latency_seconds_bucket"
+                "{input=\"%s\",le=\"%g\"} %" PRIu64 "\n",
+                label, (2ULL << i) / 1e6, cnt);
+    }
+    cnt += st->latency_hist[STATS_LATENCY_BINS - 1];
+    fprintf(f, "tetrapol_event_latency_seconds_bucket{input=\"%s\",le=\"+Inf\"} %"
+            PRIu64 "\n"
+            "tetrapol_event_latency_seconds_sum{input=\"%s\"} %g\n"
+            "tetrapol_event_latency_seconds_count{input=\"%s\"} %" PRIu64 "\n",
+            label, cnt, label, st->latency_sum / 1e6, label, cnt);
+
+    const char *log_ch_metrics[][2] = {
+        { "msgs", "Decoded messages", },
+        { "crc_errs", "Data blocks with CRC error", },
+        { "parity_fixes", "Data frames recovered by parity block", },
+        { "parity_errs", "Multiblock parity errors", },
+        { "seq_errs", "Invalid multiblock sequences", },
+        { "fcs_errs", "HDLC FCS failures", },
+        { "tsdu_errs", "TSDU decoding errors", },
+        { "dups", "Repeated messages not decoded", },
+    };
+    for (int m = 0; m < ARRAY_LEN(log_ch_metrics); ++m) {
+        fprintf(f, "# HELP tetrapol_log_ch_%s_total %s\n"
+                "# TYPE tetrapol_log_ch_%s_total counter\n",
+                log_ch_metrics[m][0], log_ch_metrics[m][1],
+                log_ch_metrics[m][0]);
+        for (int i = 0; i < ARRAY_LEN(log_ch_names); ++i) {
+            const log_ch_stats_t *ch = log_ch_stats(st, i);
+            const uint64_t vals[] = {
+                ch->msgs, ch->data_fr.crc_errs, ch->data_fr.parity_fixes,
+                ch->data_fr.parity_errs, ch->data_fr.seq_errs, ch->fcs_errs,
+                ch->tsdu_errs, ch->dups,
+            };
+            fprintf(f, "tetrapol_log_ch_%s_total{input=\"%s\",ch=\"%s\"} %"
+                    PRIu64 "\n", log_ch_metrics[m][0], label, log_ch_names[i],
+                    vals[m]);
+        }
+    }
+
+    if (fclose(f) || rename(tmp_path, path)) {
+        perror(path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+  Write network index as text, one line per entry, file is replaced
+  atomically.
+  */
+static int net_index_write(const net_index_t *idx, const char *path)
+{
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= sizeof(tmp_path)) {
+        return -1;
+    }
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        perror(tmp_path);
+        return -1;
+    }
+
+    uint8_t country_code;
+    system_id_t system_id;
+    if (net_index_get_network(idx, &country_code, &system_id)) {
+        fprintf(f, "network country=%d network=%d version=%d\n", country_code,
+                system_id.network, system_id.version);
+    }
+
+    const net_cell_t *current = net_index_get_current_cell(idx);
+    const net_cell_t *cell;
+    int it = 0;
+    while ((cell = net_index_next_cell(idx, &it))) {
+        fprintf(f, "cell bs_id=%d rws_id=%d current=%d", cell->cell_id.bs_id,
+                cell->cell_id.rws_id, cell == current);
+        if (cell->has_sysinfo) {
+            fprintf(f, " bn_id=%d loc_id=%d cell_bn=%d mux=%d",
+                    cell->bn_id, cell->loc_area_id.loc_id, cell->cell_bn,
+                    cell->cell_config.mux_type);
+        }
+        if (cell->channel_id) {
+            fprintf(f, " channel_id=%d", cell->channel_id);
+        }
+        for (int i = 0; i < cell->nneighbours; ++i) {
+            const net_neighbour_t *nb = &cell->neighbours[i];
+            fprintf(f, "%s%d", i ? "," : " neighbours=", nb->channel_id);
+            if (nb->has_cell_id) {
+                fprintf(f, ":%d/%d", nb->cell_id.bs_id, nb->cell_id.rws_id);
+            }
+        }
+        fprintf(f, "\n");
+    }
+
+    const net_group_t *group;
+    it = 0;
+    while ((group = net_index_next_group(idx, &it))) {
+        fprintf(f, "group id=%d", group->group_id);
+        for (int i = 0; group->has_composition && i < group->og_nb; ++i) {
+            fprintf(f, "%s%d", i ? "," : " composition=", group->group_ids[i]);
+        }
+        if (group->is_open) {
+            fprintf(f, " open_coverage_id=%d", group->open.coverage_id);
+        }
+        if (group->is_active) {
+            fprintf(f, " channel_id=%d coverage_id=%d",
+                    group->activation.channel_id, group->activation.coverage_id);
+        }
+        fprintf(f, "\n");
+    }
+
+    const net_call_t *call;
+    it = 0;
+    while ((call = net_index_next_call(idx, &it))) {
+        fprintf(f, "call addr=%d.%d.%d group_id=%d channel_id=%d\n",
+                call->addr.z, call->addr.y, call->addr.x, call->group_id,
+                call->activation.channel_id);
+    }
+
+    if (fclose(f) || rename(tmp_path, path)) {
+        perror(path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+  Report statistics when stats_interval elapsed.
+
+  @param next Time of next report, updated.
+  @param force Report immediately, e.g. at the end of input.
+  */
+static void stats_report(phys_ch_t *phys_ch, const char *label, time_t *next,
+        bool force)
+{
+    if (!stats_interval) {
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (!force && ts.tv_sec < *next) {
+        return;
+    }
+    *next = ts.tv_sec + stats_interval;
+
+    phys_ch_stats_t st;
+    tetrapol_phys_ch_get_stats(phys_ch, &st);
+    stats_print_line(&st, label);
+    if (stats_path) {
+        stats_write_prom(&st, label, stats_path);
+    }
+    if (net_index) {
+        net_index_write(net_index, net_index_path);
+    }
+}
+
+/**
+  Report quality of channel every FEEDBACK_INTERVAL_MS, datagram is sent
+  to feedback_fd (see tetrapol/ingest.h) and frequency offset is
+  corrected by AFC.
+
+  @param demod Demodulator of channel, NULL for bit stream input.
+  */
+static void feedback_report(feedback_t *fb, phys_ch_t *phys_ch, demod_t *demod)
+{
+    if (feedback_fd == -1 && !(afc && demod)) {
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const int64_t now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    if (now < fb->next) {
+        return;
+    }
+    fb->next = now + FEEDBACK_INTERVAL_MS * 1000000LL;
+
+    phys_ch_quality_t q;
+    tetrapol_phys_ch_get_quality(phys_ch, &q);
+    ingest_feedback_t msg = {
+        .ch_id = fb->ch_id,
+        .seq = fb->seq++,
+        .sync_errs = q.sync_errs,
+        .nerrs = q.nerrs,
+        .crc_errs = q.crc_errs,
+    };
+    if (q.has_frame_sync) {
+        msg.flags |= INGEST_FEEDBACK_SYNC;
+    }
+    if (demod) {
+        msg.flags |= INGEST_FEEDBACK_POWER;
+        msg.power = demod_get_power(demod);
+        // symbol decisions are reliable only in frame sync
+        if (q.has_frame_sync) {
+            msg.flags |= INGEST_FEEDBACK_FREQ;
+            msg.freq_offset = demod_get_freq_offset(demod);
+        }
+    }
+
+    if (afc && (msg.flags & INGEST_FEEDBACK_FREQ) &&
+            q.crc_errs < AFC_MAX_CRC_ERRS) {
+        const float corr = demod_get_freq_correction(demod);
+        demod_set_freq_correction(demod,
+                corr + AFC_GAIN * (msg.freq_offset - corr));
+    }
+
+    if (feedback_fd == -1) {
+        return;
+    }
+    timespec_get(&ts, TIME_UTC);
+    msg.timestamp = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    uint8_t buf[INGEST_FEEDBACK_LEN];
+    ingest_feedback_write(&msg, buf);
+    // feedback is best effort, e.g. nobody listens yet
+    send(feedback_fd, buf, sizeof(buf), MSG_DONTWAIT);
+}
+
+/**
+  Parse comma separated list of codops (e.g. "0x92,0x45") into filter.
+
+  @return 0 on success, -1 for invalid list
+  */
+static int parse_codops(tsdu_filter_t *filter, const char *list)
+{
+    tsdu_filter_set_all(filter, false);
+    while (*list) {
+        char *end;
+        const long codop = strtol(list, &end, 0);
+        if (end == list || codop < 0 || codop > 0xff ||
+                (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        tsdu_filter_set(filter, codop, true);
+        list = *end ? end + 1 : end;
+    }
+
+    return 0;
+}
+
+static void phys_ch_subscribe(phys_ch_t *phys_ch)
+{
+    if (!codops_set) {
+        return;
+    }
+    for (int codop = 0; codop <= 0xff; ++codop) {
+        tetrapol_phys_ch_subscribe(phys_ch, codop,
+                tsdu_filter_has(&codops, codop));
+    }
+}
+
+/**
+  Feed decoder directly from memory mapped capture, used for fast offline
+  processing of archived files.
+  */
+static int tetrapol_dump_replay(phys_ch_t *phys_ch, int fd, int input_fmt,
+        const char *label)
+{
+    struct stat st;
+    if (fstat(fd, &st)) {
+        perror("Failed to stat input file");
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Replay mode requires regular input file.\n");
+        return -1;
+    }
+    if (st.st_size == 0) {
+        return 0;
+    }
+
+    uint8_t *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        perror("Failed to map input file");
+        return -1;
+    }
+    if (madvise(data, st.st_size, MADV_SEQUENTIAL)) {
+        perror("madvise");
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    struct timespec ts_start, ts_end;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    int ret = 0;
+    off_t pos = 0;
+    time_t stats_next = 0;
+    while (ret == 0 && !do_exit && pos < st.st_size) {
+        const off_t len = st.st_size - pos;
+        const int rsize = tetrapol_phys_ch_recv(phys_ch, data + pos,
+                (len > INT_MAX) ? INT_MAX : len);
+        if (rsize < 0) {
+            ret = rsize;
+            break;
+        }
+        pos += rsize;
+
+        ret = tetrapol_phys_ch_process(phys_ch);
+        stats_report(phys_ch, label, &stats_next, false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    munmap(data, st.st_size);
+
+    const double elapsed = (ts_end.tv_sec - ts_start.tv_sec) +
+        (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9;
+    const int bits_per_byte = (input_fmt == PHYS_CH_INPUT_PACKED) ? 8 : 1;
+    const double nframes = (double)pos * bits_per_byte / FRAME_BITS;
+    const double fps = (elapsed > 0) ? nframes / elapsed : 0;
+    fprintf(stderr, "Replayed %.0f frames (%.1f s of signal) in %.3f s, "
+            "%.0f frames/s, %.1fx real time\n",
+            nframes, nframes / FRAMES_PER_SEC, elapsed, fps,
+            fps / FRAMES_PER_SEC);
+
+    return ret;
+}
+
+/**
+  Chunk of capture decoded by parallel replay.
+
+  Decoder is fed from 'begin', output produced before 'own' (overlap with
+  the previous chunk) is discarded, the overlap is used to acquire frame
+  sync and to reassemble data frames and TPDUs started in the previous
+  chunk. Output of the chunk are events completed in <own, end), the next
+  chunk owns events completed after 'end'.
+  */
+typedef struct {
+    const uint8_t *data;    ///< whole capture
+    off_t begin;
+    off_t own;
+    off_t end;
+    int idx;
+    FILE *out;          ///< text or binary output of owned range
+    bool events;        ///< binary events instead of text
+    bool synced;        ///< frame sync and SCR known at 'own'
+    int ret;
+} par_chunk_t;
+
+typedef struct {
+    par_chunk_t *chunks;
+    int nchunks;
+    _Atomic int next;   ///< next chunk to be decoded
+    int band;
+    int radio_ch_type;
+    int input_fmt;
+    int scr;            ///< seed for all chunks, PHYS_CH_SCR_DETECT if unknown
+    int mux_type;       ///< seed for all chunks, -1 if unknown
+} par_replay_t;
+
+/// Feed decoder from memory by single frames, return at 'end'.
+static int par_feed(phys_ch_t *phys_ch, const uint8_t *data, off_t pos,
+        off_t end, int step)
+{
+    while (pos < end && !do_exit) {
+        const int len = (end - pos < step) ? end - pos : step;
+        for (int n = 0; n < len; ) {
+            n += tetrapol_phys_ch_recv(phys_ch, (uint8_t *)data + pos + n,
+                    len - n);
+            if (tetrapol_phys_ch_process(phys_ch)) {
+                return -1;
+            }
+        }
+        pos += len;
+    }
+
+    return 0;
+}
+
+static int par_chunk_decode(par_replay_t *par, par_chunk_t *c)
+{
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(par->band, par->radio_ch_type);
+    if (!phys_ch) {
+        return -1;
+    }
+    tetrapol_phys_ch_set_input_fmt(phys_ch, par->input_fmt);
+    phys_ch_subscribe(phys_ch);
+    // the first chunk is decoded exactly as by serial replay
+    if (c->begin && par->scr != PHYS_CH_SCR_DETECT) {
+        tetrapol_phys_ch_preload_scr(phys_ch, par->scr);
+    }
+    if (c->begin && par->mux_type >= 0) {
+        tetrapol_phys_ch_set_cch_mux_type(phys_ch, par->mux_type);
+    }
+
+    event_writer_t *ew = NULL;
+    if (c->events) {
+        ew = event_writer_create(fileno(c->out));
+        if (!ew) {
+            tetrapol_phys_ch_destroy(phys_ch);
+            return -1;
+        }
+        log_stream = stderr;
+    } else {
+        log_stream = c->out;
+    }
+    phys_ch_set_sinks(phys_ch, ew);
+
+    // boundaries are aligned to frames, both chunks process frames
+    // at the same positions and agree on ownership of events
+    const int step = (par->input_fmt == PHYS_CH_INPUT_PACKED) ?
+        FRAME_BITS / 8 : FRAME_BITS;
+    int ret = par_feed(phys_ch, c->data, c->begin, c->own, step);
+    if (!ret) {
+        // drop output of overlap
+        if (ew) {
+            event_writer_flush(ew);
+        }
+        fflush(c->out);
+        if (ftruncate(fileno(c->out), 0) || fseek(c->out, 0, SEEK_SET)) {
+            ret = -1;
+        }
+        phys_ch_stats_t st;
+        tetrapol_phys_ch_get_stats(phys_ch, &st);
+        c->synced = c->begin == c->own ||
+            (st.sync_found && tetrapol_phys_ch_get_scr(phys_ch) >= 0);
+    }
+    if (!ret) {
+        ret = par_feed(phys_ch, c->data, c->own, c->end, step);
+    }
+
+    if (ew && event_writer_flush(ew)) {
+        ret = -1;
+    }
+    event_writer_destroy(ew);
+    fflush(c->out);
+    log_stream = NULL;
+    tetrapol_phys_ch_destroy(phys_ch);
+
+    return ret;
+}
+
+static void *par_worker(void *arg)
+{
+    par_replay_t *par = arg;
+
+    int i;
+    while ((i = atomic_fetch_add(&par->next, 1)) < par->nchunks) {
+        par->chunks[i].ret = par_chunk_decode(par, &par->chunks[i]);
+    }
+
+    return NULL;
+}
+
+/**
+  Get SCR and multiplexing type from the beginning of capture, used as
+  seed for decoder of each chunk.
+  */
+static void par_seed(par_replay_t *par, const uint8_t *data, off_t len)
+{
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(par->band, par->radio_ch_type);
+    if (!phys_ch) {
+        return;
+    }
+    tetrapol_phys_ch_set_input_fmt(phys_ch, par->input_fmt);
+    // output is produced again by the first chunk
+    FILE *null = fopen("/dev/null", "w");
+    log_stream = null;
+
+    const int step = 64 * ((par->input_fmt == PHYS_CH_INPUT_PACKED) ?
+        FRAME_BITS / 8 : FRAME_BITS);
+    for (off_t pos = 0; pos < len &&
+            tetrapol_phys_ch_get_scr(phys_ch) == PHYS_CH_SCR_DETECT;
+            pos += step) {
+        if (par_feed(phys_ch, data, pos, (len - pos < step) ? len : pos + step,
+                    step)) {
+            break;
+        }
+    }
+    par->scr = tetrapol_phys_ch_get_scr(phys_ch);
+    par->mux_type = tetrapol_phys_ch_get_cch_mux_type(phys_ch);
+
+    log_stream = NULL;
+    if (null) {
+        fclose(null);
+    }
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+/**
+  Decode capture file in overlapping chunks by pool of threads, outputs
+  of chunks are merged in order.
+  */
+static int tetrapol_dump_parallel(int fd, int nworkers, int band,
+        int radio_ch_type, int input_fmt, bool events)
+{
+    struct stat st;
+    if (fstat(fd, &st)) {
+        perror("Failed to stat input file");
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Parallel replay requires regular input file.\n");
+        return -1;
+    }
+    if (st.st_size == 0) {
+        return 0;
+    }
+
+    uint8_t *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        perror("Failed to map input file");
+        return -1;
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    struct timespec ts_start, ts_end;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    const int bits_per_byte = (input_fmt == PHYS_CH_INPUT_PACKED) ? 8 : 1;
+    // boundaries are aligned to whole frames and bytes
+    const off_t align = FRAME_BITS;
+    const off_t overlap = (off_t)PAR_OVERLAP_SEC * FRAMES_PER_SEC * FRAME_BITS /
+        bits_per_byte;
+    off_t chunk_len = st.st_size / (PAR_CHUNKS_PER_WORKER * nworkers);
+    const off_t chunk_min = (off_t)PAR_CHUNK_MIN_SEC * FRAMES_PER_SEC *
+        FRAME_BITS / bits_per_byte;
+    chunk_len = (chunk_len < chunk_min) ? chunk_min : chunk_len;
+    chunk_len = (chunk_len + align - 1) / align * align;
+
+    par_replay_t par = {
+        .nchunks = (st.st_size + chunk_len - 1) / chunk_len,
+        .band = band,
+        .radio_ch_type = radio_ch_type,
+        .input_fmt = input_fmt,
+    };
+    atomic_init(&par.next, 0);
+    int ret = -1;
+    int nworkers_started = 0;
+    pthread_t *workers = calloc(nworkers, sizeof(pthread_t));
+    par.chunks = calloc(par.nchunks, sizeof(par_chunk_t));
+    if (!workers || !par.chunks) {
+        goto err;
+    }
+    for (int i = 0; i < par.nchunks; ++i) {
+        par_chunk_t *c = &par.chunks[i];
+        c->data = data;
+        c->idx = i;
+        c->own = i * chunk_len;
+        c->begin = (c->own > overlap) ? c->own - overlap : 0;
+        c->end = (c->own + chunk_len < st.st_size) ?
+            c->own + chunk_len : st.st_size;
+        c->events = events;
+        c->out = tmpfile();
+        if (!c->out) {
+            perror("Failed to create chunk output");
+            goto err;
+        }
+    }
+
+    par_seed(&par, data, (chunk_len < st.st_size) ? chunk_len : st.st_size);
+
+    for (; nworkers_started < nworkers; ++nworkers_started) {
+        if (pthread_create(&workers[nworkers_started], NULL, par_worker, &par)) {
+            fprintf(stderr, "Failed to start worker\n");
+            break;
+        }
+    }
+    // each started worker processes chunks until all are taken
+    for (int i = 0; i < nworkers_started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    ret = nworkers_started ? 0 : -1;
+
+    for (int i = 0; i < par.nchunks && !ret && !do_exit; ++i) {
+        par_chunk_t *c = &par.chunks[i];
+        if (c->ret) {
+            fprintf(stderr, "Failed to decode chunk %d\n", i);
+            ret = -1;
+            break;
+        }
+        if (!c->synced) {
+            fprintf(stderr, "Chunk %d not synchronized at its start, "
+                    "events might be lost\n", i);
+        }
+        rewind(c->out);
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), c->out))) {
+            if (fwrite(buf, 1, n, stdout) != n) {
+                ret = -1;
+                break;
+            }
+        }
+    }
+    fflush(stdout);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    const double elapsed = (ts_end.tv_sec - ts_start.tv_sec) +
+        (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9;
+    const double nframes = (double)st.st_size * bits_per_byte / FRAME_BITS;
+    fprintf(stderr, "Decoded %.0f frames (%.1f s of signal) in %d chunks "
+            "by %d threads in %.3f s, %.1fx real time\n",
+            nframes, nframes / FRAMES_PER_SEC, par.nchunks, nworkers_started,
+            elapsed, (elapsed > 0) ? nframes / FRAMES_PER_SEC / elapsed : 0);
+
+err:
+    if (par.chunks) {
+        for (int i = 0; i < par.nchunks; ++i) {
+            if (par.chunks[i].out) {
+                fclose(par.chunks[i].out);
+            }
+        }
+    }
+    free(par.chunks);
+    free(workers);
+    munmap(data, st.st_size);
+
+    return ret;
+}
+
+/**
+  Single input in multi-channel mode.
+
+  Channel is owned by at most one worker at time, it is ensured by
+  EPOLLONESHOT or by the work queue for inputs which are not pollable.
+  In wideband mode the channel is output of channelizer, in UDP mode
+  the channel is stream of datagrams with the same channel id.
+  */
+typedef struct channel_st {
+    const char *path;
+    int fd;
+    bool pollable;      ///< epoll does not support regular files
+    phys_ch_t *phys_ch;
+    // wideband mode
+    demod_t *demod;
+    char name[16];      ///< channel label, used instead of path
+    // UDP mode
+    ingest_seq_t seq;
+    feedback_t feedback;
+    bool failed;        ///< decoding stopped on error
+    FILE *out;          ///< channel output, lines are tagged by path
+    int line_len;
+    char line[1024];
+    time_t stats_next;  ///< time of next statistics report
+    // scan mode
+    uint64_t nbits;     ///< received bits
+    int verdict;        ///< SCAN_*
+    tsdu_d_system_info_t sysinfo;   ///< valid for SCAN_CONTROL
+    cell_cache_entry_t *cache;      ///< NULL when cache is not used
+    struct channel_st *next;
+} channel_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    channel_t *head;    ///< queue of channels ready for processing
+    channel_t *tail;
+    int nactive;        ///< number of channels not finished yet
+    bool exit;
+    int epfd;
+    int evfd;           ///< wakes up epoll loop when all channels finish
+} pool_t;
+
+static void channel_write_line(channel_t *ch)
+{
+    flockfile(stdout);
+    fprintf(stdout, "[%s] %.*s", ch->path, ch->line_len, ch->line);
+    funlockfile(stdout);
+    ch->line_len = 0;
+}
+
+// cookie writer for channel output, only complete lines are forwarded
+static ssize_t channel_out_write(void *cookie, const char *buf, size_t size)
+{
+    channel_t *ch = cookie;
+
+    for (size_t i = 0; i < size; ++i) {
+        if (ch->line_len == sizeof(ch->line) - 1) {
+            ch->line[ch->line_len++] = '\n';
+            channel_write_line(ch);
+        }
+        ch->line[ch->line_len++] = buf[i];
+        if (buf[i] == '\n') {
+            channel_write_line(ch);
+        }
+    }
+
+    return size;
+}
+
+static int channel_out_close(void *cookie)
+{
+    channel_t *ch = cookie;
+
+    if (ch->line_len) {
+        ch->line[ch->line_len++] = '\n';
+        channel_write_line(ch);
+    }
+
+    return 0;
+}
+
+static void pool_push(pool_t *pool, channel_t *ch)
+{
+    pthread_mutex_lock(&pool->mutex);
+    ch->next = NULL;
+    if (pool->tail) {
+        pool->tail->next = ch;
+    } else {
+        pool->head = ch;
+    }
+    pool->tail = ch;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static channel_t *pool_pop(pool_t *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->head && !pool->exit) {
+        pthread_cond_wait(&pool->cond, &pool->mutex);
+    }
+    channel_t *ch = pool->exit ? NULL : pool->head;
+    if (ch) {
+        pool->head = ch->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return ch;
+}
+
+static void pool_channel_finished(pool_t *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->nactive == 0) {
+        const uint64_t v = 1;
+        if (write(pool->evfd, &v, sizeof(v)) != sizeof(v)) {
+            perror("Failed to notify main loop");
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void scan_sysinfo_sink(const tsdu_d_system_info_t *tsdu, void *ptr)
+{
+    channel_t *ch = ptr;
+
+    if (ch->cache) {
+        cell_cache_set_sysinfo(ch->cache, tsdu);
+    }
+    if (ch->verdict == SCAN_PENDING) {
+        memcpy(&ch->sysinfo, tsdu, sizeof(ch->sysinfo));
+        ch->verdict = SCAN_CONTROL;
+    }
+}
+
+/**
+  Decide about channel type in scan mode.
+
+  @param eof No more data will be received.
+  @return 1 when verdict is known, 0 otherwise
+  */
+static int scan_check(channel_t *ch, bool eof)
+{
+    if (ch->verdict != SCAN_PENDING) {
+        return 1;
+    }
+
+    phys_ch_stats_t st;
+    tetrapol_phys_ch_get_stats(ch->phys_ch, &st);
+    if (st.voice_frames >= SCAN_VOICE_FRAMES &&
+            st.voice_frames > 4 * st.data_frames) {
+        ch->verdict = SCAN_TRAFFIC;
+    } else if (eof ||
+            ch->nbits >= (uint64_t)scan_timeout * FRAMES_PER_SEC * FRAME_BITS) {
+        ch->verdict = (st.crc_ok < SCAN_MIN_FRAMES) ?
+            SCAN_NO_SIGNAL : SCAN_TIMEOUT;
+    }
+
+    return ch->verdict != SCAN_PENDING;
+}
+
+/**
+  Print summary of scan, one line per input.
+  */
+static void scan_print(const channel_t *chs, int nchs)
+{
+    printf("%-24s %-9s %4s %7s %7s %7s %7s %6s %5s %5s %6s %7s\n",
+            "INPUT", "VERDICT", "SCR", "FRAMES", "CRC_OK", "COUNTRY",
+            "NETWORK", "LOC_ID", "BN_ID", "BS_ID", "RWS_ID", "CELL_BN");
+    for (int i = 0; i < nchs; ++i) {
+        const channel_t *ch = &chs[i];
+        phys_ch_stats_t st;
+        tetrapol_phys_ch_get_stats(ch->phys_ch, &st);
+        printf("%-24s %-9s %4d %7" PRIu64 " %7" PRIu64, ch->path,
+                scan_verdicts[ch->verdict], st.scr, st.frames, st.crc_ok);
+        if (ch->verdict == SCAN_CONTROL) {
+            const tsdu_d_system_info_t *si = &ch->sysinfo;
+            printf(" %7d %7d %6d %5d %5d %6d %7d\n", si->country_code,
+                    si->system_id.network, si->loc_area_id.loc_id, si->bn_id,
+                    si->cell_id.bs_id, si->cell_id.rws_id, si->cell_bn);
+        } else {
+            printf(" %7s %7s %6s %5s %5s %6s %7s\n",
+                    "-", "-", "-", "-", "-", "-", "-");
+        }
+    }
+}
+
+/**
+  Read available data from channel input and process them.
+
+  @return 0 when more data are expected, 1 on EOF, -1 on error
+  */
+static int channel_process(channel_t *ch)
+{
+    uint8_t *buf;
+    const int len = tetrapol_phys_ch_recv_buf(ch->phys_ch, &buf);
+    if (len > 0) {
+        const int rsize = read(ch->fd, buf, len);
+        if (rsize == 0) {
+            if (scan_timeout) {
+                scan_check(ch, true);
+            }
+            return 1;
+        }
+        if (rsize < 0) {
+            return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+        }
+        tetrapol_phys_ch_recv_commit(ch->phys_ch, rsize);
+        ch->nbits += (tetrapol_phys_ch_get_input_fmt(ch->phys_ch) ==
+                PHYS_CH_INPUT_PACKED) ? 8 * rsize : rsize;
+    }
+
+    if (tetrapol_phys_ch_process(ch->phys_ch)) {
+        return -1;
+    }
+
+    return scan_timeout ? scan_check(ch, false) : 0;
+}
+
+static void *worker(void *arg)
+{
+    pool_t *pool = arg;
+    channel_t *ch;
+
+    while ((ch = pool_pop(pool))) {
+        log_stream = ch->out;
+        const int ret = channel_process(ch);
+        fflush(ch->out);
+        log_stream = NULL;
+        stats_report(ch->phys_ch, ch->path, &ch->stats_next, ret != 0);
+
+        if (ret) {
+            if (ret < 0) {
+                fprintf(stderr, "Failed to process input %s\n", ch->path);
+            }
+            if (ch->pollable) {
+                epoll_ctl(pool->epfd, EPOLL_CTL_DEL, ch->fd, NULL);
+            }
+            pool_channel_finished(pool);
+        } else if (ch->pollable) {
+            struct epoll_event ev = {
+                .events = EPOLLIN | EPOLLONESHOT,
+                .data.ptr = ch,
+            };
+            if (epoll_ctl(pool->epfd, EPOLL_CTL_MOD, ch->fd, &ev)) {
+                perror("Failed to rearm input");
+                pool_channel_finished(pool);
+            }
+        } else {
+            pool_push(pool, ch);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+  Create decoder and output of channel, ch->path must be set.
+  */
+static int channel_init_decoder(channel_t *ch, int band, int radio_ch_type,
+        int input_fmt)
+{
+    ch->phys_ch = tetrapol_phys_ch_create(band, radio_ch_type);
+    if (!ch->phys_ch) {
+        return -1;
+    }
+    tetrapol_phys_ch_set_input_fmt(ch->phys_ch, input_fmt);
+    phys_ch_set_sinks(ch->phys_ch, NULL);
+    phys_ch_subscribe(ch->phys_ch);
+    ch->cache = phys_ch_warm_start(ch->phys_ch, ch->path);
+    if (scan_timeout) {
+        tetrapol_phys_ch_set_bch_only(ch->phys_ch, true);
+        tetrapol_phys_ch_set_sysinfo_sink(ch->phys_ch, scan_sysinfo_sink, ch);
+    }
+
+    const cookie_io_functions_t io = {
+        .write = channel_out_write,
+        .close = channel_out_close,
+    };
+    ch->out = fopencookie(ch, "w", io);
+    if (!ch->out) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int channel_init(channel_t *ch, const char *path, int band,
+        int radio_ch_type, int input_fmt)
+{
+    ch->path = path;
+    ch->fd = strcmp(path, "-") ? open(path, O_RDONLY | O_NONBLOCK) : STDIN_FILENO;
+    if (ch->fd == -1) {
+        perror(path);
+        return -1;
+    }
+    if (fcntl(ch->fd, F_SETFL, O_NONBLOCK | fcntl(ch->fd, F_GETFL))) {
+        return -1;
+    }
+
+    return channel_init_decoder(ch, band, radio_ch_type, input_fmt);
+}
+
+static void channel_destroy(channel_t *ch)
+{
+    if (ch->out) {
+        fclose(ch->out);
+    }
+    if (ch->phys_ch) {
+        cache_store_scr(ch->cache, ch->phys_ch);
+        tetrapol_phys_ch_destroy(ch->phys_ch);
+    }
+    demod_destroy(ch->demod);
+    if (ch->fd > STDIN_FILENO) {
+        close(ch->fd);
+    }
+}
+
+/**
+  Process many inputs at once, each input has its own phys_ch_t,
+  readiness of inputs is polled by single epoll loop and decoding is done
+  by pool of worker threads.
+  */
+static int tetrapol_dump_multi(const char **paths, int npaths, int nworkers,
+        int band, int radio_ch_type, int input_fmt)
+{
+    int ret = -1;
+    int nworkers_started = 0;
+    pthread_t *workers = calloc(nworkers, sizeof(pthread_t));
+    channel_t *chs = calloc(npaths, sizeof(channel_t));
+    pool_t pool = {
+        .mutex = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+        .nactive = npaths,
+        .epfd = epoll_create1(0),
+        .evfd = eventfd(0, 0),
+    };
+    if (!workers || !chs || pool.epfd == -1 || pool.evfd == -1) {
+        goto err_alloc;
+    }
+
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.ptr = NULL,
+    };
+    if (epoll_ctl(pool.epfd, EPOLL_CTL_ADD, pool.evfd, &ev)) {
+        goto err_alloc;
+    }
+
+    for (int i = 0; i < npaths; ++i) {
+        if (channel_init(&chs[i], paths[i], band, radio_ch_type, input_fmt)) {
+            fprintf(stderr, "Failed to initialize input %s\n", paths[i]);
+            goto err_ch;
+        }
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    for (int i = 0; i < npaths; ++i) {
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = &chs[i];
+        chs[i].pollable = !epoll_ctl(pool.epfd, EPOLL_CTL_ADD, chs[i].fd, &ev);
+        if (!chs[i].pollable) {
+            if (errno != EPERM) {
+                perror(paths[i]);
+                goto err_ch;
+            }
+            // regular file, always ready
+            pool_push(&pool, &chs[i]);
+        }
+    }
+
+    // SIGINT must interrupt epoll_wait in main thread, not the workers
+    sigset_t sigset, sigset_old;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &sigset, &sigset_old);
+    for (; nworkers_started < nworkers; ++nworkers_started) {
+        if (pthread_create(&workers[nworkers_started], NULL, worker, &pool)) {
+            pthread_sigmask(SIG_SETMASK, &sigset_old, NULL);
+            goto err_workers;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &sigset_old, NULL);
+
+    ret = 0;
+    bool finished = false;
+    while (!finished && !do_exit) {
+        struct epoll_event evs[64];
+        const int n = epoll_wait(pool.epfd, evs, ARRAY_LEN(evs), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ret = -1;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (evs[i].data.ptr) {
+                pool_push(&pool, evs[i].data.ptr);
+            } else {
+                finished = true;
+            }
+        }
+    }
+
+err_workers:
+    pthread_mutex_lock(&pool.mutex);
+    pool.exit = true;
+    pthread_cond_broadcast(&pool.cond);
+    pthread_mutex_unlock(&pool.mutex);
+    while (nworkers_started) {
+        pthread_join(workers[--nworkers_started], NULL);
+    }
+
+    if (scan_timeout) {
+        scan_print(chs, npaths);
+    }
+
+err_ch:
+    // pending log messages are written into channel outputs
+    log_async_flush();
+    for (int i = 0; i < npaths; ++i) {
+        channel_destroy(&chs[i]);
+    }
+
+err_alloc:
+    if (pool.evfd != -1) {
+        close(pool.evfd);
+    }
+    if (pool.epfd != -1) {
+        close(pool.epfd);
+    }
+    free(chs);
+    free(workers);
+
+    return ret;
+}
+
+/**
+  Decode inputs of several receivers of the same channel, the best copy of
+  each frame is selected (see tetrapol/combiner.h). Inputs are read in
+  turns by COMBINE_CHUNK_FRAMES frames.
+  */
+static int tetrapol_dump_combined(const char **paths, int npaths, int band,
+        int radio_ch_type, int input_fmt)
+{
+    int ret = -1;
+    int fds[COMBINER_RX_MAX];
+    int nfds = 0;
+    combiner_t *comb = combiner_create(band, radio_ch_type, npaths);
+    if (!comb) {
+        fprintf(stderr, "Failed to initialize TETRAPOL instance.\n");
+        return -1;
+    }
+
+    for (; nfds < npaths; ++nfds) {
+        fds[nfds] = strcmp(paths[nfds], "-") ?
+            open(paths[nfds], O_RDONLY) : STDIN_FILENO;
+        if (fds[nfds] == -1) {
+            perror(paths[nfds]);
+            goto err_open;
+        }
+        tetrapol_phys_ch_set_input_fmt(combiner_get_rx(comb, nfds), input_fmt);
+    }
+    phys_ch_t *phys_ch = combiner_get_phys_ch(comb);
+    phys_ch_set_sinks(phys_ch, NULL);
+    phys_ch_subscribe(phys_ch);
+
+    signal(SIGINT, sigint_handler);
+
+    uint8_t buf[COMBINE_CHUNK_FRAMES * FRAME_BITS];
+    const int chunk = (input_fmt == PHYS_CH_INPUT_PACKED) ?
+        sizeof(buf) / 8 : sizeof(buf);
+    bool eof[COMBINER_RX_MAX] = { false, };
+    int nactive = npaths;
+    time_t stats_next = 0;
+    ret = 0;
+    while (nactive && !ret && !do_exit) {
+        for (int i = 0; i < npaths && !ret; ++i) {
+            if (eof[i]) {
+                continue;
+            }
+            const int len = read(fds[i], buf, chunk);
+            if (len <= 0) {
+                eof[i] = true;
+                --nactive;
+                continue;
+            }
+            phys_ch_t *rx = combiner_get_rx(comb, i);
+            for (int n = 0; n < len && !ret; ) {
+                n += tetrapol_phys_ch_recv(rx, buf + n, len - n);
+                ret = tetrapol_phys_ch_process(rx);
+            }
+        }
+        stats_report(phys_ch, "combined", &stats_next, false);
+    }
+    combiner_flush(comb);
+    stats_report(phys_ch, "combined", &stats_next, true);
 
-#include <fcntl.h>
-#include <poll.h>
-#include <signal.h>
-#include <getopt.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
+    if (stats_interval) {
+        combiner_stats_t st;
+        combiner_get_stats(comb, &st);
+        char line[512];
+        int len = snprintf(line, sizeof(line),
+                "[combined] COMBINER frames=%" PRIu64 " recovered=%" PRIu64
+                " late=%" PRIu64 " unaligned=%" PRIu64 " rx_best=",
+                st.frames, st.recovered, st.late, st.unaligned);
+        for (int i = 0; i < npaths; ++i) {
+            len += snprintf(line + len, sizeof(line) - len,
+                    i ? "/%" PRIu64 : "%" PRIu64, st.rx_best[i]);
+        }
+        fprintf(stderr, "%s\n", line);
+    }
 
-// set on SIGINT
-volatile static int do_exit = 0;
+err_open:
+    for (int i = 0; i < nfds; ++i) {
+        if (fds[i] != STDIN_FILENO) {
+            close(fds[i]);
+        }
+    }
+    combiner_destroy(comb);
 
+    return ret;
+}
 
-static void sigint_handler(int sig)
+/// Save and destroy warm start cache.
+static int cell_cache_close(void)
 {
-    do_exit = 1;
+    if (!cell_cache) {
+        return 0;
+    }
+    const int ret = cell_cache_save(cell_cache, cell_cache_path);
+    if (ret) {
+        fprintf(stderr, "Failed to save cache %s\n", cell_cache_path);
+    }
+    cell_cache_destroy(cell_cache);
+    cell_cache = NULL;
+
+    return ret;
 }
 
 static int do_read(int fd, uint8_t *buf, int len)
@@ -38,11 +1610,18 @@ static int do_read(int fd, uint8_t *buf, int len)
     return do_exit ? 0 : -1;
 }
 
-static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd)
+/**
+  Process live input.
+
+  @param ew Binary event output, flushed after each processed input batch,
+    or NULL.
+  */
+static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd, event_writer_t *ew,
+        const char *label)
 {
     int ret = 0;
-    int data_len = 0;
-    uint8_t data[4096];
+    time_t stats_next = 0;
+    feedback_t fb = { .ch_id = 0, };
 
     if (fcntl(fd, F_SETFL, O_NONBLOCK | fcntl(fd, F_GETFL))) {
         return -1;
@@ -51,26 +1630,531 @@ static int tetrapol_dump_loop(phys_ch_t *phys_ch, int fd)
     signal(SIGINT, sigint_handler);
 
     while (ret == 0 && !do_exit) {
-        if (sizeof(data) - data_len > 0) {
-            const int rsize = do_read(fd, data + data_len, sizeof(data) - data_len);
+        uint8_t *buf;
+        const int len = tetrapol_phys_ch_recv_buf(phys_ch, &buf);
+        if (len > 0) {
+            const int rsize = do_read(fd, buf, len);
             if (rsize <= 0) {
                 return rsize;
             }
-            data_len += rsize;
+            tetrapol_phys_ch_recv_commit(phys_ch, rsize);
         }
 
-        const int rsize = tetrapol_phys_ch_recv(phys_ch, data, data_len);
-        if (rsize < 0) {
+        ret = tetrapol_phys_ch_process(phys_ch);
+        if (ew && event_writer_flush(ew)) {
+            ret = -1;
+        }
+        stats_report(phys_ch, label, &stats_next, false);
+        feedback_report(&fb, phys_ch, NULL);
+    }
+
+    return ret;
+}
+
+/**
+  Process live complex baseband input, samples are demodulated into bits
+  and bits are passed into decoder.
+
+  @param ew Binary event output, flushed after each processed input batch,
+    or NULL.
+  */
+static int tetrapol_dump_iq(phys_ch_t *phys_ch, int fd, demod_t *demod,
+        event_writer_t *ew, const char *label)
+{
+    const int sample_size = demod_sample_size(demod);
+    uint8_t buf[IQ_BUF_SAMPLES * 2 * sizeof(float)];
+    uint8_t bits[DEMOD_BITS_MAX(IQ_BUF_SAMPLES)];
+    // bytes in buf, reads are not aligned to samples
+    int buf_len = 0;
+    int ret = 0;
+    time_t stats_next = 0;
+    feedback_t fb = { .ch_id = 0, };
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK | fcntl(fd, F_GETFL))) {
+        return -1;
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    while (ret == 0 && !do_exit) {
+        const int rsize = do_read(fd, buf + buf_len,
+                IQ_BUF_SAMPLES * sample_size - buf_len);
+        if (rsize <= 0) {
             return rsize;
         }
-        if (rsize > 0) {
-            memmove(data, data + rsize, data_len - rsize);
-            data_len -= rsize;
+        buf_len += rsize;
+
+        const int nsamples = buf_len / sample_size;
+        const int nbits = demod_process(demod, buf, nsamples, bits);
+        buf_len -= nsamples * sample_size;
+        memmove(buf, buf + nsamples * sample_size, buf_len);
+
+        for (int pos = 0; ret == 0 && pos < nbits; ) {
+            pos += tetrapol_phys_ch_recv(phys_ch, bits + pos, nbits - pos);
+            ret = tetrapol_phys_ch_process(phys_ch);
         }
+        if (ew && event_writer_flush(ew)) {
+            ret = -1;
+        }
+        stats_report(phys_ch, label, &stats_next, false);
+        feedback_report(&fb, phys_ch, demod);
+    }
 
-        ret = tetrapol_phys_ch_process(phys_ch);
+    return ret;
+}
+
+
+/**
+  Block of channelizer output, shared by all decoding workers.
+  */
+typedef struct {
+    float *samples;     ///< channel k starts at 2 * k * WB_BLOCK_OUT
+    int nout;           ///< samples per channel
+    int refs;           ///< workers which did not process block yet
+} wb_block_t;
+
+/**
+  Bounded queue of blocks between channelizer (main thread) and decoding
+  workers, block i is stored in blocks[i % WB_NBLOCKS].
+  */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    wb_block_t blocks[WB_NBLOCKS];
+    uint64_t nblocks;   ///< number of published blocks
+    bool eof;
+    channel_t *chs;
+    int nchs;
+    int nworkers;
+} wb_queue_t;
+
+typedef struct {
+    wb_queue_t *queue;
+    int idx;            ///< worker owns channels k % nworkers == idx
+} wb_worker_t;
+
+static void wb_channel_process(channel_t *ch, const float *samples, int n)
+{
+    uint8_t bits[DEMOD_BITS_MAX(WB_BLOCK_OUT)];
+
+    if (ch->failed || (scan_timeout && ch->verdict != SCAN_PENDING)) {
+        return;
+    }
+
+    log_stream = ch->out;
+    const int nbits = demod_process(ch->demod, samples, n, bits);
+    ch->nbits += nbits;
+    for (int pos = 0; !ch->failed && pos < nbits; ) {
+        pos += tetrapol_phys_ch_recv(ch->phys_ch, bits + pos, nbits - pos);
+        ch->failed = tetrapol_phys_ch_process(ch->phys_ch) != 0;
+    }
+    fflush(ch->out);
+    log_stream = NULL;
+
+    if (ch->failed) {
+        fprintf(stderr, "Failed to process channel %s\n", ch->path);
+    }
+    if (scan_timeout) {
+        scan_check(ch, false);
+    }
+    stats_report(ch->phys_ch, ch->path, &ch->stats_next, false);
+    feedback_report(&ch->feedback, ch->phys_ch, ch->demod);
+}
+
+static void *wb_worker(void *arg)
+{
+    wb_worker_t *w = arg;
+    wb_queue_t *queue = w->queue;
+
+    for (uint64_t i = 0; ; ++i) {
+        pthread_mutex_lock(&queue->mutex);
+        while (queue->nblocks == i && !queue->eof) {
+            pthread_cond_wait(&queue->cond, &queue->mutex);
+        }
+        const bool eof = queue->nblocks == i;
+        pthread_mutex_unlock(&queue->mutex);
+        if (eof) {
+            break;
+        }
+
+        wb_block_t *block = &queue->blocks[i % WB_NBLOCKS];
+        for (int k = w->idx; k < queue->nchs; k += queue->nworkers) {
+            wb_channel_process(&queue->chs[k],
+                    block->samples + 2 * k * WB_BLOCK_OUT, block->nout);
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        if (--block->refs == 0) {
+            pthread_cond_broadcast(&queue->cond);
+        }
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    for (int k = w->idx; k < queue->nchs; k += queue->nworkers) {
+        channel_t *ch = &queue->chs[k];
+        if (scan_timeout) {
+            scan_check(ch, true);
+        }
+        stats_report(ch->phys_ch, ch->path, &ch->stats_next, true);
+    }
+
+    return NULL;
+}
+
+/**
+  Process wideband complex baseband input, split it into channels by
+  channelizer and decode all of them.
+
+  Main thread reads and channelizes input into the block queue, channels
+  are demodulated and decoded by pool of workers.
+
+  @param rate Sample rate of input, multiple of 400 kS/s.
+  */
+static int tetrapol_dump_wideband(int fd, int rate, int iq_fmt, int nworkers,
+        int band, int radio_ch_type)
+{
+    int ret = -1;
+    int nworkers_started = 0;
+    const int nchs = rate / WB_CH_SPACING;
+    const int decim = rate / DEMOD_SAMPLE_RATE;
+    // at most WB_BLOCK_OUT samples are produced for this input
+    const int block_in = (WB_BLOCK_OUT - 1) * decim;
+    const int sample_size = (iq_fmt == DEMOD_INPUT_CF32) ?
+        2 * sizeof(float) : 2 * sizeof(int16_t);
+    uint8_t *buf = malloc(block_in * sample_size);
+    pthread_t *workers = calloc(nworkers, sizeof(pthread_t));
+    wb_worker_t *wb_workers = calloc(nworkers, sizeof(wb_worker_t));
+    wb_queue_t queue = {
+        .mutex = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+        .chs = calloc(nchs, sizeof(channel_t)),
+        .nchs = nchs,
+        .nworkers = nworkers,
+    };
+    channelizer_t *chzr = channelizer_create(nchs, decim,
+            (double)WB_CH_CUTOFF / rate, WB_CH_TRANSITION / rate,
+            (iq_fmt == DEMOD_INPUT_CF32) ?
+                CHANNELIZER_INPUT_CF32 : CHANNELIZER_INPUT_CS16,
+            nworkers);
+    if (!buf || !workers || !wb_workers || !queue.chs || !chzr) {
+        goto err_alloc;
+    }
+    for (int i = 0; i < WB_NBLOCKS; ++i) {
+        queue.blocks[i].samples =
+            malloc(2 * nchs * WB_BLOCK_OUT * sizeof(float));
+        if (!queue.blocks[i].samples) {
+            goto err_alloc;
+        }
+    }
+
+    for (int k = 0; k < nchs; ++k) {
+        channel_t *ch = &queue.chs[k];
+        snprintf(ch->name, sizeof(ch->name), "ch%+d",
+                (k > nchs / 2) ? k - nchs : k);
+        ch->path = ch->name;
+        ch->fd = -1;
+        ch->feedback.ch_id = k;
+        ch->demod = demod_create(DEMOD_INPUT_CF32);
+        if (!ch->demod || channel_init_decoder(ch, band, radio_ch_type,
+                    PHYS_CH_INPUT_UNPACKED)) {
+            fprintf(stderr, "Failed to initialize channel %s\n", ch->name);
+            goto err_ch;
+        }
+    }
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK | fcntl(fd, F_GETFL))) {
+        goto err_ch;
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    // SIGINT must interrupt poll in main thread, not the workers
+    sigset_t sigset, sigset_old;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &sigset, &sigset_old);
+    for (; nworkers_started < nworkers; ++nworkers_started) {
+        wb_workers[nworkers_started].queue = &queue;
+        wb_workers[nworkers_started].idx = nworkers_started;
+        if (pthread_create(&workers[nworkers_started], NULL, wb_worker,
+                    &wb_workers[nworkers_started])) {
+            pthread_sigmask(SIG_SETMASK, &sigset_old, NULL);
+            goto err_workers;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &sigset_old, NULL);
+
+    // bytes in buf, reads are not aligned to samples
+    int buf_len = 0;
+    ret = 0;
+    while (!do_exit) {
+        const int rsize = do_read(fd, buf + buf_len,
+                block_in * sample_size - buf_len);
+        if (rsize <= 0) {
+            ret = rsize;
+            break;
+        }
+        buf_len += rsize;
+        const int nsamples = buf_len / sample_size;
+
+        // wait until all workers are done with the oldest block
+        wb_block_t *block = &queue.blocks[queue.nblocks % WB_NBLOCKS];
+        pthread_mutex_lock(&queue.mutex);
+        while (block->refs) {
+            pthread_cond_wait(&queue.cond, &queue.mutex);
+        }
+        pthread_mutex_unlock(&queue.mutex);
+
+        block->nout = channelizer_process(chzr, buf, nsamples,
+                block->samples, WB_BLOCK_OUT);
+        buf_len -= nsamples * sample_size;
+        memmove(buf, buf + nsamples * sample_size, buf_len);
+
+        pthread_mutex_lock(&queue.mutex);
+        block->refs = nworkers;
+        ++queue.nblocks;
+        pthread_cond_broadcast(&queue.cond);
+        pthread_mutex_unlock(&queue.mutex);
+    }
+
+err_workers:
+    pthread_mutex_lock(&queue.mutex);
+    queue.eof = true;
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.mutex);
+    while (nworkers_started) {
+        pthread_join(workers[--nworkers_started], NULL);
+    }
+
+    if (scan_timeout) {
+        scan_print(queue.chs, nchs);
+    }
+
+err_ch:
+    // pending log messages are written into channel outputs
+    log_async_flush();
+    for (int k = 0; k < nchs; ++k) {
+        channel_destroy(&queue.chs[k]);
+    }
+
+err_alloc:
+    for (int i = 0; i < WB_NBLOCKS; ++i) {
+        free(queue.blocks[i].samples);
+    }
+    channelizer_destroy(chzr);
+    free(queue.chs);
+    free(wb_workers);
+    free(workers);
+    free(buf);
+
+    return ret;
+}
+
+
+/**
+  Open UDP socket bound to [HOST:]PORT, HOST might be IPv6 address in [].
+
+  @param peer Socket is connected to HOST:PORT instead.
+  */
+static int udp_open(const char *addr, bool peer)
+{
+    char host[256];
+    const char *port = strrchr(addr, ':');
+    if (port) {
+        int len = port - addr;
+        if (len >= sizeof(host)) {
+            return -1;
+        }
+        if (len >= 2 && addr[0] == '[' && addr[len - 1] == ']') {
+            ++addr;
+            len -= 2;
+        }
+        memcpy(host, addr, len);
+        host[len] = 0;
+        ++port;
+    } else {
+        port = addr;
+    }
+
+    const struct addrinfo hints = {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_DGRAM,
+        .ai_flags = peer ? 0 : AI_PASSIVE,
+    };
+    struct addrinfo *res;
+    const int err = getaddrinfo(port != addr ? host : NULL, port, &hints, &res);
+    if (err) {
+        fprintf(stderr, "Invalid address %s: %s\n", addr, gai_strerror(err));
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1) {
+            continue;
+        }
+        const int err = peer ? connect(fd, ai->ai_addr, ai->ai_addrlen) :
+            bind(fd, ai->ai_addr, ai->ai_addrlen);
+        if (!err) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd == -1) {
+        perror(peer ? "Failed to connect UDP socket" :
+                "Failed to bind UDP socket");
+    }
+
+    return fd;
+}
+
+/**
+  Pass payload of datagram into channel decoder, input discontinuity
+  detected by sequence number forces resync of frame synchronization.
+  */
+static void udp_channel_process(channel_t *ch, const ingest_hdr_t *hdr,
+        uint8_t *payload)
+{
+    const int64_t lost = ingest_seq_check(&ch->seq, hdr->seq);
+    if (ch->failed || lost < 0) {
+        return;
+    }
+
+    log_stream = ch->out;
+    if (lost) {
+        LOG(INFO, "%" PRId64 " datagrams lost, resync", lost);
+        tetrapol_phys_ch_resync(ch->phys_ch);
+    }
+    ch->nbits += (tetrapol_phys_ch_get_input_fmt(ch->phys_ch) ==
+            PHYS_CH_INPUT_PACKED) ? 8 * hdr->len : hdr->len;
+    // nodes without clock send zero timestamp
+    if (hdr->timestamp) {
+        tetrapol_phys_ch_set_time(ch->phys_ch, hdr->timestamp / 1000);
+    }
+    for (int pos = 0; !ch->failed && pos < hdr->len; ) {
+        pos += tetrapol_phys_ch_recv(ch->phys_ch, payload + pos, hdr->len - pos);
+        ch->failed = tetrapol_phys_ch_process(ch->phys_ch) != 0;
+    }
+    fflush(ch->out);
+    log_stream = NULL;
+
+    if (ch->failed) {
+        fprintf(stderr, "Failed to process channel %s\n", ch->path);
+    }
+    stats_report(ch->phys_ch, ch->path, &ch->stats_next, false);
+    feedback_report(&ch->feedback, ch->phys_ch, NULL);
+}
+
+/**
+  Receive bit streams from remote SDR nodes over UDP, datagrams are framed
+  as described in tetrapol/ingest.h. Each channel id gets its own decoder
+  (up to MAX_INPUTS), channel ids must be unique among all nodes sending
+  to this address. Output lines are prefixed by [udp:CH_ID].
+  */
+static int tetrapol_dump_udp(const char *addr, int band, int radio_ch_type,
+        int input_fmt)
+{
+    int ret = -1;
+    int nchs = 0;
+    uint64_t ninvalid = 0;
+    const int fd = udp_open(addr, false);
+    if (fd == -1) {
+        return -1;
+    }
+
+    channel_t *chs = calloc(MAX_INPUTS, sizeof(channel_t));
+    channel_t **by_id = calloc(UINT16_MAX + 1, sizeof(channel_t *));
+    uint8_t (*bufs)[INGEST_HDR_LEN + INGEST_PAYLOAD_MAX] =
+        malloc(UDP_BATCH * sizeof(*bufs));
+    if (!chs || !by_id || !bufs) {
+        goto err_alloc;
+    }
+
+    struct iovec iovs[UDP_BATCH];
+    struct mmsghdr msgs[UDP_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < UDP_BATCH; ++i) {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = sizeof(bufs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    signal(SIGINT, sigint_handler);
+
+    ret = 0;
+    while (!ret && !do_exit) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN, };
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            ret = -1;
+            break;
+        }
+
+        const int n = recvmmsg(fd, msgs, UDP_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            perror("recvmmsg");
+            ret = -1;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            ingest_hdr_t hdr;
+            if (ingest_hdr_parse(&hdr, bufs[i], msgs[i].msg_len)) {
+                if (!ninvalid++) {
+                    fprintf(stderr, "Invalid datagram dropped\n");
+                }
+                continue;
+            }
+
+            channel_t *ch = by_id[hdr.ch_id];
+            if (!ch) {
+                if (nchs == MAX_INPUTS) {
+                    continue;
+                }
+                ch = &chs[nchs++];
+                snprintf(ch->name, sizeof(ch->name), "udp:%u", hdr.ch_id);
+                ch->path = ch->name;
+                ch->fd = -1;
+                ch->feedback.ch_id = hdr.ch_id;
+                if (channel_init_decoder(ch, band, radio_ch_type, input_fmt)) {
+                    fprintf(stderr, "Failed to create channel %s\n", ch->path);
+                    ret = -1;
+                    break;
+                }
+                by_id[hdr.ch_id] = ch;
+                fprintf(stderr, "New channel %s\n", ch->path);
+            }
+
+            udp_channel_process(ch, &hdr, &bufs[i][INGEST_HDR_LEN]);
+        }
+    }
+
+    if (ninvalid) {
+        fprintf(stderr, "%" PRIu64 " invalid datagrams dropped\n", ninvalid);
+    }
+    for (int i = 0; i < nchs; ++i) {
+        if (chs[i].phys_ch) {
+            stats_report(chs[i].phys_ch, chs[i].path, &chs[i].stats_next, true);
+        }
+        channel_destroy(&chs[i]);
     }
 
+err_alloc:
+    free(bufs);
+    free(by_id);
+    free(chs);
+    close(fd);
+
     return ret;
 }
 
@@ -79,22 +2163,314 @@ int main(int argc, char* argv[])
 {
     // TODO: move to config
     const int band = TETRAPOL_BAND_UHF;
-    const int radio_ch_type = RADIO_CH_TYPE_CONTROL;
+    int radio_ch_type = RADIO_CH_TYPE_CONTROL;
 
     const char *in = NULL;
+    const char *ins[MAX_INPUTS];
+    int nins = 0;
+    int nworkers = NWORKERS_DEFAULT;
+    int input_fmt = PHYS_CH_INPUT_UNPACKED;
+    bool replay = false;
+    bool par_replay = false;
+    bool combine = false;
+    bool log_async = false;
+    bool events = false;
+    int iq_fmt = -1;
+    int wb_rate = 0;
+    const char *udp_addr = NULL;
+    const char *feedback_addr = NULL;
+    const char *ring_name = NULL;
 
     int opt;
-    while ((opt = getopt(argc, argv, "i:")) != -1) {
+    while ((opt = getopt(argc, argv, "aAbc:C:dDf:F:i:j:m:Mpq:rRs:S:tu:w:x:")) != -1) {
         switch (opt) {
+            case 'c':
+                scan_timeout = atoi(optarg);
+                if (scan_timeout < 1) {
+                    nins = -1;
+                }
+                break;
+            case 'C':
+                cell_cache_path = optarg;
+                break;
+            case 'a':
+                log_async = true;
+                break;
+            case 'A':
+                afc = true;
+                break;
+            case 'b':
+                events = true;
+                break;
+            case 'd':
+                dup_suppress = true;
+                dup_notify = true;
+                break;
+            case 'D':
+                dup_suppress = true;
+                break;
+
+            case 'f':
+                if (parse_codops(&codops, optarg)) {
+                    nins = -1;
+                }
+                codops_set = true;
+                break;
+            case 'F':
+                feedback_addr = optarg;
+                break;
             case 'i':
-                in = optarg;
+                if (nins < MAX_INPUTS) {
+                    ins[nins] = optarg;
+                }
+                ++nins;
+                break;
+            case 'j':
+                nworkers = atoi(optarg);
+                break;
+            case 'm':
+                ring_name = optarg;
+                break;
+            case 'M':
+                combine = true;
+                break;
+            case 'p':
+                input_fmt = PHYS_CH_INPUT_PACKED;
+                break;
+            case 'q':
+                if (!strcmp(optarg, "cf32")) {
+                    iq_fmt = DEMOD_INPUT_CF32;
+                } else if (!strcmp(optarg, "cs16")) {
+                    iq_fmt = DEMOD_INPUT_CS16;
+                } else {
+                    nins = -1;
+                }
+                break;
+            case 'r':
+                replay = true;
+                break;
+            case 'R':
+                par_replay = true;
+                break;
+            case 's':
+                stats_interval = atoi(optarg);
+                break;
+            case 'S':
+                stats_path = optarg;
+                break;
+            case 't':
+                radio_ch_type = RADIO_CH_TYPE_TRAFFIC;
+                break;
+            case 'u':
+                udp_addr = optarg;
+                break;
+            case 'x':
+                net_index_path = optarg;
+                break;
+            case 'w':
+                wb_rate = atoi(optarg);
+                if (wb_rate < 1 || wb_rate % (32 * WB_CH_SPACING) ||
+                        wb_rate % DEMOD_SAMPLE_RATE) {
+                    nins = -1;
+                }
                 break;
             default:
-                fprintf(stderr, "Usage: %s [-i IN_FILE_PATH]\n", argv[0]);
-                exit(EXIT_FAILURE);
+                nins = -1;
                 break;
         }
     }
+    for (; optind < argc && nins >= 0; ++optind) {
+        if (nins < MAX_INPUTS) {
+            ins[nins] = argv[optind];
+        }
+        ++nins;
+    }
+
+    if (stats_path && !stats_interval) {
+        stats_interval = STATS_INTERVAL_DEFAULT;
+    }
+
+    if (nins < 0 || nins > MAX_INPUTS || nworkers < 1 || stats_interval < 0 ||
+            ((replay || events || stats_path || ring_name || net_index_path ||
+              iq_fmt >= 0) && nins > 1) ||
+            ((ring_name || net_index_path) &&
+             (scan_timeout || wb_rate || udp_addr || par_replay)) ||
+            (par_replay && (nins != 1 || !strcmp(ins[0], "-") || replay ||
+                            iq_fmt >= 0 || scan_timeout || stats_interval ||
+                            ring_name || log_async || cell_cache_path ||
+                            udp_addr || dup_notify)) ||
+            (iq_fmt >= 0 && (replay || (scan_timeout && !wb_rate) ||
+                             input_fmt == PHYS_CH_INPUT_PACKED)) ||
+            (scan_timeout && (replay || events ||
+                              radio_ch_type != RADIO_CH_TYPE_CONTROL)) ||
+            (wb_rate && (iq_fmt < 0 || events || stats_path)) ||
+            (udp_addr && (nins || iq_fmt >= 0 || replay || events ||
+                          stats_path || scan_timeout)) ||
+            (combine && (nins < 2 || nins > COMBINER_RX_MAX || par_replay ||
+                         iq_fmt >= 0 || wb_rate || udp_addr || scan_timeout ||
+                         cell_cache_path)) ||
+            (feedback_addr && (replay || par_replay || combine ||
+                               ((nins > 1 || scan_timeout) && !wb_rate))) ||
+            (afc && iq_fmt < 0)) {
+        fprintf(stderr, "Usage: %s [-a] [-A] [-b] [-c SEC] [-C CACHE_PATH] [-d|-D] [-f CODOPS] [-F HOST:PORT] [-m SHM_NAME] [-M] [-p] [-q IQ_FMT] [-w RATE] [-r] [-R] [-t] [-u [HOST:]PORT] [-x INDEX_PATH] [-s SEC] [-S PROM_PATH] [-j NWORKERS] [-i IN_FILE_PATH]... [IN_FILE_PATH]...\n"
+                "\t-a write log from background thread, decoding is not\n"
+                "\t   blocked by slow output, messages might be dropped\n"
+                "\t-A correct frequency offset of IQ input (-q), offset is\n"
+                "\t   measured by demodulator while decoder is in frame sync\n"
+                "\t-b write binary event stream (see tetrapol/event.h) to\n"
+                "\t   stdout instead of text, log goes to stderr\n"
+                "\t-c scan inputs for control channels, only BCH is decoded and\n"
+                "\t   each input is stopped when identified (control, traffic,\n"
+                "\t   no_signal) or after SEC seconds of signal (timeout),\n"
+                "\t   summary table is printed at the end\n"
+                "\t-C load SCR and cell configuration of inputs from cache\n"
+                "\t   file for faster start, cache is updated at exit\n"
+                "\t-d skip decoding of BCH, PCH and RCH messages repeating\n"
+                "\t   recently decoded ones, only 'unchanged' line is printed\n"
+                "\t-D as -d, but repeated messages are skipped silently\n"
+                "\t-f decode only TSDUs with codops from comma separated list\n"
+                "\t   (e.g. 0x92,0x45), other TSDUs are skipped undecoded\n"
+                "\t-F send signal quality, frequency offset and power of\n"
+                "\t   channels to HOST:PORT every %d ms, UDP datagrams (see\n"
+                "\t   tetrapol/ingest.h) are tagged by channel id (UDP input),\n"
+                "\t   channel index (wideband input) or 0, e.g. for receiver\n"
+                "\t   calibration\n"
+                "\t-m publish binary events (as -b) into lock-free ring in\n"
+                "\t   POSIX shared memory SHM_NAME (e.g. /tetrapol), see\n"
+                "\t   tetrapol/event_ring.h, slow readers never block decoder\n"
+                "\t-M inputs (2 to %d) are receivers of the same channel, the\n"
+                "\t   best copy of each frame is selected and decoded once,\n"
+                "\t   output lines are not prefixed\n"
+                "\t-p input bits are packed (8 per byte, MSB first)\n"
+                "\t-q input is complex baseband (single input) at 16 kS/s,\n"
+                "\t   IQ_FMT is cf32 (float) or cs16 (int16_t), GMSK\n"
+                "\t   demodulation is done by decoder\n"
+                "\t-w input (-q) is wideband at RATE S/s (multiple of 400000),\n"
+                "\t   all 12.5 kHz channels are decoded by NWORKERS threads,\n"
+                "\t   channel k is at k * 12.5 kHz from center, output lines\n"
+                "\t   are prefixed by [ch+k], -c scans all channels\n"
+                "\t-r replay single capture file as fast as possible, report speed\n"
+                "\t-R replay single capture file by NWORKERS threads, capture\n"
+                "\t   is decoded in overlapping chunks, output is merged in order\n"
+                "\t-s print decoder statistics to stderr every SEC seconds\n"
+                "\t   and at the end of input, fields of logical channels are\n"
+                "\t   msgs/crc_errs/parity_fixes/parity_errs/seq_errs/fcs_errs/tsdu_errs/dups\n"
+                "\t-S write statistics into Prometheus text file (single input),\n"
+                "\t   e.g. for node_exporter textfile collector (default -s %d)\n"
+                "\t-t input is traffic channel, voice frames are written\n"
+                "\t   as soon as they are decoded\n"
+                "\t-u receive bit streams of many channels from the network,\n"
+                "\t   UDP datagrams with header (see tetrapol/ingest.h) at\n"
+                "\t   [HOST:]PORT, output lines are prefixed by [udp:CH_ID]\n"
+                "\t-x index cells, groups and active calls from decoded TSDUs\n"
+                "\t   (single input), index is written into INDEX_PATH as text\n"
+                "\t   with each statistics report and at exit\n"
+                "\t-j number of worker threads for multiple inputs (default %d)\n"
+                "\tMore inputs (up to %d) are decoded in parallel, output lines\n"
+                "\tare prefixed by [IN_FILE_PATH].\n",
+                argv[0], FEEDBACK_INTERVAL_MS, COMBINER_RX_MAX,
+                STATS_INTERVAL_DEFAULT,
+                NWORKERS_DEFAULT, MAX_INPUTS);
+        exit(EXIT_FAILURE);
+    }
+
+    if (log_async && log_async_start()) {
+        fprintf(stderr, "Failed to start logging thread.\n");
+        return -1;
+    }
+
+    if (scan_timeout) {
+        // only the summary table goes to stdout
+        log_set_lvl(ERR);
+    }
+
+    if (feedback_addr) {
+        feedback_fd = udp_open(feedback_addr, true);
+        if (feedback_fd == -1) {
+            return -1;
+        }
+    }
+
+    if (cell_cache_path) {
+        cell_cache = cell_cache_load(cell_cache_path);
+        if (!cell_cache) {
+            fprintf(stderr, "Failed to load cache %s\n", cell_cache_path);
+            return -1;
+        }
+    }
+
+    if (udp_addr) {
+        const int ret = tetrapol_dump_udp(udp_addr, band, radio_ch_type,
+                input_fmt);
+        cell_cache_close();
+        log_async_stop();
+        fprintf(stderr, "Exiting.\n");
+
+        return ret;
+    }
+
+    if (par_replay) {
+        const int infd = open(ins[0], O_RDONLY);
+        if (infd == -1) {
+            perror("Failed to open input file");
+            return -1;
+        }
+        if (events) {
+            // text output of TSDUs is not required
+            log_set_lvl(ERR);
+        }
+        const int ret = tetrapol_dump_parallel(infd, nworkers, band,
+                radio_ch_type, input_fmt, events);
+        close(infd);
+        fprintf(stderr, "Exiting.\n");
+
+        return ret;
+    }
+
+    if (wb_rate) {
+        in = nins ? ins[0] : NULL;
+        int infd = STDIN_FILENO;
+        if (in && strcmp(in, "-")) {
+            infd = open(in, O_RDONLY);
+            if (infd == -1) {
+                perror("Failed to open input file");
+                return -1;
+            }
+        }
+        const int ret = tetrapol_dump_wideband(infd, wb_rate, iq_fmt, nworkers,
+                band, radio_ch_type);
+        if (infd != STDIN_FILENO) {
+            close(infd);
+        }
+        cell_cache_close();
+        log_async_stop();
+        fprintf(stderr, "Exiting.\n");
+
+        return ret;
+    }
+
+    if (combine) {
+        const int ret = tetrapol_dump_combined(ins, nins, band, radio_ch_type,
+                input_fmt);
+        log_async_stop();
+        fprintf(stderr, "Exiting.\n");
+
+        return ret;
+    }
+
+    if (nins > 1 || scan_timeout) {
+        if (!nins) {
+            ins[nins++] = "-";
+        }
+        const int ret = tetrapol_dump_multi(ins, nins, nworkers,
+                band, radio_ch_type, input_fmt);
+        cell_cache_close();
+        log_async_stop();
+        fprintf(stderr, "Exiting.\n");
+
+        return ret;
+    }
+    in = nins ? ins[0] : NULL;
 
     int infd = STDIN_FILENO;
     if (in && strcmp(in, "-")) {
@@ -110,12 +2486,74 @@ int main(int argc, char* argv[])
         fprintf(stderr, "Failed to initialize TETRAPOL instance.");
         return -1;
     }
+    tetrapol_phys_ch_set_input_fmt(phys_ch, input_fmt);
+    phys_ch_set_sinks(phys_ch, NULL);
+    phys_ch_subscribe(phys_ch);
+    const char *label = in ? in : "-";
+    cell_cache_entry_t *cache = phys_ch_warm_start(phys_ch, label);
+
+    if (net_index_path) {
+        net_index = net_index_create();
+        if (!net_index) {
+            fprintf(stderr, "Failed to create network index\n");
+            return -1;
+        }
+    }
+
+    if (ring_name) {
+        event_ring = event_ring_create(ring_name, EVENT_RING_SIZE);
+        if (!event_ring) {
+            fprintf(stderr, "Failed to create event ring %s\n", ring_name);
+            return -1;
+        }
+    }
+
+    event_writer_t *ew = NULL;
+    if (events) {
+        ew = event_writer_create(STDOUT_FILENO);
+        if (!ew) {
+            fprintf(stderr, "Failed to create event writer.\n");
+            return -1;
+        }
+        phys_ch_set_sinks(phys_ch, ew);
+        // text output of TSDUs is not required anymore
+        log_stream = stderr;
+        log_set_lvl(ERR);
+    }
+
+    demod_t *demod = NULL;
+    if (iq_fmt >= 0) {
+        demod = demod_create(iq_fmt);
+        if (!demod) {
+            fprintf(stderr, "Failed to create demodulator.\n");
+            return -1;
+        }
+    }
 
-    const int ret = tetrapol_dump_loop(phys_ch, infd);
+    int ret;
+    if (replay) {
+        ret = tetrapol_dump_replay(phys_ch, infd, input_fmt, label);
+    } else if (demod) {
+        ret = tetrapol_dump_iq(phys_ch, infd, demod, ew, label);
+    } else {
+        ret = tetrapol_dump_loop(phys_ch, infd, ew, label);
+    }
+    demod_destroy(demod);
+    time_t stats_next;
+    stats_report(phys_ch, label, &stats_next, true);
+    event_writer_destroy(ew);
+    event_ring_destroy(event_ring);
+    if (net_index) {
+        net_index_write(net_index, net_index_path);
+        net_index_destroy(net_index);
+    }
+    cache_store_scr(cache, phys_ch);
     tetrapol_phys_ch_destroy(phys_ch);
     if (infd != STDIN_FILENO) {
         close(infd);
     }
+    cell_cache_close();
+    log_async_stop();
 
     fprintf(stderr, "Exiting.\n");
 
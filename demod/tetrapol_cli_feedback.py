@@ -0,0 +1,62 @@
+#!/usr/bin/python3
+
+"""Receive feedback of tetrapol_dump -F, print it and optionally correct
+oscillator of receiver by frequency offset measured in channels.
+
+Usage: tetrapol_cli_feedback.py [-c] [[HOST:]PORT]
+    -c  set ppm of receiver (tetrapol_rx.py) by average offset of channels"""
+
+from xmlrpc import client
+import socket
+import struct
+import sys
+
+# fraction of offset corrected by single step
+GAIN = 0.5
+# min. number of reports from each channel between corrections
+REPORTS = 10
+
+INGEST_FEEDBACK_SYNC = 0x01
+INGEST_FEEDBACK_FREQ = 0x02
+INGEST_FEEDBACK_POWER = 0x04
+
+args = sys.argv[1:]
+calibrate = '-c' in args
+if calibrate:
+    args.remove('-c')
+host, _, port = (args[0] if args else '5600').rpartition(':')
+
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.bind((host or '0.0.0.0', int(port)))
+c = client.Server("http://localhost:60100") if calibrate else None
+
+offsets = {}
+while True:
+    buf = s.recv(64)
+    if len(buf) != 32:
+        continue
+    magic, ver, flags, ch_id, _, seq, ts, sync_errs, nerrs, crc_errs, pwr, \
+        freq = struct.unpack('>HBBHHIqHHHhi', buf)
+    if magic != 0x5446 or ver != 1:
+        continue
+    line = "ch %u seq %u sync_errs %.3f nerrs %.3f crc_errs %.4f" % (
+            ch_id, seq, sync_errs / 1000., nerrs / 1000., crc_errs / 10000.)
+    if flags & INGEST_FEEDBACK_POWER:
+        line += " pwr %.2f dB" % (pwr / 100., )
+    if flags & INGEST_FEEDBACK_FREQ:
+        line += " offset %.1f Hz" % (freq / 1000., )
+    print(line)
+
+    if not c:
+        continue
+    if not (flags & INGEST_FEEDBACK_FREQ) or crc_errs >= 5000:
+        offsets.pop(ch_id, None)
+        continue
+    offsets.setdefault(ch_id, []).append(freq / 1000.)
+    if min(len(o) for o in offsets.values()) < REPORTS:
+        continue
+    offset = sum(sum(o) / len(o) for o in offsets.values()) / len(offsets)
+    ppm = c.get_ppm() - GAIN * offset / c.get_freq() * 1e6
+    print("offset %.1f Hz, ppm %.3f" % (offset, ppm))
+    c.set_ppm(ppm)
+    offsets = {}
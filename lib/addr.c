@@ -1,8 +1,17 @@
 #include <tetrapol/addr.h>
+#include <tetrapol/log.h>
 
 #include <stdio.h>
 
+// emit external definitions of inline functions from addr.h
+extern inline bool addr_is_cgi_all_st(const addr_t *addr, bool z);
+extern inline bool addr_is_tti_all_st(const addr_t *addr, bool z);
+extern inline bool addr_is_tti_no_st(const addr_t *addr, bool z);
+extern inline bool addr_is_coi_all_st(const addr_t *addr);
+extern inline void addr_parse(addr_t *addr, const uint8_t *buf, int skip);
+extern inline void addr_read(addr_t *addr, bit_reader_t *br);
+
 void addr_print(const addr_t *addr)
 {
-    printf("ADDR=%d.%d.0x%03x", addr->z, addr->y, addr->x);
+    log_printf("ADDR=%d.%d.0x%03x", addr->z, addr->y, addr->x);
 }
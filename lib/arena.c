@@ -0,0 +1,152 @@
+#define LOG_PREFIX "arena"
+#include <tetrapol/log.h>
+#include <tetrapol/arena.h>
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN_UP(x) \
+    (((x) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+// precedes each allocation
+typedef union {
+    size_t size;
+    max_align_t _align;
+} alloc_hdr_t;
+
+typedef struct _arena_block_t arena_block_t;
+struct _arena_block_t {
+    arena_block_t *next;
+    size_t size;    ///< usable size of block
+    size_t used;
+    max_align_t data[];
+};
+
+struct _arena_t {
+    arena_block_t *blocks;  ///< first block is allocated together with arena
+    arena_block_t *block;   ///< block used for allocations
+    alloc_hdr_t *last;      ///< last allocation, might be resized in place
+    size_t block_size;
+};
+
+arena_t *arena_create(size_t block_size)
+{
+    block_size = ALIGN_UP(block_size);
+    arena_t *arena = malloc(ALIGN_UP(sizeof(arena_t)) +
+            sizeof(arena_block_t) + block_size);
+    if (!arena) {
+        return NULL;
+    }
+
+    arena->blocks = (arena_block_t *)((char *)arena + ALIGN_UP(sizeof(arena_t)));
+    arena->blocks->next = NULL;
+    arena->blocks->size = block_size;
+    arena->block_size = block_size;
+    arena_reset(arena);
+
+    return arena;
+}
+
+void arena_destroy(arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    arena_block_t *block = arena->blocks->next;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void arena_reset(arena_t *arena)
+{
+    for (arena_block_t *block = arena->blocks; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->block = arena->blocks;
+    arena->last = NULL;
+}
+
+size_t arena_mem_size(const arena_t *arena)
+{
+    size_t size = ALIGN_UP(sizeof(arena_t));
+    for (const arena_block_t *block = arena->blocks; block; block = block->next) {
+        size += sizeof(arena_block_t) + block->size;
+    }
+
+    return size;
+}
+
+size_t arena_alloc_space(size_t size)
+{
+    return sizeof(alloc_hdr_t) + ALIGN_UP(size);
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    const size_t space = arena_alloc_space(size);
+
+    arena_block_t *block = arena->block;
+    while (block->used + space > block->size) {
+        if (!block->next) {
+            const size_t block_size = (space > arena->block_size) ?
+                space : arena->block_size;
+            arena_block_t *p = malloc(sizeof(arena_block_t) + block_size);
+            if (!p) {
+                LOG(ERR, "ERR OOM");
+                return NULL;
+            }
+            p->next = NULL;
+            p->size = block_size;
+            p->used = 0;
+            block->next = p;
+        }
+        block = block->next;
+    }
+
+    alloc_hdr_t *hdr = (alloc_hdr_t *)((char *)block->data + block->used);
+    hdr->size = size;
+    block->used += space;
+    arena->block = block;
+    arena->last = hdr;
+
+    return hdr + 1;
+}
+
+void *arena_realloc(arena_t *arena, void *ptr, size_t size)
+{
+    if (!ptr) {
+        return arena_alloc(arena, size);
+    }
+
+    alloc_hdr_t *hdr = (alloc_hdr_t *)ptr - 1;
+    if (hdr == arena->last) {
+        arena_block_t *block = arena->block;
+        const size_t used = block->used - arena_alloc_space(hdr->size);
+        if (used + arena_alloc_space(size) <= block->size) {
+            block->used = used + arena_alloc_space(size);
+            hdr->size = size;
+            return ptr;
+        }
+    }
+
+    void *p = arena_alloc(arena, size);
+    if (!p) {
+        return NULL;
+    }
+    memcpy(p, ptr, (hdr->size < size) ? hdr->size : size);
+
+    return p;
+}
+
+size_t arena_alloc_size(const void *ptr)
+{
+    return ((const alloc_hdr_t *)ptr - 1)->size;
+}
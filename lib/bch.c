@@ -2,6 +2,7 @@
 #include <tetrapol/log.h>
 #include <tetrapol/bch.h>
 #include <tetrapol/data_frame.h>
+#include <tetrapol/dup_cache.h>
 #include <tetrapol/hdlc_frame.h>
 #include <tetrapol/misc.h>
 #include <tetrapol/tpdu.h>
@@ -17,53 +18,113 @@ struct _bch_t {
     data_frame_t *data_fr;
     tpdu_ui_t *tpdu;
     tsdu_d_system_info_t *tsdu;
+    log_ch_stats_t stats;   ///< data_fr and TPDU counters are added on read
+    bool dup_suppress;
+    dup_cache_t dup;        ///< tag is cell_state.bch
+    int repeats;
 };
 
+size_t bch_sizeof(void)
+{
+    return MEM_ALIGN_UP(sizeof(bch_t)) + MEM_ALIGN_UP(data_frame_sizeof()) +
+        tpdu_ui_sizeof();
+}
+
 bch_t *bch_create(void)
 {
-    bch_t *bch = malloc(sizeof(bch_t));
+    bch_t *bch = malloc(bch_sizeof());
     if (!bch) {
         return NULL;
     }
+    bch_init(bch);
 
-    bch->data_fr = data_frame_create();
-    if (!bch->data_fr) {
-        free(bch);
-        return NULL;
-    }
+    return bch;
+}
 
-    bch->tpdu = tpdu_ui_create(FRAME_TYPE_DATA);
-    if (!bch->tpdu) {
-        free(bch);
-        data_frame_destroy(bch->data_fr);
-        return NULL;
-    }
+void bch_init(bch_t *bch)
+{
+    char *p = (char *)bch + MEM_ALIGN_UP(sizeof(bch_t));
+    bch->data_fr = (data_frame_t *)p;
+    data_frame_init(bch->data_fr);
+    p += MEM_ALIGN_UP(data_frame_sizeof());
+    bch->tpdu = (tpdu_ui_t *)p;
+    tpdu_ui_init(bch->tpdu, FRAME_TYPE_DATA);
 
     bch->tsdu = NULL;
+    memset(&bch->stats, 0, sizeof(bch->stats));
+    bch->dup_suppress = false;
+    dup_cache_init(&bch->dup);
+    bch->repeats = 0;
+}
 
-    return bch;
+void bch_fini(bch_t *bch)
+{
+    tpdu_ui_hibernate(bch->tpdu);
 }
 
 void bch_destroy(bch_t *bch)
 {
-    tsdu_destroy(&bch->tsdu->base);
-    data_frame_destroy(bch->data_fr);
-    tpdu_ui_destroy(bch->tpdu);
+    bch_fini(bch);
     free(bch);
 }
 
+void bch_hibernate(bch_t *bch)
+{
+    data_frame_reset(bch->data_fr);
+    tpdu_ui_hibernate(bch->tpdu);
+    bch->tsdu = NULL;
+}
+
+size_t bch_get_heap_size(const bch_t *bch)
+{
+    return tpdu_ui_get_heap_size(bch->tpdu);
+}
+
+void bch_set_dup_suppress(bch_t *bch, bool suppress)
+{
+    bch->dup_suppress = suppress;
+}
+
+/// Set frame number from superframe half (cell_state.bch), check skew.
+static void bch_set_frame_no(data_block_t *data_blk, int cell_state_bch,
+        int nblocks)
+{
+    const int frame_no = 100 * cell_state_bch + nblocks - 1;
+    if (data_blk->frame_no != FRAME_NO_UNKNOWN &&
+            frame_no != data_blk->frame_no) {
+        LOG(ERR, "Frame skew detected %d to %d\n",
+                data_blk->frame_no, frame_no);
+    }
+    data_blk->frame_no = frame_no;
+}
+
 bool bch_push_data_block(bch_t *bch, data_block_t* data_blk)
 {
     if (!data_frame_push_data_block(bch->data_fr, data_blk)) {
         return false;
     }
 
-    uint8_t tpdu_data[SYS_PAR_N200_BYTES_MAX];
+    const uint8_t *tpdu_data;
     const int nblocks = data_frame_blocks(bch->data_fr);
-    const int size = data_frame_get_bytes(bch->data_fr, tpdu_data);
+    const int size = data_frame_get_bytes(bch->data_fr, &tpdu_data);
+
+    bch->repeats = 0;
+    if (bch->dup_suppress) {
+        const dup_cache_entry_t *e = dup_cache_lookup(&bch->dup, tpdu_data,
+                size / 8);
+        if (e) {
+            bch->tsdu = NULL;
+            bch->repeats = e->repeats;
+            bch_set_frame_no(data_blk, e->tag, nblocks);
+            ++bch->stats.dups;
+
+            return true;
+        }
+    }
 
     hdlc_frame_t hdlc_fr;
     if (!hdlc_frame_parse(&hdlc_fr, tpdu_data, size)) {
+        ++bch->stats.fcs_errs;
         return false;
     }
 
@@ -76,12 +137,14 @@ bool bch_push_data_block(bch_t *bch, data_block_t* data_blk)
             IF_LOG(DBG) {
                 LOG_("invalid address for BCH");
                 addr_print(&hdlc_fr.addr);
-                printf("\n");
+                log_printf("\n");
             }
         }
         return false;
     }
 
+    // previous TSDU is released by decoding of the new one
+    bch->tsdu = NULL;
     if (!tpdu_ui_push_hdlc_frame2(bch->tpdu, &hdlc_fr)) {
         return false;
     }
@@ -89,21 +152,17 @@ bool bch_push_data_block(bch_t *bch, data_block_t* data_blk)
     tsdu_t *tsdu = tpdu_ui_get_tsdu(bch->tpdu);
     if (tsdu->codop != D_SYSTEM_INFO) {
         LOG(DBG, "Invalid codop for BCH 0x%02x", tsdu->codop);
-        tsdu_destroy(tsdu);
+        ++bch->stats.tsdu_errs;
 
         return false;
     }
 
-    tsdu_destroy(&bch->tsdu->base);
     bch->tsdu = (tsdu_d_system_info_t *)tsdu;
-
-    const int frame_no = 100 * bch->tsdu->cell_state.bch + nblocks - 1;
-    if (data_blk->frame_no != FRAME_NO_UNKNOWN &&
-            frame_no != data_blk->frame_no) {
-        LOG(ERR, "Frame skew detected %d to %d\n",
-                data_blk->frame_no, frame_no);
+    bch_set_frame_no(data_blk, bch->tsdu->cell_state.bch, nblocks);
+    if (bch->dup_suppress) {
+        dup_cache_insert(&bch->dup, bch->tsdu->cell_state.bch);
     }
-    data_blk->frame_no = frame_no;
+    ++bch->stats.msgs;
 
     return true;
 }
@@ -115,3 +174,15 @@ tsdu_d_system_info_t *bch_get_tsdu(bch_t *bch)
 
     return tsdu;
 }
+
+int bch_get_repeats(const bch_t *bch)
+{
+    return bch->repeats;
+}
+
+void bch_get_stats(const bch_t *bch, log_ch_stats_t *stats)
+{
+    memcpy(stats, &bch->stats, sizeof(*stats));
+    data_frame_get_stats(bch->data_fr, &stats->data_fr);
+    stats->tsdu_errs += tpdu_ui_get_tsdu_errs(bch->tpdu);
+}
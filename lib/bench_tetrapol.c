@@ -0,0 +1,310 @@
+// Microbenchmark of decoder stages, static functions are benchmarked too.
+#include "phys_ch.c"
+#include "frame_enc.c"
+
+#include <tetrapol/arena.h>
+#include <tetrapol/bit_utils.h>
+#include <tetrapol/data_frame.h>
+#include <tetrapol/demod.h>
+#include <tetrapol/hdlc_frame.h>
+
+#include <time.h>
+
+// number of distinct synthetic frames, stages iterate over them
+#define NFRAMES 1024
+// minimal time spent by each stage
+#define MIN_TIME_NS 200000000LL
+// number of complex samples for single frame at demodulator input
+#define FRAME_SAMPLES (FRAME_LEN * DEMOD_SAMPLES_PER_SYMBOL)
+// number of distinct frames of demodulator input
+#define NIQ_FRAMES 16
+
+static struct {
+    phys_ch_t *phys_ch;
+    frame_t frames[NFRAMES];        ///< raw frames (output of copy_frame)
+    uint8_t frames_dec[NFRAMES][FRAME_DATA_LEN];  ///< deinterleaved frames
+    data_block_t data_blks[NFRAMES];
+    batch_t bt;
+    data_frame_t *data_fr;
+    arena_t *arena;
+    uint8_t hdlc[3 + 17 + 2];       ///< HDLC frame with D_SYSTEM_INFO
+    demod_t *demod;
+    float iq[NIQ_FRAMES][2 * FRAME_SAMPLES];    ///< MSK modulated noise
+    uint8_t demod_bits[DEMOD_BITS_MAX(FRAME_SAMPLES)];
+} b;
+
+// results are stored here, so the compiler cannot drop benchmarked code
+static volatile int sink;
+
+// C11 timespec_get(), POSIX clock_gettime() requires POSIX timer_t which
+// conflicts with timer_t from tetrapol/timer.h
+static long long now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void bench_find_frame_sync(int i)
+{
+    b.phys_ch->data_begin = DATA_OFFS;
+    sink = find_frame_sync(b.phys_ch);
+}
+
+// input has no frame sync, all hypotheses are scored
+static void bench_track_frame_sync(int i)
+{
+    b.phys_ch->data_begin = DATA_OFFS + TRACK_OFFS + i % FRAME_LEN;
+    sink = track_frame_sync(b.phys_ch);
+}
+
+// all 128 candidates
+static void bench_detect_scr(int i)
+{
+    b.phys_ch->scr_search = PHYS_CH_SCR_SEARCH_EXHAUSTIVE;
+    detect_scr(b.phys_ch, &b.frames[i]);
+    sink = b.phys_ch->scr_guess;
+}
+
+// single candidate left after pruning
+static void bench_detect_scr_pruned(int i)
+{
+    const scr_lanes_t cand = { 1ULL << 7, 0 };
+    const scr_lanes_t ok = detect_scr_lanes_uhf(&b.frames[i], cand);
+    sink = ok[0];
+}
+
+static void bench_frame_descramble(int i)
+{
+    frame_t f = b.frames[i];
+    frame_descramble(&f, 7);
+    sink = f.data[i % FRAME_DATA_LEN];
+}
+
+static void bench_frame_diff_dec(int i)
+{
+    frame_t f = b.frames[i];
+    frame_diff_dec(&f);
+    sink = f.data[i % FRAME_DATA_LEN];
+}
+
+static void bench_frame_deinterleave(int i)
+{
+    frame_t f = b.frames[i];
+    frame_deinterleave(&f, interleave_data_UHF);
+    sink = f.data[i % FRAME_DATA_LEN];
+}
+
+static void bench_frame_decode(int i)
+{
+    uint8_t data[FRAME_DATA_LEN];
+    sink = b.phys_ch->band_dec->frame_decode(&b.phys_ch->frame_dec,
+            &b.frames[i], data);
+    sink = data[i % FRAME_DATA_LEN];
+}
+
+static void bench_data_block_decode_frame(int i)
+{
+    data_block_t data_blk;
+    data_block_decode_frame(&data_blk, b.frames_dec[i], FRAME_NO_UNKNOWN,
+            FRAME_TYPE_DATA);
+    sink = data_blk.nerrs;
+}
+
+// scalar equivalent of batch_decode() for single frame
+static void bench_decode_block(int i)
+{
+    uint8_t data[FRAME_DATA_LEN];
+    data_block_t data_blk;
+    const frame_type_t type = b.phys_ch->band_dec->frame_decode(
+            &b.phys_ch->frame_dec, &b.frames[i], data);
+    data_block_decode_frame(&data_blk, data, FRAME_NO_UNKNOWN, type);
+    sink = data_block_check_crc(&data_blk);
+}
+
+// LANES frames decoded at once
+static void bench_batch_decode(int i)
+{
+    batch_reset(&b.bt);
+    for (int lane = 0; lane < LANES; ++lane) {
+        b.bt.chs[lane] = b.phys_ch;
+        b.bt.frames[lane] = b.frames[(i * LANES + lane) % NFRAMES];
+        batch_add_frame(&b.bt);
+    }
+    batch_decode(&b.bt);
+    sink = b.bt.crc_ok[0];
+}
+
+static void bench_data_frame_push_data_block(int i)
+{
+    sink = data_frame_push_data_block(b.data_fr, &b.data_blks[i]);
+}
+
+static void bench_demod(int i)
+{
+    sink = demod_process(b.demod, b.iq[i % NIQ_FRAMES], FRAME_SAMPLES,
+            b.demod_bits);
+}
+
+static void bench_check_fcs(int i)
+{
+    sink = check_fcs(b.hdlc, 8 * sizeof(b.hdlc));
+}
+
+static void bench_hdlc_frame_parse(int i)
+{
+    hdlc_frame_t hdlc_fr;
+    sink = hdlc_frame_parse(&hdlc_fr, b.hdlc, 8 * sizeof(b.hdlc));
+    sink = hdlc_fr.nbits;
+}
+
+static void bench_tsdu_d_decode(int i)
+{
+    arena_reset(b.arena);
+    tsdu_t *tsdu = tsdu_d_decode(b.arena, b.hdlc + 3, 17 * 8, 0, 0);
+    sink = tsdu->codop;
+}
+
+/**
+  Run 'func' for frames until MIN_TIME_NS elapses and print result.
+
+  @param nframes_per_call Number of frames processed by single call.
+  */
+static void bench_run(const char *name, void (*func)(int),
+        double nframes_per_call)
+{
+    long long ncalls = 0;
+    long long elapsed;
+    const long long start = now_ns();
+    do {
+        for (int i = 0; i < NFRAMES; ++i) {
+            func(i);
+        }
+        ncalls += NFRAMES;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_TIME_NS);
+
+    const double ns = elapsed / (ncalls * nframes_per_call);
+    printf("%-28s %12.1f ns/frame %14.0f frames/s\n", name, ns, 1e9 / ns);
+}
+
+static bool bench_init(void)
+{
+    uint32_t r = 12345;
+
+    b.phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_UHF,
+            RADIO_CH_TYPE_CONTROL);
+    b.data_fr = data_frame_create();
+    b.arena = arena_create(4096);
+    b.demod = demod_create(DEMOD_INPUT_CF32);
+    if (!b.phys_ch || !b.data_fr || !b.arena || !b.demod) {
+        return false;
+    }
+
+    // MSK, phase is rotated by +-pi/4 per sample
+    const float rot[2][2] = { { 0.70710678f, -0.70710678f },
+        { 0.70710678f, 0.70710678f }, };
+    float re = 1, im = 0;
+    // own generator, data generated below are not affected
+    uint32_t r_iq = 54321;
+    for (int n = 0; n < NIQ_FRAMES * FRAME_SAMPLES; ++n) {
+        if (n % DEMOD_SAMPLES_PER_SYMBOL == 0) {
+            r_iq = r_iq * 1103515245 + 12345;
+        }
+        const float *c = rot[(r_iq >> 16) & 1];
+        const float re_ = re * c[0] - im * c[1];
+        im = re * c[1] + im * c[0];
+        re = re_;
+        b.iq[n / FRAME_SAMPLES][2 * (n % FRAME_SAMPLES)] = re;
+        b.iq[n / FRAME_SAMPLES][2 * (n % FRAME_SAMPLES) + 1] = im;
+    }
+    tetrapol_phys_ch_set_scr(b.phys_ch, 7);
+
+    // no frame sync in input, whole buffer is searched by find_frame_sync()
+    uint8_t bits[DATA_LEN - DATA_OFFS];
+    memset(bits, 0, sizeof(bits));
+    if (tetrapol_phys_ch_recv(b.phys_ch, bits, sizeof(bits)) != sizeof(bits)) {
+        return false;
+    }
+
+    for (int i = 0; i < NFRAMES; ++i) {
+        uint8_t blk[126];
+        // single block data frames (FN = 00)
+        do {
+            if (!mk_data_block(blk, FRAME_TYPE_DATA, &r)) {
+                return false;
+            }
+        } while (blk[1] || blk[2]);
+        mk_frame(&b.frames[i], blk, FRAME_TYPE_DATA, TETRAPOL_BAND_UHF, 7);
+        b.frames[i].data[FRAME_DATA_LEN] = 0;
+
+        b.phys_ch->band_dec->frame_decode(&b.phys_ch->frame_dec,
+                &b.frames[i], b.frames_dec[i]);
+        data_block_decode_frame(&b.data_blks[i], b.frames_dec[i],
+                FRAME_NO_UNKNOWN, FRAME_TYPE_DATA);
+        if (b.data_blks[i].nerrs || !data_block_check_crc(&b.data_blks[i])) {
+            return false;
+        }
+    }
+
+    // HDLC frame: address, command, D_SYSTEM_INFO TSDU, FCS
+    b.hdlc[0] = 0x01;
+    b.hdlc[1] = 0xff;
+    b.hdlc[2] = COMMAND_UNNUMBERED_UI;
+    b.hdlc[3] = D_SYSTEM_INFO;
+    b.hdlc[4] = CELL_STATE_MODE_NORMAL;
+    for (int i = 5; i < sizeof(b.hdlc) - 2; ++i) {
+        r = r * 1103515245 + 12345;
+        b.hdlc[i] = r >> 16;
+    }
+    // valid CELL_ID type (2 MSB of CELL_ID), decoding would log otherwise
+    b.hdlc[10] = (b.hdlc[10] & 0x3f) | (CELL_ID_FORMAT_0 << 6);
+    for (int fcs = 0; fcs <= 0xffff; ++fcs) {
+        b.hdlc[sizeof(b.hdlc) - 2] = fcs >> 8;
+        b.hdlc[sizeof(b.hdlc) - 1] = fcs;
+        if (check_fcs(b.hdlc, 8 * sizeof(b.hdlc))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(void)
+{
+    // do not measure logging
+    log_set_lvl(WTF);
+
+    if (!bench_init()) {
+        fprintf(stderr, "Failed to initialize benchmark\n");
+        return EXIT_FAILURE;
+    }
+
+    const int sync_bits = b.phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN -
+        DATA_OFFS + 1;
+    bench_run("find_frame_sync", bench_find_frame_sync,
+            (double)sync_bits / FRAME_LEN);
+    bench_run("track_frame_sync", bench_track_frame_sync, 1);
+    bench_run("detect_scr", bench_detect_scr, 1);
+    bench_run("detect_scr (pruned)", bench_detect_scr_pruned, 1);
+    bench_run("frame_descramble", bench_frame_descramble, 1);
+    bench_run("frame_diff_dec", bench_frame_diff_dec, 1);
+    bench_run("frame_deinterleave", bench_frame_deinterleave, 1);
+    bench_run("frame_decode (fused)", bench_frame_decode, 1);
+    bench_run("data_block_decode_frame", bench_data_block_decode_frame, 1);
+    bench_run("decode block (scalar)", bench_decode_block, 1);
+    bench_run("decode block (batch)", bench_batch_decode, LANES);
+    bench_run("data_frame_push_data_block", bench_data_frame_push_data_block, 1);
+    bench_run("demod (cf32)", bench_demod, 1);
+    bench_run("check_fcs", bench_check_fcs, 1);
+    bench_run("hdlc_frame_parse", bench_hdlc_frame_parse, 1);
+    bench_run("tsdu_d_decode", bench_tsdu_d_decode, 1);
+
+    demod_destroy(b.demod);
+    arena_destroy(b.arena);
+    data_frame_destroy(b.data_fr);
+    tetrapol_phys_ch_destroy(b.phys_ch);
+
+    return EXIT_SUCCESS;
+}
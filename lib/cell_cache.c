@@ -0,0 +1,316 @@
+#define _POSIX_C_SOURCE 200809L
+
+#define LOG_PREFIX "cell_cache"
+#include <tetrapol/log.h>
+#include <tetrapol/cell_cache.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// entries are allocated in chunks, pointers to entries remain valid
+#define CHUNK_ENTRIES 64
+#define SYSINFO_LEN 22
+// key and all fields must fit into line
+#define KEY_MAX 128
+#define LINE_LEN 256
+
+typedef struct {
+    char *key;
+    cell_cache_entry_t entry;
+} item_t;
+
+typedef struct _chunk_t chunk_t;
+struct _chunk_t {
+    chunk_t *next;
+    int nitems;
+    item_t items[CHUNK_ENTRIES];
+};
+
+struct _cell_cache_t {
+    chunk_t *chunks;    ///< the last chunk is first
+};
+
+static void sysinfo_serialize(const tsdu_d_system_info_t *si,
+        uint8_t buf[SYSINFO_LEN])
+{
+    const uint8_t b[SYSINFO_LEN] = {
+        si->cell_state._data, si->cell_config._data, si->country_code,
+        si->system_id._data, si->loc_area_id._data, si->bn_id,
+        si->cell_id.bs_id, si->cell_id.rws_id,
+        si->cell_bn >> 8, si->cell_bn & 0xff,
+        si->u_ch_scrambling,
+        si->cell_radio_param.tx_max, si->cell_radio_param.radio_link_timeout,
+        si->cell_radio_param.pwr_tx_adjust, si->cell_radio_param.rx_lev_access,
+        si->system_time, si->cell_access._data,
+        si->superframe_cpt >> 8, si->superframe_cpt & 0xff,
+        si->band,
+        si->channel_id >> 8, si->channel_id & 0xff,
+    };
+    memcpy(buf, b, SYSINFO_LEN);
+}
+
+static void sysinfo_deserialize(tsdu_d_system_info_t *si,
+        const uint8_t b[SYSINFO_LEN])
+{
+    memset(si, 0, sizeof(*si));
+    si->base.codop = D_SYSTEM_INFO;
+    si->base.downlink = true;
+    si->cell_state._data = b[0];
+    si->cell_config._data = b[1];
+    si->country_code = b[2];
+    si->system_id._data = b[3];
+    si->loc_area_id._data = b[4];
+    si->bn_id = b[5];
+    si->cell_id.bs_id = b[6];
+    si->cell_id.rws_id = b[7];
+    si->cell_bn = (b[8] << 8) | b[9];
+    si->u_ch_scrambling = b[10];
+    si->cell_radio_param.tx_max = b[11];
+    si->cell_radio_param.radio_link_timeout = b[12];
+    si->cell_radio_param.pwr_tx_adjust = b[13];
+    si->cell_radio_param.rx_lev_access = b[14];
+    si->system_time = b[15];
+    si->cell_access._data = b[16];
+    si->superframe_cpt = (b[17] << 8) | b[18];
+    si->band = b[19];
+    si->channel_id = (b[20] << 8) | b[21];
+}
+
+static bool valid_key(const char *key)
+{
+    if (!*key || *key == '#' || strlen(key) > KEY_MAX) {
+        return false;
+    }
+    for (; *key; ++key) {
+        if (isspace((unsigned char)*key)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+cell_cache_entry_t *cell_cache_get(cell_cache_t *cache, const char *key,
+        bool create)
+{
+    for (chunk_t *chunk = cache->chunks; chunk; chunk = chunk->next) {
+        for (int i = 0; i < chunk->nitems; ++i) {
+            if (!strcmp(chunk->items[i].key, key)) {
+                return &chunk->items[i].entry;
+            }
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+    if (!valid_key(key)) {
+        LOG(ERR, "cell_cache_get() invalid key '%s'", key);
+        return NULL;
+    }
+
+    chunk_t *chunk = cache->chunks;
+    if (!chunk || chunk->nitems == CHUNK_ENTRIES) {
+        chunk = calloc(1, sizeof(chunk_t));
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = cache->chunks;
+        cache->chunks = chunk;
+    }
+
+    item_t *item = &chunk->items[chunk->nitems];
+    item->key = strdup(key);
+    if (!item->key) {
+        return NULL;
+    }
+    ++chunk->nitems;
+    item->entry.scr = -1;
+    item->entry.mux_type = -1;
+    item->entry.has_sysinfo = false;
+
+    return &item->entry;
+}
+
+void cell_cache_set_sysinfo(cell_cache_entry_t *entry,
+        const tsdu_d_system_info_t *tsdu)
+{
+    uint8_t buf[SYSINFO_LEN];
+
+    // normalized copy, base of TSDU is not copied
+    sysinfo_serialize(tsdu, buf);
+    sysinfo_deserialize(&entry->sysinfo, buf);
+    entry->has_sysinfo = true;
+    entry->mux_type = tsdu->cell_config.mux_type;
+}
+
+static bool parse_hex(uint8_t *buf, int len, const char *s)
+{
+    if (strlen(s) != 2 * len) {
+        return false;
+    }
+    for (int i = 0; i < len; ++i) {
+        unsigned int v;
+        if (!isxdigit((unsigned char)s[2 * i]) ||
+                !isxdigit((unsigned char)s[2 * i + 1]) ||
+                sscanf(&s[2 * i], "%2x", &v) != 1) {
+            return false;
+        }
+        buf[i] = v;
+    }
+
+    return true;
+}
+
+/**
+  Parse single line of cache file.
+
+  @return 0 on success, 1 for ignored line, -1 on error
+  */
+static int parse_line(cell_cache_t *cache, char *line)
+{
+    char *saveptr;
+    const char *key = strtok_r(line, " \t\r\n", &saveptr);
+    if (!key || *key == '#') {
+        return 1;
+    }
+
+    cell_cache_entry_t entry = { .scr = -1, .mux_type = -1, };
+    const char *field;
+    while ((field = strtok_r(NULL, " \t\r\n", &saveptr))) {
+        int v;
+        char c;
+        if (!strncmp(field, "scr=", 4)) {
+            if (sscanf(field, "scr=%d%c", &v, &c) != 1 || v < -1 || v > 127) {
+                return -1;
+            }
+            entry.scr = v;
+        } else if (!strncmp(field, "mux=", 4)) {
+            if (sscanf(field, "mux=%d%c", &v, &c) != 1 || v < -1 || v > 7) {
+                return -1;
+            }
+            entry.mux_type = v;
+        } else if (!strncmp(field, "sysinfo=", 8)) {
+            uint8_t buf[SYSINFO_LEN];
+            if (!parse_hex(buf, SYSINFO_LEN, field + 8)) {
+                return -1;
+            }
+            sysinfo_deserialize(&entry.sysinfo, buf);
+            entry.has_sysinfo = true;
+        }
+    }
+
+    cell_cache_entry_t *e = cell_cache_get(cache, key, true);
+    if (!e) {
+        return -1;
+    }
+    *e = entry;
+
+    return 0;
+}
+
+cell_cache_t *cell_cache_load(const char *path)
+{
+    cell_cache_t *cache = calloc(1, sizeof(cell_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        if (errno == ENOENT) {
+            return cache;
+        }
+        LOG(ERR, "Failed to open %s: %s", path, strerror(errno));
+        goto err_open;
+    }
+
+    char line[LINE_LEN];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ++line_no;
+        if (!strchr(line, '\n') && !feof(f)) {
+            LOG(ERR, "%s:%d line too long", path, line_no);
+            goto err_read;
+        }
+        // invalid entries are dropped, cache is rebuilt by detection
+        if (parse_line(cache, line) < 0) {
+            LOG(ERR, "%s:%d invalid entry ignored", path, line_no);
+        }
+    }
+    if (ferror(f)) {
+        LOG(ERR, "Failed to read %s", path);
+        goto err_read;
+    }
+    fclose(f);
+
+    return cache;
+
+err_read:
+    fclose(f);
+err_open:
+    cell_cache_destroy(cache);
+
+    return NULL;
+}
+
+void cell_cache_destroy(cell_cache_t *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    chunk_t *chunk = cache->chunks;
+    while (chunk) {
+        chunk_t *next = chunk->next;
+        for (int i = 0; i < chunk->nitems; ++i) {
+            free(chunk->items[i].key);
+        }
+        free(chunk);
+        chunk = next;
+    }
+    free(cache);
+}
+
+int cell_cache_save(const cell_cache_t *cache, const char *path)
+{
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        LOG(ERR, "Failed to create %s: %s", tmp_path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(f, "# KEY scr=SCR mux=MUX_TYPE [sysinfo=D_SYSTEM_INFO]\n");
+    for (const chunk_t *chunk = cache->chunks; chunk; chunk = chunk->next) {
+        // chunks are in reverse order, does not matter for lookup
+        for (int i = 0; i < chunk->nitems; ++i) {
+            const item_t *item = &chunk->items[i];
+            fprintf(f, "%s scr=%d mux=%d", item->key, item->entry.scr,
+                    item->entry.mux_type);
+            if (item->entry.has_sysinfo) {
+                uint8_t buf[SYSINFO_LEN];
+                sysinfo_serialize(&item->entry.sysinfo, buf);
+                fprintf(f, " sysinfo=");
+                for (int j = 0; j < SYSINFO_LEN; ++j) {
+                    fprintf(f, "%02x", buf[j]);
+                }
+            }
+            fprintf(f, "\n");
+        }
+    }
+
+    if (fclose(f) || rename(tmp_path, path)) {
+        LOG(ERR, "Failed to write %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,506 @@
+#define LOG_PREFIX "channelizer"
+#include <tetrapol/log.h>
+#include <tetrapol/channelizer.h>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// max. number of output samples computed by single job of threads
+#define CHUNK_OUT 64
+// max. prime factor of number of channels, FFT butterflies are generic
+#define FFT_RADIX_MAX 13
+#define FFT_FACTORS_MAX 32
+
+#define PI 3.14159265358979323846
+
+// polyphase filter is vectorized by GCC vector extensions, see demod.c
+#define NLANES 4
+typedef float lanes_t __attribute__((vector_size(4 * NLANES)));
+
+typedef struct {
+    float re;
+    float im;
+} cf_t;
+
+/// thread and its scratch buffers
+typedef struct {
+    channelizer_t *chzr;
+    int idx;
+    pthread_t thread;
+    float *acc_re;      ///< polyphase filter output
+    float *acc_im;
+    cf_t *v;            ///< FFT input
+    cf_t *f;            ///< FFT output
+} worker_t;
+
+struct _channelizer_t {
+    int nchs;
+    int decim;
+    int ntaps;          ///< multiple of nchs
+    int input_fmt;
+    float *taps;        ///< prototype low-pass filter
+    cf_t *tw;           ///< FFT twiddle factors exp(-2 pi i k / nchs)
+    int factors[FFT_FACTORS_MAX];   ///< prime factors of nchs, 0 terminated
+    // input samples, real and imaginary parts are separated for filter,
+    // the oldest ntaps - 1 samples are history
+    float *in_re;
+    float *in_im;
+    int in_len;
+    int in_cap;
+    int next_out;       ///< index of input sample for next output
+    int rot;            ///< (time of next output + 1) % nchs
+    // thread pool, job is split between threads by output samples
+    int nthreads;
+    worker_t *workers;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_start;
+    pthread_cond_t cond_done;
+    unsigned generation;
+    int nbusy;
+    bool exit;
+    int job_first;      ///< index of input sample for first output
+    int job_rot;
+    int job_nout;
+    float *job_out;
+    int job_stride;
+};
+
+static inline cf_t cf_mul(cf_t a, cf_t b)
+{
+    return (cf_t){ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re, };
+}
+
+/**
+  Mixed radix FFT (decimation in time).
+
+  out[k] = sum(in[j * stride] * exp(-2 pi i j k / n)), 'factors' are
+  prime factors of n.
+  */
+static void fft_rec(const channelizer_t *chzr, cf_t *out, const cf_t *in,
+        int n, int stride, const int *factors)
+{
+    const cf_t *tw = chzr->tw;
+    const int tw_step = chzr->nchs / n;
+    const int p = factors[0];
+    const int m = n / p;
+
+    if (m == 1) {
+        for (int k = 0; k < p; ++k) {
+            cf_t s = { 0, 0, };
+            for (int j = 0; j < p; ++j) {
+                const cf_t t = cf_mul(in[j * stride], tw[(j * k % p) * tw_step]);
+                s.re += t.re;
+                s.im += t.im;
+            }
+            out[k] = s;
+        }
+        return;
+    }
+
+    for (int j = 0; j < p; ++j) {
+        fft_rec(chzr, out + j * m, in + j * stride, m, stride * p, factors + 1);
+    }
+    for (int s = 0; s < m; ++s) {
+        cf_t t[FFT_RADIX_MAX];
+        for (int j = 0; j < p; ++j) {
+            t[j] = cf_mul(out[j * m + s], tw[j * s * tw_step]);
+        }
+        for (int q = 0; q < p; ++q) {
+            cf_t acc = { 0, 0, };
+            for (int j = 0; j < p; ++j) {
+                const cf_t x = cf_mul(t[j], tw[(j * q % p) * m * tw_step]);
+                acc.re += x.re;
+                acc.im += x.im;
+            }
+            out[q * m + s] = acc;
+        }
+    }
+}
+
+/**
+  Compute output sample of all channels.
+
+  Channel k is y_k[t] = sum(h[i] * x[t - i] * exp(-2 pi i k (t - i) / nchs)).
+  Filter taps are summed by polyphase branches, (t - i) % nchs is the same
+  for all taps of branch, so the rest is FFT of branch outputs rotated
+  by t % nchs.
+
+  @param pos Index of input sample (time t) in input buffer.
+  @param rot (t + 1) % nchs
+  @param out Output of channel 0, channels are 'stride' samples apart.
+  */
+static void compute_output(const channelizer_t *chzr, worker_t *w, int pos,
+        int rot, float *out, int stride)
+{
+    const int nchs = chzr->nchs;
+    // prototype filter is symmetric, so the window does not need to
+    // be reversed in time
+    const int base = pos - chzr->ntaps + 1;
+    memset(w->acc_re, 0, nchs * sizeof(float));
+    memset(w->acc_im, 0, nchs * sizeof(float));
+    for (int q = 0; q < chzr->ntaps; q += nchs) {
+        const float *taps = &chzr->taps[q];
+        const float *re = &chzr->in_re[base + q];
+        const float *im = &chzr->in_im[base + q];
+        for (int r = 0; r < nchs; r += NLANES) {
+            lanes_t g, xr, xi, ar, ai;
+            memcpy(&g, &taps[r], sizeof(g));
+            memcpy(&xr, &re[r], sizeof(xr));
+            memcpy(&xi, &im[r], sizeof(xi));
+            memcpy(&ar, &w->acc_re[r], sizeof(ar));
+            memcpy(&ai, &w->acc_im[r], sizeof(ai));
+            ar += g * xr;
+            ai += g * xi;
+            memcpy(&w->acc_re[r], &ar, sizeof(ar));
+            memcpy(&w->acc_im[r], &ai, sizeof(ai));
+        }
+    }
+
+    // branch r contains taps with (t - i) % nchs == (rot + r) % nchs
+    for (int r = 0; r < nchs; ++r) {
+        const int k = (rot + r) % nchs;
+        w->v[k].re = w->acc_re[r];
+        w->v[k].im = w->acc_im[r];
+    }
+    fft_rec(chzr, w->f, w->v, nchs, 1, chzr->factors);
+
+    for (int k = 0; k < nchs; ++k) {
+        out[2 * k * stride] = w->f[k].re;
+        out[2 * k * stride + 1] = w->f[k].im;
+    }
+}
+
+/// Compute share of current job for worker.
+static void do_job(channelizer_t *chzr, worker_t *w)
+{
+    const int first = w->idx * chzr->job_nout / chzr->nthreads;
+    const int last = (w->idx + 1) * chzr->job_nout / chzr->nthreads;
+    for (int j = first; j < last; ++j) {
+        const int offs = j * chzr->decim;
+        compute_output(chzr, w, chzr->job_first + offs,
+                (chzr->job_rot + offs) % chzr->nchs,
+                chzr->job_out + 2 * j, chzr->job_stride);
+    }
+}
+
+static void *worker_thread(void *arg)
+{
+    worker_t *w = arg;
+    channelizer_t *chzr = w->chzr;
+    unsigned generation = 0;
+
+    pthread_mutex_lock(&chzr->mutex);
+    while (true) {
+        while (chzr->generation == generation && !chzr->exit) {
+            pthread_cond_wait(&chzr->cond_start, &chzr->mutex);
+        }
+        if (chzr->exit) {
+            break;
+        }
+        generation = chzr->generation;
+        pthread_mutex_unlock(&chzr->mutex);
+
+        do_job(chzr, w);
+
+        pthread_mutex_lock(&chzr->mutex);
+        if (--chzr->nbusy == 0) {
+            pthread_cond_signal(&chzr->cond_done);
+        }
+    }
+    pthread_mutex_unlock(&chzr->mutex);
+
+    return NULL;
+}
+
+static void run_job(channelizer_t *chzr, int first, int rot, int nout,
+        float *out, int stride)
+{
+    chzr->job_first = first;
+    chzr->job_rot = rot;
+    chzr->job_nout = nout;
+    chzr->job_out = out;
+    chzr->job_stride = stride;
+
+    if (chzr->nthreads == 1) {
+        do_job(chzr, &chzr->workers[0]);
+        return;
+    }
+
+    pthread_mutex_lock(&chzr->mutex);
+    ++chzr->generation;
+    chzr->nbusy = chzr->nthreads - 1;
+    pthread_cond_broadcast(&chzr->cond_start);
+    pthread_mutex_unlock(&chzr->mutex);
+
+    // calling thread is worker 0
+    do_job(chzr, &chzr->workers[0]);
+
+    pthread_mutex_lock(&chzr->mutex);
+    while (chzr->nbusy) {
+        pthread_cond_wait(&chzr->cond_done, &chzr->mutex);
+    }
+    pthread_mutex_unlock(&chzr->mutex);
+}
+
+static bool factorize(int *factors, int n)
+{
+    int nfactors = 0;
+    for (int p = 2; n > 1; ++p) {
+        while (n % p == 0) {
+            if (p > FFT_RADIX_MAX || nfactors == FFT_FACTORS_MAX - 1) {
+                return false;
+            }
+            factors[nfactors++] = p;
+            n /= p;
+        }
+    }
+    factors[nfactors] = 0;
+
+    return true;
+}
+
+/// Hann windowed sinc, the same design as GNU Radio firdes.low_pass().
+static float *mk_taps(int ntaps, double cutoff)
+{
+    float *taps = malloc(ntaps * sizeof(float));
+    if (!taps) {
+        return NULL;
+    }
+
+    double sum = 0;
+    const double mid = (ntaps - 1) / 2.0;
+    for (int i = 0; i < ntaps; ++i) {
+        const double x = i - mid;
+        const double sinc = (x == 0) ? 2 * cutoff :
+            sin(2 * PI * cutoff * x) / (PI * x);
+        const double win = 0.5 - 0.5 * cos(2 * PI * i / (ntaps - 1));
+        taps[i] = sinc * win;
+        sum += taps[i];
+    }
+    // unity gain for DC
+    for (int i = 0; i < ntaps; ++i) {
+        taps[i] /= sum;
+    }
+
+    return taps;
+}
+
+static bool worker_init(worker_t *w, channelizer_t *chzr, int idx)
+{
+    w->chzr = chzr;
+    w->idx = idx;
+    w->acc_re = malloc(chzr->nchs * sizeof(float));
+    w->acc_im = malloc(chzr->nchs * sizeof(float));
+    w->v = malloc(chzr->nchs * sizeof(cf_t));
+    w->f = malloc(chzr->nchs * sizeof(cf_t));
+
+    return w->acc_re && w->acc_im && w->v && w->f;
+}
+
+static void worker_free(worker_t *w)
+{
+    free(w->acc_re);
+    free(w->acc_im);
+    free(w->v);
+    free(w->f);
+}
+
+channelizer_t *channelizer_create(int nchs, int decim, double cutoff,
+        double transition, int input_fmt, int nthreads)
+{
+    if (nchs <= 0 || nchs % NLANES || decim < 1 || decim > nchs ||
+            cutoff <= 0 || cutoff >= 0.5 || transition <= 0 || nthreads < 1 ||
+            (input_fmt != CHANNELIZER_INPUT_CF32 &&
+             input_fmt != CHANNELIZER_INPUT_CS16)) {
+        LOG(ERR, "channelizer_create() invalid params");
+        return NULL;
+    }
+
+    channelizer_t *chzr = calloc(1, sizeof(channelizer_t));
+    if (!chzr) {
+        return NULL;
+    }
+    if (!factorize(chzr->factors, nchs)) {
+        LOG(ERR, "channelizer_create() unsupported number of channels %d", nchs);
+        free(chzr);
+        return NULL;
+    }
+
+    chzr->nchs = nchs;
+    chzr->decim = decim;
+    chzr->input_fmt = input_fmt;
+    // Hann window has 44 dB attenuation, see firdes.low_pass()
+    chzr->ntaps = 44 / (22 * transition);
+    chzr->ntaps = (chzr->ntaps + nchs - 1) / nchs * nchs;
+    chzr->taps = mk_taps(chzr->ntaps, cutoff);
+    if (!chzr->taps) {
+        goto err_taps;
+    }
+
+    chzr->tw = malloc(nchs * sizeof(cf_t));
+    if (!chzr->tw) {
+        goto err_tw;
+    }
+    for (int k = 0; k < nchs; ++k) {
+        chzr->tw[k].re = cos(2 * PI * k / nchs);
+        chzr->tw[k].im = -sin(2 * PI * k / nchs);
+    }
+
+    // history is zero, first output is for the first input sample
+    chzr->in_cap = chzr->ntaps + CHUNK_OUT * decim;
+    chzr->in_re = calloc(chzr->in_cap, sizeof(float));
+    chzr->in_im = calloc(chzr->in_cap, sizeof(float));
+    if (!chzr->in_re || !chzr->in_im) {
+        goto err_in;
+    }
+    chzr->in_len = chzr->ntaps - 1;
+    chzr->next_out = chzr->ntaps - 1;
+    chzr->rot = 1 % nchs;
+
+    chzr->nthreads = nthreads;
+    chzr->workers = calloc(nthreads, sizeof(worker_t));
+    if (!chzr->workers) {
+        goto err_in;
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        if (!worker_init(&chzr->workers[i], chzr, i)) {
+            goto err_workers;
+        }
+    }
+
+    pthread_mutex_init(&chzr->mutex, NULL);
+    pthread_cond_init(&chzr->cond_start, NULL);
+    pthread_cond_init(&chzr->cond_done, NULL);
+    int nstarted = 1;
+    for (; nstarted < nthreads; ++nstarted) {
+        worker_t *w = &chzr->workers[nstarted];
+        if (pthread_create(&w->thread, NULL, worker_thread, w)) {
+            goto err_threads;
+        }
+    }
+
+    return chzr;
+
+err_threads:
+    pthread_mutex_lock(&chzr->mutex);
+    chzr->exit = true;
+    pthread_cond_broadcast(&chzr->cond_start);
+    pthread_mutex_unlock(&chzr->mutex);
+    for (int i = 1; i < nstarted; ++i) {
+        pthread_join(chzr->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&chzr->cond_done);
+    pthread_cond_destroy(&chzr->cond_start);
+    pthread_mutex_destroy(&chzr->mutex);
+
+err_workers:
+    for (int i = 0; i < nthreads; ++i) {
+        worker_free(&chzr->workers[i]);
+    }
+    free(chzr->workers);
+
+err_in:
+    free(chzr->in_re);
+    free(chzr->in_im);
+    free(chzr->tw);
+
+err_tw:
+    free(chzr->taps);
+
+err_taps:
+    free(chzr);
+
+    return NULL;
+}
+
+void channelizer_destroy(channelizer_t *chzr)
+{
+    if (!chzr) {
+        return;
+    }
+
+    pthread_mutex_lock(&chzr->mutex);
+    chzr->exit = true;
+    pthread_cond_broadcast(&chzr->cond_start);
+    pthread_mutex_unlock(&chzr->mutex);
+    for (int i = 1; i < chzr->nthreads; ++i) {
+        pthread_join(chzr->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&chzr->cond_done);
+    pthread_cond_destroy(&chzr->cond_start);
+    pthread_mutex_destroy(&chzr->mutex);
+
+    for (int i = 0; i < chzr->nthreads; ++i) {
+        worker_free(&chzr->workers[i]);
+    }
+    free(chzr->workers);
+    free(chzr->in_re);
+    free(chzr->in_im);
+    free(chzr->tw);
+    free(chzr->taps);
+    free(chzr);
+}
+
+int channelizer_ntaps(const channelizer_t *chzr)
+{
+    return chzr->ntaps;
+}
+
+int channelizer_out_max(const channelizer_t *chzr, int nsamples)
+{
+    return nsamples / chzr->decim + 1;
+}
+
+int channelizer_process(channelizer_t *chzr, const void *samples,
+        int nsamples, float *out, int stride)
+{
+    const uint8_t *s = samples;
+    const int sample_size = (chzr->input_fmt == CHANNELIZER_INPUT_CF32) ?
+        2 * sizeof(float) : 2 * sizeof(int16_t);
+    int nout = 0;
+
+    while (nsamples > 0) {
+        const int space = chzr->in_cap - chzr->in_len;
+        const int n = (nsamples > space) ? space : nsamples;
+        float *re = &chzr->in_re[chzr->in_len];
+        float *im = &chzr->in_im[chzr->in_len];
+        if (chzr->input_fmt == CHANNELIZER_INPUT_CF32) {
+            const float *x = (const float *)s;
+            for (int i = 0; i < n; ++i) {
+                re[i] = x[2 * i];
+                im[i] = x[2 * i + 1];
+            }
+        } else {
+            const int16_t *x = (const int16_t *)s;
+            for (int i = 0; i < n; ++i) {
+                re[i] = x[2 * i] * (1.0f / 32768);
+                im[i] = x[2 * i + 1] * (1.0f / 32768);
+            }
+        }
+        chzr->in_len += n;
+        s += n * sample_size;
+        nsamples -= n;
+
+        if (chzr->next_out < chzr->in_len) {
+            const int k = (chzr->in_len - 1 - chzr->next_out) / chzr->decim + 1;
+            run_job(chzr, chzr->next_out, chzr->rot, k, out + 2 * nout, stride);
+            chzr->next_out += k * chzr->decim;
+            chzr->rot = (chzr->rot + k * chzr->decim) % chzr->nchs;
+            nout += k;
+        }
+
+        // keep history for next outputs
+        const int drop = chzr->next_out - (chzr->ntaps - 1);
+        memmove(chzr->in_re, &chzr->in_re[drop],
+                (chzr->in_len - drop) * sizeof(float));
+        memmove(chzr->in_im, &chzr->in_im[drop],
+                (chzr->in_len - drop) * sizeof(float));
+        chzr->in_len -= drop;
+        chzr->next_out -= drop;
+    }
+
+    return nout;
+}
@@ -0,0 +1,308 @@
+#define LOG_PREFIX "combiner"
+#include <tetrapol/tetrapol.h>
+#include <tetrapol/log.h>
+#include <tetrapol/combiner.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// frame duration (us) and period of frame numbering
+#define FRAME_US 20000
+#define FRAME_NO_CYCLE 200
+// frames received before frame numbering, BCH data frame spans 4 frames
+// and it is numbered by the last one
+#define RX_BACKLOG 3
+
+/// Frame waiting for copies from another receivers.
+typedef struct {
+    bool pending;
+    int64_t afn;        ///< absolute frame number, see frame_abs_no()
+    uint32_t rx_mask;   ///< receivers which delivered the frame
+    int nbad;           ///< copies without valid CRC
+    int best_rx;
+    frame_info_t fi;    ///< of the best copy, timestamp includes offset
+    data_block_t data_blk;
+} slot_t;
+
+typedef struct {
+    frame_info_t fi;
+    data_block_t data_blk;
+} backlog_t;
+
+typedef struct {
+    combiner_t *comb;
+    int rx;
+    int64_t offset;
+    phys_ch_t *phys_ch;
+    /// frames without number, numbered by the next numbered frame
+    int nbacklog;
+    backlog_t backlog[RX_BACKLOG];
+} rx_t;
+
+struct _combiner_t {
+    int radio_ch_type;
+    int nrx;
+    rx_t rxs[COMBINER_RX_MAX];
+    phys_ch_t *out;
+    /// receivers which delivered the last frames, others are not waited for
+    uint32_t active_mask;
+    bool has_ref;
+    int64_t ref_afn;    ///< the newest frame
+    int64_t ref_ts;
+    int64_t next_afn;   ///< the first frame not passed to output
+    slot_t slots[COMBINER_DEPTH];
+    combiner_stats_t stats;
+};
+
+/**
+  Extend frame number into absolute frame number using timestamp relative
+  to the newest frame, frame number is preserved modulo FRAME_NO_CYCLE.
+  */
+static int64_t frame_abs_no(const combiner_t *comb, int frame_no, int64_t ts)
+{
+    const int64_t dt = ts - comb->ref_ts;
+    const int64_t est = comb->ref_afn +
+        (dt + ((dt < 0) ? -FRAME_US / 2 : FRAME_US / 2)) / FRAME_US;
+    if (frame_no == FRAME_NO_UNKNOWN) {
+        return est;
+    }
+
+    int64_t d = (frame_no - est) % FRAME_NO_CYCLE;
+    if (d < 0) {
+        d += FRAME_NO_CYCLE;
+    }
+    if (d >= FRAME_NO_CYCLE / 2) {
+        d -= FRAME_NO_CYCLE;
+    }
+
+    return est + d;
+}
+
+static bool copy_is_better(const frame_info_t *fi, const frame_info_t *best)
+{
+    if (fi->crc_ok != best->crc_ok) {
+        return fi->crc_ok;
+    }
+
+    return fi->nerrs < best->nerrs;
+}
+
+/// Pass the first frame (if any copy was received) to output.
+static void output_next(combiner_t *comb)
+{
+    slot_t *slot = &comb->slots[comb->next_afn % COMBINER_DEPTH];
+    ++comb->next_afn;
+    if (!slot->pending) {
+        return;
+    }
+
+    slot->pending = false;
+    // receivers missing the frame are not waited for until they deliver
+    comb->active_mask &= slot->rx_mask;
+    ++comb->stats.frames;
+    ++comb->stats.rx_best[slot->best_rx];
+    if (slot->fi.crc_ok && slot->nbad) {
+        ++comb->stats.recovered;
+    }
+    tetrapol_phys_ch_push_data_block(comb->out, &slot->fi, &slot->data_blk);
+}
+
+/// Pass frames preceding 'afn' to output.
+static void output_until(combiner_t *comb, int64_t afn)
+{
+    // frames beyond the window are not pending
+    const int64_t end = (afn - comb->next_afn > COMBINER_DEPTH) ?
+        comb->next_afn + COMBINER_DEPTH : afn;
+    while (comb->next_afn < end) {
+        output_next(comb);
+    }
+    comb->next_afn = afn;
+}
+
+static void combine_copy(combiner_t *comb, rx_t *rx, const frame_info_t *fi,
+        const data_block_t *data_blk)
+{
+    const int64_t ts = fi->timestamp + rx->offset;
+    if (!comb->has_ref) {
+        comb->has_ref = true;
+        comb->ref_afn = (fi->frame_no == FRAME_NO_UNKNOWN) ? 0 : fi->frame_no;
+        comb->ref_ts = ts;
+        comb->next_afn = comb->ref_afn;
+    }
+
+    const int64_t afn = frame_abs_no(comb, fi->frame_no, ts);
+    if (afn < comb->next_afn) {
+        ++comb->stats.late;
+        return;
+    }
+    if (afn >= comb->next_afn + COMBINER_DEPTH) {
+        output_until(comb, afn - COMBINER_DEPTH + 1);
+    }
+    if (afn > comb->ref_afn) {
+        comb->ref_afn = afn;
+        comb->ref_ts = ts;
+    }
+
+    slot_t *slot = &comb->slots[afn % COMBINER_DEPTH];
+    if (!slot->pending || copy_is_better(fi, &slot->fi)) {
+        if (!slot->pending) {
+            slot->pending = true;
+            slot->afn = afn;
+            slot->rx_mask = 0;
+            slot->nbad = 0;
+        }
+        slot->best_rx = rx->rx;
+        slot->fi = *fi;
+        slot->fi.timestamp = ts;
+        slot->data_blk = *data_blk;
+    }
+    if (!fi->crc_ok) {
+        ++slot->nbad;
+    }
+    slot->rx_mask |= 1u << rx->rx;
+    comb->active_mask |= 1u << rx->rx;
+
+    // pass frames delivered by all active receivers
+    for (;;) {
+        slot = &comb->slots[comb->next_afn % COMBINER_DEPTH];
+        if (!slot->pending ||
+                (slot->rx_mask & comb->active_mask) != comb->active_mask) {
+            break;
+        }
+        output_next(comb);
+    }
+}
+
+static void rx_block_sink(const frame_info_t *fi,
+        const data_block_t *data_blk, void *ptr)
+{
+    rx_t *rx = ptr;
+    combiner_t *comb = rx->comb;
+
+    if (comb->radio_ch_type != RADIO_CH_TYPE_CONTROL) {
+        combine_copy(comb, rx, fi, data_blk);
+        return;
+    }
+
+    if (fi->frame_no == FRAME_NO_UNKNOWN) {
+        if (rx->nbacklog == RX_BACKLOG) {
+            memmove(&rx->backlog[0], &rx->backlog[1],
+                    (RX_BACKLOG - 1) * sizeof(backlog_t));
+            --rx->nbacklog;
+            ++comb->stats.unaligned;
+        }
+        rx->backlog[rx->nbacklog].fi = *fi;
+        rx->backlog[rx->nbacklog].data_blk = *data_blk;
+        ++rx->nbacklog;
+        return;
+    }
+
+    for (int i = 0; i < rx->nbacklog; ++i) {
+        backlog_t *b = &rx->backlog[i];
+        const int64_t n = (fi->timestamp - b->fi.timestamp + FRAME_US / 2) /
+            FRAME_US;
+        // frames from before sync loss can not be numbered
+        if (n < 1 || n > RX_BACKLOG) {
+            ++comb->stats.unaligned;
+            continue;
+        }
+        b->fi.frame_no = (fi->frame_no - n + FRAME_NO_CYCLE) % FRAME_NO_CYCLE;
+        b->data_blk.frame_no = b->fi.frame_no;
+        combine_copy(comb, rx, &b->fi, &b->data_blk);
+    }
+    rx->nbacklog = 0;
+
+    combine_copy(comb, rx, fi, data_blk);
+}
+
+combiner_t *combiner_create(int band, int radio_ch_type, int nrx)
+{
+    if (nrx < 1 || nrx > COMBINER_RX_MAX) {
+        LOG(ERR, "combiner_create() invalid param 'nrx'");
+        return NULL;
+    }
+
+    combiner_t *comb = calloc(1, sizeof(combiner_t));
+    if (!comb) {
+        return NULL;
+    }
+    comb->radio_ch_type = radio_ch_type;
+    comb->active_mask = (1u << nrx) - 1;
+
+    comb->out = tetrapol_phys_ch_create(band, radio_ch_type);
+    if (!comb->out) {
+        goto err_out;
+    }
+
+    for (; comb->nrx < nrx; ++comb->nrx) {
+        rx_t *rx = &comb->rxs[comb->nrx];
+        rx->comb = comb;
+        rx->rx = comb->nrx;
+        rx->phys_ch = tetrapol_phys_ch_create(band, radio_ch_type);
+        if (!rx->phys_ch) {
+            goto err_rx;
+        }
+        tetrapol_phys_ch_set_block_sink(rx->phys_ch, rx_block_sink, rx);
+        // BCH is decoded by receivers just for frame numbering
+        tetrapol_phys_ch_set_dup_suppress(rx->phys_ch, true);
+    }
+
+    return comb;
+
+err_rx:
+    for (int i = 0; i < comb->nrx; ++i) {
+        tetrapol_phys_ch_destroy(comb->rxs[i].phys_ch);
+    }
+    tetrapol_phys_ch_destroy(comb->out);
+err_out:
+    free(comb);
+
+    return NULL;
+}
+
+void combiner_destroy(combiner_t *comb)
+{
+    if (!comb) {
+        return;
+    }
+    for (int i = 0; i < comb->nrx; ++i) {
+        tetrapol_phys_ch_destroy(comb->rxs[i].phys_ch);
+    }
+    tetrapol_phys_ch_destroy(comb->out);
+    free(comb);
+}
+
+phys_ch_t *combiner_get_rx(combiner_t *comb, int rx)
+{
+    if (rx < 0 || rx >= comb->nrx) {
+        LOG(ERR, "combiner_get_rx() invalid param 'rx'");
+        return NULL;
+    }
+
+    return comb->rxs[rx].phys_ch;
+}
+
+phys_ch_t *combiner_get_phys_ch(combiner_t *comb)
+{
+    return comb->out;
+}
+
+void combiner_set_rx_offset(combiner_t *comb, int rx, int64_t offset)
+{
+    if (rx < 0 || rx >= comb->nrx) {
+        LOG(ERR, "combiner_set_rx_offset() invalid param 'rx'");
+        return;
+    }
+
+    comb->rxs[rx].offset = offset;
+}
+
+void combiner_flush(combiner_t *comb)
+{
+    output_until(comb, comb->next_afn + COMBINER_DEPTH);
+}
+
+void combiner_get_stats(const combiner_t *comb, combiner_stats_t *stats)
+{
+    memcpy(stats, &comb->stats, sizeof(*stats));
+}
@@ -1,68 +1,130 @@
 #define LOG_PREFIX " data_block"
 #include <tetrapol/log.h>
 #include <tetrapol/data_block.h>
+#include <tetrapol/trace.h>
 
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
-// http://ghsi.de/CRC/index.php?Polynom=1010
-static void mk_crc3(uint8_t *res, const uint8_t *input, int input_len)
-{
-    uint8_t inv;
-    memset(res, 0, 3);
+// emit external definitions of inline functions from data_block.h
+extern inline int data_block_get_bit(const data_block_t *data_blk, int pos);
+extern inline uint64_t data_block_get_bits(const data_block_t *data_blk,
+        int pos, int len);
 
-    for (int i = 0; i < input_len; ++i)
-    {
-        inv = input[i] ^ res[0];
+/**
+  Byte tables for CRC3 (x^3 + x + 1) and CRC5 (x^5 + x^2 + 1),
+  generated by this python3 script
+
+  def table(n, poly):
+      t = []
+      for i in range(256):
+          r = 0
+          for j in range(7, -1, -1):
+              inv = ((i >> j) & 1) ^ (r >> (n - 1))
+              r = ((r << 1) & ((1 << n) - 1)) ^ (poly if inv else 0)
+          t.append(r)
+      return t
+
+  crc3_table = table(3, 0x3)
+  crc5_table = table(5, 0x5)
+  */
+static const uint8_t crc3_table[256] = {
+    0, 3, 6, 5, 7, 4, 1, 2, 5, 6, 3, 0, 2, 1, 4, 7,
+    1, 2, 7, 4, 6, 5, 0, 3, 4, 7, 2, 1, 3, 0, 5, 6,
+    2, 1, 4, 7, 5, 6, 3, 0, 7, 4, 1, 2, 0, 3, 6, 5,
+    3, 0, 5, 6, 4, 7, 2, 1, 6, 5, 0, 3, 1, 2, 7, 4,
+    4, 7, 2, 1, 3, 0, 5, 6, 1, 2, 7, 4, 6, 5, 0, 3,
+    5, 6, 3, 0, 2, 1, 4, 7, 0, 3, 6, 5, 7, 4, 1, 2,
+    6, 5, 0, 3, 1, 2, 7, 4, 3, 0, 5, 6, 4, 7, 2, 1,
+    7, 4, 1, 2, 0, 3, 6, 5, 2, 1, 4, 7, 5, 6, 3, 0,
+    3, 0, 5, 6, 4, 7, 2, 1, 6, 5, 0, 3, 1, 2, 7, 4,
+    2, 1, 4, 7, 5, 6, 3, 0, 7, 4, 1, 2, 0, 3, 6, 5,
+    1, 2, 7, 4, 6, 5, 0, 3, 4, 7, 2, 1, 3, 0, 5, 6,
+    0, 3, 6, 5, 7, 4, 1, 2, 5, 6, 3, 0, 2, 1, 4, 7,
+    7, 4, 1, 2, 0, 3, 6, 5, 2, 1, 4, 7, 5, 6, 3, 0,
+    6, 5, 0, 3, 1, 2, 7, 4, 3, 0, 5, 6, 4, 7, 2, 1,
+    5, 6, 3, 0, 2, 1, 4, 7, 0, 3, 6, 5, 7, 4, 1, 2,
+    4, 7, 2, 1, 3, 0, 5, 6, 1, 2, 7, 4, 6, 5, 0, 3,
+};
+
+static const uint8_t crc5_table[256] = {
+    0, 5, 10, 15, 20, 17, 30, 27, 13, 8, 7, 2, 25, 28, 19, 22,
+    26, 31, 16, 21, 14, 11, 4, 1, 23, 18, 29, 24, 3, 6, 9, 12,
+    17, 20, 27, 30, 5, 0, 15, 10, 28, 25, 22, 19, 8, 13, 2, 7,
+    11, 14, 1, 4, 31, 26, 21, 16, 6, 3, 12, 9, 18, 23, 24, 29,
+    7, 2, 13, 8, 19, 22, 25, 28, 10, 15, 0, 5, 30, 27, 20, 17,
+    29, 24, 23, 18, 9, 12, 3, 6, 16, 21, 26, 31, 4, 1, 14, 11,
+    22, 19, 28, 25, 2, 7, 8, 13, 27, 30, 17, 20, 15, 10, 5, 0,
+    12, 9, 6, 3, 24, 29, 18, 23, 1, 4, 11, 14, 21, 16, 31, 26,
+    14, 11, 4, 1, 26, 31, 16, 21, 3, 6, 9, 12, 23, 18, 29, 24,
+    20, 17, 30, 27, 0, 5, 10, 15, 25, 28, 19, 22, 13, 8, 7, 2,
+    31, 26, 21, 16, 11, 14, 1, 4, 18, 23, 24, 29, 6, 3, 12, 9,
+    5, 0, 15, 10, 17, 20, 27, 30, 8, 13, 2, 7, 28, 25, 22, 19,
+    9, 12, 3, 6, 29, 24, 23, 18, 4, 1, 14, 11, 16, 21, 26, 31,
+    19, 22, 25, 28, 7, 2, 13, 8, 30, 27, 20, 17, 10, 15, 0, 5,
+    24, 29, 18, 23, 12, 9, 6, 3, 21, 16, 31, 26, 1, 4, 11, 14,
+    2, 7, 8, 13, 22, 19, 28, 25, 15, 10, 5, 0, 27, 30, 17, 20,
+};
 
-        res[0] = res[1];
-        res[1] = res[2] ^ inv;
-        res[2] = inv;
+/**
+  Table driven CRC of 'nbits' bits packed MSB first into 64 bit words.
+
+  @param n CRC lenght (up to 8 bits)
+  @param poly Feedback polynome (without x^n)
+  @return CRC, MSB is the first CRC bit
+  */
+static uint8_t mk_crc_packed(const uint8_t *table, int n, uint8_t poly,
+        const uint64_t *bits, int nbits)
+{
+    uint8_t r = 0;
+    int i = 0;
+    for ( ; i + 8 <= nbits; i += 8) {
+        const uint8_t byte = bits[i / 64] >> (56 - i % 64);
+        r = table[byte ^ (uint8_t)(r << (8 - n))];
     }
+    for ( ; i < nbits; ++i) {
+        const int inv = ((bits[i / 64] >> (63 - i % 64)) & 1) ^ (r >> (n - 1));
+        r = ((r << 1) & ((1 << n) - 1)) ^ (inv ? poly : 0);
+    }
+
+    return r;
 }
 
-// http://ghsi.de/CRC/index.php?Polynom=10010
-static void mk_crc5(uint8_t *res, const uint8_t *input, int input_len)
+static uint64_t rotl(uint64_t x, int n, int len)
 {
-    uint8_t inv;
-    memset(res, 0, 5);
-
-    for (int i = 0; i < input_len; ++i)
-    {
-        inv = input[i] ^ res[0];
-
-        res[0] = res[1];
-        res[1] = res[2];
-        res[2] = res[3] ^ inv;
-        res[3] = res[4];
-        res[4] = inv;
-    }
+    return ((x << n) | (x >> (len - n))) & ((1ULL << len) - 1);
 }
 
 /**
   PAS 0001-2 6.1.2
   PAS 0001-2 6.2.2
-*/
-static int decode_data_frame(uint8_t *res, uint8_t *err, const uint8_t *in, int res_len)
-{
-#ifdef GET_IN_
-#error "Collision in definition of macro GET_IN_!"
-#endif
-#define GET_IN_(x, y) in[((x) + (y)) % (2*res_len)]
 
-    int errs = 0;
+  Whole block is decoded at once, with E and O being even and odd input bits
+    res[i] = E[i+1] ^ O[i+1]
+    err[i] = O[i+2] ^ E[i+3] ^ O[i+3] ^ res[i]
+  indexes are modulo res_len (code is tail-biting).
+
+  @param err Error flags, same layout as result.
+  @param in Input bits, one bit per byte, 2*res_len bits.
+  @param res_len Number of decoded bits, up to 63.
+  @return Decoded bits, first bit is MSB of lower res_len bits.
+  */
+static uint64_t decode_data_frame(uint64_t *err, const uint8_t *in, int res_len)
+{
+    uint64_t even = 0;
+    uint64_t odd = 0;
     for (int i = 0; i < res_len; ++i) {
-        res[i] = GET_IN_(2*i, 2) ^ GET_IN_(2*i, 3);
-        err[i] = GET_IN_(2*i, 5) ^ GET_IN_(2*i, 6) ^ GET_IN_(2*i, 7);
-
-        // we have 2 solutions, if match set to 0, 1 othervise
-        err[i] ^= res[i];
-        errs += err[i];
+        even = (even << 1) | in[2*i];
+        odd = (odd << 1) | in[2*i + 1];
     }
-#undef GET_IN_
 
-    return errs;
+    const uint64_t x = even ^ odd;
+    const uint64_t res = rotl(x, 1, res_len);
+    // we have 2 solutions, if match set to 0, 1 othervise
+    *err = rotl(odd, 2, res_len) ^ rotl(x, 3, res_len) ^ res;
+
+    return res;
 }
 
 void data_block_decode_frame(data_block_t *data_blk, const uint8_t *data,
@@ -70,27 +132,44 @@ void data_block_decode_frame(data_block_t *data_blk, const uint8_t *data,
 {
     data_blk->frame_no = frame_no;
     data_blk->nerrs = 0;
+    data_blk->data[0] = data_blk->data[1] = 0;
+    data_blk->err[0] = data_blk->err[1] = 0;
 
     data_blk->fr_type = fr_type;
 
     if (fr_type == FRAME_TYPE_DATA) {
+        uint64_t err1, err2;
         // decode first 52 bites of frame
-        data_blk->nerrs = decode_data_frame(
-                data_blk->data, data_blk->err, data, 26);
+        const uint64_t res1 = decode_data_frame(&err1, data, 26);
         // decode remaining part of frame
-        data_blk->nerrs += decode_data_frame(
-                data_blk->data + 26, data_blk->err + 26, data + 2*26, 50);
-        if (!data_blk->nerrs && ( data_blk->data[74] || data_blk->data[75] )) {
+        const uint64_t res2 = decode_data_frame(&err2, data + 2*26, 50);
+
+        data_blk->data[0] = (res1 << 38) | (res2 >> 12);
+        data_blk->data[1] = res2 << 52;
+        data_blk->err[0] = (err1 << 38) | (err2 >> 12);
+        data_blk->err[1] = err2 << 52;
+        data_blk->nerrs = __builtin_popcountll(err1) +
+            __builtin_popcountll(err2);
+
+        const int pad = (data_blk->data[1] >> 52) & 3;
+        if (!data_blk->nerrs && pad) {
             LOG(WTF, "nonzero padding in frame %d: %d %d", frame_no,
-                    data_blk->data[74], data_blk->data[75]);
+                    pad >> 1, pad & 1);
         }
     } else if (fr_type == FRAME_TYPE_VOICE) {
+        uint64_t err;
         // decode protected part of frame (first 52 bits)
-        data_blk->nerrs = decode_data_frame(
-            data_blk->data, data_blk->err, data, 26);
+        const uint64_t res = decode_data_frame(&err, data, 26);
+        data_blk->data[0] = res << 38;
+        data_blk->err[0] = err << 38;
+        data_blk->nerrs = __builtin_popcountll(err);
 
         // append unprotected part
-        memcpy(data_blk->data + 26, data + 2*26, 100);
+        for (int i = 0; i < 100; ++i) {
+            const int pos = 26 + i;
+            data_blk->data[pos / 64] |=
+                (uint64_t)data[2*26 + i] << (63 - pos % 64);
+        }
     } else if (fr_type == FRAME_TYPE_HR_DATA) {
         // TODO
         LOG(ERR, "decoding frame type %d not implemented", fr_type);
@@ -100,32 +179,59 @@ void data_block_decode_frame(data_block_t *data_blk, const uint8_t *data,
         LOG(ERR, "decoding frame type %d not implemented", fr_type);
         data_blk->nerrs = INT_MAX;
     }
+
+    TRACE(block_decoded, frame_no, fr_type, data_blk->nerrs);
+}
+
+bool data_block_check_hr_data(const data_block_t *data_blk,
+        const uint8_t *data)
+{
+    // the first 26 bits are coded as in data block
+    if (data_blk->fr_type != FRAME_TYPE_DATA || data_blk->err[0] >> 38) {
+        return false;
+    }
+
+    uint64_t bits[2] = { data_blk->data[0] & ~((1ULL << 38) - 1), 0, };
+    for (int i = 0; i < 100; ++i) {
+        const int pos = 26 + i;
+        bits[pos / 64] |= (uint64_t)data[2*26 + i] << (63 - pos % 64);
+    }
+
+    return data_block_check_crc_packed(bits, FRAME_TYPE_HR_DATA);
 }
 
 bool data_block_check_crc(data_block_t *data_blk)
 {
     if (data_blk->fr_type == FRAME_TYPE_AUTO) {
-        data_blk->fr_type = data_blk->data[0];
-    } else {
-        if (data_blk->fr_type != data_blk->data[0]) {
-            return false;
-        }
+        data_blk->fr_type = data_block_get_bit(data_blk, 0);
     }
 
-    if (data_blk->fr_type == FRAME_TYPE_DATA) {
-        uint8_t crc[5];
+    return data_block_check_crc_packed(data_blk->data, data_blk->fr_type);
+}
 
-        mk_crc5(crc, data_blk->data, 69);
-        return !memcmp(data_blk->data + 69, crc, 5);
+bool data_block_check_crc_packed(const uint64_t *bits, frame_type_t fr_type)
+{
+    const frame_type_t type = bits[0] >> 63;
+    if (fr_type == FRAME_TYPE_HR_DATA) {
+        const int pos = HR_DATA_BLOCK_CRC_POS - 64;
+        const uint8_t crc = (bits[1] >> (64 - pos - 5)) & 0x1f;
+        // stuffing bits 100-127 (the last 2 are not part of the block)
+        return type == FRAME_TYPE_DATA && !(bits[1] << (pos + 5)) &&
+            mk_crc_packed(crc5_table, 5, 0x05, bits,
+                    HR_DATA_BLOCK_CRC_POS) == crc;
     }
 
-    if (data_blk->fr_type == FRAME_TYPE_VOICE) {
-        uint8_t crc[3];
-        const uint8_t ok[3] = {0, 1, 0}; // residue accounting for inverted CRC bits
+    if (fr_type != FRAME_TYPE_AUTO && fr_type != type) {
+        return false;
+    }
 
-        // discriminator + 22 voice protected bits + 3 CRC bits
-        mk_crc3(crc, data_blk->data, 26);
-        return !memcmp(crc, ok, 3);
+    if (type == FRAME_TYPE_DATA) {
+        // CRC is in bits 69-73
+        const uint8_t crc = (bits[1] >> (128 - 74)) & 0x1f;
+        return mk_crc_packed(crc5_table, 5, 0x05, bits, 69) == crc;
     }
-    return false;
+
+    // discriminator + 22 voice protected bits + 3 CRC bits,
+    // residue accounting for inverted CRC bits
+    return mk_crc_packed(crc3_table, 3, 0x03, bits, 26) == 0x02;
 }
@@ -3,6 +3,7 @@
 #include <tetrapol/system_config.h>
 #include <tetrapol/data_frame.h>
 #include <tetrapol/misc.h>
+#include <tetrapol/trace.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,11 +17,16 @@ enum {
 };
 
 struct _data_frame_t {
-    data_block_t data_blks[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
     int fn[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
     bool crc_ok[SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1];
     int nblks;
     int nerrs;
+    int err_blk_no;         ///< block with CRC error, valid when nerrs == 1
+    uint64_t err_data[2];   ///< bits of block with CRC error
+    uint64_t parity[2];     ///< XOR of all blocks of current frame
+    /// data bits (3-66) of blocks, packed into bytes as blocks arrive
+    uint8_t bytes[8 * (SYS_PAR_DATA_FRAME_BLOCKS_MAX + 1)];
+    data_frame_stats_t stats;
 };
 
 data_frame_t *data_frame_create(void)
@@ -29,10 +35,20 @@ data_frame_t *data_frame_create(void)
     if (!data_fr) {
         return NULL;
     }
+    data_frame_init(data_fr);
 
+    return data_fr;
+}
+
+void data_frame_init(data_frame_t *data_fr)
+{
     data_frame_reset(data_fr);
+    memset(&data_fr->stats, 0, sizeof(data_fr->stats));
+}
 
-    return data_fr;
+size_t data_frame_sizeof(void)
+{
+    return sizeof(data_frame_t);
 }
 
 void data_frame_destroy(data_frame_t *data_fr)
@@ -40,6 +56,12 @@ void data_frame_destroy(data_frame_t *data_fr)
     free(data_fr);
 }
 
+void data_frame_get_stats(const data_frame_t *data_fr,
+        data_frame_stats_t *stats)
+{
+    memcpy(stats, &data_fr->stats, sizeof(*stats));
+}
+
 int data_frame_blocks(data_frame_t *data_fr)
 {
     return data_fr->nblks;
@@ -49,48 +71,56 @@ void data_frame_reset(data_frame_t *data_fr)
 {
     data_fr->nblks = 0;
     data_fr->nerrs = 0;
+    data_fr->parity[0] = data_fr->parity[1] = 0;
 }
 
-static bool check_parity(data_frame_t *data_fr)
+/**
+  Pack data bits (3-66) of block into 8 bytes of frame at position of block
+  blk_no, TETRAPOL bit order is used (first bit is LSB of byte).
+  */
+static void pack_block(data_frame_t *data_fr, const uint64_t *data, int blk_no)
 {
-    for (int i = 3; i < 3 + 64; ++i) {
-        int parity = 0;
-        for (int blk_no = 0; blk_no < data_fr->nblks; ++blk_no) {
-            parity ^= data_fr->data_blks[blk_no].data[i];
-        }
-        if (parity) {
-            return false;
-        }
+    uint64_t bits = (data[0] << 3) | (data[1] >> 61);
+    // reverse bits in each byte, first bit goes into LSB
+    bits = ((bits >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((bits & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+
+    uint8_t *bytes = &data_fr->bytes[8 * blk_no];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = bits >> (56 - 8 * i);
     }
+}
 
-    return true;
+// data bits 3-66 are protected by parity block, bits 1-2 (FN) are fixed too
+#define PARITY_MASK0 (~0ULL >> 3)
+#define PARITY_MASK1 (~0ULL << 61)
+#define FIX_MASK0 (~0ULL >> 1)
+
+static bool check_parity(data_frame_t *data_fr)
+{
+    return !(data_fr->parity[0] & PARITY_MASK0) &&
+        !(data_fr->parity[1] & PARITY_MASK1);
 }
 
 static void fix_by_parity(data_frame_t *data_fr)
 {
-    int err_blk_no = 0;
-
-    for (int blk_no = 0; blk_no < data_fr->nblks; ++blk_no) {
-        if (!data_fr->crc_ok[blk_no]) {
-            err_blk_no = blk_no;
-            break;
-        }
-    }
-
     // do not fix parity frame
-    if (err_blk_no == data_fr->nblks - 1) {
+    if (data_fr->err_blk_no == data_fr->nblks - 1) {
         return;
     }
 
-    for (int i = 1; i < 1 + 64 + 2; ++i) {
-        int bit = 0;
-        for (int blk_no = 0; blk_no < data_fr->nblks; ++blk_no) {
-            if (blk_no != err_blk_no) {
-                bit ^= data_fr->data_blks[blk_no].data[i];
-            }
-            data_fr->data_blks[err_blk_no].data[i] = bit;
-        }
-    }
+    // XOR of all other blocks
+    const uint64_t *err = data_fr->err_data;
+    const uint64_t bits0 = data_fr->parity[0] ^ err[0];
+    const uint64_t bits1 = data_fr->parity[1] ^ err[1];
+
+    ++data_fr->stats.parity_fixes;
+    const uint64_t data[2] = {
+        (err[0] & ~FIX_MASK0) | (bits0 & FIX_MASK0),
+        (err[1] & ~PARITY_MASK1) | (bits1 & PARITY_MASK1),
+    };
+    pack_block(data_fr, data, data_fr->err_blk_no);
 }
 
 static bool data_frame_check_multiblock(data_frame_t *data_fr)
@@ -100,6 +130,7 @@ static bool data_frame_check_multiblock(data_frame_t *data_fr)
     } else {
         if (!check_parity(data_fr)) {
             LOG(ERR, "MB parity error %d", data_fr->nblks);
+            ++data_fr->stats.parity_errs;
             data_frame_reset(data_fr);
             return false;
         }
@@ -108,13 +139,13 @@ static bool data_frame_check_multiblock(data_frame_t *data_fr)
     return true;
 }
 
-bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
+static bool push_data_block(data_frame_t *data_fr,
+        const data_block_t *data_blk, bool crc_ok)
 {
-    if (data_fr->nblks == ARRAY_LEN(data_fr->data_blks)) {
+    if (data_fr->nblks == ARRAY_LEN(data_fr->fn)) {
         data_frame_reset(data_fr);
     }
 
-    const bool crc_ok = data_block_check_crc(data_blk) && !data_blk->nerrs;
     data_fr->nerrs += crc_ok ? 0 : 1;
     data_fr->crc_ok[data_fr->nblks] = crc_ok;
 
@@ -123,10 +154,18 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         return false;
     }
 
-    const int fn = data_blk->data[1] | (data_blk->data[2] << 1);
+    const int fn = data_block_get_bit(data_blk, 1) |
+        (data_block_get_bit(data_blk, 2) << 1);
     data_fr->fn[data_fr->nblks] = fn;
 
-    memcpy(&data_fr->data_blks[data_fr->nblks], data_blk, sizeof(data_block_t));
+    if (!crc_ok) {
+        data_fr->err_blk_no = data_fr->nblks;
+        data_fr->err_data[0] = data_blk->data[0];
+        data_fr->err_data[1] = data_blk->data[1];
+    }
+    data_fr->parity[0] ^= data_blk->data[0];
+    data_fr->parity[1] ^= data_blk->data[1];
+    pack_block(data_fr, data_blk->data, data_fr->nblks);
     ++data_fr->nblks;
 
     // single frame
@@ -139,6 +178,7 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         }
         if (fn != FN_01) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
         }
         return false;
@@ -152,6 +192,7 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         if (!crc_ok) {
             if (fn_prev != FN_01) {
                 LOG(DBG, "MB err");
+                ++data_fr->stats.seq_errs;
                 data_frame_reset(data_fr);
             }
             return false;
@@ -159,6 +200,7 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         if (fn == FN_11) {
             if (!crc_ok_prev) {
                 LOG(DBG, "MB err");
+                ++data_fr->stats.seq_errs;
                 data_frame_reset(data_fr);
                 return false;
             }
@@ -166,8 +208,9 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         }
         if (fn != FN_10) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
-            return data_frame_push_data_block(data_fr, data_blk);
+            return push_data_block(data_fr, data_blk, crc_ok);
         }
         return false;
     }
@@ -179,8 +222,9 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
         }
         if (fn != FN_10 && fn != FN_11) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
-            return data_frame_push_data_block(data_fr, data_blk);
+            return push_data_block(data_fr, data_blk, crc_ok);
         }
         return false;
     }
@@ -196,6 +240,7 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
     if (fn == FN_11) {
         if (fn_prev != FN_11 && crc_ok_prev) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
         }
         return false;
@@ -205,6 +250,7 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
     if (fn == FN_10) {
         if (fn_prev != FN_11 && crc_ok_prev) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
         }
         return false;
@@ -213,54 +259,46 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
     if (fn == FN_01) {
         if (fn_prev != FN_10 && crc_ok_prev) {
             LOG(DBG, "MB err");
+            ++data_fr->stats.seq_errs;
             data_frame_reset(data_fr);
-            return false;
+            // block might start a new frame
+            return push_data_block(data_fr, data_blk, crc_ok);
         }
-        return data_frame_check_multiblock(data_fr);
+        if (data_frame_check_multiblock(data_fr)) {
+            return true;
+        }
+        // FN 01 is used by parity block and by first block of frame
+        return push_data_block(data_fr, data_blk, crc_ok);
     }
 
     LOG(DBG, "MB err");
+    ++data_fr->stats.seq_errs;
     data_frame_reset(data_fr);
-    return data_frame_push_data_block(data_fr, data_blk);
+    return push_data_block(data_fr, data_blk, crc_ok);
 }
 
-/**
-  Pack bits from one bit per byte into 8 bits per byte (TETRAPOL bite order).
-
-  Data are ORed, so do not forrget to initialise output buffer with zeres.
-
-  @param bytes Output byte array.
-  @param bits Input array of bits.
-  @param offs Number of bites already used in output.
-  @param nbits Number of bites to be used;
-  */
-static void pack_bits(uint8_t *bytes, const uint8_t *bits, int offs, int nbits)
+bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk)
 {
-    bytes += offs / 8;
-    offs %= 8;
-
-    while (nbits > 0) {
-        while (offs < 8 && nbits) {
-            *bytes |= (*bits) << offs;
-            ++offs;
-            --nbits;
-            ++bits;
-        }
-        offs = 0;
-        ++bytes;
+    const bool crc_ok = data_block_check_crc(data_blk) && !data_blk->nerrs;
+    ++data_fr->stats.blocks;
+    data_fr->stats.crc_errs += crc_ok ? 0 : 1;
+
+    if (!push_data_block(data_fr, data_blk, crc_ok)) {
+        return false;
     }
+    ++data_fr->stats.frames;
+    TRACE(data_frame_complete, data_blk->frame_no, data_fr->nblks,
+            data_fr->nerrs);
+
+    return true;
 }
 
-int data_frame_get_bytes(data_frame_t *data_fr, uint8_t *data)
+int data_frame_get_bytes(data_frame_t *data_fr, const uint8_t **data)
 {
     const int nblks = (data_fr->nblks <= 2) ?
         data_fr->nblks : data_fr->nblks - 1;
 
-    memset(data, 0, 8*nblks);
-    for (int blk_no = 0; blk_no < nblks; ++blk_no) {
-        pack_bits(data, data_fr->data_blks[blk_no].data + 3, 64*blk_no, 64);
-    }
-
+    *data = data_fr->bytes;
     data_frame_reset(data_fr);
 
     return nblks * 64;
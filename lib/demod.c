@@ -0,0 +1,288 @@
+#define LOG_PREFIX "demod"
+#include <tetrapol/log.h>
+#include <tetrapol/demod.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// samples are converted and discriminated in batches
+#define BATCH 256
+// cubic interpolator uses 1 sample before and 2 after interpolated instant
+#define INTERP_TAPS 4
+
+// clock recovery parameters, the same as in demod/tetrapol_rx.py
+#define OMEGA_MID ((float)DEMOD_SAMPLES_PER_SYMBOL)
+#define OMEGA_REL_LIMIT 0.005f
+#define GAIN_MU 0.05f
+#define GAIN_OMEGA (0.25f * GAIN_MU * GAIN_MU)
+#define MU_INIT 0.5f
+
+#define PI_F 3.14159265f
+/// scale output of discriminator to +-1 for symbol, as GNU Radio gmsk_demod
+#define FM_GAIN (2 * DEMOD_SAMPLES_PER_SYMBOL / PI_F)
+/// frequency (Hz) for discriminator output 1, deviation of MSK
+#define FM_DEV ((float)DEMOD_SAMPLE_RATE / DEMOD_SAMPLES_PER_SYMBOL / 4)
+
+/**
+  Discriminator is vectorized by GCC vector extensions, compiled into
+  SSE2 on x86-64 and NEON on AArch64, wider vectors require -march.
+  */
+#define NLANES 4
+typedef float lanes_t __attribute__((vector_size(4 * NLANES)));
+typedef int32_t mask_t __attribute__((vector_size(4 * NLANES)));
+
+struct _demod_t {
+    int input_fmt;
+    float last_re;      ///< last input sample, required by discriminator
+    float last_im;
+    float omega;        ///< tracked number of samples per symbol
+    float mu;           ///< fractional offset of next symbol
+    float last_sym;     ///< value of last symbol (before slicing)
+    int ifreq;          ///< index of sample preceding the next symbol
+    int nfreq;          ///< number of valid samples in 'freq'
+    float freq_corr;    ///< subtracted from discriminator output
+    float freq_err;     ///< average difference of symbols and sliced symbols
+    int nsyms;          ///< symbols in freq_err, up to DEMOD_AVG_SYMBOLS
+    float power;        ///< average of |sample|^2
+    int npower;         ///< samples in power, up to DEMOD_AVG_SAMPLES
+    /// discriminator output, unused samples are kept for next batch
+    float freq[INTERP_TAPS + BATCH];
+};
+
+demod_t *demod_create(int input_fmt)
+{
+    if (input_fmt != DEMOD_INPUT_CF32 && input_fmt != DEMOD_INPUT_CS16) {
+        LOG(ERR, "demod_create() invalid param 'input_fmt'");
+        return NULL;
+    }
+
+    demod_t *demod = calloc(1, sizeof(demod_t));
+    if (!demod) {
+        return NULL;
+    }
+
+    demod->input_fmt = input_fmt;
+    demod->omega = OMEGA_MID;
+    demod->mu = MU_INIT;
+    // interpolator requires one sample before the first symbol
+    demod->nfreq = 1;
+    demod->ifreq = 1;
+
+    return demod;
+}
+
+void demod_destroy(demod_t *demod)
+{
+    free(demod);
+}
+
+int demod_sample_size(const demod_t *demod)
+{
+    return (demod->input_fmt == DEMOD_INPUT_CF32) ?
+        2 * sizeof(float) : 2 * sizeof(int16_t);
+}
+
+static inline lanes_t lanes_select(mask_t m, lanes_t a, lanes_t b)
+{
+    return (lanes_t)((m & (mask_t)a) | (~m & (mask_t)b));
+}
+
+/**
+  Approximation of atan2() for all lanes, max. error is about 2e-4 rad.
+
+  Argument is reduced into <0, 1> by octant symmetry, then minimax
+  polynomial for atan() is used.
+  */
+static inline lanes_t lanes_atan2(lanes_t y, lanes_t x)
+{
+    const mask_t sign = (mask_t){ INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN, };
+    const lanes_t ax = (lanes_t)((mask_t)x & ~sign);
+    const lanes_t ay = (lanes_t)((mask_t)y & ~sign);
+    const mask_t swap = ay > ax;
+    const lanes_t mx = lanes_select(swap, ay, ax);
+    const lanes_t mn = lanes_select(swap, ax, ay);
+    // mx == 0 only for x == y == 0, result is 0 as for atan2()
+    const lanes_t a = mn / (mx + 1e-30f);
+    const lanes_t s = a * a;
+    lanes_t r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    r = lanes_select(swap, PI_F / 2 - r, r);
+    r = lanes_select(x < 0, PI_F - r, r);
+
+    return (lanes_t)((mask_t)r | ((mask_t)y & sign));
+}
+
+/**
+  FM discriminator, append instantaneous frequency of 'n' samples
+  (n <= BATCH) into demod->freq.
+  */
+static void discriminate(demod_t *demod, const void *samples, int n)
+{
+    // index 0 is the last sample of previous batch, padded by zeros
+    // to multiple of NLANES
+    float re[BATCH + 1];
+    float im[BATCH + 1];
+    re[0] = demod->last_re;
+    im[0] = demod->last_im;
+    if (demod->input_fmt == DEMOD_INPUT_CF32) {
+        const float *s = samples;
+        for (int i = 0; i < n; ++i) {
+            re[i + 1] = s[2 * i];
+            im[i + 1] = s[2 * i + 1];
+        }
+    } else {
+        // discriminator is scale invariant, no normalization is required
+        const int16_t *s = samples;
+        for (int i = 0; i < n; ++i) {
+            re[i + 1] = s[2 * i];
+            im[i + 1] = s[2 * i + 1];
+        }
+    }
+    const int nlanes = (n + NLANES - 1) / NLANES * NLANES;
+    for (int i = n; i < nlanes; ++i) {
+        re[i + 1] = im[i + 1] = 0;
+    }
+    demod->last_re = re[n];
+    demod->last_im = im[n];
+
+    float *out = &demod->freq[demod->nfreq];
+    // padding has zero power
+    lanes_t pwr = { 0, 0, 0, 0, };
+    for (int i = 0; i < nlanes; i += NLANES) {
+        lanes_t r0, i0, r1, i1;
+        memcpy(&r0, &re[i], sizeof(r0));
+        memcpy(&i0, &im[i], sizeof(i0));
+        memcpy(&r1, &re[i + 1], sizeof(r1));
+        memcpy(&i1, &im[i + 1], sizeof(i1));
+        // phase of s[i + 1] * conj(s[i])
+        const lanes_t f = lanes_atan2(i1 * r0 - r1 * i0, r1 * r0 + i1 * i0) *
+            FM_GAIN - demod->freq_corr;
+        pwr += r1 * r1 + i1 * i1;
+        if (i + NLANES <= n) {
+            memcpy(&out[i], &f, sizeof(f));
+        } else {
+            memcpy(&out[i], &f, (n - i) * sizeof(float));
+        }
+    }
+    demod->nfreq += n;
+
+    // moving average, weight of batch is proportional to its length, the
+    // first samples are averaged with equal weight
+    const float mean = (pwr[0] + pwr[1] + pwr[2] + pwr[3]) / n;
+    demod->npower += n;
+    if (demod->npower > DEMOD_AVG_SAMPLES) {
+        demod->npower = DEMOD_AVG_SAMPLES;
+    }
+    demod->power += (mean - demod->power) * ((float)n / demod->npower);
+}
+
+/// Cubic Lagrange interpolation between x[1] and x[2], 0 <= mu < 1.
+static inline float interpolate(const float *x, float mu)
+{
+    const float m1 = mu + 1;
+    const float m_1 = mu - 1;
+    const float m_2 = mu - 2;
+
+    return (x[3] * m1 * mu * m_1 - x[0] * mu * m_1 * m_2) * (1.0f / 6) +
+        (x[1] * m1 * m_1 * m_2 - x[2] * m1 * mu * m_2) * 0.5f;
+}
+
+// branchless, decisions are random and would be mispredicted
+static inline float slice(float x)
+{
+    return __builtin_copysignf(1.0f, x);
+}
+
+/**
+  Mueller-Muller clock recovery and binary slicer, the same loop as
+  GNU Radio clock_recovery_mm_ff followed by binary_slicer_fb.
+
+  @return number of bits written into 'bits'
+  */
+static int clock_recovery(demod_t *demod, uint8_t *bits)
+{
+    const float omega_min = OMEGA_MID * (1 - OMEGA_REL_LIMIT);
+    const float omega_max = OMEGA_MID * (1 + OMEGA_REL_LIMIT);
+    float omega = demod->omega;
+    float mu = demod->mu;
+    float last_sym = demod->last_sym;
+    float freq_err = demod->freq_err;
+    int nsyms = demod->nsyms;
+    int i = demod->ifreq;
+    int nbits = 0;
+
+    while (i + 2 < demod->nfreq) {
+        const float sym = interpolate(&demod->freq[i - 1], mu);
+        bits[nbits++] = sym >= 0;
+        if (nsyms < DEMOD_AVG_SYMBOLS) {
+            ++nsyms;
+        }
+        freq_err += (sym - slice(sym) - freq_err) / nsyms;
+
+        const float mm = slice(last_sym) * sym - slice(sym) * last_sym;
+        last_sym = sym;
+        omega += GAIN_OMEGA * mm;
+        omega = (omega < omega_min) ? omega_min :
+            (omega > omega_max) ? omega_max : omega;
+        mu += omega + GAIN_MU * mm;
+        const int step = (int)mu;
+        i += step;
+        mu -= step;
+    }
+
+    // interpolated |sym| < 1.25 * FM_GAIN * PI, so GAIN_MU * mm < 1,
+    // step <= 3 and the samples for the next symbol are still in buffer
+    const int keep = demod->nfreq - (i - 1);
+    memmove(demod->freq, &demod->freq[i - 1], keep * sizeof(float));
+    demod->nfreq = keep;
+    demod->ifreq = 1;
+    demod->omega = omega;
+    demod->mu = mu;
+    demod->last_sym = last_sym;
+    demod->freq_err = freq_err;
+    demod->nsyms = nsyms;
+
+    return nbits;
+}
+
+int demod_process(demod_t *demod, const void *samples, int nsamples,
+        uint8_t *bits)
+{
+    const uint8_t *s = samples;
+    const int sample_size = demod_sample_size(demod);
+    int nbits = 0;
+
+    while (nsamples > 0) {
+        const int n = (nsamples > BATCH) ? BATCH : nsamples;
+        discriminate(demod, s, n);
+        nbits += clock_recovery(demod, bits + nbits);
+        s += n * sample_size;
+        nsamples -= n;
+    }
+
+    return nbits;
+}
+
+float demod_get_freq_offset(const demod_t *demod)
+{
+    return (demod->freq_corr + demod->freq_err) * FM_DEV;
+}
+
+void demod_set_freq_correction(demod_t *demod, float freq)
+{
+    demod->freq_corr = freq / FM_DEV;
+}
+
+float demod_get_freq_correction(const demod_t *demod)
+{
+    return demod->freq_corr * FM_DEV;
+}
+
+float demod_get_power(const demod_t *demod)
+{
+    // full scale of CS16 input
+    const float scale = (demod->input_fmt == DEMOD_INPUT_CF32) ?
+        1.0f : 1.0f / (32768.0f * 32768.0f);
+
+    return 10 * log10f(demod->power * scale + 1e-20f);
+}
@@ -0,0 +1,55 @@
+#include <tetrapol/dup_cache.h>
+#include <tetrapol/misc.h>
+
+#include <string.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// FNV-1a, payloads are short (up to a few hundreds of bytes)
+static uint64_t payload_hash(const uint8_t *data, int len)
+{
+    uint64_t h = FNV_OFFSET ^ len;
+    for (int i = 0; i < len; ++i) {
+        h = (h ^ data[i]) * FNV_PRIME;
+    }
+
+    return h;
+}
+
+void dup_cache_init(dup_cache_t *dc)
+{
+    memset(dc, 0, sizeof(*dc));
+}
+
+dup_cache_entry_t *dup_cache_lookup(dup_cache_t *dc, const uint8_t *data,
+        int len)
+{
+    dc->hash = payload_hash(data, len);
+    ++dc->clock;
+    for (int i = 0; i < ARRAY_LEN(dc->entries); ++i) {
+        dup_cache_entry_t *e = &dc->entries[i];
+        if (e->seen && e->hash == dc->hash) {
+            e->seen = dc->clock;
+            ++e->repeats;
+            return e;
+        }
+    }
+
+    return NULL;
+}
+
+void dup_cache_insert(dup_cache_t *dc, int tag)
+{
+    dup_cache_entry_t *e = &dc->entries[0];
+    for (int i = 1; i < ARRAY_LEN(dc->entries); ++i) {
+        if (dc->entries[i].seen < e->seen) {
+            e = &dc->entries[i];
+        }
+    }
+
+    e->hash = dc->hash;
+    e->seen = dc->clock;
+    e->repeats = 0;
+    e->tag = tag;
+}
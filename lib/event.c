@@ -0,0 +1,469 @@
+#define _POSIX_C_SOURCE 200809L
+
+#define LOG_PREFIX "event"
+#include <tetrapol/log.h>
+#include <tetrapol/event.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+/// records are never split between chunks
+#define EVENT_CHUNK_SIZE (4 * EVENT_REC_MAX)
+#define EVENT_NCHUNKS 8
+
+struct _event_writer_t {
+    int fd;
+    int nchunks;        ///< number of used chunks, last one is being filled
+    int len;            ///< bytes used in the last chunk
+    /// iov_len is valid for all used chunks except the last one
+    struct iovec iov[EVENT_NCHUNKS];
+    uint8_t chunks[EVENT_NCHUNKS][EVENT_CHUNK_SIZE];
+};
+
+// output cursor, overflow is checked once at the end of serialization
+typedef struct {
+    uint8_t *p;
+    uint8_t *end;
+    bool overflow;
+} ser_t;
+
+static void put_u8(ser_t *s, uint8_t v)
+{
+    if (s->p < s->end) {
+        *s->p++ = v;
+    } else {
+        s->overflow = true;
+    }
+}
+
+static void put_u16(ser_t *s, uint16_t v)
+{
+    put_u8(s, v);
+    put_u8(s, v >> 8);
+}
+
+static void put_bytes(ser_t *s, const uint8_t *data, int len)
+{
+    if (s->end - s->p < len) {
+        s->overflow = true;
+        return;
+    }
+    memcpy(s->p, data, len);
+    s->p += len;
+}
+
+static void put_addr(ser_t *s, const addr_t *addr)
+{
+    put_u8(s, addr->z);
+    put_u8(s, addr->y);
+    put_u16(s, addr->x);
+}
+
+static void put_cell_id(ser_t *s, const cell_id_t *cell_id)
+{
+    put_u8(s, cell_id->bs_id);
+    put_u8(s, cell_id->rws_id);
+}
+
+static void put_activation_mode(ser_t *s, const activation_mode_t *am)
+{
+    put_u8(s, am->hook);
+    put_u8(s, am->type);
+}
+
+static void d_data_end_serialize(ser_t *s, const tsdu_d_data_end_t *tsdu)
+{
+    put_u8(s, tsdu->cause);
+}
+
+static void d_datagram_serialize(ser_t *s, const tsdu_d_datagram_t *tsdu)
+{
+    put_u8(s, tsdu->call_priority);
+    put_u16(s, tsdu->message_reference);
+    put_u8(s, tsdu->key_reference._data);
+    put_u16(s, tsdu->len);
+    put_bytes(s, tsdu->data, tsdu->len);
+}
+
+static void d_datagram_notify_serialize(ser_t *s,
+        const tsdu_d_datagram_notify_t *tsdu)
+{
+    put_u8(s, tsdu->call_priority);
+    put_u16(s, tsdu->message_reference);
+    put_u8(s, tsdu->key_reference._data);
+    put_u8(s, tsdu->destination_port != -1);
+    if (tsdu->destination_port != -1) {
+        put_u16(s, tsdu->destination_port);
+    }
+}
+
+static void d_ech_overload_id_serialize(ser_t *s,
+        const tsdu_d_ech_overload_id_t *tsdu)
+{
+    put_activation_mode(s, &tsdu->activation_mode);
+    put_u16(s, tsdu->group_id);
+    put_cell_id(s, &tsdu->cell_id);
+    put_u8(s, tsdu->organisation);
+}
+
+static void d_explicit_short_data_serialize(ser_t *s,
+        const tsdu_d_explicit_short_data_t *tsdu)
+{
+    put_u16(s, tsdu->len);
+    put_bytes(s, tsdu->data, tsdu->len);
+}
+
+static void d_group_activation_serialize(ser_t *s,
+        const tsdu_d_group_activation_t *tsdu)
+{
+    put_activation_mode(s, &tsdu->activation_mode);
+    put_u16(s, tsdu->group_id);
+    put_u8(s, tsdu->coverage_id);
+    put_u16(s, tsdu->channel_id);
+    put_u8(s, tsdu->u_ch_scrambling);
+    put_u8(s, tsdu->d_ch_scrambling);
+    put_u8(s, tsdu->key_reference._data);
+    put_u8(s, tsdu->has_addr_tti);
+    if (tsdu->has_addr_tti) {
+        put_addr(s, &tsdu->addr_tti);
+    }
+}
+
+static void d_group_composition_serialize(ser_t *s,
+        const tsdu_d_group_composition_t *tsdu)
+{
+    put_u16(s, tsdu->group_id);
+    put_u8(s, tsdu->og_nb);
+    for (int i = 0; i < tsdu->og_nb; ++i) {
+        put_u16(s, tsdu->group_ids[i]);
+    }
+}
+
+static void d_group_list_serialize(ser_t *s, const tsdu_d_group_list_t *tsdu)
+{
+    put_u8(s, tsdu->nemergency);
+    for (int i = 0; i < tsdu->nemergency; ++i) {
+        put_cell_id(s, &tsdu->emergency[i].cell_id);
+    }
+    put_u8(s, tsdu->ngroup);
+    for (int i = 0; i < tsdu->ngroup; ++i) {
+        put_u8(s, tsdu->group[i].coverage_id);
+        put_u16(s, tsdu->group[i].neighbouring_cell);
+    }
+    put_u8(s, tsdu->nopen);
+    for (int i = 0; i < tsdu->nopen; ++i) {
+        const tsdu_d_group_list_open_t *open = &tsdu->open[i];
+        put_u8(s, open->coverage_id);
+        put_u8(s, open->call_priority);
+        put_u16(s, open->group_id);
+        put_u8(s, open->och_parameters.add);
+        put_u8(s, open->och_parameters.mbn);
+        put_u16(s, open->neighbouring_cell);
+    }
+    put_u8(s, tsdu->reference_list._data);
+    put_u8(s, tsdu->index_list._data);
+}
+
+static void d_neighbouring_cell_serialize(ser_t *s,
+        const tsdu_d_neighbouring_cell_t *tsdu)
+{
+    const int ncell_ids = tsdu->cell_ids ? tsdu->cell_ids->len : 0;
+    put_u8(s, ncell_ids);
+    for (int i = 0; i < ncell_ids; ++i) {
+        put_cell_id(s, &tsdu->cell_ids->cell_ids[i]);
+    }
+    const int ncell_bns = tsdu->cell_bns ? tsdu->cell_bns->len : 0;
+    put_u8(s, ncell_bns);
+    for (int i = 0; i < ncell_bns; ++i) {
+        put_addr(s, &tsdu->cell_bns->addrs[i]);
+    }
+    put_u8(s, tsdu->ccr_config.number);
+    put_u8(s, tsdu->ccr_param);
+    for (int i = 0; i < tsdu->ccr_config.number; ++i) {
+        put_u8(s, tsdu->adj_cells[i].bn_nb);
+        put_u16(s, tsdu->adj_cells[i].channel_id);
+        put_u8(s, tsdu->adj_cells[i].adjacent_param._data);
+    }
+}
+
+static void d_system_info_serialize(ser_t *s, const tsdu_d_system_info_t *tsdu)
+{
+    put_u8(s, tsdu->cell_state._data);
+    put_u8(s, tsdu->cell_config._data);
+    put_u8(s, tsdu->country_code);
+    put_u8(s, tsdu->system_id._data);
+    put_u8(s, tsdu->loc_area_id._data);
+    put_u8(s, tsdu->bn_id);
+    put_cell_id(s, &tsdu->cell_id);
+    put_u16(s, tsdu->cell_bn);
+    put_u8(s, tsdu->u_ch_scrambling);
+    put_u8(s, tsdu->cell_radio_param.tx_max);
+    put_u8(s, tsdu->cell_radio_param.radio_link_timeout);
+    put_u8(s, tsdu->cell_radio_param.pwr_tx_adjust);
+    put_u8(s, tsdu->cell_radio_param.rx_lev_access);
+    put_u8(s, tsdu->system_time);
+    put_u8(s, tsdu->cell_access._data);
+    put_u16(s, tsdu->superframe_cpt);
+    put_u8(s, tsdu->band);
+    put_u16(s, tsdu->channel_id);
+}
+
+static void d_seecret_serialize(ser_t *s, const tsdu_seecret_codop_t *tsdu)
+{
+    put_u16(s, tsdu->nbits);
+    put_bytes(s, tsdu->data, (tsdu->nbits + 7) / 8);
+}
+
+static void tsdu_d_serialize(ser_t *s, const tsdu_t *tsdu)
+{
+    switch (tsdu->codop) {
+        case D_DATA_END:
+            d_data_end_serialize(s, (const tsdu_d_data_end_t *)tsdu);
+            break;
+
+        case D_DATAGRAM:
+            d_datagram_serialize(s, (const tsdu_d_datagram_t *)tsdu);
+            break;
+
+        case D_DATAGRAM_NOTIFY:
+            d_datagram_notify_serialize(s,
+                    (const tsdu_d_datagram_notify_t *)tsdu);
+            break;
+
+        case D_ECH_OVERLOAD_ID:
+            d_ech_overload_id_serialize(s,
+                    (const tsdu_d_ech_overload_id_t *)tsdu);
+            break;
+
+        case D_EXPLICIT_SHORT_DATA:
+            d_explicit_short_data_serialize(s,
+                    (const tsdu_d_explicit_short_data_t *)tsdu);
+            break;
+
+        case D_GROUP_ACTIVATION:
+            d_group_activation_serialize(s,
+                    (const tsdu_d_group_activation_t *)tsdu);
+            break;
+
+        case D_GROUP_COMPOSITION:
+            d_group_composition_serialize(s,
+                    (const tsdu_d_group_composition_t *)tsdu);
+            break;
+
+        case D_GROUP_LIST:
+            d_group_list_serialize(s, (const tsdu_d_group_list_t *)tsdu);
+            break;
+
+        case D_NEIGHBOURING_CELL:
+            d_neighbouring_cell_serialize(s,
+                    (const tsdu_d_neighbouring_cell_t *)tsdu);
+            break;
+
+        case D_SYSTEM_INFO:
+            d_system_info_serialize(s, (const tsdu_d_system_info_t *)tsdu);
+            break;
+
+        case D_SEECRET_0x47:
+        case D_RESERVED_0x97:
+            d_seecret_serialize(s, (const tsdu_seecret_codop_t *)tsdu);
+            break;
+
+        default:
+            // header only, at least the codop is reported
+            LOG(WTF, "serialize not implemented: downlink codop=0x%02x",
+                tsdu->codop);
+    }
+}
+
+int event_tsdu_serialize(const tsdu_t *tsdu, uint8_t *buf, int len)
+{
+    if (len > EVENT_REC_MAX) {
+        len = EVENT_REC_MAX;
+    }
+    ser_t s = {
+        .p = buf,
+        .end = buf + len,
+        .overflow = false,
+    };
+
+    put_u16(&s, 0);     // length, filled later
+    put_u8(&s, EVENT_TYPE_TSDU);
+    put_u8(&s, tsdu->codop);
+    put_u8(&s, tsdu->prio);
+    put_u8(&s, tsdu->id_tsap);
+    put_u8(&s, tsdu->downlink);
+    if (tsdu->downlink) {
+        tsdu_d_serialize(&s, tsdu);
+    } else {
+        LOG(WTF, "serialize not implemented: uplink codop=0x%02x",
+            tsdu->codop);
+    }
+
+    if (s.overflow) {
+        return -1;
+    }
+    const int rec_len = s.p - buf;
+    buf[0] = rec_len - 2;
+    buf[1] = (rec_len - 2) >> 8;
+
+    return rec_len;
+}
+
+event_writer_t *event_writer_create(int fd)
+{
+    event_writer_t *ew = malloc(sizeof(event_writer_t));
+    if (!ew) {
+        return NULL;
+    }
+
+    ew->fd = fd;
+    ew->nchunks = 1;
+    ew->len = 0;
+    for (int i = 0; i < EVENT_NCHUNKS; ++i) {
+        ew->iov[i].iov_base = ew->chunks[i];
+    }
+
+    return ew;
+}
+
+void event_writer_destroy(event_writer_t *ew)
+{
+    if (!ew) {
+        return;
+    }
+    event_writer_flush(ew);
+    free(ew);
+}
+
+int event_writer_flush(event_writer_t *ew)
+{
+    int niov = ew->nchunks;
+    ew->iov[niov - 1].iov_len = ew->len;
+    ew->nchunks = 1;
+    ew->len = 0;
+
+    struct iovec *iov = ew->iov;
+    if (!iov[niov - 1].iov_len) {
+        --niov;
+    }
+    int ret = 0;
+    while (niov) {
+        ssize_t n = writev(ew->fd, iov, niov);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERR, "writev failed: %s", strerror(errno));
+            ret = -1;
+            break;
+        }
+        // partial write
+        while (niov && n >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --niov;
+        }
+        if (niov) {
+            iov->iov_base = (uint8_t *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    // chunks might be shortened by partial write
+    for (int i = 0; i < EVENT_NCHUNKS; ++i) {
+        ew->iov[i].iov_base = ew->chunks[i];
+    }
+
+    return ret;
+}
+
+/// Start filling next chunk, batch is flushed when all chunks are used.
+static int writer_next_chunk(event_writer_t *ew)
+{
+    if (ew->nchunks == EVENT_NCHUNKS) {
+        return event_writer_flush(ew);
+    }
+    ew->iov[ew->nchunks - 1].iov_len = ew->len;
+    ++ew->nchunks;
+    ew->len = 0;
+
+    return 0;
+}
+
+/// Get space in batch for record of given length.
+static uint8_t *writer_reserve(event_writer_t *ew, int len)
+{
+    if (EVENT_CHUNK_SIZE - ew->len < len && writer_next_chunk(ew)) {
+        return NULL;
+    }
+
+    uint8_t *p = ew->chunks[ew->nchunks - 1] + ew->len;
+    ew->len += len;
+
+    return p;
+}
+
+int event_voice_serialize(int64_t timestamp, int frame_no, bool crc_ok,
+        const uint64_t *data, uint8_t *buf, int len)
+{
+    if (len < EVENT_VOICE_REC_LEN) {
+        return -1;
+    }
+
+    ser_t s = {
+        .p = buf,
+        .end = buf + EVENT_VOICE_REC_LEN,
+        .overflow = false,
+    };
+    put_u16(&s, EVENT_VOICE_REC_LEN - 2);
+    put_u8(&s, EVENT_TYPE_VOICE);
+    for (int i = 0; i < 64; i += 16) {
+        put_u16(&s, timestamp >> i);
+    }
+    put_u16(&s, frame_no);
+    put_u8(&s, crc_ok);
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 56; j >= 0; j -= 8) {
+            put_u8(&s, data[i] >> j);
+        }
+    }
+
+    return EVENT_VOICE_REC_LEN;
+}
+
+int event_write_voice(event_writer_t *ew, int64_t timestamp, int frame_no,
+        bool crc_ok, const uint64_t *data)
+{
+    uint8_t *buf = writer_reserve(ew, EVENT_VOICE_REC_LEN);
+    if (!buf) {
+        return -1;
+    }
+    event_voice_serialize(timestamp, frame_no, crc_ok, data, buf,
+            EVENT_VOICE_REC_LEN);
+
+    return 0;
+}
+
+int event_write_tsdu(event_writer_t *ew, const tsdu_t *tsdu)
+{
+    uint8_t *chunk = ew->chunks[ew->nchunks - 1];
+    int n = event_tsdu_serialize(tsdu, chunk + ew->len,
+            EVENT_CHUNK_SIZE - ew->len);
+    if (n < 0) {
+        if (writer_next_chunk(ew)) {
+            return -1;
+        }
+        chunk = ew->chunks[ew->nchunks - 1];
+        n = event_tsdu_serialize(tsdu, chunk, EVENT_CHUNK_SIZE);
+        if (n < 0) {
+            LOG(ERR, "TSDU record too long, codop=0x%02x", tsdu->codop);
+            return -1;
+        }
+    }
+    ew->len += n;
+
+    return 0;
+}
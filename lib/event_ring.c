@@ -0,0 +1,309 @@
+#define _POSIX_C_SOURCE 200809L
+
+#define LOG_PREFIX "event_ring"
+#include <tetrapol/log.h>
+#include <tetrapol/event.h>
+#include <tetrapol/event_ring.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define EVENT_RING_MAGIC 0x52455054   // "TPER"
+#define EVENT_RING_VERSION 1
+#define REC_ALIGN 8
+
+/// layout of shared memory, data area follows the header
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;      ///< size of data area
+    // producer and consumers touch different cache lines
+    _Alignas(64) _Atomic uint64_t tail_intent;
+    _Alignas(64) _Atomic uint64_t tail;
+    _Alignas(64) uint8_t data[];
+} ring_shm_t;
+
+struct _event_ring_t {
+    char *name;
+    ring_shm_t *shm;
+    size_t map_len;
+    uint64_t tail;      ///< private copy, producer is the only writer
+    uint8_t rec[EVENT_REC_MAX];     ///< serialization buffer
+};
+
+struct _event_ring_reader_t {
+    const ring_shm_t *shm;
+    size_t map_len;
+    uint64_t cursor;
+    uint64_t lost;
+};
+
+static inline int rec_padded_len(int rec_len)
+{
+    return (rec_len + REC_ALIGN - 1) & ~(REC_ALIGN - 1);
+}
+
+event_ring_t *event_ring_create(const char *name, int size)
+{
+    if (size < 4 * EVENT_REC_MAX || (size & (size - 1))) {
+        LOG(ERR, "event_ring_create() invalid param 'size'");
+        return NULL;
+    }
+
+    event_ring_t *ring = calloc(1, sizeof(event_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+    ring->name = strdup(name);
+    if (!ring->name) {
+        goto err_name;
+    }
+
+    // consumers attached to previous ring keep their (stale) mapping
+    shm_unlink(name);
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        LOG(ERR, "shm_open(%s) failed: %s", name, strerror(errno));
+        goto err_open;
+    }
+    ring->map_len = sizeof(ring_shm_t) + size;
+    if (ftruncate(fd, ring->map_len)) {
+        LOG(ERR, "ftruncate(%s) failed: %s", name, strerror(errno));
+        goto err_map;
+    }
+    ring->shm = mmap(NULL, ring->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    if (ring->shm == MAP_FAILED) {
+        LOG(ERR, "mmap(%s) failed: %s", name, strerror(errno));
+        goto err_map;
+    }
+    close(fd);
+
+    ring->shm->size = size;
+    ring->shm->version = EVENT_RING_VERSION;
+    atomic_init(&ring->shm->tail_intent, 0);
+    atomic_init(&ring->shm->tail, 0);
+    // magic is the last, consumer checks it first
+    atomic_thread_fence(memory_order_release);
+    ring->shm->magic = EVENT_RING_MAGIC;
+
+    return ring;
+
+err_map:
+    close(fd);
+    shm_unlink(name);
+
+err_open:
+    free(ring->name);
+
+err_name:
+    free(ring);
+
+    return NULL;
+}
+
+void event_ring_destroy(event_ring_t *ring)
+{
+    if (!ring) {
+        return;
+    }
+    munmap(ring->shm, ring->map_len);
+    shm_unlink(ring->name);
+    free(ring->name);
+    free(ring);
+}
+
+int event_ring_put(event_ring_t *ring, const uint8_t *rec, int len)
+{
+    if (len < 3 || len > EVENT_REC_MAX || rec[0] + (rec[1] << 8) != len - 2) {
+        LOG(ERR, "event_ring_put() invalid param 'rec'");
+        return -1;
+    }
+
+    ring_shm_t *shm = ring->shm;
+    const uint64_t mask = shm->size - 1;
+    uint64_t pos = ring->tail;
+    const int rest = shm->size - (pos & mask);
+    const int padded_len = rec_padded_len(len);
+    const int pad_len = (padded_len > rest) ? rest : 0;
+
+    // data up to the new tail are going to be overwritten
+    const uint64_t tail = pos + pad_len + padded_len;
+    atomic_store_explicit(&shm->tail_intent, tail, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (pad_len) {
+        uint8_t *p = &shm->data[pos & mask];
+        p[0] = pad_len - 2;
+        p[1] = (pad_len - 2) >> 8;
+        p[2] = EVENT_RING_PAD;
+        pos += pad_len;
+    }
+    memcpy(&shm->data[pos & mask], rec, len);
+
+    atomic_store_explicit(&shm->tail, tail, memory_order_release);
+    ring->tail = tail;
+
+    return 0;
+}
+
+int event_ring_write_tsdu(event_ring_t *ring, const tsdu_t *tsdu)
+{
+    const int len = event_tsdu_serialize(tsdu, ring->rec, sizeof(ring->rec));
+    if (len < 0) {
+        LOG(ERR, "TSDU record too long, codop=0x%02x", tsdu->codop);
+        return -1;
+    }
+
+    return event_ring_put(ring, ring->rec, len);
+}
+
+int event_ring_write_voice(event_ring_t *ring, int64_t timestamp,
+        int frame_no, bool crc_ok, const uint64_t *data)
+{
+    const int len = event_voice_serialize(timestamp, frame_no, crc_ok, data,
+            ring->rec, sizeof(ring->rec));
+
+    return event_ring_put(ring, ring->rec, len);
+}
+
+event_ring_reader_t *event_ring_reader_open(const char *name)
+{
+    event_ring_reader_t *reader = calloc(1, sizeof(event_ring_reader_t));
+    if (!reader) {
+        return NULL;
+    }
+
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        LOG(ERR, "shm_open(%s) failed: %s", name, strerror(errno));
+        goto err_open;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < sizeof(ring_shm_t)) {
+        LOG(ERR, "invalid ring %s", name);
+        goto err_map;
+    }
+    reader->map_len = st.st_size;
+    reader->shm = mmap(NULL, reader->map_len, PROT_READ, MAP_SHARED, fd, 0);
+    if (reader->shm == MAP_FAILED) {
+        LOG(ERR, "mmap(%s) failed: %s", name, strerror(errno));
+        goto err_map;
+    }
+    close(fd);
+
+    const ring_shm_t *shm = reader->shm;
+    if (shm->magic != EVENT_RING_MAGIC) {
+        LOG(ERR, "invalid ring %s", name);
+        goto err_ring;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (shm->version != EVENT_RING_VERSION ||
+            shm->size != reader->map_len - sizeof(ring_shm_t) ||
+            (shm->size & (shm->size - 1))) {
+        LOG(ERR, "invalid ring %s", name);
+        goto err_ring;
+    }
+    reader->cursor = atomic_load_explicit(
+            (_Atomic uint64_t *)&shm->tail, memory_order_acquire);
+
+    return reader;
+
+err_ring:
+    munmap((void *)reader->shm, reader->map_len);
+    goto err_open;
+
+err_map:
+    close(fd);
+
+err_open:
+    free(reader);
+
+    return NULL;
+}
+
+void event_ring_reader_close(event_ring_reader_t *reader)
+{
+    if (!reader) {
+        return;
+    }
+    munmap((void *)reader->shm, reader->map_len);
+    free(reader);
+}
+
+/// Check if data at cursor could have been overwritten, skip lost data.
+static bool reader_overrun(event_ring_reader_t *reader)
+{
+    const ring_shm_t *shm = reader->shm;
+    // consumer never writes into shared memory, atomic loads are plain reads
+    const uint64_t intent = atomic_load_explicit(
+            (_Atomic uint64_t *)&shm->tail_intent, memory_order_relaxed);
+    if (intent - reader->cursor <= shm->size) {
+        return false;
+    }
+
+    const uint64_t tail = atomic_load_explicit(
+            (_Atomic uint64_t *)&shm->tail, memory_order_acquire);
+    reader->lost += tail - reader->cursor;
+    reader->cursor = tail;
+
+    return true;
+}
+
+int event_ring_read(event_ring_reader_t *reader, uint8_t *buf, int len)
+{
+    const ring_shm_t *shm = reader->shm;
+    const uint64_t mask = shm->size - 1;
+
+    while (true) {
+        const uint64_t tail = atomic_load_explicit(
+                (_Atomic uint64_t *)&shm->tail, memory_order_acquire);
+        if (tail == reader->cursor) {
+            return 0;
+        }
+        if (tail - reader->cursor > shm->size) {
+            reader_overrun(reader);
+            return EVENT_RING_OVERRUN;
+        }
+
+        const uint8_t *p = &shm->data[reader->cursor & mask];
+        const int rec_len = p[0] + (p[1] << 8) + 2;
+        const uint8_t type = p[2];
+        const int rest = shm->size - (reader->cursor & mask);
+        const bool valid = rec_len >= 3 && rec_len <= rest &&
+            (type == EVENT_RING_PAD || rec_len <= len);
+        if (valid && type != EVENT_RING_PAD) {
+            memcpy(buf, p, rec_len);
+        }
+
+        // copied data are valid only when producer did not reach them
+        atomic_thread_fence(memory_order_acquire);
+        if (reader_overrun(reader)) {
+            return EVENT_RING_OVERRUN;
+        }
+        if (!valid) {
+            if (rec_len > len && rec_len <= rest) {
+                LOG(ERR, "too small buffer for record of length %d", rec_len);
+            } else {
+                LOG(ERR, "corrupted ring, record length %d", rec_len);
+            }
+            return -1;
+        }
+
+        reader->cursor += rec_padded_len(rec_len);
+        if (type != EVENT_RING_PAD) {
+            return rec_len;
+        }
+    }
+}
+
+uint64_t event_ring_reader_lost(const event_ring_reader_t *reader)
+{
+    return reader->lost;
+}
@@ -0,0 +1,100 @@
+// Encoder of synthetic frames used by tests and benchmarks.
+// This file should be directly included after phys_ch.c, it uses its
+// static tables and functions.
+
+// convolutional encoder, PAS 0001-2 6.1.2, PAS 0001-2 6.2.2
+static void conv_enc(uint8_t *c, const uint8_t *b, int n, bool tail_biting)
+{
+    for (int j = 0; j < n; ++j) {
+        const uint8_t b1 = (j >= 1) ? b[j - 1] : (tail_biting ? b[n - 1] : 0);
+        const uint8_t b2 = (j >= 2) ? b[j - 2] : (tail_biting ? b[n + j - 2] : 0);
+        c[2*j] = b[j] ^ b1 ^ b2;
+        c[2*j + 1] = b[j] ^ b2;
+    }
+}
+
+/**
+  Create frame from data block (see misc/forward.c).
+
+  @param blk 74 bits of data frame (including CRC) or 126 bits of voice frame
+  */
+static void mk_frame(frame_t *f, const uint8_t *blk, frame_type_t type,
+        int band, int scr)
+{
+    uint8_t c[FRAME_DATA_LEN];
+    const uint8_t *int_table;
+
+    conv_enc(c, blk, 26, true);
+    if (type == FRAME_TYPE_DATA) {
+        uint8_t bxx[50];
+        memcpy(bxx, blk + 26, 48);
+        bxx[48] = bxx[49] = 0;
+        conv_enc(c + 2*26, bxx, 50, false);
+        int_table = (band == TETRAPOL_BAND_UHF) ?
+            interleave_data_UHF : interleave_voice_data_VHF;
+    } else {
+        memcpy(c + 2*26, blk + 26, 100);
+        // high rate data frame is interleaved as data frame
+        if (type == FRAME_TYPE_HR_DATA) {
+            int_table = (band == TETRAPOL_BAND_UHF) ?
+                interleave_data_UHF : interleave_voice_data_VHF;
+        } else {
+            int_table = (band == TETRAPOL_BAND_UHF) ?
+                interleave_voice_UHF : interleave_voice_data_VHF;
+        }
+    }
+
+    for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+        f->data[int_table[j]] = c[j];
+    }
+
+    if (band == TETRAPOL_BAND_UHF) {
+        for (int j = 1; j < FRAME_DATA_LEN; ++j) {
+            f->data[j] ^= f->data[j - diff_precod_UHF[j]];
+        }
+    }
+
+    frame_descramble(f, scr);
+    f->frame_no = FRAME_NO_UNKNOWN;
+}
+
+/**
+  Create random data block with valid CRC.
+
+  @param r State of pseudo-random generator.
+  @return false if valid CRC is not found (should never happen)
+  */
+static bool mk_data_block(uint8_t *blk, frame_type_t type, uint32_t *r)
+{
+    const int len = (type == FRAME_TYPE_DATA) ? 74 : 126;
+    for (int i = 0; i < len; ++i) {
+        *r = *r * 1103515245 + 12345;
+        blk[i] = (*r >> 16) & 1;
+    }
+    blk[0] = (type == FRAME_TYPE_VOICE) ? FRAME_TYPE_VOICE : FRAME_TYPE_DATA;
+
+    // find CRC bits (5 for data, 3 for voice) accepted by data_block_check_crc
+    int crc_pos = (type == FRAME_TYPE_DATA) ? 69 : 23;
+    const int crc_len = (type == FRAME_TYPE_VOICE) ? 3 : 5;
+    if (type == FRAME_TYPE_HR_DATA) {
+        crc_pos = HR_DATA_BLOCK_CRC_POS;
+        memset(&blk[crc_pos + crc_len], 0,
+                HR_DATA_BLOCK_LEN - crc_pos - crc_len);
+    }
+    data_block_t data_blk;
+    data_blk.fr_type = type;
+    for (int i = 0; i < (1 << crc_len); ++i) {
+        for (int j = 0; j < crc_len; ++j) {
+            blk[crc_pos + j] = (i >> j) & 1;
+        }
+        data_blk.data[0] = data_blk.data[1] = 0;
+        for (int j = 0; j < len; ++j) {
+            data_blk.data[j / 64] |= (uint64_t)blk[j] << (63 - j % 64);
+        }
+        if (data_block_check_crc(&data_blk)) {
+            return true;
+        }
+    }
+
+    return false;
+}
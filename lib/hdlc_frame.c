@@ -105,7 +105,7 @@ bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int nbits)
     command_parse(&hdlc_frame->command, data[2]);
     // nbits - HDLC_header_nbits - FCS_len
     hdlc_frame->nbits = nbits - 3*8 - 2*8;
-    memcpy(hdlc_frame->data, data + 3, (hdlc_frame->nbits + 7) / 8);
+    hdlc_frame->data = data + 3;
 
     return true;
 }
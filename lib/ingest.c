@@ -0,0 +1,124 @@
+#include <tetrapol/ingest.h>
+
+#include <math.h>
+
+static uint64_t get_be(const uint8_t *buf, int len)
+{
+    uint64_t r = 0;
+    for (int i = 0; i < len; ++i) {
+        r = (r << 8) | buf[i];
+    }
+
+    return r;
+}
+
+static void put_be(uint8_t *buf, uint64_t val, int len)
+{
+    for (int i = len - 1; i >= 0; --i) {
+        buf[i] = val;
+        val >>= 8;
+    }
+}
+
+int ingest_hdr_parse(ingest_hdr_t *hdr, const uint8_t *buf, int len)
+{
+    if (len < INGEST_HDR_LEN || get_be(buf, 2) != INGEST_MAGIC ||
+            buf[2] != INGEST_VERSION || buf[3]) {
+        return -1;
+    }
+
+    hdr->ch_id = get_be(&buf[4], 2);
+    hdr->len = get_be(&buf[6], 2);
+    hdr->seq = get_be(&buf[8], 4);
+    hdr->timestamp = get_be(&buf[12], 8);
+
+    // truncated datagram or trailing garbage
+    return (hdr->len == len - INGEST_HDR_LEN) ? 0 : -1;
+}
+
+void ingest_hdr_write(const ingest_hdr_t *hdr, uint8_t *buf)
+{
+    put_be(&buf[0], INGEST_MAGIC, 2);
+    buf[2] = INGEST_VERSION;
+    buf[3] = 0;
+    put_be(&buf[4], hdr->ch_id, 2);
+    put_be(&buf[6], hdr->len, 2);
+    put_be(&buf[8], hdr->seq, 4);
+    put_be(&buf[12], hdr->timestamp, 8);
+}
+
+int64_t ingest_seq_check(ingest_seq_t *seq, uint32_t n)
+{
+    if (!seq->started) {
+        seq->started = true;
+        seq->next = n + 1;
+        return 0;
+    }
+
+    // distance modulo 2^32, half of range behind is considered old
+    const uint32_t d = n - seq->next;
+    if (d >= 0x80000000u) {
+        return -1;
+    }
+    seq->next = n + 1;
+
+    return d;
+}
+
+/// Scale value to fixed point and saturate it into range.
+static int64_t to_fixed(float val, float scale, int64_t min, int64_t max)
+{
+    const float v = val * scale;
+    if (!(v > min)) {
+        // NaN included
+        return min;
+    }
+
+    return (v < max) ? llrintf(v) : max;
+}
+
+/// Sign extension of 'len' bytes long integer.
+static int64_t get_be_signed(const uint8_t *buf, int len)
+{
+    const uint64_t r = get_be(buf, len);
+    const uint64_t sign = 1ULL << (8 * len - 1);
+
+    return (int64_t)((r ^ sign) - sign);
+}
+
+int ingest_feedback_parse(ingest_feedback_t *fb, const uint8_t *buf, int len)
+{
+    if (len != INGEST_FEEDBACK_LEN ||
+            get_be(buf, 2) != INGEST_FEEDBACK_MAGIC ||
+            buf[2] != INGEST_VERSION || get_be(&buf[6], 2)) {
+        return -1;
+    }
+
+    fb->flags = buf[3];
+    fb->ch_id = get_be(&buf[4], 2);
+    fb->seq = get_be(&buf[8], 4);
+    fb->timestamp = get_be(&buf[12], 8);
+    fb->sync_errs = get_be(&buf[20], 2) / 1000.0f;
+    fb->nerrs = get_be(&buf[22], 2) / 1000.0f;
+    fb->crc_errs = get_be(&buf[24], 2) / 10000.0f;
+    fb->power = get_be_signed(&buf[26], 2) / 100.0f;
+    fb->freq_offset = get_be_signed(&buf[28], 4) / 1000.0f;
+
+    return 0;
+}
+
+void ingest_feedback_write(const ingest_feedback_t *fb, uint8_t *buf)
+{
+    put_be(&buf[0], INGEST_FEEDBACK_MAGIC, 2);
+    buf[2] = INGEST_VERSION;
+    buf[3] = fb->flags;
+    put_be(&buf[4], fb->ch_id, 2);
+    put_be(&buf[6], 0, 2);
+    put_be(&buf[8], fb->seq, 4);
+    put_be(&buf[12], fb->timestamp, 8);
+    put_be(&buf[20], to_fixed(fb->sync_errs, 1000, 0, UINT16_MAX), 2);
+    put_be(&buf[22], to_fixed(fb->nerrs, 1000, 0, UINT16_MAX), 2);
+    put_be(&buf[24], to_fixed(fb->crc_errs, 10000, 0, UINT16_MAX), 2);
+    put_be(&buf[26], to_fixed(fb->power, 100, INT16_MIN, INT16_MAX), 2);
+    put_be(&buf[28], to_fixed(fb->freq_offset, 1000, INT32_MIN, INT32_MAX), 4);
+}
@@ -1,3 +1,526 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <tetrapol/log.h>
 
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdalign.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// number of records in ring buffer of each thread, power of 2
+#define LOG_RING_LEN 1024
+/// max. number of arguments stored in record
+#define LOG_REC_NARGS 8
+/// space for copies of string arguments or preformatted message
+#define LOG_REC_STR_LEN 128
+/// max. length of single conversion specification, e.g. "%02x"
+#define LOG_SPEC_LEN 16
+
 int log_global_lvl = INFO;
+_Thread_local FILE *log_stream = NULL;
+
+enum {
+    ARG_UNSUPPORTED = -1,
+    ARG_NONE,       ///< "%%"
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+};
+
+typedef union {
+    long long i;
+    intmax_t j;
+    size_t z;
+    ptrdiff_t t;
+    double d;
+    const void *p;
+    int str_offs;   ///< position of string copy in log_rec_t.str
+} log_arg_t;
+
+typedef struct {
+    uint_fast64_t seq;
+    FILE *stream;
+    const char *fmt;    ///< NULL when message is preformatted in str
+    log_arg_t args[LOG_REC_NARGS];
+    char str[LOG_REC_STR_LEN];
+} log_rec_t;
+
+/// single producer (owning thread), single consumer (formatter thread)
+typedef struct _log_ring_t log_ring_t;
+struct _log_ring_t {
+    log_ring_t *next;
+    atomic_uint ndropped;
+    alignas(64) atomic_uint head;   ///< written by producer
+    alignas(64) atomic_uint tail;   ///< written by consumer
+    log_rec_t recs[LOG_RING_LEN];
+};
+
+static struct {
+    atomic_bool running;
+    atomic_uint gen;                ///< incremented when backend stops
+    _Atomic(log_ring_t *) rings;    ///< ring of each thread which ever logged
+    atomic_uint_fast64_t seq;       ///< sequence number of next record
+    atomic_uint_fast64_t nwritten;  ///< records written by formatter
+    atomic_bool sleeping;           ///< formatter waits for sem
+    sem_t sem;
+    pthread_t thread;
+} async;
+
+static _Thread_local log_ring_t *log_ring = NULL;
+static _Thread_local unsigned int log_ring_gen;
+
+/**
+  Parse conversion specification.
+
+  @param fmt Points to '%'.
+  @param type Type of argument is stored here.
+  @return Pointer after conversion specification.
+  */
+static const char *parse_spec(const char *fmt, int *type)
+{
+    const char *p = fmt + 1;
+    if (*p == '%') {
+        *type = ARG_NONE;
+        return p + 1;
+    }
+    while (*p && strchr("-+ #0123456789.", *p)) {
+        ++p;
+    }
+
+    int len_mod = ARG_INT;
+    if (*p == 'h') {
+        p += (p[1] == 'h') ? 2 : 1;
+    } else if (*p == 'l') {
+        if (p[1] == 'l') {
+            len_mod = ARG_LLONG;
+            ++p;
+        } else {
+            len_mod = ARG_LONG;
+        }
+        ++p;
+    } else if (*p == 'j') {
+        len_mod = ARG_INTMAX;
+        ++p;
+    } else if (*p == 'z') {
+        len_mod = ARG_SIZE;
+        ++p;
+    } else if (*p == 't') {
+        len_mod = ARG_PTRDIFF;
+        ++p;
+    }
+
+    if (!*p || p - fmt + 2 > LOG_SPEC_LEN) {
+        *type = ARG_UNSUPPORTED;
+        return *p ? p + 1 : p;
+    }
+
+    switch (*p) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            *type = len_mod;
+            break;
+
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            *type = (len_mod == ARG_INT) ? ARG_DOUBLE : ARG_UNSUPPORTED;
+            break;
+
+        case 'p':
+            *type = (len_mod == ARG_INT) ? ARG_PTR : ARG_UNSUPPORTED;
+            break;
+
+        case 's':
+            *type = (len_mod == ARG_INT) ? ARG_STR : ARG_UNSUPPORTED;
+            break;
+
+        default:
+            // '*', '$', 'n', 'L', wide chars ...
+            *type = ARG_UNSUPPORTED;
+    }
+
+    return p + 1;
+}
+
+/// Store arguments into record, or whole message if it is not possible.
+static void rec_store(log_rec_t *rec, const char *fmt, va_list ap)
+{
+    va_list ap2;
+    va_copy(ap2, ap);
+
+    int nargs = 0;
+    int str_len = 0;
+    const char *p = fmt;
+    while ((p = strchr(p, '%'))) {
+        int type;
+        p = parse_spec(p, &type);
+        if (type == ARG_NONE) {
+            continue;
+        }
+        if (type == ARG_UNSUPPORTED || nargs == LOG_REC_NARGS) {
+            goto preformat;
+        }
+
+        log_arg_t *arg = &rec->args[nargs++];
+        switch (type) {
+            case ARG_INT:
+                arg->i = va_arg(ap, int);
+                break;
+
+            case ARG_LONG:
+                arg->i = va_arg(ap, long);
+                break;
+
+            case ARG_LLONG:
+                arg->i = va_arg(ap, long long);
+                break;
+
+            case ARG_INTMAX:
+                arg->j = va_arg(ap, intmax_t);
+                break;
+
+            case ARG_SIZE:
+                arg->z = va_arg(ap, size_t);
+                break;
+
+            case ARG_PTRDIFF:
+                arg->t = va_arg(ap, ptrdiff_t);
+                break;
+
+            case ARG_DOUBLE:
+                arg->d = va_arg(ap, double);
+                break;
+
+            case ARG_PTR:
+                arg->p = va_arg(ap, void *);
+                break;
+
+            case ARG_STR:
+                {
+                    const char *s = va_arg(ap, const char *);
+                    if (!s) {
+                        s = "(null)";
+                    }
+                    // string is truncated when there is not enough space
+                    const int n = strnlen(s, LOG_REC_STR_LEN - 1 - str_len);
+                    memcpy(&rec->str[str_len], s, n);
+                    rec->str[str_len + n] = '\0';
+                    arg->str_offs = str_len;
+                    str_len += n;
+                    if (str_len < LOG_REC_STR_LEN - 1) {
+                        ++str_len;
+                    }
+                }
+                break;
+        }
+    }
+    rec->fmt = fmt;
+    va_end(ap2);
+
+    return;
+
+preformat:
+    vsnprintf(rec->str, sizeof(rec->str), fmt, ap2);
+    rec->fmt = NULL;
+    va_end(ap2);
+}
+
+static void rec_write(const log_rec_t *rec)
+{
+    FILE *f = rec->stream ? rec->stream : stdout;
+
+    if (!rec->fmt) {
+        fputs(rec->str, f);
+        return;
+    }
+
+    const log_arg_t *arg = rec->args;
+    const char *p = rec->fmt;
+    const char *pct;
+    while ((pct = strchr(p, '%'))) {
+        fwrite(p, 1, pct - p, f);
+
+        int type;
+        p = parse_spec(pct, &type);
+        if (type == ARG_NONE) {
+            fputc('%', f);
+            continue;
+        }
+
+        char spec[LOG_SPEC_LEN];
+        memcpy(spec, pct, p - pct);
+        spec[p - pct] = '\0';
+        switch (type) {
+            case ARG_INT:
+                fprintf(f, spec, (int)arg->i);
+                break;
+
+            case ARG_LONG:
+                fprintf(f, spec, (long)arg->i);
+                break;
+
+            case ARG_LLONG:
+                fprintf(f, spec, arg->i);
+                break;
+
+            case ARG_INTMAX:
+                fprintf(f, spec, arg->j);
+                break;
+
+            case ARG_SIZE:
+                fprintf(f, spec, arg->z);
+                break;
+
+            case ARG_PTRDIFF:
+                fprintf(f, spec, arg->t);
+                break;
+
+            case ARG_DOUBLE:
+                fprintf(f, spec, arg->d);
+                break;
+
+            case ARG_PTR:
+                fprintf(f, spec, arg->p);
+                break;
+
+            case ARG_STR:
+                fprintf(f, spec, &rec->str[arg->str_offs]);
+                break;
+        }
+        ++arg;
+    }
+    fputs(p, f);
+}
+
+static void formatter_wake(void)
+{
+    if (atomic_exchange(&async.sleeping, false)) {
+        sem_post(&async.sem);
+    }
+}
+
+static log_ring_t *ring_get(void)
+{
+    const unsigned int gen = atomic_load_explicit(&async.gen,
+            memory_order_relaxed);
+    if (log_ring && log_ring_gen == gen) {
+        return log_ring;
+    }
+
+    log_ring_t *ring = aligned_alloc(alignof(log_ring_t), sizeof(log_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+    atomic_init(&ring->ndropped, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->next = atomic_load(&async.rings);
+    while (!atomic_compare_exchange_weak(&async.rings, &ring->next, ring));
+
+    log_ring = ring;
+    log_ring_gen = gen;
+
+    return ring;
+}
+
+/// @return false if message could not be handled asynchronously
+static bool ring_push(const char *fmt, va_list ap)
+{
+    log_ring_t *ring = ring_get();
+    if (!ring) {
+        return false;
+    }
+
+    const unsigned int head = atomic_load_explicit(&ring->head,
+            memory_order_relaxed);
+    const unsigned int tail = atomic_load_explicit(&ring->tail,
+            memory_order_acquire);
+    if (head - tail == LOG_RING_LEN) {
+        atomic_fetch_add_explicit(&ring->ndropped, 1, memory_order_relaxed);
+        return true;
+    }
+
+    log_rec_t *rec = &ring->recs[head % LOG_RING_LEN];
+    rec->stream = log_stream;
+    rec_store(rec, fmt, ap);
+    // sequence number is taken only when record is surely published
+    rec->seq = atomic_fetch_add(&async.seq, 1);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    formatter_wake();
+
+    return true;
+}
+
+/**
+  Write records in order of sequence numbers.
+
+  @return true if anything was written
+  */
+static bool formatter_drain(void)
+{
+    bool written = false;
+
+    for (;;) {
+        const uint_fast64_t seq = atomic_load(&async.nwritten);
+        if (seq == atomic_load(&async.seq)) {
+            return written;
+        }
+
+        log_ring_t *ring = atomic_load(&async.rings);
+        for ( ; ring; ring = ring->next) {
+            const unsigned int tail = atomic_load_explicit(&ring->tail,
+                    memory_order_relaxed);
+            if (tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+                continue;
+            }
+            const log_rec_t *rec = &ring->recs[tail % LOG_RING_LEN];
+            if (rec->seq == seq) {
+                rec_write(rec);
+                atomic_store_explicit(&ring->tail, tail + 1,
+                        memory_order_release);
+                atomic_store(&async.nwritten, seq + 1);
+                written = true;
+                break;
+            }
+        }
+        if (!ring) {
+            // sequence number is taken, but record is not published yet
+            sched_yield();
+        }
+    }
+}
+
+static void formatter_report_drops(void)
+{
+    log_ring_t *ring = atomic_load(&async.rings);
+    for ( ; ring; ring = ring->next) {
+        const unsigned int n = atomic_exchange_explicit(&ring->ndropped, 0,
+                memory_order_relaxed);
+        if (n) {
+            fprintf(stderr, "log: %u messages dropped\n", n);
+        }
+    }
+}
+
+static void *formatter(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        if (formatter_drain()) {
+            continue;
+        }
+        formatter_report_drops();
+        if (!atomic_load(&async.running)) {
+            break;
+        }
+
+        atomic_store(&async.sleeping, true);
+        // recheck, message might be logged before the flag was set
+        if (atomic_load(&async.nwritten) != atomic_load(&async.seq)) {
+            atomic_store(&async.sleeping, false);
+            continue;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 10000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_nsec -= 1000000000;
+            ++ts.tv_sec;
+        }
+        sem_timedwait(&async.sem, &ts);
+        atomic_store(&async.sleeping, false);
+    }
+    formatter_drain();
+
+    return NULL;
+}
+
+int log_async_start(void)
+{
+    if (atomic_load(&async.running)) {
+        return 0;
+    }
+    if (sem_init(&async.sem, 0, 0)) {
+        return -1;
+    }
+    atomic_store(&async.sleeping, false);
+    atomic_store(&async.running, true);
+    if (pthread_create(&async.thread, NULL, formatter, NULL)) {
+        atomic_store(&async.running, false);
+        sem_destroy(&async.sem);
+        return -1;
+    }
+
+    return 0;
+}
+
+void log_async_flush(void)
+{
+    const uint_fast64_t seq = atomic_load(&async.seq);
+    while (atomic_load(&async.nwritten) < seq) {
+        formatter_wake();
+        const struct timespec ts = { .tv_sec = 0, .tv_nsec = 100000, };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void log_async_stop(void)
+{
+    if (!atomic_load(&async.running)) {
+        return;
+    }
+    atomic_store(&async.running, false);
+    sem_post(&async.sem);
+    pthread_join(async.thread, NULL);
+    sem_destroy(&async.sem);
+
+    atomic_fetch_add(&async.gen, 1);
+    log_ring_t *ring = atomic_exchange(&async.rings, NULL);
+    while (ring) {
+        log_ring_t *next = ring->next;
+        free(ring);
+        ring = next;
+    }
+}
+
+int log_printf(const char *fmt, ...)
+{
+    int r = 0;
+    va_list ap;
+    va_start(ap, fmt);
+    if (!atomic_load_explicit(&async.running, memory_order_relaxed) ||
+            !ring_push(fmt, ap)) {
+        r = vfprintf(log_stream ? log_stream : stdout, fmt, ap);
+    }
+    va_end(ap);
+
+    return r;
+}
+
+// emit external definition of inline function from log.h
+extern inline void log_set_lvl(int lvl);
@@ -0,0 +1,534 @@
+#define LOG_PREFIX "net_index"
+#include <tetrapol/log.h>
+#include <tetrapol/net_index.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// initial number of slots, table grows when it is half full
+#define TABLE_MIN_CAP 16
+
+/**
+  Open addressing hash table with linear probing and fixed size values,
+  slots are stored in another array than values to keep probing dense.
+  */
+typedef struct {
+    uint32_t *keys;     ///< key + 1, 0 for empty slot
+    uint8_t *vals;
+    int val_size;
+    int cap;            ///< number of slots, power of 2
+    int shift;          ///< 32 - log2(cap)
+    int n;
+} table_t;
+
+struct _net_index_t {
+    uint64_t seq;
+    bool has_network;
+    uint8_t country_code;
+    system_id_t system_id;
+    bool has_cell;
+    cell_id_t cell_id;  ///< current cell
+    table_t cells;
+    table_t groups;
+    table_t calls;
+};
+
+static bool table_init(table_t *t, int val_size, int cap)
+{
+    t->keys = calloc(cap, sizeof(uint32_t));
+    t->vals = malloc((size_t)cap * val_size);
+    t->val_size = val_size;
+    t->cap = cap;
+    t->shift = 32 - __builtin_ctz(cap);
+    t->n = 0;
+    if (!t->keys || !t->vals) {
+        free(t->keys);
+        free(t->vals);
+        t->keys = NULL;
+        t->vals = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static void table_free(table_t *t)
+{
+    free(t->keys);
+    free(t->vals);
+}
+
+static bool table_copy(table_t *dst, const table_t *src)
+{
+    if (!table_init(dst, src->val_size, src->cap)) {
+        return false;
+    }
+    memcpy(dst->keys, src->keys, src->cap * sizeof(uint32_t));
+    memcpy(dst->vals, src->vals, (size_t)src->cap * src->val_size);
+    dst->n = src->n;
+
+    return true;
+}
+
+static inline int table_home(const table_t *t, uint32_t key)
+{
+    // Fibonacci hashing, keys are small integers
+    return (key * 0x9e3779b1u) >> t->shift;
+}
+
+static inline void *table_val(const table_t *t, int i)
+{
+    return t->vals + (size_t)i * t->val_size;
+}
+
+/// @return slot with key or empty slot where key should be inserted
+static int table_probe(const table_t *t, uint32_t key)
+{
+    const uint32_t k = key + 1;
+    int i = table_home(t, key);
+    while (t->keys[i] && t->keys[i] != k) {
+        i = (i + 1) & (t->cap - 1);
+    }
+
+    return i;
+}
+
+static void *table_find(const table_t *t, uint32_t key)
+{
+    const int i = table_probe(t, key);
+
+    return t->keys[i] ? table_val(t, i) : NULL;
+}
+
+static bool table_grow(table_t *t)
+{
+    table_t nt;
+    if (!table_init(&nt, t->val_size, 2 * t->cap)) {
+        return false;
+    }
+    for (int i = 0; i < t->cap; ++i) {
+        if (t->keys[i]) {
+            const int j = table_probe(&nt, t->keys[i] - 1);
+            nt.keys[j] = t->keys[i];
+            memcpy(table_val(&nt, j), table_val(t, i), t->val_size);
+        }
+    }
+    nt.n = t->n;
+    table_free(t);
+    *t = nt;
+
+    return true;
+}
+
+/**
+  Get value for key, value of new entry is zeroed.
+
+  @return value or NULL on allocation failure
+  */
+static void *table_get(table_t *t, uint32_t key)
+{
+    int i = table_probe(t, key);
+    if (t->keys[i]) {
+        return table_val(t, i);
+    }
+
+    if (2 * (t->n + 1) > t->cap) {
+        if (!table_grow(t)) {
+            return NULL;
+        }
+        i = table_probe(t, key);
+    }
+    t->keys[i] = key + 1;
+    ++t->n;
+    void *val = table_val(t, i);
+    memset(val, 0, t->val_size);
+
+    return val;
+}
+
+/// Remove entry in slot, following entries of the cluster are shifted back.
+static void table_remove_at(table_t *t, int i)
+{
+    const int mask = t->cap - 1;
+    int j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (!t->keys[j]) {
+            break;
+        }
+        // entry at j can fill the hole at i when its home is not in (i, j>
+        const int home = table_home(t, t->keys[j] - 1);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            t->keys[i] = t->keys[j];
+            memcpy(table_val(t, i), table_val(t, j), t->val_size);
+            i = j;
+        }
+    }
+    t->keys[i] = 0;
+    --t->n;
+}
+
+static const void *table_next(const table_t *t, int *it)
+{
+    while (*it < t->cap) {
+        const int i = (*it)++;
+        if (t->keys[i]) {
+            return table_val(t, i);
+        }
+    }
+
+    return NULL;
+}
+
+static inline uint32_t cell_key(const cell_id_t *cell_id)
+{
+    return (cell_id->bs_id << 8) | cell_id->rws_id;
+}
+
+static inline uint32_t addr_key(const addr_t *addr)
+{
+    return (addr->z << 15) | (addr->y << 12) | addr->x;
+}
+
+net_index_t *net_index_create(void)
+{
+    net_index_t *idx = calloc(1, sizeof(net_index_t));
+    if (!idx) {
+        return NULL;
+    }
+
+    if (!table_init(&idx->cells, sizeof(net_cell_t), TABLE_MIN_CAP)) {
+        goto err_cells;
+    }
+    if (!table_init(&idx->groups, sizeof(net_group_t), TABLE_MIN_CAP)) {
+        goto err_groups;
+    }
+    if (!table_init(&idx->calls, sizeof(net_call_t), TABLE_MIN_CAP)) {
+        goto err_calls;
+    }
+
+    return idx;
+
+err_calls:
+    table_free(&idx->groups);
+
+err_groups:
+    table_free(&idx->cells);
+
+err_cells:
+    free(idx);
+
+    return NULL;
+}
+
+void net_index_destroy(net_index_t *idx)
+{
+    if (!idx) {
+        return;
+    }
+    table_free(&idx->cells);
+    table_free(&idx->groups);
+    table_free(&idx->calls);
+    free(idx);
+}
+
+net_index_t *net_index_clone(const net_index_t *idx)
+{
+    net_index_t *copy = malloc(sizeof(net_index_t));
+    if (!copy) {
+        return NULL;
+    }
+
+    memcpy(copy, idx, sizeof(net_index_t));
+    if (!table_copy(&copy->cells, &idx->cells)) {
+        goto err_cells;
+    }
+    if (!table_copy(&copy->groups, &idx->groups)) {
+        goto err_groups;
+    }
+    if (!table_copy(&copy->calls, &idx->calls)) {
+        goto err_calls;
+    }
+
+    return copy;
+
+err_calls:
+    table_free(&copy->groups);
+
+err_groups:
+    table_free(&copy->cells);
+
+err_cells:
+    free(copy);
+
+    return NULL;
+}
+
+static int update_system_info(net_index_t *idx,
+        const tsdu_d_system_info_t *tsdu)
+{
+    if (idx->has_network && (idx->country_code != tsdu->country_code ||
+                idx->system_id._data != tsdu->system_id._data)) {
+        LOG(INFO, "network changed to %d/%d", tsdu->country_code,
+                tsdu->system_id.network);
+    }
+    idx->has_network = true;
+    idx->country_code = tsdu->country_code;
+    idx->system_id = tsdu->system_id;
+
+    net_cell_t *cell = table_get(&idx->cells, cell_key(&tsdu->cell_id));
+    if (!cell) {
+        return -1;
+    }
+    idx->has_cell = true;
+    idx->cell_id = tsdu->cell_id;
+
+    cell->cell_id = tsdu->cell_id;
+    cell->has_sysinfo = true;
+    cell->cell_state = tsdu->cell_state;
+    cell->cell_config = tsdu->cell_config;
+    cell->loc_area_id = tsdu->loc_area_id;
+    cell->bn_id = tsdu->bn_id;
+    cell->cell_bn = tsdu->cell_bn;
+    cell->updated = idx->seq;
+
+    return 0;
+}
+
+static int update_neighbouring_cell(net_index_t *idx,
+        const tsdu_d_neighbouring_cell_t *tsdu)
+{
+    // neighbours are relative to the current cell
+    if (!idx->has_cell) {
+        return 0;
+    }
+
+    net_neighbour_t neighbours[NET_INDEX_NEIGHBOURS_MAX];
+    const int n = tsdu->ccr_config.number;
+    for (int i = 0; i < n; ++i) {
+        net_neighbour_t *nb = &neighbours[i];
+        nb->bn_nb = tsdu->adj_cells[i].bn_nb;
+        nb->channel_id = tsdu->adj_cells[i].channel_id;
+        nb->adjacent_param = tsdu->adj_cells[i].adjacent_param;
+        nb->has_cell_id = tsdu->cell_ids && i < tsdu->cell_ids->len;
+        if (nb->has_cell_id) {
+            nb->cell_id = tsdu->cell_ids->cell_ids[i];
+        }
+        nb->has_bn = tsdu->cell_bns && i < tsdu->cell_bns->len;
+        if (nb->has_bn) {
+            nb->bn = tsdu->cell_bns->addrs[i];
+        }
+
+        if (nb->has_cell_id) {
+            net_cell_t *cell = table_get(&idx->cells, cell_key(&nb->cell_id));
+            if (!cell) {
+                return -1;
+            }
+            cell->cell_id = nb->cell_id;
+            cell->channel_id = nb->channel_id;
+            cell->updated = idx->seq;
+        }
+    }
+
+    // might be moved by insertion of neighbours
+    net_cell_t *cell = table_find(&idx->cells, cell_key(&idx->cell_id));
+    cell->nneighbours = n;
+    memcpy(cell->neighbours, neighbours, n * sizeof(net_neighbour_t));
+    cell->updated = idx->seq;
+
+    return 0;
+}
+
+static int update_group_composition(net_index_t *idx,
+        const tsdu_d_group_composition_t *tsdu)
+{
+    net_group_t *group = table_get(&idx->groups, tsdu->group_id);
+    if (!group) {
+        return -1;
+    }
+
+    group->group_id = tsdu->group_id;
+    group->has_composition = true;
+    group->og_nb = tsdu->og_nb;
+    memcpy(group->group_ids, tsdu->group_ids, sizeof(group->group_ids));
+    group->updated = idx->seq;
+
+    return 0;
+}
+
+static int update_group_list(net_index_t *idx, const tsdu_d_group_list_t *tsdu)
+{
+    for (int i = 0; i < tsdu->nopen; ++i) {
+        const tsdu_d_group_list_open_t *open = &tsdu->open[i];
+        net_group_t *group = table_get(&idx->groups, open->group_id);
+        if (!group) {
+            return -1;
+        }
+        group->group_id = open->group_id;
+        group->is_open = true;
+        group->open = *open;
+        group->updated = idx->seq;
+    }
+
+    return 0;
+}
+
+static int update_group_activation(net_index_t *idx,
+        const tsdu_d_group_activation_t *tsdu)
+{
+    const net_activation_t activation = {
+        .activation_mode = tsdu->activation_mode,
+        .coverage_id = tsdu->coverage_id,
+        .channel_id = tsdu->channel_id,
+        .u_ch_scrambling = tsdu->u_ch_scrambling,
+        .d_ch_scrambling = tsdu->d_ch_scrambling,
+        .key_reference = tsdu->key_reference,
+    };
+
+    net_group_t *group = table_get(&idx->groups, tsdu->group_id);
+    if (!group) {
+        return -1;
+    }
+    group->group_id = tsdu->group_id;
+    group->is_active = true;
+    group->activation = activation;
+    group->updated = idx->seq;
+
+    if (!tsdu->has_addr_tti) {
+        return 0;
+    }
+    net_call_t *call = table_get(&idx->calls, addr_key(&tsdu->addr_tti));
+    if (!call) {
+        return -1;
+    }
+    call->addr = tsdu->addr_tti;
+    call->group_id = tsdu->group_id;
+    call->activation = activation;
+    call->updated = idx->seq;
+
+    return 0;
+}
+
+int net_index_update(net_index_t *idx, const tsdu_t *tsdu)
+{
+    if (!tsdu->downlink) {
+        return 0;
+    }
+
+    switch (tsdu->codop) {
+        case D_GROUP_ACTIVATION:
+            ++idx->seq;
+            return update_group_activation(idx,
+                    (const tsdu_d_group_activation_t *)tsdu);
+
+        case D_GROUP_COMPOSITION:
+            ++idx->seq;
+            return update_group_composition(idx,
+                    (const tsdu_d_group_composition_t *)tsdu);
+
+        case D_GROUP_LIST:
+            ++idx->seq;
+            return update_group_list(idx, (const tsdu_d_group_list_t *)tsdu);
+
+        case D_NEIGHBOURING_CELL:
+            ++idx->seq;
+            return update_neighbouring_cell(idx,
+                    (const tsdu_d_neighbouring_cell_t *)tsdu);
+
+        case D_SYSTEM_INFO:
+            ++idx->seq;
+            return update_system_info(idx, (const tsdu_d_system_info_t *)tsdu);
+
+        default:
+            return 0;
+    }
+}
+
+uint64_t net_index_seq(const net_index_t *idx)
+{
+    return idx->seq;
+}
+
+bool net_index_get_network(const net_index_t *idx, uint8_t *country_code,
+        system_id_t *system_id)
+{
+    if (!idx->has_network) {
+        return false;
+    }
+    *country_code = idx->country_code;
+    *system_id = idx->system_id;
+
+    return true;
+}
+
+const net_cell_t *net_index_get_current_cell(const net_index_t *idx)
+{
+    return idx->has_cell ? net_index_get_cell(idx, &idx->cell_id) : NULL;
+}
+
+const net_cell_t *net_index_get_cell(const net_index_t *idx,
+        const cell_id_t *cell_id)
+{
+    return table_find(&idx->cells, cell_key(cell_id));
+}
+
+const net_group_t *net_index_get_group(const net_index_t *idx,
+        uint16_t group_id)
+{
+    return table_find(&idx->groups, group_id);
+}
+
+const net_call_t *net_index_get_call(const net_index_t *idx,
+        const addr_t *addr)
+{
+    return table_find(&idx->calls, addr_key(addr));
+}
+
+int net_index_ncells(const net_index_t *idx)
+{
+    return idx->cells.n;
+}
+
+int net_index_ngroups(const net_index_t *idx)
+{
+    return idx->groups.n;
+}
+
+int net_index_ncalls(const net_index_t *idx)
+{
+    return idx->calls.n;
+}
+
+const net_cell_t *net_index_next_cell(const net_index_t *idx, int *it)
+{
+    return table_next(&idx->cells, it);
+}
+
+const net_group_t *net_index_next_group(const net_index_t *idx, int *it)
+{
+    return table_next(&idx->groups, it);
+}
+
+const net_call_t *net_index_next_call(const net_index_t *idx, int *it)
+{
+    return table_next(&idx->calls, it);
+}
+
+int net_index_expire_calls(net_index_t *idx, uint64_t seq)
+{
+    table_t *t = &idx->calls;
+    int nremoved = 0;
+
+    // entry shifted back into already visited slot is checked again
+    for (int i = 0; i < t->cap; ) {
+        const net_call_t *call = table_val(t, i);
+        if (t->keys[i] && call->updated < seq) {
+            table_remove_at(t, i);
+            ++nremoved;
+        } else {
+            ++i;
+        }
+    }
+
+    return nremoved;
+}
@@ -2,44 +2,52 @@
 #include <tetrapol/log.h>
 #include <tetrapol/pch.h>
 #include <tetrapol/addr.h>
+#include <tetrapol/dup_cache.h>
 #include <tetrapol/misc.h>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
-typedef struct {
-    uint8_t act_bitmap[8];
-    uint8_t naddrs;
-    addr_t addrs[4];
-} pch_data_t;
-
 struct _pch_t {
     data_frame_t *data_fr;
     pch_data_t pch_data;
+    uint64_t msgs;
+    bool dup_suppress;
+    dup_cache_t dup;
+    int repeats;
+    uint64_t dups;
 };
 
+size_t pch_sizeof(void)
+{
+    return MEM_ALIGN_UP(sizeof(pch_t)) + data_frame_sizeof();
+}
+
 pch_t *pch_create(void)
 {
-    pch_t *pch = malloc(sizeof(pch_t));
+    pch_t *pch = malloc(pch_sizeof());
     if (!pch) {
         return NULL;
     }
-
-    pch->data_fr = data_frame_create();
-    if (!pch->data_fr) {
-        free(pch);
-        return NULL;
-    }
+    pch_init(pch);
 
     return pch;
 }
 
+void pch_init(pch_t *pch)
+{
+    pch->data_fr = (data_frame_t *)((char *)pch + MEM_ALIGN_UP(sizeof(pch_t)));
+    data_frame_init(pch->data_fr);
+    pch->msgs = 0;
+    pch->dup_suppress = false;
+    dup_cache_init(&pch->dup);
+    pch->repeats = 0;
+    pch->dups = 0;
+}
+
 void pch_destroy(pch_t *pch)
 {
-    if (pch) {
-        data_frame_destroy(pch->data_fr);
-    }
     free(pch);
 }
 
@@ -48,6 +56,11 @@ void pch_reset(pch_t *pch)
     data_frame_reset(pch->data_fr);
 }
 
+void pch_set_dup_suppress(pch_t *pch, bool suppress)
+{
+    pch->dup_suppress = suppress;
+}
+
 bool pch_push_data_block(pch_t *pch, data_block_t* data_blk)
 {
     if (!data_frame_push_data_block(pch->data_fr, data_blk)) {
@@ -64,15 +77,28 @@ bool pch_push_data_block(pch_t *pch, data_block_t* data_blk)
         return false;
     }
 
-    uint8_t data[(2 * 92) / 8];  // (2 * 64) / 8 should be OK, but ...
-    const int size = data_frame_get_bytes(pch->data_fr, data);
+    const uint8_t *data;
+    const int size = data_frame_get_bytes(pch->data_fr, &data);
     if (size != 2*64) {
         LOG(WTF, "block size: %d != 128\n", size);
         return false;
     }
 
+    pch->repeats = 0;
+    if (pch->dup_suppress) {
+        const dup_cache_entry_t *e = dup_cache_lookup(&pch->dup, data,
+                size / 8);
+        if (e) {
+            pch->repeats = e->repeats;
+            ++pch->dups;
+            return true;
+        }
+        dup_cache_insert(&pch->dup, 0);
+    }
+
     memcpy(pch->pch_data.act_bitmap, data, sizeof(pch->pch_data.act_bitmap));
 
+    pch->pch_data.timestamp = data_blk->timestamp;
     pch->pch_data.naddrs = 0;
     for (int i = 0; i < ARRAY_LEN(pch->pch_data.addrs); ++i) {
         addr_t *addr = &pch->pch_data.addrs[pch->pch_data.naddrs];
@@ -81,20 +107,39 @@ bool pch_push_data_block(pch_t *pch, data_block_t* data_blk)
             ++pch->pch_data.naddrs;
         }
     }
+    ++pch->msgs;
 
     return true;
 }
 
-void pch_print(pch_t *pch)
+void pch_get_stats(const pch_t *pch, log_ch_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    data_frame_get_stats(pch->data_fr, &stats->data_fr);
+    stats->msgs = pch->msgs;
+    stats->dups = pch->dups;
+}
+
+int pch_get_repeats(const pch_t *pch)
+{
+    return pch->repeats;
+}
+
+const pch_data_t *pch_get_data(const pch_t *pch)
+{
+    return &pch->pch_data;
+}
+
+void pch_print(const pch_data_t *pch_data)
 {
-    printf("PCH: activation_bitmap=");
-    for (int i = 0; i < ARRAY_LEN(pch->pch_data.act_bitmap); ++i) {
-        printf("0x%02x  ", pch->pch_data.act_bitmap[i]);
+    log_printf("PCH: activation_bitmap=");
+    for (int i = 0; i < ARRAY_LEN(pch_data->act_bitmap); ++i) {
+        log_printf("0x%02x  ", pch_data->act_bitmap[i]);
     }
-    printf("\n");
-    for (int i = 0; i < pch->pch_data.naddrs; ++i) {
-        printf("\taddr %d: ", i);
-        addr_print(&pch->pch_data.addrs[i]);
-        printf("\n");
+    log_printf("\n");
+    for (int i = 0; i < pch_data->naddrs; ++i) {
+        log_printf("\taddr %d: ", i);
+        addr_print(&pch_data->addrs[i]);
+        log_printf("\n");
     }
 }
@@ -12,48 +12,169 @@
 #include <tetrapol/rch.h>
 #include <tetrapol/sdch.h>
 #include <tetrapol/timer.h>
+#include <tetrapol/trace.h>
 
 #include <limits.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 // max error rate for 2 frame synchronization sequences
 #define MAX_FRAME_SYNC_ERR 1
 
+// bits of bitsliced counter of synchronization errors, up to 3 sequences
+// of 7 bits are compared
+#define FRAME_SYNC_CNT_BITS 5
+
 #define FRAME_HDR_LEN (8)
 #define FRAME_DATA_LEN (152)
 #define FRAME_LEN (FRAME_HDR_LEN + FRAME_DATA_LEN)
 
 #define DATA_OFFS (FRAME_LEN/2)
 
+// frame duration and duration of single bit (us)
+#define FRAME_US 20000
+#define BIT_US (FRAME_US / FRAME_LEN)
+
+// sync tracking, hypotheses for offsets -TRACK_OFFS..TRACK_OFFS-1 from
+// expected frame position are scored at once
+#define TRACK_OFFS 32
+// sync tracking, number of frame headers compared for each hypothesis
+#define TRACK_FRAMES 3
+// sync tracking, max. length of fade (frames) before the sync is lost
+#define TRACK_FADE_FRAMES 50
+
+// size of input ring buffer in bytes, must be power of 2
+#define RING_SIZE 1024
+#define RING_BITS (8 * RING_SIZE)
+// mirror of ring start placed after its end, allows unaligned 64 bit reads
+#define RING_GUARD (sizeof(uint64_t))
+
+// max. number of bits stored in input buffer (including DATA_OFFS history),
+// space is reserved to never share byte with oldest data during wrap
+#define DATA_LEN (RING_BITS - 64)
+
+// returned by get_frame() for frame lost in fade
+#define GET_FRAME_FADE 2
+
+// sequential SCR search, candidate with no valid frame yet is pruned after
+// this number of frames valid for other candidates
+#define SCR_PRUNE_FRAMES 2
+// sequential SCR search, -log2 of upper bound of probability that valid
+// frame passes FEC and CRC checks for wrong SCR
+#define SCR_FALSE_PASS_LOG2 8
+// sequential SCR search, log2 likelihood ratio of two best SCRs for lock
+#define SCR_LOCK_LLR 24
+
+// size of staging buffer used by tetrapol_phys_ch_recv_buf()
+#define RECV_BUF_LEN 512
+
+// timer wheel slots, the only deadline is SDCH tick with period of one slot
+#define TIMER_SLOTS 4
+
 typedef struct {
     int frame_no;
-    uint8_t data[FRAME_DATA_LEN];
+    int64_t timestamp;  ///< time of the first bit of frame header (us)
+    /// last extra bit is always zero, it is used by frame_dec_t as source
+    /// for bits without differential precoding
+    uint8_t data[FRAME_DATA_LEN + 1];
 } frame_t;
 
+/**
+  Tables for fused descrambling, differential decoding and deinterleaving.
+
+  Bit j of deinterleaved frame is
+  data[src1[j]] ^ data[src2[j]] ^ scr_xor[j]
+  */
+typedef struct {
+    uint8_t src1[FRAME_DATA_LEN];
+    uint8_t src2[FRAME_DATA_LEN];
+    uint8_t scr_xor[FRAME_DATA_LEN];
+} frame_dec_tab_t;
+
+typedef struct {
+    int band;
+    int scr;            ///< SCR used for tables generation
+    /// sources of bits 38 and 114 used for frame type detection
+    uint8_t type_src[4];
+    uint8_t type_xor;
+    frame_dec_tab_t data;
+    frame_dec_tab_t voice;
+    /// scrambling sequence packed by frame_pack_rows(), for batch_t
+    uint64_t scr_rows[3];
+} frame_dec_t;
+
+/**
+  Band specialized decoding pipeline, bodies are generated from common
+  inline functions with constant band, so branches on band and unused
+  table lookups are eliminated at compile time.
+  */
+typedef struct _band_dec_t band_dec_t;
+
 struct _phys_ch_t {
     int band;           ///< VHF or UHF
+    const band_dec_t *band_dec; ///< selected by band in create
     int radio_ch_type;  ///< control or traffic
-    int sync_errs;      ///< cumulative no. of errors in frame synchronisation
+    int fade_frames;    ///< consecutive frames without synchronization
     bool has_frame_sync;
     int frame_no;
     int scr;            ///< SCR, scrambling constant
     int scr_guess;      ///< SCR with best score when guessing SCR
+    /// preloaded SCR waiting for verification, PHYS_CH_SCR_DETECT if none
+    int scr_preload;
     int scr_confidence; ///< required confidence for SCR detection
+    int scr_search;     ///< PHYS_CH_SCR_SEARCH_*
     int scr_stat[128];  ///< statistics for SCR detection
-    uint8_t *data_begin;    ///< start of unprocessed part of data
-    uint8_t *data_end;      ///< end of unprocessed part of data
-    uint8_t data[10*FRAME_LEN];
+    /// sequential search, frames valid for other SCRs while scr_stat is 0
+    uint8_t scr_fails[128];
+    uint64_t scr_cand[2];   ///< sequential search, candidates not pruned yet
+    int input_fmt;      ///< format of data passed to tetrapol_phys_ch_recv()
+    int data_begin;     ///< start of unprocessed part of data (bit index)
+    int data_end;       ///< end of unprocessed part of data (bit index)
+    int64_t time_base;  ///< time of bit index 0 (us), follows data_rebase()
+    bool has_time;      ///< time_base set by tetrapol_phys_ch_set_time()
+    /// received bits packed MSB first, ring buffer indexed by bit index
+    /// modulo RING_BITS, first RING_GUARD bytes are mirrored after the end
+    uint8_t data[RING_SIZE + RING_GUARD];
+    uint8_t *recv_buf;  ///< window returned by tetrapol_phys_ch_recv_buf()
+    uint8_t in_buf[RECV_BUF_LEN];
     // CCH specific data, will be union with traffich CH specicic data
     int cch_mux_type;   ///< control CH multiplexing, see PAS 0001-3-3 5.1.3
+    frame_dec_t frame_dec;
     timer_t *timer;
+    timer_deadline_t sdch_timer;
     bch_t *bch;
     pch_t *pch;
     rch_t *rch;
     sdch_t *sdch;
+    tsdu_sink_t tsdu_sink;
+    void *tsdu_sink_ptr;
+    pch_sink_t pch_sink;
+    void *pch_sink_ptr;
+    rch_sink_t rch_sink;
+    void *rch_sink_ptr;
+    sysinfo_sink_t sysinfo_sink;
+    void *sysinfo_sink_ptr;
+    bool bch_only;      ///< skip PCH, RCH and SDCH
+    dup_sink_t dup_sink;
+    void *dup_sink_ptr;
+    tsdu_filter_t tsdu_filter;  ///< subscribed codops
+    frame_sink_t frame_sink;
+    void *frame_sink_ptr;
+    /// decoded data blocks are passed here instead of logical channels
+    block_sink_t block_sink;
+    void *block_sink_ptr;
+    // TCH specific data
+    voice_sink_t voice_sink;
+    void *voice_sink_ptr;
+    /// own counters, counters of logical channels are added on read
+    phys_ch_stats_t stats;
+    phys_ch_quality_t quality;
+    int sync_errs;      ///< errors in frame sync of the last frame
+    size_t mem_size;    ///< size of allocation with all components
 };
 
 /**
@@ -71,7 +192,7 @@ struct _phys_ch_t {
     if i % 8 == 7:
       print()
   */
-static uint8_t scramb_table[127] = {
+static const uint8_t scramb_table[127] = {
     1, 1, 1, 1, 1, 1, 1, 0,
     1, 0, 1, 0, 1, 0, 0, 1,
     1, 0, 0, 1, 1, 1, 0, 1,
@@ -90,9 +211,39 @@ static uint8_t scramb_table[127] = {
     1, 0, 0, 0, 0, 0, 0,
 };
 
+static void frame_dec_init(frame_dec_t *frame_dec, int band, int scr);
+static const band_dec_t *band_dec_select(int band);
 static int process_frame(phys_ch_t *phys_ch, frame_t *frame);
-static int process_control_radio_ch(phys_ch_t *phys_ch, frame_t *f);
-static int process_traffic_radio_ch(phys_ch_t *phys_ch, frame_t *f);
+static frame_type_t decode_data_block(phys_ch_t *phys_ch, const frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi);
+static int process_data_block(phys_ch_t *phys_ch, frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi);
+static int process_control_radio_ch(phys_ch_t *phys_ch, frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi);
+static int process_traffic_radio_ch(phys_ch_t *phys_ch,
+        data_block_t *data_blk, frame_info_t *fi);
+static int control_data_block(phys_ch_t *phys_ch, data_block_t *data_blk);
+static int traffic_data_block(phys_ch_t *phys_ch,
+        const data_block_t *data_blk, const frame_info_t *fi);
+
+static size_t phys_ch_sizeof(int radio_ch_type)
+{
+    size_t size = MEM_ALIGN_UP(sizeof(phys_ch_t)) +
+        MEM_ALIGN_UP(timer_sizeof(TIMER_SLOTS));
+    if (radio_ch_type == RADIO_CH_TYPE_CONTROL) {
+        size += MEM_ALIGN_UP(bch_sizeof()) + MEM_ALIGN_UP(pch_sizeof()) +
+            MEM_ALIGN_UP(rch_sizeof()) + sdch_sizeof();
+    }
+
+    return size;
+}
+
+static void scr_search_reset(phys_ch_t *phys_ch)
+{
+    memset(&phys_ch->scr_stat, 0, sizeof(phys_ch->scr_stat));
+    memset(&phys_ch->scr_fails, 0, sizeof(phys_ch->scr_fails));
+    phys_ch->scr_cand[0] = phys_ch->scr_cand[1] = ~0ULL;
+}
 
 phys_ch_t *tetrapol_phys_ch_create(int band, int radio_ch_type)
 {
@@ -107,67 +258,88 @@ phys_ch_t *tetrapol_phys_ch_create(int band, int radio_ch_type)
         return NULL;
     }
 
-    phys_ch_t *phys_ch = calloc(1, sizeof(phys_ch_t));
-    if (phys_ch == NULL) {
+    // all components are placed into single allocation
+    const size_t size = phys_ch_sizeof(radio_ch_type);
+    char *p = calloc(1, size);
+    if (p == NULL) {
         return NULL;
     }
+    phys_ch_t *phys_ch = (phys_ch_t *)p;
+    phys_ch->mem_size = size;
+    p += MEM_ALIGN_UP(sizeof(phys_ch_t));
 
     phys_ch->band = band;
+    phys_ch->band_dec = band_dec_select(band);
     phys_ch->radio_ch_type = radio_ch_type;
-    phys_ch->data_begin = phys_ch->data_end = phys_ch->data + DATA_OFFS;
+    phys_ch->input_fmt = PHYS_CH_INPUT_UNPACKED;
+    phys_ch->data_begin = phys_ch->data_end = DATA_OFFS;
+    phys_ch->time_base = -DATA_OFFS * BIT_US;
     phys_ch->frame_no = FRAME_NO_UNKNOWN;
     phys_ch->scr = PHYS_CH_SCR_DETECT;
+    phys_ch->scr_preload = PHYS_CH_SCR_DETECT;
     phys_ch->scr_confidence = 50;
-    phys_ch->timer = timer_create();
+    phys_ch->scr_search = PHYS_CH_SCR_SEARCH_SEQUENTIAL;
+    scr_search_reset(phys_ch);
+    phys_ch->stats.scr = PHYS_CH_SCR_DETECT;
+    phys_ch->stats.scr_lock_time = -1;
+    frame_dec_init(&phys_ch->frame_dec, band, 0);
+    phys_ch->timer = (timer_t *)p;
+    timer_init(phys_ch->timer, TIMER_SLOTS);
+    p += MEM_ALIGN_UP(timer_sizeof(TIMER_SLOTS));
 
     if (radio_ch_type == RADIO_CH_TYPE_CONTROL) {
-        phys_ch->bch = bch_create();
-        if (!phys_ch->bch) {
-            goto err_bch;
-        }
-        phys_ch->pch = pch_create();
-        if (!phys_ch->pch) {
-            goto err_pch;
-        }
-        phys_ch->rch = rch_create();
-        if (!phys_ch->rch) {
-            goto err_rch;
-        }
-        phys_ch->sdch = sdch_create();
-        if (!phys_ch->sdch) {
-            goto err_sdch;
-        }
-        timer_register(phys_ch->timer, sdch_tick, phys_ch->sdch);
+        phys_ch->bch = (bch_t *)p;
+        bch_init(phys_ch->bch);
+        p += MEM_ALIGN_UP(bch_sizeof());
+        phys_ch->pch = (pch_t *)p;
+        pch_init(phys_ch->pch);
+        p += MEM_ALIGN_UP(pch_sizeof());
+        phys_ch->rch = (rch_t *)p;
+        rch_init(phys_ch->rch);
+        p += MEM_ALIGN_UP(rch_sizeof());
+        phys_ch->sdch = (sdch_t *)p;
+        sdch_init(phys_ch->sdch);
+        tsdu_filter_set_all(&phys_ch->tsdu_filter, true);
+        sdch_set_filter(phys_ch->sdch, &phys_ch->tsdu_filter);
+        timer_deadline_init(&phys_ch->sdch_timer, sdch_tick, phys_ch->sdch);
+        timer_start(phys_ch->timer, &phys_ch->sdch_timer, 0, TIMER_SLOT_US);
     }
 
     return phys_ch;
+}
 
-err_sdch:
-    rch_destroy(phys_ch->rch);
-
-err_rch:
-    pch_destroy(phys_ch->pch);
-
-err_pch:
-    bch_destroy(phys_ch->bch);
-
-err_bch:
-    timer_destroy(phys_ch->timer);
+void tetrapol_phys_ch_destroy(phys_ch_t *phys_ch)
+{
+    if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
+        bch_fini(phys_ch->bch);
+        sdch_fini(phys_ch->sdch);
+    }
+    timer_fini(phys_ch->timer);
     free(phys_ch);
+}
 
-    return NULL;
+void tetrapol_phys_ch_hibernate(phys_ch_t *phys_ch)
+{
+    phys_ch->data_begin = phys_ch->data_end;
+    phys_ch->has_frame_sync = false;
+    phys_ch->fade_frames = 0;
+    phys_ch->frame_no = FRAME_NO_UNKNOWN;
+    if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
+        bch_hibernate(phys_ch->bch);
+        pch_reset(phys_ch->pch);
+        sdch_hibernate(phys_ch->sdch);
+    }
 }
 
-void tetrapol_phys_ch_destroy(phys_ch_t *phys_ch)
+size_t tetrapol_phys_ch_get_mem_size(const phys_ch_t *phys_ch)
 {
+    size_t size = phys_ch->mem_size;
     if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
-        bch_destroy(phys_ch->bch);
-        pch_destroy(phys_ch->pch);
-        rch_destroy(phys_ch->rch);
-        sdch_destroy(phys_ch->sdch);
+        size += bch_get_heap_size(phys_ch->bch);
+        size += sdch_get_heap_size(phys_ch->sdch);
     }
-    timer_destroy(phys_ch->timer);
-    free(phys_ch);
+
+    return size;
 }
 
 int tetrapol_phys_ch_get_scr(phys_ch_t *phys_ch)
@@ -178,7 +350,59 @@ int tetrapol_phys_ch_get_scr(phys_ch_t *phys_ch)
 void tetrapol_phys_ch_set_scr(phys_ch_t *phys_ch, int scr)
 {
     phys_ch->scr = scr;
-    memset(&phys_ch->scr_stat, 0, sizeof(phys_ch->scr_stat));
+    phys_ch->scr_preload = PHYS_CH_SCR_DETECT;
+    scr_search_reset(phys_ch);
+    phys_ch->stats.scr = scr;
+    phys_ch->stats.scr_lock_time = -1;
+    if (scr != PHYS_CH_SCR_DETECT) {
+        frame_dec_init(&phys_ch->frame_dec, phys_ch->band, scr);
+        phys_ch->stats.scr_lock_time = timer_now(phys_ch->timer);
+    }
+}
+
+void tetrapol_phys_ch_preload_scr(phys_ch_t *phys_ch, int scr)
+{
+    tetrapol_phys_ch_set_scr(phys_ch, scr);
+    if (scr != PHYS_CH_SCR_DETECT) {
+        phys_ch->scr_preload = scr;
+        // locked when verified
+        phys_ch->stats.scr_lock_time = -1;
+    }
+}
+
+int tetrapol_phys_ch_get_cch_mux_type(phys_ch_t *phys_ch)
+{
+    return phys_ch->cch_mux_type;
+}
+
+bool tetrapol_phys_ch_set_cch_mux_type(phys_ch_t *phys_ch, int mux_type)
+{
+    if (mux_type != CELL_CONFIG_MUX_TYPE_DEFAULT &&
+            mux_type != CELL_CONFIG_MUX_TYPE_TYPE_2) {
+        LOG(ERR, "tetrapol_phys_ch_set_cch_mux_type() invalid param 'mux_type'");
+        return false;
+    }
+    phys_ch->cch_mux_type = mux_type;
+
+    return true;
+}
+
+void tetrapol_phys_ch_get_quality(const phys_ch_t *phys_ch,
+        phys_ch_quality_t *quality)
+{
+    memcpy(quality, &phys_ch->quality, sizeof(*quality));
+    quality->has_frame_sync = phys_ch->has_frame_sync;
+}
+
+void tetrapol_phys_ch_get_stats(phys_ch_t *phys_ch, phys_ch_stats_t *stats)
+{
+    memcpy(stats, &phys_ch->stats, sizeof(*stats));
+    if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
+        bch_get_stats(phys_ch->bch, &stats->bch);
+        pch_get_stats(phys_ch->pch, &stats->pch);
+        rch_get_stats(phys_ch->rch, &stats->rch);
+        sdch_get_stats(phys_ch->sdch, &stats->sdch);
+    }
 }
 
 int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch)
@@ -192,265 +416,741 @@ void tetrapol_phys_ch_set_scr_confidence(
     phys_ch->scr_confidence = scr_confidence;
 }
 
-static uint8_t differential_dec(uint8_t *data, int size, uint8_t first_bit)
+int tetrapol_phys_ch_get_scr_search(phys_ch_t *phys_ch)
 {
-    while (size--) {
-        first_bit = *data = *data ^ first_bit;
-        ++data;
-    }
-    return first_bit;
+    return phys_ch->scr_search;
 }
 
-int tetrapol_phys_ch_recv(phys_ch_t *phys_ch, uint8_t *buf, int len)
+bool tetrapol_phys_ch_set_scr_search(phys_ch_t *phys_ch, int scr_search)
 {
-    const int data_len = phys_ch->data_end - phys_ch->data_begin;
+    if (scr_search != PHYS_CH_SCR_SEARCH_SEQUENTIAL &&
+            scr_search != PHYS_CH_SCR_SEARCH_EXHAUSTIVE) {
+        LOG(ERR, "tetrapol_phys_ch_set_scr_search() invalid param 'scr_search'");
+        return false;
+    }
+    phys_ch->scr_search = scr_search;
+    scr_search_reset(phys_ch);
 
-    memmove(phys_ch->data, phys_ch->data_begin - DATA_OFFS, data_len + DATA_OFFS);
-    phys_ch->data_begin = phys_ch->data + DATA_OFFS;
-    phys_ch->data_end = phys_ch->data_begin + data_len;
+    return true;
+}
 
-    const int space = sizeof(phys_ch->data) - data_len - DATA_OFFS;
-    len = (len > space) ? space : len;
+void tetrapol_phys_ch_set_frame_sink(phys_ch_t *phys_ch, frame_sink_t sink,
+        void *ptr)
+{
+    phys_ch->frame_sink = sink;
+    phys_ch->frame_sink_ptr = ptr;
+}
 
-    memcpy(phys_ch->data_end, buf, len);
-    phys_ch->data_end += len;
+void tetrapol_phys_ch_set_block_sink(phys_ch_t *phys_ch, block_sink_t sink,
+        void *ptr)
+{
+    phys_ch->block_sink = sink;
+    phys_ch->block_sink_ptr = ptr;
+}
 
-    return len;
+void tetrapol_phys_ch_set_tsdu_sink(phys_ch_t *phys_ch, tsdu_sink_t sink,
+        void *ptr)
+{
+    phys_ch->tsdu_sink = sink;
+    phys_ch->tsdu_sink_ptr = ptr;
 }
 
-// compare bite stream to differentialy encoded synchronization sequence
-static int cmp_frame_sync(const uint8_t *data)
+void tetrapol_phys_ch_set_pch_sink(phys_ch_t *phys_ch, pch_sink_t sink,
+        void *ptr)
 {
-    const uint8_t frame_dsync[] = { 1, 0, 1, 0, 0, 1, 1, };
-    int sync_err = 0;
-    for(int i = 0; i < sizeof(frame_dsync); ++i) {
-        if (frame_dsync[i] != data[i + 1]) {
-            ++sync_err;
-        }
-    }
-    return sync_err;
+    phys_ch->pch_sink = sink;
+    phys_ch->pch_sink_ptr = ptr;
 }
 
-/**
-  Find 2 consecutive frame synchronization sequences.
+void tetrapol_phys_ch_set_rch_sink(phys_ch_t *phys_ch, rch_sink_t sink,
+        void *ptr)
+{
+    phys_ch->rch_sink = sink;
+    phys_ch->rch_sink_ptr = ptr;
+}
 
-  Using raw stream (before differential decoding) simplyfies search
-  because only signal polarity must be considered,
-  there is lot of troubles with error handlig after differential decoding.
-  */
-static int find_frame_sync(phys_ch_t *phys_ch)
+void tetrapol_phys_ch_set_sysinfo_sink(phys_ch_t *phys_ch,
+        sysinfo_sink_t sink, void *ptr)
 {
-    const uint8_t *end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
-    int sync_err = MAX_FRAME_SYNC_ERR + 1;
-    while (phys_ch->data_begin <= end) {
-        sync_err = cmp_frame_sync(phys_ch->data_begin) +
-            cmp_frame_sync(phys_ch->data_begin + FRAME_LEN);
-        if (sync_err <= MAX_FRAME_SYNC_ERR) {
-            break;
-        }
+    phys_ch->sysinfo_sink = sink;
+    phys_ch->sysinfo_sink_ptr = ptr;
+}
 
-        ++phys_ch->data_begin;
-    }
+void tetrapol_phys_ch_set_bch_only(phys_ch_t *phys_ch, bool bch_only)
+{
+    phys_ch->bch_only = bch_only;
+}
 
-    if (sync_err <= MAX_FRAME_SYNC_ERR) {
-        phys_ch->sync_errs = 0;
-        return 1;
+void tetrapol_phys_ch_set_dup_suppress(phys_ch_t *phys_ch, bool suppress)
+{
+    if (phys_ch->radio_ch_type != RADIO_CH_TYPE_CONTROL) {
+        return;
     }
+    bch_set_dup_suppress(phys_ch->bch, suppress);
+    pch_set_dup_suppress(phys_ch->pch, suppress);
+    rch_set_dup_suppress(phys_ch->rch, suppress);
+}
 
-    return 0;
+void tetrapol_phys_ch_set_dup_sink(phys_ch_t *phys_ch, dup_sink_t sink,
+        void *ptr)
+{
+    phys_ch->dup_sink = sink;
+    phys_ch->dup_sink_ptr = ptr;
 }
 
-static void copy_frame(phys_ch_t *phys_ch, frame_t *frame)
+void tetrapol_phys_ch_subscribe(phys_ch_t *phys_ch, codop_t codop,
+        bool subscribe)
 {
-    memcpy(frame->data, phys_ch->data_begin + FRAME_HDR_LEN, FRAME_DATA_LEN);
-    phys_ch->data_begin += FRAME_LEN;
+    tsdu_filter_set(&phys_ch->tsdu_filter, codop, subscribe);
+}
 
-    frame->frame_no = phys_ch->frame_no;
-    differential_dec(frame->data, FRAME_DATA_LEN, 0);
+void tetrapol_phys_ch_subscribe_all(phys_ch_t *phys_ch, bool subscribe)
+{
+    tsdu_filter_set_all(&phys_ch->tsdu_filter, subscribe);
 }
 
-/// return number of acquired frames (0 or 1) or -1 on error
-static int get_frame(phys_ch_t *phys_ch, frame_t *frame)
+void tetrapol_phys_ch_set_voice_sink(phys_ch_t *phys_ch, voice_sink_t sink,
+        void *ptr)
 {
-    if (phys_ch->data_end - phys_ch->data_begin < FRAME_LEN) {
-        return 0;
+    phys_ch->voice_sink = sink;
+    phys_ch->voice_sink_ptr = ptr;
+}
+
+int tetrapol_phys_ch_get_input_fmt(phys_ch_t *phys_ch)
+{
+    return phys_ch->input_fmt;
+}
+
+bool tetrapol_phys_ch_set_input_fmt(phys_ch_t *phys_ch, int input_fmt)
+{
+    if (input_fmt != PHYS_CH_INPUT_UNPACKED &&
+            input_fmt != PHYS_CH_INPUT_PACKED) {
+        LOG(ERR, "tetrapol_phys_ch_set_input_fmt() invalid param 'input_fmt'");
+        return false;
     }
+    phys_ch->input_fmt = input_fmt;
 
-    // are we in sync?
-    if (cmp_frame_sync(phys_ch->data_begin) == 0) {
-        copy_frame(phys_ch, frame);
-        if (phys_ch->sync_errs > 0) {
-            --phys_ch->sync_errs;
-        }
-        return 1;
+    return true;
+}
+
+/**
+  Get 64 bits from ring buffer starting at bit 'pos', first bit is MSB.
+
+  Position wraps at RING_BITS, 'data' must be mirrored by RING_GUARD bytes.
+  */
+static inline uint64_t get_bits64(const uint8_t *data, int pos)
+{
+    pos &= RING_BITS - 1;
+    const uint8_t *d = data + pos / 8;
+    uint64_t r = 0;
+    for (int i = 0; i < sizeof(r); ++i) {
+        r = (r << 8) | d[i];
     }
 
-    if (phys_ch->sync_errs > 6) {
-        LOG(INFO, "get_frame() - sync lost sync_errs=%d", phys_ch->sync_errs);
-        return -1;
+    const int shift = pos % 8;
+    if (shift) {
+        r = (r << shift) | (d[sizeof(r)] >> (8 - shift));
     }
 
-    // look for synchoronization pattern shifted by some offset from expected
-    // possition. At the same time look for synchronization pattern of the
-    // following frame. If pattern(s) are found, synchronization is restored.
-    int sync_errs1 = INT_MAX;
-    int sync_errs2 = INT_MAX;
-    const uint8_t *end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
-    uint8_t *data = phys_ch->data_begin;
-    uint8_t *rdata = phys_ch->data_begin;
-    uint8_t *sync_pos1 = NULL;
-    uint8_t *sync_pos2 = NULL;
-    for (int i = 0; i < DATA_OFFS; ++i) {
-        if (data > end) {
-            return 0;
-        }
+    return r;
+}
 
-        int e = cmp_frame_sync(data);
-        if (e < sync_errs1) {
-            sync_pos1 = data;
-            sync_errs1 = e;
-        }
+/**
+  Differential decoding of 64 packed bits, first bit is MSB.
 
-        e = cmp_frame_sync(rdata);
-        if (e < sync_errs1) {
-            sync_pos1 = rdata;
-            sync_errs1 = e;
-        }
+  Each output bit is XOR of input bit and previous output bit, which makes
+  it prefix XOR over the whole word.
 
-        e = cmp_frame_sync(data + FRAME_LEN);
-        if (e < sync_errs2) {
-            sync_pos2 = data;
-            sync_errs2 = e;
-        }
+  @param first_bit Output bit preceding MSB of 'bits'.
+  */
+static inline uint64_t differential_dec(uint64_t bits, uint64_t first_bit)
+{
+    bits ^= bits >> 1;
+    bits ^= bits >> 2;
+    bits ^= bits >> 4;
+    bits ^= bits >> 8;
+    bits ^= bits >> 16;
+    bits ^= bits >> 32;
+
+    return first_bit ? ~bits : bits;
+}
 
-        e = cmp_frame_sync(rdata + FRAME_LEN);
-        if (e < sync_errs2) {
-            sync_pos2 = rdata;
-            sync_errs2 = e;
+/// Append bits from one bit per byte array.
+static void put_bits_unpacked(uint8_t *data, int pos, const uint8_t *buf, int len)
+{
+    for (int i = 0; i < len; ++i, ++pos) {
+        const uint8_t mask = 0x80 >> (pos % 8);
+        if (buf[i] & 1) {
+            data[pos / 8] |= mask;
+        } else {
+            data[pos / 8] &= ~mask;
         }
+    }
+}
 
-        if (sync_errs1 == 0 || sync_errs2 == 0) {
-            break;
-        }
+/// Append bits from array packed 8 bits per byte, MSB first.
+static void put_bits_packed(uint8_t *data, int pos, const uint8_t *buf, int len)
+{
+    const int shift = pos % 8;
+    data += pos / 8;
 
-        ++data;
-        --rdata;
+    if (!shift) {
+        memcpy(data, buf, len);
+        return;
     }
 
-    // increase error counter only if we have not found 2 consecutive sync patterns
-    if (sync_errs1 != 0 || sync_errs2 != 0 || sync_pos1 != sync_pos2) {
-        phys_ch->sync_errs = 2 * phys_ch->sync_errs + 2;
+    data[0] = (data[0] & (0xff << (8 - shift))) | (buf[0] >> shift);
+    for (int i = 1; i < len; ++i) {
+        data[i] = (buf[i - 1] << (8 - shift)) | (buf[i] >> shift);
     }
+    data[len] = buf[len - 1] << (8 - shift);
+}
 
-    if (phys_ch->sync_errs > 10) {
-        LOG(INFO, "get_frame() sync lost sync_errs=%d", phys_ch->sync_errs);
-        return -1;
+/// Free space in data buffer (bits).
+static int data_space(const phys_ch_t *phys_ch)
+{
+    return DATA_LEN - (phys_ch->data_end - phys_ch->data_begin + DATA_OFFS);
+}
+
+/// Keep bit indexes small, data is not moved, ring is indexed modulo RING_BITS.
+static void data_rebase(phys_ch_t *phys_ch)
+{
+    if (phys_ch->data_begin - DATA_OFFS >= RING_BITS) {
+        phys_ch->data_begin -= RING_BITS;
+        phys_ch->data_end -= RING_BITS;
+        phys_ch->time_base += RING_BITS * BIT_US;
     }
+}
 
+/// Time of bit at index 'pos' (us).
+static int64_t data_time(const phys_ch_t *phys_ch, int pos)
+{
+    return phys_ch->time_base + (int64_t)pos * BIT_US;
+}
+
+void tetrapol_phys_ch_set_time(phys_ch_t *phys_ch, int64_t timestamp)
+{
+    phys_ch->time_base = timestamp - (int64_t)phys_ch->data_end * BIT_US;
+    phys_ch->has_time = true;
+}
 
-    phys_ch->data_begin = (sync_errs1 < sync_errs2) ? sync_pos1 : sync_pos2;
+/**
+  Finish write of 'len' bits at ring position 'pos'.
 
-    copy_frame(phys_ch, frame);
-    LOG(INFO, "get_frame() sync fail sync_errs=%d", phys_ch->sync_errs);
+  Write can overflow into the guard area by one byte, such bits belongs
+  to the ring start. Writes of ring start must be mirrored into the guard.
+  */
+static void data_written(phys_ch_t *phys_ch, int pos, int len)
+{
+    uint8_t *data = phys_ch->data;
 
-    return 1;
+    if (pos + len > RING_BITS) {
+        data[0] = data[RING_SIZE];
+    }
+    if (pos < 8 * RING_GUARD || pos + len > RING_BITS) {
+        memcpy(data + RING_SIZE, data, RING_GUARD);
+    }
+    phys_ch->data_end += len;
 }
 
-int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
+/// Append 'len' bytes of input into ring buffer, space must be checked.
+static void data_put(phys_ch_t *phys_ch, const uint8_t *buf, int len)
 {
-    if (!phys_ch->has_frame_sync) {
-        int n = phys_ch->data_end - phys_ch->data_end;
-        phys_ch->has_frame_sync = find_frame_sync(phys_ch);
-        n -= phys_ch->data_end - phys_ch->data_end;
-        if (!phys_ch->has_frame_sync) {
-            timer_tick(phys_ch->timer, n * 20000 / 160);
-            return 0;
-        }
-        LOG(INFO, "Frame sync found");
-        phys_ch->frame_no = FRAME_NO_UNKNOWN;
-        pch_reset(phys_ch->pch);
-    }
+    const int bits_per_byte =
+        (phys_ch->input_fmt == PHYS_CH_INPUT_PACKED) ? 8 : 1;
 
-    int r = 1;
-    frame_t frame;
-    while ((r = get_frame(phys_ch, &frame)) > 0) {
-        process_frame(phys_ch, &frame);
-        if (frame.frame_no != FRAME_NO_UNKNOWN) {
-            phys_ch->frame_no = (frame.frame_no + 1) % 200;
+    while (len > 0) {
+        const int pos = phys_ch->data_end % RING_BITS;
+        int n = (RING_BITS - pos + bits_per_byte - 1) / bits_per_byte;
+        n = (n > len) ? len : n;
+
+        if (phys_ch->input_fmt == PHYS_CH_INPUT_PACKED) {
+            put_bits_packed(phys_ch->data, pos, buf, n);
+        } else {
+            put_bits_unpacked(phys_ch->data, pos, buf, n);
         }
-        timer_tick(phys_ch->timer, 20000);
+        data_written(phys_ch, pos, n * bits_per_byte);
+        buf += n;
+        len -= n;
     }
+}
+
+int tetrapol_phys_ch_recv(phys_ch_t *phys_ch, uint8_t *buf, int len)
+{
+    data_rebase(phys_ch);
 
-    if (r == 0) {
+    const int bits_per_byte =
+        (phys_ch->input_fmt == PHYS_CH_INPUT_PACKED) ? 8 : 1;
+    const int space = data_space(phys_ch) / bits_per_byte;
+    len = (len > space) ? space : len;
+    if (len <= 0) {
         return 0;
     }
 
-    LOG(INFO, "Frame sync lost");
-    phys_ch->has_frame_sync = false;
+    data_put(phys_ch, buf, len);
 
-    return 0;
+    return len;
 }
 
-// PAS 0001-2 6.1.4.1
-static const uint8_t interleave_voice_UHF[] = {
-    1, 77, 38, 114, 20, 96, 59, 135,
-    3, 79, 41, 117, 23, 99, 62, 138,
-    5, 81, 44, 120, 26, 102, 65, 141,
-    8, 84, 47, 123, 29, 105, 68, 144,
-    11, 87, 50, 126, 32, 108, 71, 147,
-    14, 90, 53, 129, 35, 111, 74, 150,
-    17, 93, 56, 132, 37, 113, 73, 4,
-    0, 76, 40, 119, 19, 95, 58, 137,
-    151, 80, 42, 115, 24, 100, 60, 133,
-    12, 88, 48, 121, 30, 106, 66, 139,
-    18, 91, 51, 124, 28, 104, 67, 146,
-    10, 89, 52, 131, 34, 110, 70, 149,
-    13, 97, 57, 130, 36, 112, 75, 148,
-    6, 82, 39, 116, 16, 92, 55, 134,
-    2, 78, 43, 122, 22, 98, 61, 140,
-    9, 85, 45, 118, 27, 103, 63, 136,
-    15, 83, 46, 125, 25, 101, 64, 143,
-    7, 86, 49, 128, 31, 107, 69, 142,
-    21, 94, 54, 127, 33, 109, 72, 145,
-};
+int tetrapol_phys_ch_recv_buf(phys_ch_t *phys_ch, uint8_t **buf)
+{
+    data_rebase(phys_ch);
+
+    int len;
+    if (phys_ch->input_fmt == PHYS_CH_INPUT_PACKED &&
+            phys_ch->data_end % 8 == 0) {
+        // read directly into ring, up to its end
+        const int pos = phys_ch->data_end % RING_BITS;
+        len = (RING_BITS - pos) / 8;
+        phys_ch->recv_buf = phys_ch->data + pos / 8;
+        len = (len > data_space(phys_ch) / 8) ? data_space(phys_ch) / 8 : len;
+    } else {
+        const int bits_per_byte =
+            (phys_ch->input_fmt == PHYS_CH_INPUT_PACKED) ? 8 : 1;
+        len = data_space(phys_ch) / bits_per_byte;
+        len = (len > RECV_BUF_LEN) ? RECV_BUF_LEN : len;
+        phys_ch->recv_buf = phys_ch->in_buf;
+    }
 
-// PAS 0001-2 6.2.4.1
-static const uint8_t interleave_data_UHF[] = {
-    1, 77, 38, 114, 20, 96, 59, 135,
-    3, 79, 41, 117, 23, 99, 62, 138,
-    5, 81, 44, 120, 26, 102, 65, 141,
-    8, 84, 47, 123, 29, 105, 68, 144,
-    11, 87, 50, 126, 32, 108, 71, 147,
-    14, 90, 53, 129, 35, 111, 74, 150,
-    17, 93, 56, 132, 37, 112, 76, 148,
-    2, 88, 40, 115, 19, 97, 58, 133,
-    4, 75, 43, 118, 22, 100, 61, 136,
-    7, 85, 46, 121, 25, 103, 64, 139,
-    10, 82, 49, 124, 28, 106, 67, 142,
-    13, 91, 52, 127, 31, 109, 73, 145,
-    16, 94, 55, 130, 34, 113, 70, 151,
-    0, 80, 39, 116, 21, 95, 57, 134,
-    6, 78, 42, 119, 24, 98, 60, 137,
-    9, 83, 45, 122, 27, 101, 63, 140,
-    12, 86, 48, 125, 30, 104, 66, 143,
-    15, 89, 51, 128, 33, 107, 69, 146,
-    18, 92, 54, 131, 36, 110, 72, 149,
-};
+    *buf = phys_ch->recv_buf;
 
-/**
-  PAS 0001-2 6.1.3.1
-  PAS 0001-2 6.2.3.1
+    return (len > 0) ? len : 0;
+}
 
-  Interleaving sequence was generated by this python3 script
+void tetrapol_phys_ch_recv_commit(phys_ch_t *phys_ch, int len)
+{
+    if (len <= 0) {
+        return;
+    }
 
-  p = (0, 4, 2, 6, 1, 5, 3, 7)
-  K = [19 * p[j % 8] + (3 * ((j // 8)) % 19) for j in range(152)]
-  for i in range(len(K)):
-    print(K[i], end=", ")
-    if i % 8 == 7:
-      print()
+    if (phys_ch->recv_buf == phys_ch->in_buf) {
+        data_put(phys_ch, phys_ch->in_buf, len);
+    } else {
+        data_written(phys_ch, phys_ch->data_end % RING_BITS, 8 * len);
+    }
+}
+
+// compare bite stream to differentialy encoded synchronization sequence
+static int cmp_frame_sync(const uint8_t *data, int pos)
+{
+    // bits 1-7 of frame header: 1, 0, 1, 0, 0, 1, 1
+    const uint8_t frame_dsync = 0x53;
+    const uint8_t hdr = get_bits64(data, pos) >> 56;
+
+    return __builtin_popcount((hdr ^ frame_dsync) & 0x7f);
+}
+
+/**
+  Bit-parallel version of cmp_frame_sync() for 64 consecutive offsets.
+
+  Errors for synchronization at position pos + i are added into bitsliced
+  counter 'cnt' at bit 63 - i, cnt[0] holds LSBs of counters.
   */
-static const uint8_t interleave_voice_data_VHF[] = {
+static void cmp_frame_sync64(const uint8_t *data, int pos,
+        uint64_t cnt[FRAME_SYNC_CNT_BITS])
+{
+    const uint8_t frame_dsync[] = { 1, 0, 1, 0, 0, 1, 1, };
+    for (int i = 0; i < sizeof(frame_dsync); ++i) {
+        // XOR with sync bit, set bits means error for given offset
+        uint64_t c = get_bits64(data, pos + i + 1) ^
+            (frame_dsync[i] ? ~0ULL : 0);
+        for (int j = 0; j < FRAME_SYNC_CNT_BITS; ++j) {
+            const uint64_t t = cnt[j] & c;
+            cnt[j] ^= c;
+            c = t;
+        }
+    }
+}
+
+/**
+  Get mask of bitsliced counters with value <= max_errs.
+  */
+static uint64_t frame_sync_cnt_le(const uint64_t cnt[FRAME_SYNC_CNT_BITS],
+        int max_errs)
+{
+    uint64_t gt = 0;
+    uint64_t eq = ~0ULL;
+    for (int j = FRAME_SYNC_CNT_BITS - 1; j >= 0; --j) {
+        if ((max_errs >> j) & 1) {
+            eq &= cnt[j];
+        } else {
+            gt |= eq & cnt[j];
+            eq &= ~cnt[j];
+        }
+    }
+
+    return ~gt;
+}
+
+/**
+  Find 2 consecutive frame synchronization sequences.
+
+  Using raw stream (before differential decoding) simplyfies search
+  because only signal polarity must be considered,
+  there is lot of troubles with error handlig after differential decoding.
+
+  64 offsets are tested at once, data_begin is set to first offset
+  with matching synchronization.
+  */
+static int find_frame_sync(phys_ch_t *phys_ch)
+{
+    const int end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
+    while (phys_ch->data_begin <= end) {
+        uint64_t cnt[FRAME_SYNC_CNT_BITS] = { 0, };
+        cmp_frame_sync64(phys_ch->data, phys_ch->data_begin, cnt);
+        cmp_frame_sync64(phys_ch->data, phys_ch->data_begin + FRAME_LEN, cnt);
+
+        uint64_t match = frame_sync_cnt_le(cnt, MAX_FRAME_SYNC_ERR);
+        const int n = end - phys_ch->data_begin + 1;
+        if (n < 64) {
+            match &= ~(~0ULL >> n);
+        }
+
+        if (match) {
+            phys_ch->data_begin += __builtin_clzll(match);
+            phys_ch->fade_frames = 0;
+            return 1;
+        }
+
+        phys_ch->data_begin += (n < 64) ? n : 64;
+    }
+
+    return 0;
+}
+
+static void copy_frame(phys_ch_t *phys_ch, frame_t *frame)
+{
+    const int pos = phys_ch->data_begin + FRAME_HDR_LEN;
+    uint64_t last_bit = 0;
+    for (int i = 0; i < FRAME_DATA_LEN; i += 64) {
+        const uint64_t bits = differential_dec(
+                get_bits64(phys_ch->data, pos + i), last_bit);
+        const int n = (FRAME_DATA_LEN - i < 64) ? FRAME_DATA_LEN - i : 64;
+        for (int j = 0; j < n; ++j) {
+            frame->data[i + j] = (bits >> (63 - j)) & 1;
+        }
+        last_bit = bits & 1;
+    }
+    frame->data[FRAME_DATA_LEN] = 0;
+    frame->timestamp = data_time(phys_ch, phys_ch->data_begin);
+    phys_ch->data_begin += FRAME_LEN;
+
+    frame->frame_no = phys_ch->frame_no;
+}
+
+/**
+  Find offset of frame synchronization relative to expected position.
+
+  Hypotheses for all offsets in <-TRACK_OFFS, TRACK_OFFS) are scored
+  at once by number of errors in TRACK_FRAMES consecutive frame headers,
+  the frame period is known so slipped or faded signal is found without
+  new acquisition.
+
+  @return offset closest to expected position, INT_MAX if none matches
+  */
+static int track_frame_sync(const phys_ch_t *phys_ch)
+{
+    const int pos = phys_ch->data_begin - TRACK_OFFS;
+    uint64_t cnt[FRAME_SYNC_CNT_BITS] = { 0, };
+    for (int i = 0; i < TRACK_FRAMES; ++i) {
+        cmp_frame_sync64(phys_ch->data, pos + i * FRAME_LEN, cnt);
+    }
+    const uint64_t match = frame_sync_cnt_le(cnt, MAX_FRAME_SYNC_ERR);
+
+    // offset d is at bit TRACK_OFFS - 1 - d, split by sign of offset
+    const uint64_t pos_mask = ~0ULL >> (64 - TRACK_OFFS);
+    const uint64_t match_pos = match & pos_mask;
+    const uint64_t match_neg = match & ~pos_mask;
+    const int d_pos = match_pos ? __builtin_clzll(match_pos) - TRACK_OFFS : INT_MAX;
+    const int d_neg = match_neg ? TRACK_OFFS - 1 - __builtin_ctzll(match_neg) : -INT_MAX;
+    if (d_pos == INT_MAX && d_neg == -INT_MAX) {
+        return INT_MAX;
+    }
+
+    return (d_pos <= -d_neg) ? d_pos : d_neg;
+}
+
+/// restart averages of quality estimate
+static void quality_reset(phys_ch_t *phys_ch)
+{
+    memset(&phys_ch->quality, 0, sizeof(phys_ch->quality));
+    phys_ch->sync_errs = 0;
+}
+
+/**
+  Add frame into quality estimate.
+
+  @param nerrs FEC errors, -1 for frame lost in fade
+  */
+static void quality_add(phys_ch_t *phys_ch, int sync_errs, int nerrs,
+        bool crc_err)
+{
+    phys_ch_quality_t *q = &phys_ch->quality;
+    if (q->nframes < PHYS_CH_QUALITY_FRAMES) {
+        ++q->nframes;
+    }
+    // the first frames are averaged with equal weight
+    const float a = 1.0f / q->nframes;
+    q->sync_errs += (sync_errs - q->sync_errs) * a;
+    if (nerrs >= 0) {
+        if (nerrs >= STATS_NERRS_BINS) {
+            nerrs = STATS_NERRS_BINS - 1;
+        }
+        q->nerrs += (nerrs - q->nerrs) * a;
+    }
+    q->crc_errs += (crc_err - q->crc_errs) * a;
+}
+
+/**
+  Get next frame while in frame sync.
+
+  When synchronization is not found at expected position it is tracked
+  by track_frame_sync(), bit slips are followed and frames lost in fade
+  are skipped without losing frame number and SCR.
+
+  @return number of acquired frames (0 or 1), GET_FRAME_FADE when frame
+    is lost in fade, or -1 when sync is lost
+  */
+static int get_frame(phys_ch_t *phys_ch, frame_t *frame)
+{
+    if (phys_ch->data_end - phys_ch->data_begin < FRAME_LEN) {
+        return 0;
+    }
+
+    // are we in sync?
+    int offs = 0;
+    int sync_errs = cmp_frame_sync(phys_ch->data, phys_ch->data_begin);
+    if (sync_errs != 0) {
+        // all headers of all hypotheses must be received
+        if (phys_ch->data_end < phys_ch->data_begin + TRACK_OFFS - 1 +
+                (TRACK_FRAMES - 1) * FRAME_LEN + FRAME_HDR_LEN) {
+            return 0;
+        }
+        offs = track_frame_sync(phys_ch);
+    }
+
+    if (offs != INT_MAX) {
+        TRACE(frame_acquired, phys_ch->frame_no, offs, phys_ch->fade_frames);
+        if (offs) {
+            ++phys_ch->stats.sync_recovered;
+            LOG(INFO, "get_frame() sync shifted by %d", offs);
+        }
+        if (phys_ch->fade_frames) {
+            LOG(INFO, "get_frame() sync recovered after %d frames",
+                    phys_ch->fade_frames);
+            phys_ch->fade_frames = 0;
+        }
+        phys_ch->data_begin += offs;
+        // quality is updated when the frame is decoded
+        phys_ch->sync_errs = offs ?
+            cmp_frame_sync(phys_ch->data, phys_ch->data_begin) : sync_errs;
+        copy_frame(phys_ch, frame);
+        return 1;
+    }
+
+    if (++phys_ch->fade_frames > TRACK_FADE_FRAMES) {
+        LOG(INFO, "get_frame() sync lost after %d frames", TRACK_FADE_FRAMES);
+        return -1;
+    }
+
+    // skip frame, keep frame period
+    frame->timestamp = data_time(phys_ch, phys_ch->data_begin);
+    phys_ch->data_begin += FRAME_LEN;
+    frame->frame_no = phys_ch->frame_no;
+    ++phys_ch->stats.fade_frames;
+    quality_add(phys_ch, sync_errs, -1, true);
+
+    return GET_FRAME_FADE;
+}
+
+static int64_t time_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/// Account frame processing time (ns).
+static void stats_add_time(phys_ch_stats_t *stats, int64_t ns)
+{
+    int bin = (ns > 0) ? 63 - __builtin_clzll(ns) : 0;
+    if (bin >= STATS_TIME_BINS) {
+        bin = STATS_TIME_BINS - 1;
+    }
+    ++stats->time_hist[bin];
+    stats->time_sum += (ns > 0) ? ns : 0;
+}
+
+/**
+  Account latency of message from frame with 'timestamp' to the sink call,
+  it is measured only for time set by tetrapol_phys_ch_set_time().
+  */
+static void stats_add_latency(phys_ch_t *phys_ch, int64_t timestamp)
+{
+    if (!phys_ch->has_time) {
+        return;
+    }
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    const int64_t us = now.tv_sec * 1000000LL + now.tv_nsec / 1000 -
+        (timestamp + FRAME_US);
+    int bin = (us > 0) ? 63 - __builtin_clzll(us) : 0;
+    if (bin >= STATS_LATENCY_BINS) {
+        bin = STATS_LATENCY_BINS - 1;
+    }
+    phys_ch_stats_t *stats = &phys_ch->stats;
+    ++stats->latency_hist[bin];
+    stats->latency_sum += (us > 0) ? us : 0;
+}
+
+/// Search frame sync if not in sync, @return true when channel is in sync
+static bool sync_search(phys_ch_t *phys_ch)
+{
+    if (phys_ch->has_frame_sync) {
+        return true;
+    }
+
+    const int begin = phys_ch->data_begin;
+    phys_ch->has_frame_sync = find_frame_sync(phys_ch);
+    // time of channel follows processed bits
+    timer_tick(phys_ch->timer, (phys_ch->data_begin - begin) * BIT_US);
+    if (!phys_ch->has_frame_sync) {
+        return false;
+    }
+    LOG(INFO, "Frame sync found");
+    ++phys_ch->stats.sync_found;
+    quality_reset(phys_ch);
+    phys_ch->frame_no = FRAME_NO_UNKNOWN;
+    if (phys_ch->pch) {
+        pch_reset(phys_ch->pch);
+    }
+
+    return true;
+}
+
+static void sync_lost(phys_ch_t *phys_ch)
+{
+    LOG(INFO, "Frame sync lost");
+    ++phys_ch->stats.sync_lost;
+    phys_ch->has_frame_sync = false;
+}
+
+/**
+  Finish frame returned by get_frame(), frame number and time of channel
+  are advanced.
+
+  @param begin Value of data_begin before get_frame().
+  */
+static void frame_done(phys_ch_t *phys_ch, const frame_t *frame, int begin)
+{
+    if (frame->frame_no != FRAME_NO_UNKNOWN) {
+        phys_ch->frame_no = (frame->frame_no + 1) % 200;
+    }
+    timer_tick(phys_ch->timer, (phys_ch->data_begin - begin) * BIT_US);
+}
+
+int tetrapol_phys_ch_process(phys_ch_t *phys_ch)
+{
+    if (!sync_search(phys_ch)) {
+        return 0;
+    }
+
+    int r = 1;
+    frame_t frame;
+    int begin = phys_ch->data_begin;
+    while ((r = get_frame(phys_ch, &frame)) > 0) {
+        if (r != GET_FRAME_FADE) {
+            ++phys_ch->stats.frames;
+            const int64_t start = time_ns();
+            process_frame(phys_ch, &frame);
+            stats_add_time(&phys_ch->stats, time_ns() - start);
+        }
+        frame_done(phys_ch, &frame, begin);
+        begin = phys_ch->data_begin;
+    }
+
+    if (r < 0) {
+        sync_lost(phys_ch);
+    }
+
+    return 0;
+}
+
+void tetrapol_phys_ch_resync(phys_ch_t *phys_ch)
+{
+    // bits before the gap can not be continued by bits after it
+    phys_ch->data_begin = phys_ch->data_end;
+    if (phys_ch->has_frame_sync) {
+        LOG(INFO, "Frame sync dropped, input discontinuity");
+        phys_ch->has_frame_sync = false;
+    }
+    phys_ch->fade_frames = 0;
+    phys_ch->frame_no = FRAME_NO_UNKNOWN;
+    ++phys_ch->stats.resyncs;
+}
+
+// PAS 0001-2 6.1.4.1
+static const uint8_t interleave_voice_UHF[] = {
+    1, 77, 38, 114, 20, 96, 59, 135,
+    3, 79, 41, 117, 23, 99, 62, 138,
+    5, 81, 44, 120, 26, 102, 65, 141,
+    8, 84, 47, 123, 29, 105, 68, 144,
+    11, 87, 50, 126, 32, 108, 71, 147,
+    14, 90, 53, 129, 35, 111, 74, 150,
+    17, 93, 56, 132, 37, 113, 73, 4,
+    0, 76, 40, 119, 19, 95, 58, 137,
+    151, 80, 42, 115, 24, 100, 60, 133,
+    12, 88, 48, 121, 30, 106, 66, 139,
+    18, 91, 51, 124, 28, 104, 67, 146,
+    10, 89, 52, 131, 34, 110, 70, 149,
+    13, 97, 57, 130, 36, 112, 75, 148,
+    6, 82, 39, 116, 16, 92, 55, 134,
+    2, 78, 43, 122, 22, 98, 61, 140,
+    9, 85, 45, 118, 27, 103, 63, 136,
+    15, 83, 46, 125, 25, 101, 64, 143,
+    7, 86, 49, 128, 31, 107, 69, 142,
+    21, 94, 54, 127, 33, 109, 72, 145,
+};
+
+// PAS 0001-2 6.2.4.1
+static const uint8_t interleave_data_UHF[] = {
+    1, 77, 38, 114, 20, 96, 59, 135,
+    3, 79, 41, 117, 23, 99, 62, 138,
+    5, 81, 44, 120, 26, 102, 65, 141,
+    8, 84, 47, 123, 29, 105, 68, 144,
+    11, 87, 50, 126, 32, 108, 71, 147,
+    14, 90, 53, 129, 35, 111, 74, 150,
+    17, 93, 56, 132, 37, 112, 76, 148,
+    2, 88, 40, 115, 19, 97, 58, 133,
+    4, 75, 43, 118, 22, 100, 61, 136,
+    7, 85, 46, 121, 25, 103, 64, 139,
+    10, 82, 49, 124, 28, 106, 67, 142,
+    13, 91, 52, 127, 31, 109, 73, 145,
+    16, 94, 55, 130, 34, 113, 70, 151,
+    0, 80, 39, 116, 21, 95, 57, 134,
+    6, 78, 42, 119, 24, 98, 60, 137,
+    9, 83, 45, 122, 27, 101, 63, 140,
+    12, 86, 48, 125, 30, 104, 66, 143,
+    15, 89, 51, 128, 33, 107, 69, 146,
+    18, 92, 54, 131, 36, 110, 72, 149,
+};
+
+/**
+  PAS 0001-2 6.1.3.1
+  PAS 0001-2 6.2.3.1
+
+  Interleaving sequence was generated by this python3 script
+
+  p = (0, 4, 2, 6, 1, 5, 3, 7)
+  K = [19 * p[j % 8] + (3 * ((j // 8)) % 19) for j in range(152)]
+  for i in range(len(K)):
+    print(K[i], end=", ")
+    if i % 8 == 7:
+      print()
+  */
+static const uint8_t interleave_voice_data_VHF[] = {
     0, 76, 38, 114, 19, 95, 57, 133,
     3, 79, 41, 117, 22, 98, 60, 136,
     6, 82, 44, 120, 25, 101, 63, 139,
@@ -527,61 +1227,310 @@ static void frame_diff_dec(frame_t *f)
     }
 }
 
-static void frame_descramble(frame_t *f, int scr)
+static void frame_descramble(frame_t *f, int scr)
+{
+    if (scr == 0) {
+        return;
+    }
+
+    for(int k = 0 ; k < FRAME_DATA_LEN; k++) {
+        f->data[k] ^= scramb_table[(k + scr) % 127];
+    }
+}
+
+/// Bitsliced bits, lane N is bit N % 64 of element N / 64.
+typedef uint64_t lanes_t __attribute__((vector_size(16)));
+
+#define LANES 128
+
+/**
+  Bitsliced SCR detection.
+
+  Descrambling, differential decoding, deinterleaving, decoding of data
+  block and CRC are linear operations in GF(2), so frame for each SCR can
+  be obtained by XOR of descrambled frame with precomputed sequence.
+  All 128 SCR candidates are evaluated at once, lane N of scr_lanes_t
+  corresponds to SCR N.
+  */
+typedef lanes_t scr_lanes_t;
+
+struct _band_dec_t {
+    scr_lanes_t (*detect_scr_lanes)(const frame_t *f, scr_lanes_t cand);
+    frame_type_t (*frame_decode)(const frame_dec_t *frame_dec,
+            const frame_t *f, uint8_t *data);
+};
+
+/**
+  Generate scrambling sequence for all SCRs.
+
+  Lane scr of scr_seq[k] contains the bit XORed with k-th bit of frame
+  scrambled by this SCR, lane for SCR = 0 is always zero.
+  */
+static void mk_scr_seq(scr_lanes_t scr_seq[127])
+{
+    scr_lanes_t seq = { 0, 0 };
+    for (int scr = 1; scr < 128; ++scr) {
+        seq[scr / 64] |= (uint64_t)scramb_table[scr % 127] << (scr % 64);
+    }
+
+    for (int k = 0; k < 127; ++k) {
+        scr_seq[k] = seq;
+        // next bit of sequence for each SCR, rotate lanes 1-127 by one
+        const uint64_t lo = (seq[0] >> 1) | (seq[1] << 63);
+        const uint64_t hi = (seq[1] >> 1) | (lo << 63);
+        seq[0] = lo & ~1ULL;
+        seq[1] = hi;
+    }
+}
+
+/**
+  Get k-th frame bit after descrambling and differential decoding
+  for all SCRs.
+
+  @param f_dec Frame after differential decoding, without descrambling.
+  */
+static inline __attribute__((always_inline))
+scr_lanes_t frame_bit_lanes(const int band, const frame_t *f_dec,
+        const scr_lanes_t scr_seq[127], int k)
+{
+    const uint64_t b = f_dec->data[k] ? ~0ULL : 0;
+    scr_lanes_t r = (scr_lanes_t){ b, b } ^ scr_seq[k % 127];
+    if (band == TETRAPOL_BAND_UHF && k > 0) {
+        r ^= scr_seq[(k - diff_precod_UHF[k]) % 127];
+    }
+
+    return r;
+}
+
+/**
+  Bitsliced decode_data_frame() from data_block.c.
+
+  @param err Error flags of decoded bits or NULL.
+  @return lanes with nonzero error bits
+  */
+static inline __attribute__((always_inline))
+lanes_t decode_data_frame_lanes(lanes_t *res, lanes_t *err,
+        const lanes_t *in, int res_len)
+{
+#ifdef GET_IN_
+#error "Collision in definition of macro GET_IN_!"
+#endif
+#define GET_IN_(x, y) in[((x) + (y)) % (2*res_len)]
+
+    lanes_t errs = { 0, 0 };
+    for (int i = 0; i < res_len; ++i) {
+        res[i] = GET_IN_(2*i, 2) ^ GET_IN_(2*i, 3);
+        const lanes_t e =
+            GET_IN_(2*i, 5) ^ GET_IN_(2*i, 6) ^ GET_IN_(2*i, 7) ^ res[i];
+        if (err) {
+            err[i] = e;
+        }
+        errs |= e;
+    }
+#undef GET_IN_
+
+    return errs;
+}
+
+/**
+  Bitsliced data_block_check_crc_packed() with known frame type.
+
+  @param res Decoded bits of data block, the first one is frame type.
+  @return lanes where frame type bit or CRC does not match
+  */
+static inline __attribute__((always_inline))
+lanes_t check_crc_lanes(const lanes_t *res, frame_type_t type)
+{
+    // bitsliced mk_crc5() / mk_crc3()
+    lanes_t crc[5] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    lanes_t bad;
+    if (type == FRAME_TYPE_DATA || type == FRAME_TYPE_HR_DATA) {
+        const int crc_pos =
+            (type == FRAME_TYPE_DATA) ? 69 : HR_DATA_BLOCK_CRC_POS;
+        bad = ~res[0];
+        for (int i = 0; i < crc_pos; ++i) {
+            const lanes_t inv = res[i] ^ crc[0];
+            crc[0] = crc[1];
+            crc[1] = crc[2];
+            crc[2] = crc[3] ^ inv;
+            crc[3] = crc[4];
+            crc[4] = inv;
+        }
+        for (int i = 0; i < 5; ++i) {
+            bad |= crc[i] ^ res[crc_pos + i];
+        }
+        if (type == FRAME_TYPE_HR_DATA) {
+            for (int i = crc_pos + 5; i < HR_DATA_BLOCK_LEN; ++i) {
+                bad |= res[i];
+            }
+        }
+    } else {
+        bad = res[0];
+        for (int i = 0; i < 26; ++i) {
+            const lanes_t inv = res[i] ^ crc[0];
+            crc[0] = crc[1];
+            crc[1] = crc[2] ^ inv;
+            crc[2] = inv;
+        }
+        // residue accounting for inverted CRC bits is 0, 1, 0
+        bad |= crc[0] | ~crc[1] | crc[2];
+    }
+
+    return bad;
+}
+
+/**
+  Evaluate frame for all SCRs, equivalent of data_block_decode_frame()
+  followed by data_block_check_crc().
+
+  @return lanes for SCRs where frame is decoded without errors and CRC is OK
+  */
+static inline __attribute__((always_inline))
+scr_lanes_t detect_scr_eval(const int band, const frame_t *f_dec,
+        const scr_lanes_t scr_seq[127], const uint8_t *int_table,
+        frame_type_t type)
+{
+    scr_lanes_t in[FRAME_DATA_LEN];
+    scr_lanes_t res[76];
+
+    for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+        in[j] = frame_bit_lanes(band, f_dec, scr_seq, int_table[j]);
+    }
+
+    scr_lanes_t bad = decode_data_frame_lanes(res, NULL, in, 26);
+    if (type == FRAME_TYPE_DATA) {
+        bad |= decode_data_frame_lanes(res + 26, NULL, in + 2*26, 50);
+    }
+    bad |= check_crc_lanes(res, type);
+
+    return ~bad;
+}
+
+/**
+  Check frame for all SCRs at once.
+
+  Body is always inlined with constant 'band' into the band specialized
+  variants, see band_dec_t.
+
+  @param cand Lanes of SCR candidates, frame type is evaluated only
+    if required by some candidate.
+  @return lanes for candidates where frame is decoded without errors
+    and CRC is OK
+  */
+static inline __attribute__((always_inline))
+scr_lanes_t detect_scr_lanes_band(const int band, const frame_t *f,
+        scr_lanes_t cand)
+{
+    scr_lanes_t scr_seq[127];
+    mk_scr_seq(scr_seq);
+
+    frame_t f_dec;
+    memcpy(&f_dec, f, sizeof(f_dec));
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_diff_dec(&f_dec);
+    }
+
+    const scr_lanes_t is_data =
+        frame_bit_lanes(band, &f_dec, scr_seq, 38) ^
+        frame_bit_lanes(band, &f_dec, scr_seq, 114);
+    const scr_lanes_t data_cand = is_data & cand;
+    const scr_lanes_t voice_cand = ~is_data & cand;
+
+    scr_lanes_t ok = { 0, 0 };
+    // high rate data frames are not used, their layout is not verified
+    if (data_cand[0] | data_cand[1]) {
+        ok |= is_data & detect_scr_eval(band, &f_dec, scr_seq,
+                (band == TETRAPOL_BAND_UHF) ?
+                interleave_data_UHF : interleave_voice_data_VHF,
+                FRAME_TYPE_DATA);
+    }
+    if (voice_cand[0] | voice_cand[1]) {
+        ok |= ~is_data & detect_scr_eval(band, &f_dec, scr_seq,
+                (band == TETRAPOL_BAND_UHF) ?
+                interleave_voice_UHF : interleave_voice_data_VHF,
+                FRAME_TYPE_VOICE);
+    }
+
+    return ok & cand;
+}
+
+static scr_lanes_t detect_scr_lanes_uhf(const frame_t *f, scr_lanes_t cand)
 {
-    if (scr == 0) {
-        return;
-    }
+    return detect_scr_lanes_band(TETRAPOL_BAND_UHF, f, cand);
+}
 
-    for(int k = 0 ; k < FRAME_DATA_LEN; k++) {
-        f->data[k] ^= scramb_table[(k + scr) % 127];
-    }
+static scr_lanes_t detect_scr_lanes_vhf(const frame_t *f, scr_lanes_t cand)
+{
+    return detect_scr_lanes_band(TETRAPOL_BAND_VHF, f, cand);
 }
 
 /**
-  Try detect (and set) SCR - scrambling constant.
-
-  @return SCR wich have now best score
+  Update SCR statistics for exhaustive search, score is increased for
+  valid frame and decreased otherwise.
   */
-static void detect_scr(phys_ch_t *phys_ch, const frame_t *f)
+static void detect_scr_update_exhaustive(phys_ch_t *phys_ch, scr_lanes_t ok)
 {
-    // compute SCR statistics
     for(int scr = 0; scr < ARRAY_LEN(phys_ch->scr_stat); ++scr) {
-        frame_t f_;
-        frame_type_t type;
-        memcpy(&f_, f, sizeof(f_));
-
-        frame_descramble(&f_, scr);
-        if (phys_ch->band == TETRAPOL_BAND_UHF) {
-            frame_diff_dec(&f_);
-        }
-        // TODO: check for High-Rate frames?
-        type = (f_.data[38] ^ f_.data[114]) ? FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
-        if (phys_ch->band == TETRAPOL_BAND_UHF) {
-            frame_deinterleave(&f_, type == FRAME_TYPE_DATA ? interleave_data_UHF : interleave_voice_UHF);
+        if ((ok[scr / 64] >> (scr % 64)) & 1) {
+            ++phys_ch->scr_stat[scr];
         } else {
-            frame_deinterleave(&f_, interleave_voice_data_VHF);
-        }
-
-        data_block_t data_blk;
-        data_block_decode_frame(&data_blk, f_.data, f_.frame_no, type);
-        if (data_blk.nerrs) {
             phys_ch->scr_stat[scr] -= 2;
             if (phys_ch->scr_stat[scr] < 0) {
                 phys_ch->scr_stat[scr] = 0;
             }
-            continue;
         }
+    }
+}
 
-        if(!data_block_check_crc(&data_blk)) {
-            phys_ch->scr_stat[scr] -= 2;
-            if (phys_ch->scr_stat[scr] < 0) {
-                phys_ch->scr_stat[scr] = 0;
-            }
-            continue;
+/**
+  Update SCR statistics for sequential search, scr_stat counts valid frames.
+
+  Frames failing for all candidates (noise, bit errors) carry no
+  information and are ignored. Candidates without any valid frame are
+  pruned after SCR_PRUNE_FRAMES frames valid for other candidates
+  and are not evaluated anymore.
+  */
+static void detect_scr_update_sequential(phys_ch_t *phys_ch, scr_lanes_t ok)
+{
+    if (!(ok[0] | ok[1])) {
+        return;
+    }
+
+    for(int scr = 0; scr < ARRAY_LEN(phys_ch->scr_stat); ++scr) {
+        const uint64_t lane = 1ULL << (scr % 64);
+        if (ok[scr / 64] & lane) {
+            ++phys_ch->scr_stat[scr];
+        } else if ((phys_ch->scr_cand[scr / 64] & lane) &&
+                !phys_ch->scr_stat[scr] &&
+                ++phys_ch->scr_fails[scr] >= SCR_PRUNE_FRAMES) {
+            phys_ch->scr_cand[scr / 64] &= ~lane;
         }
+    }
+}
+
+/**
+  Try detect (and set) SCR - scrambling constant.
+
+  Exhaustive search evaluates all SCRs for each frame and SCR is detected
+  when its score exceeds all others by scr_confidence. Sequential search
+  evaluates only not pruned candidates and SCR is detected when
+  likelihood ratio of the two best candidates reaches SCR_LOCK_LLR,
+  for clean signal it takes a few frames.
+  */
+static void detect_scr(phys_ch_t *phys_ch, const frame_t *f)
+{
+    const bool sequential =
+        phys_ch->scr_search == PHYS_CH_SCR_SEARCH_SEQUENTIAL;
+    const scr_lanes_t cand = sequential ?
+        (scr_lanes_t){ phys_ch->scr_cand[0], phys_ch->scr_cand[1] } :
+        (scr_lanes_t){ ~0ULL, ~0ULL };
 
-        ++phys_ch->scr_stat[scr];
+    // compute SCR statistics
+    const scr_lanes_t ok = phys_ch->band_dec->detect_scr_lanes(f, cand);
+    if (sequential) {
+        detect_scr_update_sequential(phys_ch, ok);
+    } else {
+        detect_scr_update_exhaustive(phys_ch, ok);
     }
 
     // get difference in statistic for two best SCRs
@@ -597,157 +1546,759 @@ static void detect_scr(phys_ch_t *phys_ch, const frame_t *f)
             scr_max = scr;
         }
     }
-    if (phys_ch->scr_stat[scr_max] - phys_ch->scr_confidence > phys_ch->scr_stat[scr_max2]) {
+    const int diff = phys_ch->scr_stat[scr_max] - phys_ch->scr_stat[scr_max2];
+    TRACE(scr_scored, f->frame_no, scr_max, phys_ch->scr_stat[scr_max], diff,
+            __builtin_popcountll(ok[0]) + __builtin_popcountll(ok[1]));
+    const bool lock = sequential ?
+        diff * SCR_FALSE_PASS_LOG2 >= SCR_LOCK_LLR :
+        diff > phys_ch->scr_confidence;
+    if (lock) {
         phys_ch->scr = scr_max;
+        frame_dec_init(&phys_ch->frame_dec, phys_ch->band, scr_max);
         LOG(INFO, "SCR detected %d", scr_max);
+        phys_ch->stats.scr = scr_max;
+        phys_ch->stats.scr_lock_time = timer_now(phys_ch->timer);
     }
 
     phys_ch->scr_guess = scr_max;
 }
 
+/**
+  Verify preloaded SCR by the first frame valid for any SCR,
+  SCR detection is started on mismatch.
+  */
+static void verify_scr(phys_ch_t *phys_ch, const frame_t *f)
+{
+    const scr_lanes_t all = { ~0ULL, ~0ULL, };
+    const scr_lanes_t ok = phys_ch->band_dec->detect_scr_lanes(f, all);
+    if (!(ok[0] | ok[1])) {
+        return;
+    }
+
+    const int scr = phys_ch->scr_preload;
+    if ((ok[scr / 64] >> (scr % 64)) & 1) {
+        LOG(INFO, "SCR %d verified", scr);
+        phys_ch->scr_preload = PHYS_CH_SCR_DETECT;
+        phys_ch->stats.scr_lock_time = timer_now(phys_ch->timer);
+        return;
+    }
+
+    LOG(INFO, "SCR %d mismatch, detecting SCR", scr);
+    tetrapol_phys_ch_set_scr(phys_ch, PHYS_CH_SCR_DETECT);
+    detect_scr(phys_ch, f);
+}
+
+/**
+  Pack FRAME_DATA_LEN bits (bytes of value 0 or 1), bit j % 64 of
+  rows[j / 64] is bit j.
+  */
+static void frame_pack_rows(const uint8_t *bits, uint64_t rows[3])
+{
+    rows[0] = rows[1] = rows[2] = 0;
+    // 8 bits at once, the multiplication gathers bit 8 * i of 'x' into
+    // bit 56 + i
+    for (int q = 0; q < FRAME_DATA_LEN / 8; ++q) {
+        uint64_t x;
+        memcpy(&x, &bits[8 * q], sizeof(x));
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+        x = __builtin_bswap64(x);
+#endif
+        rows[q / 8] |= ((x * 0x0102040810204080ULL) >> 56) << (8 * (q % 8));
+    }
+}
+
+/**
+  Get source bit indexes for k-th bit after differential decoding.
+  */
+static void frame_dec_src(int band, int k, uint8_t *src1, uint8_t *src2)
+{
+    *src1 = k;
+    if (band == TETRAPOL_BAND_UHF && k > 0) {
+        *src2 = k - diff_precod_UHF[k];
+    } else {
+        *src2 = FRAME_DATA_LEN;
+    }
+}
+
+static void frame_dec_tab_init(frame_dec_tab_t *tab, int band, int scr,
+        const uint8_t *int_table)
+{
+    for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+        frame_dec_src(band, int_table[j], &tab->src1[j], &tab->src2[j]);
+    }
+
+    // all steps are linear, so decoding of zero frame gives bits
+    // which must be XORed with the result
+    frame_t f;
+    memset(&f, 0, sizeof(f));
+    frame_descramble(&f, scr);
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_diff_dec(&f);
+    }
+    frame_deinterleave(&f, int_table);
+    memcpy(tab->scr_xor, f.data, FRAME_DATA_LEN);
+}
+
+/**
+  Generate tables for fused frame decoding, it should be called only
+  when SCR is changed.
+  */
+static void frame_dec_init(frame_dec_t *frame_dec, int band, int scr)
+{
+    frame_dec->band = band;
+    frame_dec->scr = scr;
+
+    frame_dec_src(band, 38, &frame_dec->type_src[0], &frame_dec->type_src[1]);
+    frame_dec_src(band, 114, &frame_dec->type_src[2], &frame_dec->type_src[3]);
+
+    frame_t f;
+    memset(&f, 0, sizeof(f));
+    frame_descramble(&f, scr);
+    frame_pack_rows(f.data, frame_dec->scr_rows);
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_diff_dec(&f);
+    }
+    frame_dec->type_xor = f.data[38] ^ f.data[114];
+
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_dec_tab_init(&frame_dec->data, band, scr, interleave_data_UHF);
+        frame_dec_tab_init(&frame_dec->voice, band, scr, interleave_voice_UHF);
+    } else {
+        frame_dec_tab_init(&frame_dec->data, band, scr, interleave_voice_data_VHF);
+        memcpy(&frame_dec->voice, &frame_dec->data, sizeof(frame_dec->voice));
+    }
+}
+
+/**
+  Descramble, differential decode and deinterleave frame in single pass.
+
+  VHF frames are not differentially precoded, the second source is always
+  the zero padding bit and the specialized variant skips it.
+
+  @param data Output, FRAME_DATA_LEN bits
+  @return frame type
+  */
+static inline __attribute__((always_inline))
+frame_type_t frame_decode_band(const int band, const frame_dec_t *frame_dec,
+        const frame_t *f, uint8_t *data)
+{
+    const uint8_t *in = f->data;
+    const uint8_t *ts = frame_dec->type_src;
+
+    // high rate data frame has the type bit of data frame and the same
+    // interleaving, it is recognized later by CRC
+    const frame_type_t type =
+        (in[ts[0]] ^ in[ts[1]] ^ in[ts[2]] ^ in[ts[3]] ^ frame_dec->type_xor) ?
+        FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
+    const frame_dec_tab_t *tab =
+        (type == FRAME_TYPE_DATA) ? &frame_dec->data : &frame_dec->voice;
+
+    if (band == TETRAPOL_BAND_UHF) {
+        for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+            data[j] = in[tab->src1[j]] ^ in[tab->src2[j]] ^ tab->scr_xor[j];
+        }
+    } else {
+        for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+            data[j] = in[tab->src1[j]] ^ tab->scr_xor[j];
+        }
+    }
+
+    return type;
+}
+
+static frame_type_t frame_decode_uhf(const frame_dec_t *frame_dec,
+        const frame_t *f, uint8_t *data)
+{
+    return frame_decode_band(TETRAPOL_BAND_UHF, frame_dec, f, data);
+}
+
+static frame_type_t frame_decode_vhf(const frame_dec_t *frame_dec,
+        const frame_t *f, uint8_t *data)
+{
+    return frame_decode_band(TETRAPOL_BAND_VHF, frame_dec, f, data);
+}
+
+static const band_dec_t band_dec_uhf = {
+    .detect_scr_lanes = detect_scr_lanes_uhf,
+    .frame_decode = frame_decode_uhf,
+};
+
+static const band_dec_t band_dec_vhf = {
+    .detect_scr_lanes = detect_scr_lanes_vhf,
+    .frame_decode = frame_decode_vhf,
+};
+
+static const band_dec_t *band_dec_select(int band)
+{
+    return (band == TETRAPOL_BAND_UHF) ? &band_dec_uhf : &band_dec_vhf;
+}
+
 static int process_frame(phys_ch_t *phys_ch, frame_t *f)
 {
     if (phys_ch->scr == PHYS_CH_SCR_DETECT) {
         detect_scr(phys_ch, f);
+    } else if (phys_ch->scr_preload != PHYS_CH_SCR_DETECT) {
+        verify_scr(phys_ch, f);
     }
 
+    data_block_t data_blk;
+    frame_info_t fi;
+    decode_data_block(phys_ch, f, &data_blk, &fi);
+
+    return process_data_block(phys_ch, f, &data_blk, &fi);
+}
+
+/// Pass decoded data block into logical channels or block sink.
+static int process_data_block(phys_ch_t *phys_ch, frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi)
+{
     if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
-        return process_control_radio_ch(phys_ch, f);
+        return process_control_radio_ch(phys_ch, f, data_blk, fi);
     }
 
-    return process_traffic_radio_ch(phys_ch, f);
+    return process_traffic_radio_ch(phys_ch, data_blk, fi);
 }
 
-static int process_control_radio_ch(phys_ch_t *phys_ch, frame_t *f)
+/**
+  Update frame statistics, call frame sink.
+
+  @param crc_ok Block without errors and valid CRC.
+  */
+static void account_data_block(phys_ch_t *phys_ch,
+        const data_block_t *data_blk, bool crc_ok, frame_info_t *fi)
+{
+    phys_ch_stats_t *stats = &phys_ch->stats;
+    if (data_blk->fr_type == FRAME_TYPE_VOICE) {
+        ++stats->voice_frames;
+    } else {
+        ++stats->data_frames;
+    }
+    const int nerrs = data_blk->nerrs;
+    ++stats->nerrs_hist[(nerrs < STATS_NERRS_BINS) ? nerrs : STATS_NERRS_BINS - 1];
+    if (crc_ok) {
+        ++stats->crc_ok;
+    }
+    quality_add(phys_ch, phys_ch->sync_errs, nerrs, !crc_ok);
+
+    *fi = (frame_info_t){
+        .timestamp = data_blk->timestamp,
+        .frame_no = data_blk->frame_no,
+        .fr_type = data_blk->fr_type,
+        .nerrs = nerrs,
+        .crc_ok = crc_ok,
+    };
+    if (phys_ch->frame_sink) {
+        phys_ch->frame_sink(fi, phys_ch->frame_sink_ptr);
+    }
+}
+
+/**
+  Decode frame into data block, best SCR guess is used while SCR is being
+  detected.
+  */
+static frame_type_t decode_data_block(phys_ch_t *phys_ch, const frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi)
 {
     const int scr = (phys_ch->scr == PHYS_CH_SCR_DETECT) ?
         phys_ch->scr_guess : phys_ch->scr;
-    frame_type_t type;
+    if (scr != phys_ch->frame_dec.scr) {
+        frame_dec_init(&phys_ch->frame_dec, phys_ch->band, scr);
+    }
 
-    frame_descramble(f, scr);
-    if (phys_ch->band == TETRAPOL_BAND_UHF) {
-        frame_diff_dec(f);
+    uint8_t data[FRAME_DATA_LEN];
+    const frame_type_t type =
+        phys_ch->band_dec->frame_decode(&phys_ch->frame_dec, f, data);
+    data_block_decode_frame(data_blk, data, f->frame_no, type);
+    const bool crc_ok = !data_blk->nerrs && data_block_check_crc(data_blk);
+    // high rate data frame is only counted, it is passed on as data frame
+    // with invalid CRC
+    if (type == FRAME_TYPE_DATA && !crc_ok &&
+            data_block_check_hr_data(data_blk, data)) {
+        ++phys_ch->stats.hr_data_frames;
     }
-    // TODO: check for High-Rate frames?
-    type = (f->data[38] ^ f->data[114]) ? FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
-    if (phys_ch->band == TETRAPOL_BAND_UHF) {
-        frame_deinterleave(f, type == FRAME_TYPE_DATA ? interleave_data_UHF : interleave_voice_UHF);
-    } else {
-        frame_deinterleave(f, interleave_voice_data_VHF);
+    data_blk->timestamp = f->timestamp;
+    account_data_block(phys_ch, data_blk, crc_ok, fi);
+
+    return type;
+}
+
+int tetrapol_phys_ch_push_data_block(phys_ch_t *phys_ch,
+        const frame_info_t *fi, const data_block_t *data_blk)
+{
+    const int64_t dt = fi->timestamp - timer_now(phys_ch->timer);
+    if (dt > 0) {
+        timer_tick(phys_ch->timer, (dt < INT_MAX) ? dt : INT_MAX);
     }
 
-    data_block_t data_blk;
-    data_block_decode_frame(&data_blk, f->data, f->frame_no, type);
+    ++phys_ch->stats.frames;
+    data_block_t blk = *data_blk;
+    blk.timestamp = fi->timestamp;
+    frame_info_t fi_out;
+    account_data_block(phys_ch, &blk,
+            !blk.nerrs && data_block_check_crc(&blk), &fi_out);
+    if (phys_ch->radio_ch_type == RADIO_CH_TYPE_CONTROL) {
+        return control_data_block(phys_ch, &blk);
+    }
+
+    return traffic_data_block(phys_ch, &blk, &fi_out);
+}
+
+static void dup_notify(phys_ch_t *phys_ch, int log_ch, int repeats)
+{
+    if (phys_ch->dup_sink) {
+        phys_ch->dup_sink(log_ch, repeats, phys_ch->dup_sink_ptr);
+    }
+}
+
+static int process_control_radio_ch(phys_ch_t *phys_ch, frame_t *f,
+        data_block_t *data_blk, frame_info_t *fi)
+{
     IF_LOG(DBG) {
-        if (!data_blk.nerrs) {
+        if (!data_blk->nerrs) {
             int asbx, asby;
             int fn0, fn1;
-            switch (type) {
+            switch (data_blk->fr_type) {
                 case FRAME_TYPE_DATA:
-                    asbx = data_blk.data[67];
-                    asby = data_blk.data[68];
-                    fn0 = data_blk.data[1];
-                    fn1 = data_blk.data[2];
+                    asbx = data_block_get_bit(data_blk, 67);
+                    asby = data_block_get_bit(data_blk, 68);
+                    fn0 = data_block_get_bit(data_blk, 1);
+                    fn1 = data_block_get_bit(data_blk, 2);
                     LOG_("OK data frame_no=%03i fn=%i%i asb=%i%i data=",
-                        data_blk.frame_no, fn1, fn0, asbx, asby);
+                        data_blk->frame_no, fn1, fn0, asbx, asby);
                     break;
                 case FRAME_TYPE_VOICE:
-                    asbx = data_blk.data[23];
-                    asby = data_blk.data[24];
+                    asbx = data_block_get_bit(data_blk, 23);
+                    asby = data_block_get_bit(data_blk, 24);
                     LOG_("OK voice frame_no=%03i asb=%i%i data=",
-                        data_blk.frame_no, asbx, asby);
+                        data_blk->frame_no, asbx, asby);
                     break;
                 default:
                     asbx = asby = -1;
                     fn0 = fn1 = -1;
             }
         } else {
-            LOG_("ERR frame_no=%03i ", data_blk.frame_no);
+            LOG_("ERR frame_no=%03i ", data_blk->frame_no);
         }
-        print_hex(data_blk.data + 3, 64);
+        uint8_t bits[64];
+        for (int i = 0; i < ARRAY_LEN(bits); ++i) {
+            bits[i] = data_block_get_bit(data_blk, 3 + i);
+        }
+        print_hex(bits, ARRAY_LEN(bits));
+    }
+
+    if (phys_ch->block_sink) {
+        // BCH is still required for frame numbering
+        if (bch_push_data_block(phys_ch->bch, data_blk)) {
+            f->frame_no = fi->frame_no = data_blk->frame_no;
+        }
+        phys_ch->block_sink(fi, data_blk, phys_ch->block_sink_ptr);
+        return 0;
     }
 
+    const int ret = control_data_block(phys_ch, data_blk);
+    f->frame_no = data_blk->frame_no;
+
+    return ret;
+}
+
+/// Pass data block into logical channels of control channel.
+static int control_data_block(phys_ch_t *phys_ch, data_block_t *data_blk)
+{
     // For decoding BCH are used always all frames, not only 0-3, 100-103
     // Firs of all for detection BCH (frame 0/100 in superblock).
     // The second reason is just to check frame synchronization.
-    if (bch_push_data_block(phys_ch->bch, &data_blk)) {
+    if (bch_push_data_block(phys_ch->bch, data_blk)) {
+        const int repeats = bch_get_repeats(phys_ch->bch);
+        if (repeats) {
+            dup_notify(phys_ch, PHYS_CH_LOG_CH_BCH, repeats);
+            return 0;
+        }
         tsdu_d_system_info_t *tsdu = bch_get_tsdu(phys_ch->bch);
         if (tsdu) {
+            if (phys_ch->cch_mux_type != tsdu->cell_config.mux_type) {
+                LOG(INFO, "channel multiplexing type %d", tsdu->cell_config.mux_type);
+            }
             phys_ch->cch_mux_type = tsdu->cell_config.mux_type;
             if (phys_ch->cch_mux_type != CELL_CONFIG_MUX_TYPE_DEFAULT &&
                     phys_ch->cch_mux_type != CELL_CONFIG_MUX_TYPE_TYPE_2) {
                 LOG(ERR, "Unknown channel multiplexing type");
                 return -1;
             }
-            IF_LOG(INFO) {
-                LOG_("\n");
-                tsdu_print(&tsdu->base);
+            tsdu->base.timestamp = data_blk->timestamp;
+            stats_add_latency(phys_ch, data_blk->timestamp);
+            TRACE(tsdu_delivered, data_blk->frame_no, tsdu->base.codop,
+                    data_blk->timestamp);
+            if (phys_ch->tsdu_sink) {
+                phys_ch->tsdu_sink(&tsdu->base, phys_ch->tsdu_sink_ptr);
+            }
+            if (phys_ch->sysinfo_sink) {
+                phys_ch->sysinfo_sink(tsdu, phys_ch->sysinfo_sink_ptr);
             }
-            tsdu_destroy(&tsdu->base);
-            f->frame_no = data_blk.frame_no;
             return 0;
         }
     }
 
-    if (f->frame_no == FRAME_NO_UNKNOWN) {
+    if (data_blk->frame_no == FRAME_NO_UNKNOWN || phys_ch->bch_only) {
         return 0;
     }
 
-    const int fn_mod = f->frame_no % 100;
+    const int fn_mod = data_blk->frame_no % 100;
     // BCH is processed above
     if (fn_mod >= 0 && fn_mod <= 3) {
         return 0;
     }
 
-    if (fn_mod == 98 || fn_mod == 99) {
-        if (pch_push_data_block(phys_ch->pch, &data_blk)) {
-            IF_LOG(INFO) {
-                LOG_("\n");
-                pch_print(phys_ch->pch);
+    if (fn_mod == 98 || fn_mod == 99 ||
+            (phys_ch->cch_mux_type == CELL_CONFIG_MUX_TYPE_TYPE_2 &&
+             (fn_mod == 48 || fn_mod == 49))) {
+        if (pch_push_data_block(phys_ch->pch, data_blk)) {
+            const int repeats = pch_get_repeats(phys_ch->pch);
+            if (repeats) {
+                dup_notify(phys_ch, PHYS_CH_LOG_CH_PCH, repeats);
+            } else if (phys_ch->pch_sink) {
+                stats_add_latency(phys_ch, data_blk->timestamp);
+                phys_ch->pch_sink(pch_get_data(phys_ch->pch),
+                        phys_ch->pch_sink_ptr);
             }
         }
         return 0;
     }
-    if (phys_ch->cch_mux_type == CELL_CONFIG_MUX_TYPE_TYPE_2) {
-        if (fn_mod == 48 || fn_mod == 49) {
-            if (pch_push_data_block(phys_ch->pch, &data_blk)) {
-                IF_LOG(INFO) {
-                    LOG_("\n");
-                    pch_print(phys_ch->pch);
-                }
-            }
-            return 0;
-        }
-    }
 
-    if (f->frame_no % 25 == 14) {
-        if (rch_push_data_block(phys_ch->rch, &data_blk)) {
-            IF_LOG(INFO) {
-                LOG_("\n");
-                rch_print(phys_ch->rch);
+    if (data_blk->frame_no % 25 == 14) {
+        if (rch_push_data_block(phys_ch->rch, data_blk)) {
+            const int repeats = rch_get_repeats(phys_ch->rch);
+            if (repeats) {
+                dup_notify(phys_ch, PHYS_CH_LOG_CH_RCH, repeats);
+            } else if (phys_ch->rch_sink) {
+                stats_add_latency(phys_ch, data_blk->timestamp);
+                phys_ch->rch_sink(rch_get_data(phys_ch->rch),
+                        phys_ch->rch_sink_ptr);
             }
         }
         return 0;
     }
 
-    if (sdch_dl_push_data_frame(phys_ch->sdch, &data_blk)) {
+    if (sdch_dl_push_data_frame(phys_ch->sdch, data_blk)) {
         tsdu_t *tsdu = sdch_get_tsdu(phys_ch->sdch);
-        if (tsdu) {
-            IF_LOG(INFO) {
-                LOG_("\n");
-                tsdu_print(tsdu);
-            }
+        if (tsdu && phys_ch->tsdu_sink) {
+            tsdu->timestamp = data_blk->timestamp;
+            stats_add_latency(phys_ch, data_blk->timestamp);
+            TRACE(tsdu_delivered, data_blk->frame_no, tsdu->codop,
+                    data_blk->timestamp);
+            phys_ch->tsdu_sink(tsdu, phys_ch->tsdu_sink_ptr);
         }
-        tsdu_destroy(tsdu);
         return 0;
     }
 
     return 0;
 }
 
-static int process_traffic_radio_ch(phys_ch_t *phys_ch, frame_t *f)
+static int process_traffic_radio_ch(phys_ch_t *phys_ch,
+        data_block_t *data_blk, frame_info_t *fi)
+{
+    if (phys_ch->block_sink) {
+        phys_ch->block_sink(fi, data_blk, phys_ch->block_sink_ptr);
+        return 0;
+    }
+
+    return traffic_data_block(phys_ch, data_blk, fi);
+}
+
+/// Pass data block of traffic channel into voice sink.
+static int traffic_data_block(phys_ch_t *phys_ch,
+        const data_block_t *data_blk, const frame_info_t *fi)
+{
+    if (data_blk->fr_type != FRAME_TYPE_VOICE) {
+        // signalling of traffic channel is not decoded, block sink gets it
+        ++phys_ch->stats.tch_data_frames;
+        return 0;
+    }
+
+    if (!phys_ch->voice_sink) {
+        return 0;
+    }
+
+    voice_frame_t vf = {
+        .timestamp = fi->timestamp,
+        .frame_no = data_blk->frame_no,
+        .crc_ok = fi->crc_ok,
+        .data = { data_blk->data[0], data_blk->data[1], },
+    };
+    stats_add_latency(phys_ch, vf.timestamp);
+    phys_ch->voice_sink(&vf, phys_ch->voice_sink_ptr);
+
+    return 0;
+}
+
+/**
+  Frames of several channels decoded at once, lane N belongs to chs[N].
+
+  Frames are descrambled by XOR with packed scrambling sequence of the
+  channel and packed into rows. Rows are transposed into lanes, then
+  differential decoding (masked by band), deinterleaving (selected by band
+  and frame type), FEC decoding and CRC check are done for all lanes at
+  once.
+  */
+typedef struct {
+    int nlanes;
+    phys_ch_t *chs[LANES];
+    int begin[LANES];       ///< data_begin before get_frame()
+    frame_t frames[LANES];
+    /// descrambled frames, bit j % 64 of rows[j / 64][lane] is bit j
+    uint64_t rows[3][LANES];
+    lanes_t uhf;            ///< lanes of UHF channels, VHF otherwise
+    lanes_t is_data;        ///< lanes with data frame, voice otherwise
+    lanes_t hr;             ///< data frames recognized as high rate data
+    lanes_t crc_ok;         ///< decoded without errors and CRC is valid
+    data_block_t data_blks[LANES];
+} batch_t;
+
+static void batch_reset(batch_t *bt)
+{
+    bt->nlanes = 0;
+    bt->uhf = (lanes_t){ 0, 0 };
+}
+
+/// Pack and descramble the last added frame, SCR must be known.
+static void batch_add_frame(batch_t *bt)
+{
+    const int lane = bt->nlanes++;
+    phys_ch_t *phys_ch = bt->chs[lane];
+    if (phys_ch->scr != phys_ch->frame_dec.scr) {
+        frame_dec_init(&phys_ch->frame_dec, phys_ch->band, phys_ch->scr);
+    }
+
+    if (phys_ch->band == TETRAPOL_BAND_UHF) {
+        bt->uhf[lane / 64] |= 1ULL << (lane % 64);
+    }
+    uint64_t rows[3];
+    frame_pack_rows(bt->frames[lane].data, rows);
+    for (int k = 0; k < 3; ++k) {
+        bt->rows[k][lane] = rows[k] ^ phys_ch->frame_dec.scr_rows[k];
+    }
+}
+
+/**
+  Transpose 64x64 bit matrices, both words of lanes at once, bit c of
+  word w of m[r] is element (r, c) of matrix w.
+  */
+static void transpose64(lanes_t m[64])
+{
+    uint64_t mask_ = 0x00000000ffffffffULL;
+    for (int j = 32; j; j >>= 1, mask_ ^= mask_ << j) {
+        const lanes_t mask = { mask_, mask_ };
+        for (int k = 0; k < 64; k = (k + j + 1) & ~j) {
+            const lanes_t t = ((m[k] >> j) ^ m[k + j]) & mask;
+            m[k] ^= t << j;
+            m[k + j] ^= t;
+        }
+    }
+}
+
+/**
+  Equivalent of data_block_decode_frame() and data_block_check_crc() for
+  all lanes, results are stored in data_blks and crc_ok.
+  */
+static void batch_decode(batch_t *bt)
+{
+    lanes_t raw[FRAME_DATA_LEN];
+    for (int k = 0; k < 3; ++k) {
+        lanes_t m[64];
+        for (int r = 0; r < 64; ++r) {
+            for (int w = 0; w < LANES / 64; ++w) {
+                m[r][w] = (64 * w + r < bt->nlanes) ?
+                    bt->rows[k][64 * w + r] : 0;
+            }
+        }
+        transpose64(m);
+        for (int j = 64 * k; j < FRAME_DATA_LEN && j < 64 * (k + 1); ++j) {
+            raw[j] = m[j % 64];
+        }
+    }
+
+    // see frame_diff_dec(), VHF frames are not differentially precoded
+    const lanes_t uhf = bt->uhf;
+    lanes_t dec[FRAME_DATA_LEN];
+    dec[0] = raw[0];
+    for (int j = 1; j < FRAME_DATA_LEN; ++j) {
+        dec[j] = raw[j] ^ (raw[j - diff_precod_UHF[j]] & uhf);
+    }
+    bt->is_data = dec[38] ^ dec[114];
+
+    // VHF data and voice frames share interleaving
+    const lanes_t data_uhf = uhf & bt->is_data;
+    const lanes_t voice_uhf = uhf & ~bt->is_data;
+    lanes_t in[FRAME_DATA_LEN];
+    for (int j = 0; j < FRAME_DATA_LEN; ++j) {
+        in[j] = (dec[interleave_data_UHF[j]] & data_uhf) |
+            (dec[interleave_voice_UHF[j]] & voice_uhf) |
+            (dec[interleave_voice_data_VHF[j]] & ~uhf);
+    }
+
+    lanes_t res[76], err[76];
+    decode_data_frame_lanes(res, err, in, 26);
+    decode_data_frame_lanes(res + 26, err + 26, in + 2*26, 50);
+
+    const lanes_t is_data = bt->is_data;
+    const lanes_t zero = { 0, 0 };
+
+    // high rate data frame has the type bit of data frame, it is a frame
+    // which is not valid data frame but valid high rate data frame, see
+    // data_block_check_hr_data()
+    lanes_t err26 = zero;
+    for (int p = 0; p < 26; ++p) {
+        err26 |= err[p];
+    }
+    lanes_t data_bad = err26 | check_crc_lanes(res, FRAME_TYPE_DATA);
+    for (int p = 26; p < 76; ++p) {
+        data_bad |= err[p];
+    }
+    data_bad &= is_data;
+    bt->hr = zero;
+    if (data_bad[0] | data_bad[1]) {
+        lanes_t hr_bits[HR_DATA_BLOCK_LEN];
+        memcpy(&hr_bits[0], &res[0], 26 * sizeof(hr_bits[0]));
+        memcpy(&hr_bits[26], &in[2*26], 100 * sizeof(hr_bits[0]));
+        bt->hr = data_bad & ~err26 &
+            ~check_crc_lanes(hr_bits, FRAME_TYPE_HR_DATA);
+    }
+
+    // layout of data_block_t, voice block has 26 protected bits followed
+    // by 100 unprotected bits
+    lanes_t bits[128], errs[128];
+    for (int p = 0; p < 26; ++p) {
+        bits[p] = res[p];
+        errs[p] = err[p];
+    }
+    for (int p = 26; p < 76; ++p) {
+        bits[p] = (res[p] & is_data) | (in[26 + p] & ~is_data);
+        errs[p] = err[p] & is_data;
+    }
+    for (int p = 76; p < 126; ++p) {
+        bits[p] = in[26 + p] & ~is_data;
+        errs[p] = zero;
+    }
+    bits[126] = bits[127] = errs[126] = errs[127] = zero;
+
+    bt->crc_ok = ~((check_crc_lanes(bits, FRAME_TYPE_DATA) & is_data) |
+            (check_crc_lanes(bits, FRAME_TYPE_VOICE) & ~is_data));
+
+    // rows are stored in reverse order, row of transposed matrix is then
+    // data of single block with the first bit in MSB
+    for (int i = 0; i < 2; ++i) {
+        lanes_t m[64], e[64];
+        for (int r = 0; r < 64; ++r) {
+            m[63 - r] = bits[64 * i + r];
+            e[63 - r] = errs[64 * i + r];
+        }
+        transpose64(m);
+        transpose64(e);
+        for (int lane = 0; lane < bt->nlanes; ++lane) {
+            data_block_t *data_blk = &bt->data_blks[lane];
+            data_blk->data[i] = m[lane % 64][lane / 64];
+            data_blk->err[i] = e[lane % 64][lane / 64];
+        }
+    }
+
+    for (int lane = 0; lane < bt->nlanes; ++lane) {
+        data_block_t *data_blk = &bt->data_blks[lane];
+        const frame_t *f = &bt->frames[lane];
+        data_blk->fr_type = ((is_data[lane / 64] >> (lane % 64)) & 1) ?
+            FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
+        data_blk->frame_no = f->frame_no;
+        data_blk->nerrs = __builtin_popcountll(data_blk->err[0]) +
+            __builtin_popcountll(data_blk->err[1]);
+        data_blk->timestamp = f->timestamp;
+        TRACE(block_decoded, data_blk->frame_no, data_blk->fr_type,
+                data_blk->nerrs);
+    }
+}
+
+/// Pass decoded data blocks into channels, decoding time is split evenly.
+static void batch_dispatch(batch_t *bt, int64_t decode_ns)
+{
+    for (int lane = 0; lane < bt->nlanes; ++lane) {
+        phys_ch_t *phys_ch = bt->chs[lane];
+        data_block_t *data_blk = &bt->data_blks[lane];
+        const int64_t start = time_ns();
+        const bool crc_ok = !data_blk->nerrs &&
+            ((bt->crc_ok[lane / 64] >> (lane % 64)) & 1);
+        if ((bt->hr[lane / 64] >> (lane % 64)) & 1) {
+            ++phys_ch->stats.hr_data_frames;
+        }
+        frame_info_t fi;
+        account_data_block(phys_ch, data_blk, crc_ok, &fi);
+        process_data_block(phys_ch, &bt->frames[lane], data_blk, &fi);
+        stats_add_time(&phys_ch->stats,
+                time_ns() - start + decode_ns / bt->nlanes);
+        frame_done(phys_ch, &bt->frames[lane], bt->begin[lane]);
+    }
+}
+
+/// tetrapol_phys_ch_process_batch() for up to LANES channels
+static void process_batch(batch_t *bt, phys_ch_t **chs, int n)
+{
+    bool active[LANES];
+    int nactive = 0;
+    for (int i = 0; i < n; ++i) {
+        active[i] = sync_search(chs[i]);
+        nactive += active[i];
+    }
+
+    // single frame of each channel in each round
+    while (nactive) {
+        batch_reset(bt);
+        for (int i = 0; i < n; ++i) {
+            if (!active[i]) {
+                continue;
+            }
+            phys_ch_t *phys_ch = chs[i];
+            frame_t *frame = &bt->frames[bt->nlanes];
+            const int begin = phys_ch->data_begin;
+            const int r = get_frame(phys_ch, frame);
+            if (r <= 0) {
+                if (r < 0) {
+                    sync_lost(phys_ch);
+                }
+                active[i] = false;
+                --nactive;
+                continue;
+            }
+            if (r == GET_FRAME_FADE) {
+                frame_done(phys_ch, frame, begin);
+                continue;
+            }
+
+            ++phys_ch->stats.frames;
+            if (phys_ch->scr == PHYS_CH_SCR_DETECT ||
+                    phys_ch->scr_preload != PHYS_CH_SCR_DETECT) {
+                // SCR search uses own bitsliced evaluation of the frame
+                const int64_t start = time_ns();
+                process_frame(phys_ch, frame);
+                stats_add_time(&phys_ch->stats, time_ns() - start);
+                frame_done(phys_ch, frame, begin);
+                continue;
+            }
+
+            bt->chs[bt->nlanes] = phys_ch;
+            bt->begin[bt->nlanes] = begin;
+            batch_add_frame(bt);
+        }
+
+        if (bt->nlanes) {
+            const int64_t start = time_ns();
+            batch_decode(bt);
+            batch_dispatch(bt, time_ns() - start);
+        }
+    }
+}
+
+int tetrapol_phys_ch_process_batch(phys_ch_t **chs, int n)
 {
-    // TODO
-    LOG(ERR, "process_traffic_radio_ch() not implemented");
-    return -1;
+    batch_t bt;
+    for (int i = 0; i < n; i += LANES) {
+        process_batch(&bt, chs + i, (n - i < LANES) ? n - i : LANES);
+    }
+
+    return 0;
 }
@@ -4,45 +4,62 @@
 #include <tetrapol/addr.h>
 #include <tetrapol/bit_utils.h>
 #include <tetrapol/data_frame.h>
+#include <tetrapol/dup_cache.h>
 #include <tetrapol/misc.h>
 #include <tetrapol/system_config.h>
 
 #include <stdlib.h>
-
-typedef struct {
-    int naddrs;
-    addr_t addrs[3];
-} rch_data_t;
+#include <string.h>
 
 struct _rch_t {
      data_frame_t *data_fr;
      rch_data_t rch_data;
+     uint64_t fcs_errs;
+     uint64_t msgs;
+     bool dup_suppress;
+     dup_cache_t dup;
+     int repeats;
+     uint64_t dups;
 };
 
+size_t rch_sizeof(void)
+{
+    return MEM_ALIGN_UP(sizeof(rch_t)) + data_frame_sizeof();
+}
+
 rch_t *rch_create(void)
 {
-    rch_t *rch = malloc(sizeof(rch_t));
+    rch_t *rch = malloc(rch_sizeof());
     if (!rch) {
         return NULL;
     }
-
-    rch->data_fr = data_frame_create();
-    if (!rch->data_fr) {
-        free(rch);
-        return NULL;
-    }
+    rch_init(rch);
 
     return rch;
 }
 
+void rch_init(rch_t *rch)
+{
+    rch->data_fr = (data_frame_t *)((char *)rch + MEM_ALIGN_UP(sizeof(rch_t)));
+    data_frame_init(rch->data_fr);
+    rch->fcs_errs = 0;
+    rch->msgs = 0;
+    rch->dup_suppress = false;
+    dup_cache_init(&rch->dup);
+    rch->repeats = 0;
+    rch->dups = 0;
+}
+
 void rch_destroy(rch_t *rch)
 {
-    if (rch) {
-        data_frame_destroy(rch->data_fr);
-    }
     free(rch);
 }
 
+void rch_set_dup_suppress(rch_t *rch, bool suppress)
+{
+    rch->dup_suppress = suppress;
+}
+
 bool rch_push_data_block(rch_t *rch, data_block_t *data_blk)
 {
     if (!data_frame_push_data_block(rch->data_fr, data_blk)) {
@@ -55,18 +72,35 @@ bool rch_push_data_block(rch_t *rch, data_block_t *data_blk)
         return false;
     }
 
-    uint8_t data[(92 + 7) / 8];
-    const int size = data_frame_get_bytes(rch->data_fr, data);
+    const uint8_t *data;
+    const int size = data_frame_get_bytes(rch->data_fr, &data);
     if (size != 64) {
         LOG(WTF, "invalid frame lenght");
         return false;
     }
 
+    // payload with valid FCS is cached, FCS check can be skipped too
+    rch->repeats = 0;
+    if (rch->dup_suppress) {
+        const dup_cache_entry_t *e = dup_cache_lookup(&rch->dup, data,
+                size / 8);
+        if (e) {
+            rch->repeats = e->repeats;
+            ++rch->dups;
+            return true;
+        }
+    }
+
     if (!check_fcs(data, size)) {
         LOG(DBG, "invalid FCS");
+        ++rch->fcs_errs;
         return false;
     }
+    if (rch->dup_suppress) {
+        dup_cache_insert(&rch->dup, 0);
+    }
 
+    rch->rch_data.timestamp = data_blk->timestamp;
     rch->rch_data.naddrs = 0;
     for (int i = 0; i < ARRAY_LEN(rch->rch_data.addrs); ++i) {
         addr_parse(&rch->rch_data.addrs[rch->rch_data.naddrs], data + 2*i, 0);
@@ -74,27 +108,47 @@ bool rch_push_data_block(rch_t *rch, data_block_t *data_blk)
             ++rch->rch_data.naddrs;
         }
     }
+    ++rch->msgs;
 
     return true;
 }
 
-void rch_print(const rch_t *rch)
+void rch_get_stats(const rch_t *rch, log_ch_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    data_frame_get_stats(rch->data_fr, &stats->data_fr);
+    stats->fcs_errs = rch->fcs_errs;
+    stats->msgs = rch->msgs;
+    stats->dups = rch->dups;
+}
+
+int rch_get_repeats(const rch_t *rch)
+{
+    return rch->repeats;
+}
+
+const rch_data_t *rch_get_data(const rch_t *rch)
+{
+    return &rch->rch_data;
+}
+
+void rch_print(const rch_data_t *rch_data)
 {
-    printf("RCH ACKs (%d):\n", rch->rch_data.naddrs);
-    for (int i = 0; i < rch->rch_data.naddrs; ++i) {
-        const addr_t *addr = &rch->rch_data.addrs[i];
+    log_printf("RCH ACKs (%d):\n", rch_data->naddrs);
+    for (int i = 0; i < rch_data->naddrs; ++i) {
+        const addr_t *addr = &rch_data->addrs[i];
         if (!addr->z) {
-            printf("\tADDR ACK: ");
+            log_printf("\tADDR ACK: ");
             addr_print(addr);
-            printf("\n");
+            log_printf("\n");
         } else {
-            printf("\tNACK: ");
+            log_printf("\tNACK: ");
             if (addr->y == 4) {
-                printf("noise\n");
+                log_printf("noise\n");
             } else if (addr->y == 5) {
-                printf("collision\n");
+                log_printf("collision\n");
             } else {
-                printf("WTF unknown\n");
+                log_printf("WTF unknown\n");
             }
         }
     }
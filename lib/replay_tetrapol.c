@@ -0,0 +1,643 @@
+// End-to-end replay of captures through phys_ch and all logical channels.
+// Decoded TSDUs are compared (as event records, see tetrapol/event.h) with
+// golden output, throughput and peak memory usage are written into metrics
+// file in Prometheus text format, so they can be tracked across commits.
+#include "phys_ch.c"
+#include "frame_enc.c"
+
+#include <tetrapol/event.h>
+#include <tetrapol/hdlc_frame.h>
+
+#include <inttypes.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define METRICS_PATH_DEFAULT "replay_metrics.prom"
+// frames of each synthetic capture (1 minute of signal)
+#define SYNTH_FRAMES 3000
+// synthetic capture starts in the middle of superframe, frame number
+// is unknown until the first BCH
+#define SYNTH_FIRST_FRAME 10
+// bytes of input passed to decoder at once
+#define RECV_CHUNK 4096
+
+typedef struct {
+    uint8_t *data;
+    int len;
+    int size;
+} buf_t;
+
+typedef struct {
+    char name[64];
+    int band;
+    buf_t bits;         ///< unpacked bits
+    buf_t golden;       ///< expected event records
+    const char *golden_path;    ///< NULL for synthetic capture
+    int pch_msgs;       ///< expected PCH messages, -1 if unknown
+    int rch_msgs;       ///< expected RCH messages, -1 if unknown
+} capture_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t crc_ok;
+    uint64_t pch_msgs;
+    uint64_t rch_msgs;
+    int nevents;
+    double elapsed;     ///< decoding time (s)
+    bool ok;
+} result_t;
+
+// C11 timespec_get(), POSIX clock_gettime() requires POSIX timer_t which
+// conflicts with timer_t from tetrapol/timer.h
+static long long now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool buf_append(buf_t *buf, const void *data, int len)
+{
+    if (buf->len + len > buf->size) {
+        const int size = 2 * (buf->len + len);
+        uint8_t *p = realloc(buf->data, size);
+        if (!p) {
+            return false;
+        }
+        buf->data = p;
+        buf->size = size;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+
+    return true;
+}
+
+static bool append_event(buf_t *buf, const tsdu_t *tsdu)
+{
+    uint8_t rec[EVENT_REC_MAX];
+    const int len = event_tsdu_serialize(tsdu, rec, sizeof(rec));
+
+    return len > 0 && buf_append(buf, rec, len);
+}
+
+/**
+  Append golden event for TSDU transmitted in HDLC frame.
+
+  @param tsdu_data TSDU, the first byte is TPDU header (prio and id_tsap).
+  */
+static bool append_golden(buf_t *buf, arena_t *arena, const uint8_t *tsdu_data,
+        int len)
+{
+    arena_reset(arena);
+    const tsdu_t *tsdu = tsdu_d_decode(arena, tsdu_data + 2, 8 * len,
+            get_bits(2, tsdu_data, 2), get_bits(4, tsdu_data, 4));
+
+    return tsdu && append_event(buf, tsdu);
+}
+
+/**
+  Create data block with given payload and valid CRC.
+
+  @param fn value of FN bits (1-2)
+  @param bytes 8 bytes of payload (bits 3-66), TETRAPOL bit order
+  @return false if valid CRC is not found (should never happen)
+  */
+static bool mk_data_block_bytes(uint8_t *blk, int fn, const uint8_t *bytes)
+{
+    memset(blk, 0, 74);
+    blk[0] = FRAME_TYPE_DATA;
+    blk[1] = fn & 1;
+    blk[2] = fn >> 1;
+    for (int i = 0; i < 64; ++i) {
+        blk[3 + i] = (bytes[i / 8] >> (i % 8)) & 1;
+    }
+
+    data_block_t data_blk;
+    data_blk.fr_type = FRAME_TYPE_DATA;
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            blk[69 + j] = (i >> j) & 1;
+        }
+        data_blk.data[0] = data_blk.data[1] = 0;
+        for (int j = 0; j < 74; ++j) {
+            data_blk.data[j / 64] |= (uint64_t)blk[j] << (63 - j % 64);
+        }
+        if (data_block_check_crc(&data_blk)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Append FCS to HDLC frame, 'len' bytes including 2 bytes of FCS.
+static void mk_fcs(uint8_t *frame, int len)
+{
+    uint16_t crc = 0xffff;
+    for (int i = 0; i < len - 2; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            crc ^= (frame[i] >> j) & 1;
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    crc = ~crc;
+    frame[len - 2] = crc;
+    frame[len - 1] = crc >> 8;
+}
+
+/**
+  Split data frame into data blocks, multiblock frame (more than 2 blocks)
+  is followed by parity block, see data_frame.c.
+
+  @param blks Output blocks, 74 bits each.
+  @param bytes Data, 8 bytes per block.
+  @param nblks Number of data blocks (up to SYS_PAR_DATA_FRAME_BLOCKS_MAX).
+  @return number of blocks written into 'blks', -1 on error
+  */
+static int mk_data_frame(uint8_t blks[][74], const uint8_t *bytes, int nblks)
+{
+    if (nblks == 1) {
+        return mk_data_block_bytes(blks[0], 0, bytes) ? 1 : -1;
+    }
+
+    uint8_t parity[8] = { 0, };
+    for (int i = 0; i < nblks; ++i) {
+        // FN 01 starts frame, FN 11 ends dual frame, inner blocks of
+        // multiblock frame use 10 and 11, the last one 10
+        int fn = 2;
+        if (i == 0) {
+            fn = 1;
+        } else if (nblks == 2) {
+            fn = 3;
+        } else if (i > 1 && i < nblks - 1) {
+            fn = 3;
+        }
+        if (!mk_data_block_bytes(blks[i], fn, &bytes[8 * i])) {
+            return -1;
+        }
+        for (int j = 0; j < 8; ++j) {
+            parity[j] ^= bytes[8 * i + j];
+        }
+    }
+    if (nblks == 2) {
+        return 2;
+    }
+
+    return mk_data_block_bytes(blks[nblks], 1, parity) ? nblks + 1 : -1;
+}
+
+// frame sync, differential encoding, the same as demodulator output
+static bool append_frame(buf_t *bits, const uint8_t *blk, int band, int scr)
+{
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    uint8_t raw[FRAME_LEN];
+    frame_t f;
+
+    mk_frame(&f, blk, FRAME_TYPE_DATA, band, scr);
+    memcpy(raw, frame_sync, FRAME_HDR_LEN);
+    for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+        raw[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+    }
+
+    return buf_append(bits, raw, FRAME_LEN);
+}
+
+/**
+  Create control channel capture, BCH carries D_SYSTEM_INFO with given
+  multiplexing type, SDCH carries D_GROUP_LIST in multiblock frames,
+  PCH and RCH carry random addresses. Frames before the first BCH
+  are random data blocks.
+  */
+static bool synth_capture(capture_t *c, int band, int mux_type, int scr,
+        uint32_t r)
+{
+    // HDLC frame of 3 blocks, TTI all stations, UI, TPDU header and length
+    uint8_t bch_fr[24] = {
+        0x7f, 0xff, COMMAND_UNNUMBERED_UI, 0x00, 17,
+        D_SYSTEM_INFO,
+        0x00,                           // CELL_STATE, set later
+        (mux_type << 2) | 0xc0,         // CELL_CONFIG, ECCH, ATTA
+        0x02, 0x15, 0x00, 0x0a,         // COUNTRY_CODE ... BN_ID
+        0x01, 0x21, 0x01, 0x40,         // CELL_ID, CELL_BN, U_CH_SCRAMBLING
+        0x00, 0x72, 0xe1, 0x00,         // CELL_RADIO_PARAM ... CELL_ACCESS
+        0x05, 0x3b,                     // SUPERFRAME_CPT
+    };
+    // HDLC frame of 4 blocks, individual address, UI, prio 1, id_tsap 2
+    uint8_t sdch_fr[32] = {
+        0x01, 0x23, COMMAND_UNNUMBERED_UI, 0x12, 20,
+        D_GROUP_LIST,
+        0x20, 0x00, 0x82, 0x05, 0x60, 0x06, 0x70,
+        0xc1, 0x12, 0x34, 0x56, 0x00, 0x78,
+        0x41, 0x9a, 0x00, 0x0b, 0xcd,   // talk group, changed per message
+        0x00,
+    };
+    uint8_t bch_blks[2][4][74];
+    uint8_t sdch_blks[5][74];
+    uint8_t pch_blks[2][74];
+    int sdch_nblks = 0;
+    int sdch_blk = 0;
+    int nmsgs = 0;
+    bool ret = false;
+
+    arena_t *arena = arena_create(1024);
+    buf_t bch_golden[2] = { { NULL, 0, 0, }, { NULL, 0, 0, }, };
+    buf_t sdch_golden = { NULL, 0, 0, };
+    if (!arena) {
+        return false;
+    }
+
+    for (int bch = 0; bch < 2; ++bch) {
+        const cell_state_t cell_state = {
+            .mode = CELL_STATE_MODE_NORMAL,
+            .bch = bch,
+        };
+        bch_fr[6] = cell_state._data;
+        mk_fcs(bch_fr, sizeof(bch_fr));
+        if (mk_data_frame(bch_blks[bch], bch_fr, 3) != 4 ||
+                !append_golden(&bch_golden[bch], arena, &bch_fr[3], 17)) {
+            goto err;
+        }
+    }
+
+    for (int n = 0; n < SYNTH_FRAMES; ++n) {
+        const int frame_no = (SYNTH_FIRST_FRAME + n) % 200;
+        const int fn_mod = frame_no % 100;
+        // frame number is known after the first BCH
+        const bool synced = n > 100 - SYNTH_FIRST_FRAME + 3;
+        const bool pch = fn_mod == 98 || fn_mod == 99 ||
+            (mux_type == CELL_CONFIG_MUX_TYPE_TYPE_2 &&
+             (fn_mod == 48 || fn_mod == 49));
+        uint8_t rnd_blk[74];
+        const uint8_t *blk = rnd_blk;
+        uint8_t bytes[16];
+        for (int i = 0; i < ARRAY_LEN(bytes); ++i) {
+            r = r * 1103515245 + 12345;
+            bytes[i] = r >> 16;
+        }
+
+        if (fn_mod <= 3) {
+            blk = bch_blks[frame_no / 100][fn_mod];
+            if (fn_mod == 3 && !buf_append(&c->golden,
+                        bch_golden[frame_no / 100].data,
+                        bch_golden[frame_no / 100].len)) {
+                goto err;
+            }
+        } else if (!synced) {
+            if (!mk_data_block(rnd_blk, FRAME_TYPE_DATA, &r)) {
+                goto err;
+            }
+        } else if (pch) {
+            // activation bitmap and 4 addresses in dual frame
+            if (fn_mod % 2 == 0 && mk_data_frame(pch_blks, bytes, 2) != 2) {
+                goto err;
+            }
+            blk = pch_blks[fn_mod % 2];
+            c->pch_msgs += fn_mod % 2;
+        } else if (frame_no % 25 == 14) {
+            // random address, 2 empty slots (TTI no station) and FCS
+            bytes[2] = bytes[4] = 0x70;
+            bytes[3] = bytes[5] = 0x00;
+            mk_fcs(bytes, 8);
+            if (mk_data_frame(&rnd_blk, bytes, 1) != 1) {
+                goto err;
+            }
+            ++c->rch_msgs;
+        } else {
+            if (sdch_blk == sdch_nblks) {
+                sdch_fr[23] = nmsgs++;
+                mk_fcs(sdch_fr, sizeof(sdch_fr));
+                sdch_nblks = mk_data_frame(sdch_blks, sdch_fr, 4);
+                sdch_blk = 0;
+                sdch_golden.len = 0;
+                if (sdch_nblks != 5 ||
+                        !append_golden(&sdch_golden, arena, &sdch_fr[3], 20)) {
+                    goto err;
+                }
+            }
+            blk = sdch_blks[sdch_blk++];
+            if (sdch_blk == sdch_nblks &&
+                    !buf_append(&c->golden, sdch_golden.data, sdch_golden.len)) {
+                goto err;
+            }
+        }
+
+        if (!append_frame(&c->bits, blk, band, scr)) {
+            goto err;
+        }
+    }
+
+    c->band = band;
+    snprintf(c->name, sizeof(c->name), "synth_%s_mux%d_scr%d",
+            (band == TETRAPOL_BAND_UHF) ? "uhf" : "vhf", mux_type, scr);
+    ret = true;
+
+err:
+    free(bch_golden[0].data);
+    free(bch_golden[1].data);
+    free(sdch_golden.data);
+    arena_destroy(arena);
+
+    return ret;
+}
+
+static bool read_file(buf_t *buf, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+
+    uint8_t data[RECV_CHUNK];
+    size_t len;
+    bool ok = true;
+    while (ok && (len = fread(data, 1, sizeof(data), f)) > 0) {
+        ok = buf_append(buf, data, len);
+    }
+    ok = ok && !ferror(f);
+    fclose(f);
+
+    return ok;
+}
+
+/**
+  Load capture NAME.bits, golden output is NAME.events, VHF band is used
+  for NAME starting by "vhf".
+
+  @param update Golden output is not required, it is (re)created by replay.
+  */
+static bool file_capture(capture_t *c, const char *path, bool update)
+{
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    const int len = strlen(name);
+    if (len < 6 || strcmp(name + len - 5, ".bits") ||
+            len - 5 >= sizeof(c->name)) {
+        fprintf(stderr, "%s: capture must be NAME.bits\n", path);
+        return false;
+    }
+    snprintf(c->name, sizeof(c->name), "%.*s", len - 5, name);
+    c->band = strncmp(c->name, "vhf", 3) ?
+        TETRAPOL_BAND_UHF : TETRAPOL_BAND_VHF;
+
+    char *golden_path = malloc(strlen(path) + 3);
+    if (!golden_path) {
+        return false;
+    }
+    sprintf(golden_path, "%.*s.events", (int)strlen(path) - 5, path);
+    c->golden_path = golden_path;
+    c->pch_msgs = c->rch_msgs = -1;
+
+    if (!read_file(&c->bits, path)) {
+        fprintf(stderr, "%s: failed to read capture\n", path);
+        return false;
+    }
+    if (!update && !read_file(&c->golden, golden_path)) {
+        fprintf(stderr, "%s: failed to read golden output\n", golden_path);
+        return false;
+    }
+
+    return true;
+}
+
+static void tsdu_sink(const tsdu_t *tsdu, void *ptr)
+{
+    buf_t *events = ptr;
+
+    if (!append_event(events, tsdu)) {
+        // mismatch with golden output is reported
+        fprintf(stderr, "Failed to store event codop=0x%02x\n", tsdu->codop);
+    }
+}
+
+// decode whole capture, events are stored into 'events'
+static bool replay(const capture_t *c, buf_t *events, result_t *res)
+{
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(c->band, RADIO_CH_TYPE_CONTROL);
+    if (!phys_ch) {
+        return false;
+    }
+    tetrapol_phys_ch_set_tsdu_sink(phys_ch, tsdu_sink, events);
+
+    const long long start = now_ns();
+    int pos = 0;
+    while (pos < c->bits.len) {
+        const int len = (c->bits.len - pos < RECV_CHUNK) ?
+            c->bits.len - pos : RECV_CHUNK;
+        const int rsize = tetrapol_phys_ch_recv(phys_ch, c->bits.data + pos, len);
+        if (rsize < 0) {
+            break;
+        }
+        pos += rsize;
+        if (tetrapol_phys_ch_process(phys_ch) < 0) {
+            break;
+        }
+    }
+    res->elapsed = (now_ns() - start) / 1e9;
+
+    phys_ch_stats_t st;
+    tetrapol_phys_ch_get_stats(phys_ch, &st);
+    res->frames = st.frames;
+    res->crc_ok = st.crc_ok;
+    res->pch_msgs = st.pch.msgs;
+    res->rch_msgs = st.rch.msgs;
+    tetrapol_phys_ch_destroy(phys_ch);
+
+    return pos == c->bits.len;
+}
+
+static int count_events(const buf_t *events)
+{
+    int n = 0;
+    for (int pos = 0; pos + 2 <= events->len; ++n) {
+        pos += 2 + (events->data[pos] | (events->data[pos + 1] << 8));
+    }
+
+    return n;
+}
+
+/// @return index of the first different event, -1 if streams are the same
+static int compare_events(const buf_t *a, const buf_t *b)
+{
+    int n = 0;
+    int pos = 0;
+    while (pos + 2 <= a->len && pos + 2 <= b->len) {
+        const int len = 2 + (a->data[pos] | (a->data[pos + 1] << 8));
+        if (pos + len > b->len || memcmp(a->data + pos, b->data + pos, len)) {
+            return n;
+        }
+        pos += len;
+        ++n;
+    }
+
+    return (a->len == b->len) ? -1 : n;
+}
+
+static int write_metrics(const char *path, const capture_t *cs,
+        const result_t *rs, int ncs)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(f, "# HELP tetrapol_replay_frames Frames decoded in frame sync\n"
+            "# TYPE tetrapol_replay_frames gauge\n");
+    for (int i = 0; i < ncs; ++i) {
+        fprintf(f, "tetrapol_replay_frames{capture=\"%s\"} %" PRIu64 "\n",
+                cs[i].name, rs[i].frames);
+    }
+    fprintf(f, "# HELP tetrapol_replay_crc_ok Frames with valid CRC\n"
+            "# TYPE tetrapol_replay_crc_ok gauge\n");
+    for (int i = 0; i < ncs; ++i) {
+        fprintf(f, "tetrapol_replay_crc_ok{capture=\"%s\"} %" PRIu64 "\n",
+                cs[i].name, rs[i].crc_ok);
+    }
+    fprintf(f, "# HELP tetrapol_replay_events Decoded TSDUs\n"
+            "# TYPE tetrapol_replay_events gauge\n");
+    for (int i = 0; i < ncs; ++i) {
+        fprintf(f, "tetrapol_replay_events{capture=\"%s\"} %d\n",
+                cs[i].name, rs[i].nevents);
+    }
+    fprintf(f, "# HELP tetrapol_replay_frames_per_second End-to-end decoding throughput\n"
+            "# TYPE tetrapol_replay_frames_per_second gauge\n");
+    for (int i = 0; i < ncs; ++i) {
+        const double fps = (rs[i].elapsed > 0) ?
+            (double)cs[i].bits.len / FRAME_LEN / rs[i].elapsed : 0;
+        fprintf(f, "tetrapol_replay_frames_per_second{capture=\"%s\"} %.0f\n",
+                cs[i].name, fps);
+    }
+    fprintf(f, "# HELP tetrapol_replay_ok Decoded events match golden output\n"
+            "# TYPE tetrapol_replay_ok gauge\n");
+    for (int i = 0; i < ncs; ++i) {
+        fprintf(f, "tetrapol_replay_ok{capture=\"%s\"} %d\n",
+                cs[i].name, rs[i].ok);
+    }
+
+    struct rusage ru;
+    if (!getrusage(RUSAGE_SELF, &ru)) {
+        fprintf(f, "# HELP tetrapol_replay_peak_rss_bytes Peak resident set size\n"
+                "# TYPE tetrapol_replay_peak_rss_bytes gauge\n"
+                "tetrapol_replay_peak_rss_bytes %ld\n", ru.ru_maxrss * 1024L);
+    }
+
+    if (fclose(f)) {
+        perror(path);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *metrics_path = METRICS_PATH_DEFAULT;
+    bool update = false;
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-'; ++argi) {
+        if (!strcmp(argv[argi], "-o") && argi + 1 < argc) {
+            metrics_path = argv[++argi];
+        } else if (!strcmp(argv[argi], "-u")) {
+            update = true;
+        } else {
+            fprintf(stderr, "Usage: %s [-o METRICS_PATH] [-u] [CAPTURE.bits]...\n"
+                    "\tSynthetic captures and given captures (unpacked bits)\n"
+                    "\tare decoded, TSDUs are compared with golden output\n"
+                    "\tCAPTURE.events (see tetrapol/event.h), VHF band is used\n"
+                    "\tfor CAPTURE starting by \"vhf\".\n"
+                    "\t-o write metrics (default %s)\n"
+                    "\t-u update golden output of given captures\n",
+                    argv[0], METRICS_PATH_DEFAULT);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // decoding is measured, not logging
+    log_set_lvl(WTF);
+
+    // control channels of both bands with both multiplexing types
+    static const struct {
+        int band;
+        int mux_type;
+        int scr;
+    } synth[] = {
+        { TETRAPOL_BAND_UHF, CELL_CONFIG_MUX_TYPE_DEFAULT, 0, },
+        { TETRAPOL_BAND_UHF, CELL_CONFIG_MUX_TYPE_TYPE_2, 67, },
+        { TETRAPOL_BAND_VHF, CELL_CONFIG_MUX_TYPE_DEFAULT, 5, },
+        { TETRAPOL_BAND_VHF, CELL_CONFIG_MUX_TYPE_TYPE_2, 126, },
+    };
+    const int nsynth = ARRAY_LEN(synth);
+    const int ncs = nsynth + argc - argi;
+    capture_t *cs = calloc(ncs, sizeof(capture_t));
+    result_t *rs = calloc(ncs, sizeof(result_t));
+    if (!cs || !rs) {
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_SUCCESS;
+    for (int i = 0; i < ncs; ++i) {
+        capture_t *c = &cs[i];
+        const bool ok = (i < nsynth) ?
+            synth_capture(c, synth[i].band, synth[i].mux_type, synth[i].scr,
+                    1000 + i) :
+            file_capture(c, argv[argi + i - nsynth], update);
+        if (!ok) {
+            fprintf(stderr, "Failed to load capture %d\n", i);
+            ret = EXIT_FAILURE;
+            break;
+        }
+
+        buf_t events = { NULL, 0, 0, };
+        const bool replayed = replay(c, &events, &rs[i]);
+        rs[i].nevents = count_events(&events);
+        if (update && c->golden_path) {
+            FILE *f = fopen(c->golden_path, "wb");
+            if (!f || fwrite(events.data, 1, events.len, f) != events.len ||
+                    fclose(f)) {
+                perror(c->golden_path);
+                ret = EXIT_FAILURE;
+            }
+            rs[i].ok = replayed;
+        } else {
+            const int diff = compare_events(&events, &c->golden);
+            rs[i].ok = replayed && diff < 0;
+            if (diff >= 0) {
+                fprintf(stderr, "%s: event %d differs (%d decoded, %d expected)\n",
+                        c->name, diff, rs[i].nevents, count_events(&c->golden));
+            }
+            if (c->pch_msgs >= 0 && (rs[i].pch_msgs != c->pch_msgs ||
+                        rs[i].rch_msgs != c->rch_msgs)) {
+                fprintf(stderr, "%s: %" PRIu64 "/%" PRIu64 " PCH/RCH messages "
+                        "decoded, %d/%d expected\n", c->name, rs[i].pch_msgs,
+                        rs[i].rch_msgs, c->pch_msgs, c->rch_msgs);
+                rs[i].ok = false;
+            }
+        }
+        free(events.data);
+
+        const double fps = (rs[i].elapsed > 0) ?
+            (double)c->bits.len / FRAME_LEN / rs[i].elapsed : 0;
+        printf("%-32s %s %8" PRIu64 " frames %6d events %10.0f frames/s\n",
+                c->name, rs[i].ok ? "OK  " : "FAIL", rs[i].frames,
+                rs[i].nevents, fps);
+        if (!rs[i].ok) {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if (write_metrics(metrics_path, cs, rs, ncs)) {
+        ret = EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < ncs; ++i) {
+        free(cs[i].bits.data);
+        free(cs[i].golden.data);
+        free((char *)cs[i].golden_path);
+    }
+    free(rs);
+    free(cs);
+
+    return ret;
+}
@@ -6,6 +6,7 @@
 #include <tetrapol/misc.h>
 #include <tetrapol/tpdu.h>
 #include <tetrapol/system_config.h>
+#include <tetrapol/trace.h>
 
 #include <stdlib.h>
 #include <string.h>
@@ -14,67 +15,81 @@ struct _sdch_t {
     data_frame_t *data_fr;
     tpdu_t *tpdu;
     tpdu_ui_t *tpdu_ui;
+    log_ch_stats_t stats;   ///< data_fr and TPDU counters are added on read
 };
 
+size_t sdch_sizeof(void)
+{
+    return MEM_ALIGN_UP(sizeof(sdch_t)) + MEM_ALIGN_UP(data_frame_sizeof()) +
+        MEM_ALIGN_UP(tpdu_ui_sizeof()) + tpdu_sizeof();
+}
+
 sdch_t *sdch_create(void)
 {
-    sdch_t *sdch = malloc(sizeof(sdch_t));
+    sdch_t *sdch = malloc(sdch_sizeof());
     if (!sdch) {
         return NULL;
     }
-
-    sdch->data_fr = data_frame_create();
-    if (!sdch->data_fr) {
-        goto err_data_fr;
-    }
-
-    sdch->tpdu_ui = tpdu_ui_create(FRAME_TYPE_DATA);
-    if (!sdch->tpdu_ui) {
-        goto err_tpdu_ui;
-    }
-
-    sdch->tpdu = tpdu_create();
-    if (!sdch->tpdu) {
-        goto err_tpdu;
-    }
+    sdch_init(sdch);
 
     return sdch;
+}
 
-err_tpdu:
-    tpdu_ui_destroy(sdch->tpdu_ui);
-
-err_tpdu_ui:
-    data_frame_destroy(sdch->data_fr);
-
-err_data_fr:
-    free(sdch);
+void sdch_init(sdch_t *sdch)
+{
+    char *p = (char *)sdch + MEM_ALIGN_UP(sizeof(sdch_t));
+    sdch->data_fr = (data_frame_t *)p;
+    data_frame_init(sdch->data_fr);
+    p += MEM_ALIGN_UP(data_frame_sizeof());
+    sdch->tpdu_ui = (tpdu_ui_t *)p;
+    tpdu_ui_init(sdch->tpdu_ui, FRAME_TYPE_DATA);
+    p += MEM_ALIGN_UP(tpdu_ui_sizeof());
+    sdch->tpdu = (tpdu_t *)p;
+    tpdu_init(sdch->tpdu);
+    memset(&sdch->stats, 0, sizeof(sdch->stats));
+}
 
-    return NULL;
+void sdch_fini(sdch_t *sdch)
+{
+    tpdu_ui_hibernate(sdch->tpdu_ui);
 }
 
 void sdch_destroy(sdch_t *sdch)
 {
     if (sdch) {
-        data_frame_destroy(sdch->data_fr);
-        tpdu_ui_destroy(sdch->tpdu_ui);
-        tpdu_destroy(sdch->tpdu);
+        sdch_fini(sdch);
     }
     free(sdch);
 }
 
+void sdch_hibernate(sdch_t *sdch)
+{
+    data_frame_reset(sdch->data_fr);
+    tpdu_ui_hibernate(sdch->tpdu_ui);
+}
+
+size_t sdch_get_heap_size(const sdch_t *sdch)
+{
+    return tpdu_ui_get_heap_size(sdch->tpdu_ui);
+}
+
 bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk)
 {
     if (!data_frame_push_data_block(sdch->data_fr, data_blk)) {
         return false;
     }
 
-    uint8_t data[SYS_PAR_N200_BYTES_MAX];
-    const int size = data_frame_get_bytes(sdch->data_fr, data);
+    const uint8_t *data;
+    const int size = data_frame_get_bytes(sdch->data_fr, &data);
 
     hdlc_frame_t hdlc_fr;
 
-    if (!hdlc_frame_parse(&hdlc_fr, data, size)) {
+    const bool fcs_ok = hdlc_frame_parse(&hdlc_fr, data, size);
+    TRACE(hdlc_parsed, data_blk->frame_no, fcs_ok ? hdlc_fr.command.cmd : -1,
+            size, fcs_ok);
+    if (!fcs_ok) {
         // PAS 0001-3-3 7.4.1.9 stuffing frames are dropped, FCS does not match
+        ++sdch->stats.fcs_errs;
         return false;
     }
 
@@ -89,9 +104,9 @@ bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk)
         IF_LOG(DBG) {
             LOG_("HDLC info=");
             print_hex(hdlc_fr.data, hdlc_fr.nbits / 8);
-            printf("\t");
+            log_printf("\t");
             addr_print(&hdlc_fr.addr);
-            printf("\n");
+            log_printf("\n");
         }
         return tpdu_ui_push_hdlc_frame(sdch->tpdu_ui, &hdlc_fr);
     }
@@ -100,7 +115,7 @@ bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk)
         IF_LOG(INFO) {
             LOG_("\n\tcmd ACK_DACH\n\taddr: ");
             addr_print(&hdlc_fr.addr);
-            printf("\n");
+            log_printf("\n");
         }
         if (!cmpzero(hdlc_fr.data, hdlc_fr.nbits / 8)) {
             IF_LOG(WTF) {
@@ -118,7 +133,7 @@ bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk)
         IF_LOG(INFO) {
             LOG_("\n\tcmd SNMR\n\taddr: ");
             addr_print(&hdlc_fr.addr);
-            printf("\n");
+            log_printf("\n");
         }
 
         if (!cmpzero(hdlc_fr.data, hdlc_fr.nbits / 8)) {
@@ -141,12 +156,27 @@ bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk)
 tsdu_t *sdch_get_tsdu(sdch_t *sdch)
 {
     tsdu_t *tsdu = tpdu_ui_get_tsdu(sdch->tpdu_ui);
+    if (tsdu) {
+        ++sdch->stats.msgs;
+    }
 
     // TODO: multiplexing for other TPDU types
 
     return tsdu;
 }
 
+void sdch_set_filter(sdch_t *sdch, const tsdu_filter_t *filter)
+{
+    tpdu_ui_set_filter(sdch->tpdu_ui, filter);
+}
+
+void sdch_get_stats(const sdch_t *sdch, log_ch_stats_t *stats)
+{
+    memcpy(stats, &sdch->stats, sizeof(*stats));
+    data_frame_get_stats(sdch->data_fr, &stats->data_fr);
+    stats->tsdu_errs += tpdu_ui_get_tsdu_errs(sdch->tpdu_ui);
+}
+
 void sdch_tick(const timeval_t *tv, void *sdch)
 {
     tpdu_du_tick(tv, ((sdch_t *)sdch)->tpdu_ui);
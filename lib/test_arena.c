@@ -0,0 +1,146 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "arena.c"
+
+#include <tetrapol/tsdu.h>
+
+static void test_alloc(void **state)
+{
+    (void) state;   // unused
+
+    arena_t *arena = arena_create(256);
+    assert_non_null(arena);
+
+    uint8_t *ptrs[64];
+    for (int i = 0; i < 64; ++i) {
+        ptrs[i] = arena_alloc(arena, i + 1);
+        assert_non_null(ptrs[i]);
+        assert_int_equal((uintptr_t)ptrs[i] % alignof(max_align_t), 0);
+        assert_int_equal(arena_alloc_size(ptrs[i]), i + 1);
+        memset(ptrs[i], i, i + 1);
+    }
+    // allocations must not overlap
+    for (int i = 0; i < 64; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            assert_int_equal(ptrs[i][j], i);
+        }
+    }
+
+    // larger than block size
+    uint8_t *big = arena_alloc(arena, 1000);
+    assert_non_null(big);
+    memset(big, 0xaa, 1000);
+    assert_int_equal(ptrs[63][63], 63);
+
+    // memory is reused after reset, no new blocks are required
+    arena_block_t *last = arena->blocks;
+    while (last->next) {
+        last = last->next;
+    }
+    arena_reset(arena);
+    assert_true(arena_alloc(arena, 1) == ptrs[0]);
+    for (int i = 1; i < 64; ++i) {
+        assert_non_null(arena_alloc(arena, i + 1));
+    }
+    assert_non_null(arena_alloc(arena, 1000));
+    assert_null(last->next);
+
+    arena_destroy(arena);
+}
+
+static void test_realloc(void **state)
+{
+    (void) state;   // unused
+
+    arena_t *arena = arena_create(128);
+    assert_non_null(arena);
+
+    // last allocation grows in place
+    uint8_t *p = arena_realloc(arena, NULL, 8);
+    memset(p, 1, 8);
+    uint8_t *p2 = arena_realloc(arena, p, 64);
+    assert_true(p == p2);
+    assert_int_equal(arena_alloc_size(p2), 64);
+    memset(p2 + 8, 2, 56);
+
+    // moved when another allocation follows or block is full
+    uint8_t *q = arena_alloc(arena, 8);
+    p2 = arena_realloc(arena, p, 200);
+    assert_non_null(p2);
+    assert_true(p != p2);
+    assert_true(q != p2);
+    for (int i = 0; i < 64; ++i) {
+        assert_int_equal(p2[i], (i < 8) ? 1 : 2);
+    }
+
+    arena_destroy(arena);
+}
+
+// cloned TSDU must stay valid after arena is reset and reused
+static void test_tsdu_clone(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t data[] = {
+        D_GROUP_LIST,
+        0x20,               // REFERENCE_LIST revision 1
+        0x00,               // INDEX_LIST
+        0x82,               // 2x EMERGENCY
+        0x05, 0x60, 0x06, 0x70,
+        0xc1,               // 1x OPEN
+        0x12, 0x34, 0x56, 0x00, 0x78,
+        0x41,               // 1x TALK_GROUP
+        0x9a, 0x00, 0x0b, 0xcd,
+        0x00,               // END
+    };
+
+    arena_t *arena = arena_create(64);
+    assert_non_null(arena);
+
+    tsdu_t *tsdu = tsdu_d_decode(arena, data, 8 * sizeof(data), 1, 2);
+    assert_non_null(tsdu);
+    tsdu_t *clone = tsdu_clone(tsdu);
+    assert_non_null(clone);
+    // no-op for TSDU owned by arena
+    tsdu_destroy(tsdu);
+
+    arena_reset(arena);
+    memset(arena_alloc(arena, 1024), 0xff, 1024);
+
+    const tsdu_d_group_list_t *gl = (const tsdu_d_group_list_t *)clone;
+    assert_int_equal(clone->codop, D_GROUP_LIST);
+    assert_int_equal(clone->prio, 1);
+    assert_int_equal(clone->id_tsap, 2);
+    assert_int_equal(gl->reference_list.revision, 1);
+    assert_int_equal(gl->nemergency, 2);
+    assert_int_equal(gl->emergency[0].cell_id.bs_id, 5);
+    assert_int_equal(gl->emergency[0].cell_id.rws_id, 6);
+    assert_int_equal(gl->emergency[1].cell_id.bs_id, 6);
+    assert_int_equal(gl->emergency[1].cell_id.rws_id, 7);
+    assert_int_equal(gl->nopen, 1);
+    assert_int_equal(gl->open[0].coverage_id, 0x12);
+    assert_int_equal(gl->open[0].call_priority, 3);
+    assert_int_equal(gl->open[0].group_id, 0x456);
+    assert_int_equal(gl->open[0].neighbouring_cell, 0x078);
+    assert_int_equal(gl->ngroup, 1);
+    assert_int_equal(gl->group[0].coverage_id, 0x9a);
+    assert_int_equal(gl->group[0].neighbouring_cell, 0xbcd);
+
+    tsdu_destroy(clone);
+    arena_destroy(arena);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_alloc),
+        unit_test(test_realloc),
+        unit_test(test_tsdu_clone),
+    };
+
+    return run_tests(tests);
+}
@@ -6,6 +6,8 @@
 // include, we are testing static methods
 #include "bit_utils.c"
 
+#include <tetrapol/misc.h>
+
 
 /// test few results known as good
 static void test_check_fcs(void **state)
@@ -43,10 +45,215 @@ static void test_check_fcs(void **state)
     }
 }
 
+// original bit by bit implementation of check_fcs()
+static bool check_fcs_bitwise(const uint8_t *data, int nbits)
+{
+    // roll in firts 16 bites of data
+    uint32_t crc = 0;
+    uint8_t b = data[0];
+    for (int i = 0; i < 8; ++i) {
+        crc = (crc << 1) | (b & 1);
+        b = b >> 1;
+    }
+    b = data[1];
+    for (int i = 0; i < 8; ++i) {
+        crc = (crc << 1) | (b & 1);
+        b = b >> 1;
+    }
+
+    // invert first 16 bits of data
+    crc ^= 0xffff;
+
+    nbits -= 16;
+    data += 2;
+    for ( ; nbits > 0; ++data) {
+        b = *data;
+        for (int offs = 0; offs < 8 && nbits; ++offs, --nbits) {
+            // shift data bits into CRC
+            crc = (crc << 1) | (b & 1);
+            b = b >> 1;
+            if (crc & 0x10000) {
+                // CRC with poly: x^16 + x^12 + x^5 + 1
+                crc ^= 0x11021;
+            }
+        }
+    }
+
+    return !(crc ^ 0xffff);
+}
+
+/// table driven FCS must match bitwise version, vectors from misc/fcs_data.py
+static void test_check_fcs_table(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t vectors[][24] = {
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xdf, 0xa8, 0x26,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xdf, 0x20, 0x87,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe0, 0xdc, 0xef,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe0, 0x54, 0x4e,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe1, 0x55, 0xfe,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe1, 0xdd, 0x5f,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe2, 0xce, 0xcc,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe2, 0x46, 0x6d,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe3, 0x47, 0xdd,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe3, 0xcf, 0x7c,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x03, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe4, 0xf8, 0xa9,
+        },
+        {
+            0x7f, 0xff, 0x03, 0x00, 0x11, 0x90, 0x13, 0x60,
+            0x02, 0x16, 0x00, 0x0a, 0x00, 0x01, 0x01, 0x47,
+            0x00, 0x83, 0xf5, 0x00, 0x04, 0xe4, 0x70, 0x08,
+        },
+    };
+
+    for (int i = 0; i < ARRAY_LEN(vectors); ++i) {
+        assert_true(check_fcs_bitwise(vectors[i], 8 * sizeof(vectors[i])));
+        assert_true(check_fcs(vectors[i], 8 * sizeof(vectors[i])));
+    }
+
+    // random data of all lengths (including unaligned), valid FCS is forced
+    // into the last 16 bits
+    uint32_t r = 24680;
+    for (int nbits = 16; nbits < 8 * 24; ++nbits) {
+        uint8_t data[24];
+        for (int i = 0; i < sizeof(data); ++i) {
+            r = r * 1103515245 + 12345;
+            data[i] = r >> 16;
+        }
+        assert_int_equal(check_fcs_bitwise(data, nbits), check_fcs(data, nbits));
+
+        for (int fcs = 0; fcs <= 0xffff; ++fcs) {
+            for (int i = 0; i < 16; ++i) {
+                const int pos = nbits - 16 + i;
+                if ((fcs >> i) & 1) {
+                    data[pos / 8] |= 1 << (pos % 8);
+                } else {
+                    data[pos / 8] &= ~(1 << (pos % 8));
+                }
+            }
+            if (check_fcs_bitwise(data, nbits)) {
+                break;
+            }
+        }
+        assert_true(check_fcs(data, nbits));
+
+        // any single bit error must be detected
+        const int err_pos = r % nbits;
+        data[err_pos / 8] ^= 1 << (err_pos % 8);
+        assert_false(check_fcs_bitwise(data, nbits));
+        assert_false(check_fcs(data, nbits));
+    }
+}
+
+/// reads must match get_bits(), reads past the end of data must be detected
+static void test_bit_reader(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t data[24];
+    uint32_t r = 13579;
+    for (int i = 0; i < sizeof(data); ++i) {
+        r = r * 1103515245 + 12345;
+        data[i] = r >> 16;
+    }
+
+    // all lengths from all offsets, including the tail of data
+    for (int nbits = 1; nbits <= 8 * sizeof(data); ++nbits) {
+        for (int len = 1; len <= 32; ++len) {
+            bit_reader_t br;
+            bit_reader_init(&br, data, nbits);
+            int pos = 0;
+            while (pos + len <= nbits) {
+                assert_int_equal(bit_reader_get(&br, len),
+                        get_bits(len, data, pos));
+                pos += len;
+                assert_int_equal(bit_reader_left(&br), nbits - pos);
+            }
+            assert_false(br.overflow);
+            assert_int_equal(bit_reader_get(&br, len), 0);
+            assert_true(br.overflow);
+            assert_int_equal(bit_reader_left(&br), 0);
+        }
+    }
+
+    // overflow is sticky
+    bit_reader_t br;
+    bit_reader_init(&br, data, 16);
+    bit_reader_skip(&br, 12);
+    assert_false(br.overflow);
+    bit_reader_skip(&br, 5);
+    assert_true(br.overflow);
+    bit_reader_get(&br, 1);
+    assert_true(br.overflow);
+
+    // sub-reader is bounded, parent skips the split part
+    bit_reader_t sub;
+    bit_reader_init(&br, data, 8 * sizeof(data));
+    bit_reader_skip(&br, 4);
+    bit_reader_split(&br, &sub, 20);
+    assert_int_equal(bit_reader_left(&sub), 20);
+    assert_int_equal(bit_reader_get(&sub, 20), get_bits(20, data, 4));
+    assert_int_equal(bit_reader_get(&sub, 1), 0);
+    assert_true(sub.overflow);
+    assert_false(br.overflow);
+    assert_int_equal(bit_reader_get(&br, 8), data[3]);
+    assert_true(bit_reader_ptr(&br) == &data[4]);
+
+    bit_reader_split(&br, &sub, 8 * sizeof(data));
+    assert_true(br.overflow);
+    assert_int_equal(bit_reader_left(&sub), 8 * (sizeof(data) - 4));
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_check_fcs),
+        unit_test(test_check_fcs_table),
+        unit_test(test_bit_reader),
     };
 
     return run_tests(tests);
@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "cell_cache.c"
+
+#include <unistd.h>
+
+static void mk_path(char *path, size_t len)
+{
+    snprintf(path, len, "/tmp/test_cell_cache.%d", (int)getpid());
+}
+
+static void test_round_trip(void **state)
+{
+    (void) state;   // unused
+
+    char path[64];
+    mk_path(path, sizeof(path));
+    unlink(path);
+
+    // missing file is an empty cache
+    cell_cache_t *cache = cell_cache_load(path);
+    assert_non_null(cache);
+    assert_null(cell_cache_get(cache, "ch0", false));
+
+    cell_cache_entry_t *e = cell_cache_get(cache, "ch0", true);
+    assert_non_null(e);
+    assert_int_equal(e->scr, -1);
+    assert_int_equal(e->mux_type, -1);
+    assert_true(!e->has_sysinfo);
+    e->scr = 42;
+
+    tsdu_d_system_info_t si;
+    memset(&si, 0, sizeof(si));
+    si.cell_config.mux_type = CELL_CONFIG_MUX_TYPE_TYPE_2;
+    si.country_code = 0x21;
+    si.cell_bn = 0x1234;
+    si.superframe_cpt = 0x0abc;
+    si.channel_id = 0x0321;
+    si.band = 2;
+    // more entries than fits into chunk, entries must not move
+    for (int i = 0; i < 2 * CHUNK_ENTRIES; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "f%d", i);
+        cell_cache_entry_t *ei = cell_cache_get(cache, key, true);
+        assert_non_null(ei);
+        ei->scr = i % 128;
+        if (i % 2) {
+            cell_cache_set_sysinfo(ei, &si);
+        }
+    }
+    assert_true(cell_cache_get(cache, "ch0", false) == e);
+    assert_int_equal(e->scr, 42);
+
+    assert_int_equal(cell_cache_save(cache, path), 0);
+    cell_cache_destroy(cache);
+
+    cache = cell_cache_load(path);
+    assert_non_null(cache);
+    e = cell_cache_get(cache, "ch0", false);
+    assert_non_null(e);
+    assert_int_equal(e->scr, 42);
+    assert_int_equal(e->mux_type, -1);
+    for (int i = 0; i < 2 * CHUNK_ENTRIES; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "f%d", i);
+        cell_cache_entry_t *ei = cell_cache_get(cache, key, false);
+        assert_non_null(ei);
+        assert_int_equal(ei->scr, i % 128);
+        assert_int_equal(ei->has_sysinfo, i % 2);
+        if (i % 2) {
+            assert_int_equal(ei->mux_type, CELL_CONFIG_MUX_TYPE_TYPE_2);
+            assert_int_equal(ei->sysinfo.cell_config.mux_type,
+                    CELL_CONFIG_MUX_TYPE_TYPE_2);
+            assert_int_equal(ei->sysinfo.country_code, 0x21);
+            assert_int_equal(ei->sysinfo.cell_bn, 0x1234);
+            assert_int_equal(ei->sysinfo.superframe_cpt, 0x0abc);
+            assert_int_equal(ei->sysinfo.channel_id, 0x0321);
+            assert_int_equal(ei->sysinfo.band, 2);
+            assert_int_equal(ei->sysinfo.base.codop, D_SYSTEM_INFO);
+        }
+    }
+    cell_cache_destroy(cache);
+
+    unlink(path);
+}
+
+static void test_invalid(void **state)
+{
+    (void) state;   // unused
+
+    char path[64];
+    mk_path(path, sizeof(path));
+    FILE *f = fopen(path, "w");
+    assert_non_null(f);
+    fprintf(f,
+            "# comment\n"
+            "\n"
+            "a scr=1 mux=0 future=x\n"
+            "b scr=128\n"
+            "c scr=1x\n"
+            "d sysinfo=0011\n"
+            "e mux=1\n");
+    fclose(f);
+
+    cell_cache_t *cache = cell_cache_load(path);
+    assert_non_null(cache);
+    cell_cache_entry_t *e = cell_cache_get(cache, "a", false);
+    assert_non_null(e);
+    assert_int_equal(e->scr, 1);
+    assert_int_equal(e->mux_type, 0);
+    assert_null(cell_cache_get(cache, "b", false));
+    assert_null(cell_cache_get(cache, "c", false));
+    assert_null(cell_cache_get(cache, "d", false));
+    e = cell_cache_get(cache, "e", false);
+    assert_non_null(e);
+    assert_int_equal(e->scr, -1);
+    assert_int_equal(e->mux_type, 1);
+
+    assert_null(cell_cache_get(cache, "with space", true));
+    assert_null(cell_cache_get(cache, "#x", true));
+    assert_null(cell_cache_get(cache, "", true));
+
+    cell_cache_destroy(cache);
+    unlink(path);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_round_trip),
+        unit_test(test_invalid),
+    };
+
+    return run_tests(tests);
+}
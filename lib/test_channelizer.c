@@ -0,0 +1,136 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "channelizer.c"
+
+#include <tetrapol/misc.h>
+
+#define NCHS 32
+#define DECIM 25
+#define NSAMPLES (DECIM * 400)
+
+static void test_fft(void **state)
+{
+    (void) state;   // unused
+
+    const int ns[] = { 4, 12, 60, 192, };
+    for (int t = 0; t < (int)ARRAY_LEN(ns); ++t) {
+        const int n = ns[t];
+        channelizer_t *chzr = channelizer_create(n, 1, 0.25, 0.1,
+                CHANNELIZER_INPUT_CF32, 1);
+        assert_non_null(chzr);
+
+        cf_t in[192], out[192];
+        uint32_t r = 1;
+        for (int i = 0; i < n; ++i) {
+            r = r * 1103515245 + 12345;
+            in[i].re = (int)(r >> 16) % 100 / 50.0f - 1;
+            r = r * 1103515245 + 12345;
+            in[i].im = (int)(r >> 16) % 100 / 50.0f - 1;
+        }
+        fft_rec(chzr, out, in, n, 1, chzr->factors);
+
+        for (int k = 0; k < n; ++k) {
+            double re = 0, im = 0;
+            for (int j = 0; j < n; ++j) {
+                const double a = -2 * PI * j * k / n;
+                re += in[j].re * cos(a) - in[j].im * sin(a);
+                im += in[j].re * sin(a) + in[j].im * cos(a);
+            }
+            assert_true(fabs(out[k].re - re) < 1e-3);
+            assert_true(fabs(out[k].im - im) < 1e-3);
+        }
+        channelizer_destroy(chzr);
+    }
+
+    // prime factor 17 is not supported
+    assert_null(channelizer_create(68, 1, 0.25, 0.1, CHANNELIZER_INPUT_CF32, 1));
+}
+
+/// Mean power of output samples of channel, initial transient is skipped.
+static double ch_power(const float *out, int stride, int ch, int nout)
+{
+    double p = 0;
+    for (int i = nout / 2; i < nout; ++i) {
+        const float *s = &out[2 * (ch * stride + i)];
+        p += s[0] * s[0] + s[1] * s[1];
+    }
+
+    return p / (nout - nout / 2);
+}
+
+/**
+  Tones in channels +5 and -3 (slightly off center) must appear only
+  in their channels, output must not depend on threads or input chunks.
+  */
+static void test_channels(void **state)
+{
+    (void) state;   // unused
+
+    static float iq[2 * NSAMPLES];
+    for (int t = 0; t < NSAMPLES; ++t) {
+        const double a1 = 2 * PI * (5 + 0.1) * t / NCHS;
+        const double a2 = 2 * PI * (-3 - 0.05) * t / NCHS;
+        iq[2 * t] = cos(a1) + 0.5 * cos(a2);
+        iq[2 * t + 1] = sin(a1) + 0.5 * sin(a2);
+    }
+
+    channelizer_t *chzr = channelizer_create(NCHS, DECIM, 0.35 / NCHS,
+            0.1 / NCHS, CHANNELIZER_INPUT_CF32, 1);
+    assert_non_null(chzr);
+    assert_int_equal(channelizer_ntaps(chzr) % NCHS, 0);
+    const int stride = channelizer_out_max(chzr, NSAMPLES);
+    float *out = calloc(2 * NCHS * stride, sizeof(float));
+    float *out_mt = calloc(2 * NCHS * stride, sizeof(float));
+    assert_non_null(out);
+    assert_non_null(out_mt);
+    const int nout = channelizer_process(chzr, iq, NSAMPLES, out, stride);
+    assert_int_equal(nout, NSAMPLES / DECIM);
+    channelizer_destroy(chzr);
+
+    assert_true(fabs(ch_power(out, stride, 5, nout) - 1) < 0.05);
+    assert_true(fabs(ch_power(out, stride, NCHS - 3, nout) - 0.25) < 0.02);
+    for (int ch = 0; ch < NCHS; ++ch) {
+        if (ch != 5 && ch != NCHS - 3) {
+            assert_true(ch_power(out, stride, ch, nout) < 1e-3);
+        }
+    }
+    // tone is shifted to 0.1 of channel spacing
+    for (int i = nout / 2; i < nout; ++i) {
+        const float *s0 = &out[2 * (5 * stride + i - 1)];
+        const float *s1 = &out[2 * (5 * stride + i)];
+        const float dphi = atan2f(s1[1] * s0[0] - s1[0] * s0[1],
+                s1[0] * s0[0] + s1[1] * s0[1]);
+        assert_true(fabsf(dphi - 2 * PI * 0.1 * DECIM / NCHS) < 1e-2);
+    }
+
+    // more threads, odd input chunks
+    chzr = channelizer_create(NCHS, DECIM, 0.35 / NCHS, 0.1 / NCHS,
+            CHANNELIZER_INPUT_CF32, 3);
+    assert_non_null(chzr);
+    int nout_mt = 0;
+    for (int pos = 0, len = 7; pos < NSAMPLES; pos += len, len = len * 5 % 3001) {
+        len = (pos + len > NSAMPLES) ? NSAMPLES - pos : len;
+        nout_mt += channelizer_process(chzr, &iq[2 * pos], len,
+                out_mt + 2 * nout_mt, stride);
+    }
+    channelizer_destroy(chzr);
+    assert_int_equal(nout_mt, nout);
+    assert_memory_equal(out_mt, out, 2 * NCHS * stride * sizeof(float));
+
+    free(out_mt);
+    free(out);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_fft),
+        unit_test(test_channels),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,246 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "phys_ch.c"
+#include "frame_enc.c"
+#undef LOG_PREFIX
+#include "combiner.c"
+
+typedef struct {
+    int n;
+    voice_frame_t frames[16];
+} voice_frames_t;
+
+static void voice_sink(const voice_frame_t *vf, void *ptr)
+{
+    voice_frames_t *vfs = ptr;
+
+    if (vfs->n < ARRAY_LEN(vfs->frames)) {
+        vfs->frames[vfs->n] = *vf;
+    }
+    ++vfs->n;
+}
+
+// frames damaged at one receiver are taken from the other one
+static void test_diversity(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int nframes = 8;
+    const int bad_frame[2] = { 3, 5, };
+    uint8_t blks[nframes][126];
+    uint8_t bits[2][nframes * FRAME_LEN];
+    uint32_t r = 1357;
+
+    for (int n = 0; n < nframes; ++n) {
+        assert_true(mk_data_block(blks[n], FRAME_TYPE_VOICE, &r));
+        for (int rx = 0; rx < 2; ++rx) {
+            uint8_t blk[126];
+            memcpy(blk, blks[n], sizeof(blk));
+            if (n == bad_frame[rx]) {
+                blk[7] ^= 1;
+            }
+            frame_t f;
+            mk_frame(&f, blk, FRAME_TYPE_VOICE, TETRAPOL_BAND_UHF, 0);
+            uint8_t *b = &bits[rx][n * FRAME_LEN];
+            memcpy(b, frame_sync, FRAME_HDR_LEN);
+            for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+            }
+        }
+    }
+
+    combiner_t *comb = combiner_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_TRAFFIC, 2);
+    assert_non_null(comb);
+    assert_null(combiner_get_rx(comb, 2));
+    voice_frames_t vfs = { .n = 0, };
+    tetrapol_phys_ch_set_voice_sink(combiner_get_phys_ch(comb),
+            voice_sink, &vfs);
+    for (int rx = 0; rx < 2; ++rx) {
+        tetrapol_phys_ch_set_scr(combiner_get_rx(comb, rx), 0);
+    }
+
+    // frame is passed as soon as both receivers have it
+    for (int n = 0; n < nframes; ++n) {
+        for (int rx = 0; rx < 2; ++rx) {
+            phys_ch_t *phys_ch = combiner_get_rx(comb, rx);
+            assert_int_equal(FRAME_LEN, tetrapol_phys_ch_recv(
+                        phys_ch, &bits[rx][n * FRAME_LEN], FRAME_LEN));
+            assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+        }
+        assert_int_equal(vfs.n, n ? n + 1 : 0);
+    }
+    combiner_flush(comb);
+    assert_int_equal(vfs.n, nframes);
+
+    for (int n = 0; n < vfs.n; ++n) {
+        const voice_frame_t *vf = &vfs.frames[n];
+        assert_true(vf->crc_ok);
+        if (n) {
+            assert_int_equal(vf->timestamp - vf[-1].timestamp, 20000);
+        }
+        for (int i = 0; i < 126; ++i) {
+            assert_int_equal((vf->data[i / 64] >> (63 - i % 64)) & 1, blks[n][i]);
+        }
+    }
+
+    combiner_stats_t stats;
+    combiner_get_stats(comb, &stats);
+    assert_int_equal(stats.frames, nframes);
+    assert_int_equal(stats.recovered, 2);
+    assert_int_equal(stats.late, 0);
+    assert_int_equal(stats.rx_best[0], nframes - 1);
+    assert_int_equal(stats.rx_best[1], 1);
+
+    phys_ch_stats_t ch_stats;
+    tetrapol_phys_ch_get_stats(combiner_get_phys_ch(comb), &ch_stats);
+    assert_int_equal(ch_stats.frames, nframes);
+    assert_int_equal(ch_stats.crc_ok, nframes);
+    tetrapol_phys_ch_get_stats(combiner_get_rx(comb, 1), &ch_stats);
+    assert_int_equal(ch_stats.crc_ok, nframes - 1);
+
+    combiner_destroy(comb);
+}
+
+typedef struct {
+    int n;
+    int frame_no[128];
+} frame_nos_t;
+
+static void frame_sink(const frame_info_t *fi, void *ptr)
+{
+    frame_nos_t *fns = ptr;
+
+    if (fns->n < ARRAY_LEN(fns->frame_no)) {
+        fns->frame_no[fns->n] = fi->frame_no;
+    }
+    ++fns->n;
+}
+
+static void deliver(combiner_t *comb, int rx, int frame_no, int64_t ts,
+        bool crc_ok)
+{
+    const frame_info_t fi = {
+        .timestamp = ts,
+        .frame_no = frame_no,
+        .fr_type = FRAME_TYPE_DATA,
+        .nerrs = crc_ok ? 0 : 1,
+        .crc_ok = crc_ok,
+    };
+    const data_block_t data_blk = {
+        .fr_type = FRAME_TYPE_DATA,
+        .frame_no = frame_no,
+        .nerrs = fi.nerrs,
+    };
+    rx_block_sink(&fi, &data_blk, &comb->rxs[rx]);
+}
+
+static void test_align(void **state)
+{
+    (void) state;   // unused
+
+    combiner_t *comb = combiner_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL, 2);
+    assert_non_null(comb);
+    frame_nos_t fns = { .n = 0, };
+    tetrapol_phys_ch_set_frame_sink(combiner_get_phys_ch(comb),
+            frame_sink, &fns);
+    // clock of receiver 1 is 0.5 s ahead
+    const int64_t offs = 500000;
+    combiner_set_rx_offset(comb, 1, -offs);
+
+    // the same frame can not be numbered back
+    deliver(comb, 0, FRAME_NO_UNKNOWN, 0, true);
+
+    // frame numbers wrap
+    const int fn[] = { 198, 199, 0, 1, };
+    for (int i = 0; i < ARRAY_LEN(fn); ++i) {
+        deliver(comb, 0, fn[i], i * 20000, i != 2);
+    }
+    assert_int_equal(fns.n, 0);
+    combiner_stats_t stats;
+    combiner_get_stats(comb, &stats);
+    assert_int_equal(stats.unaligned, 1);
+    for (int i = 0; i < ARRAY_LEN(fn); ++i) {
+        deliver(comb, 1, fn[i], i * 20000 + offs, true);
+        assert_int_equal(fns.n, i + 1);
+        assert_int_equal(fns.frame_no[i], fn[i]);
+    }
+    deliver(comb, 0, 199, 20000, true);
+    combiner_get_stats(comb, &stats);
+    assert_int_equal(stats.frames, 4);
+    assert_int_equal(stats.recovered, 1);
+    assert_int_equal(stats.late, 1);
+    assert_int_equal(stats.rx_best[0], 3);
+    assert_int_equal(stats.rx_best[1], 1);
+
+    // receiver 1 is lost, frames are passed after COMBINER_DEPTH frames
+    int i = 4;
+    for (; i < 4 + COMBINER_DEPTH; ++i) {
+        deliver(comb, 0, (198 + i) % 200, i * 20000, true);
+    }
+    assert_int_equal(fns.n, 4);
+    deliver(comb, 0, (198 + i) % 200, i * 20000, true);
+    ++i;
+    assert_int_equal(fns.n, 4 + COMBINER_DEPTH + 1);
+    deliver(comb, 0, (198 + i) % 200, i * 20000, true);
+    ++i;
+    assert_int_equal(fns.n, 4 + COMBINER_DEPTH + 2);
+    for (int j = 0; j < fns.n; ++j) {
+        assert_int_equal(fns.frame_no[j], (198 + j) % 200);
+    }
+
+    // receiver 1 is back, it is waited for again
+    deliver(comb, 1, (198 + i) % 200, i * 20000 + offs, true);
+    assert_int_equal(fns.n, 4 + COMBINER_DEPTH + 2);
+    deliver(comb, 0, (198 + i) % 200, i * 20000, true);
+    assert_int_equal(fns.n, 4 + COMBINER_DEPTH + 3);
+
+    combiner_destroy(comb);
+}
+
+// frames preceding the first numbered frame are numbered back
+static void test_backlog(void **state)
+{
+    (void) state;   // unused
+
+    combiner_t *comb = combiner_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL, 1);
+    assert_non_null(comb);
+    frame_nos_t fns = { .n = 0, };
+    tetrapol_phys_ch_set_frame_sink(combiner_get_phys_ch(comb),
+            frame_sink, &fns);
+
+    for (int i = 0; i <= RX_BACKLOG; ++i) {
+        deliver(comb, 0, FRAME_NO_UNKNOWN, i * 20000, true);
+    }
+    assert_int_equal(fns.n, 0);
+    deliver(comb, 0, 104, (RX_BACKLOG + 1) * 20000, true);
+    assert_int_equal(fns.n, RX_BACKLOG + 1);
+    for (int i = 0; i < fns.n; ++i) {
+        assert_int_equal(fns.frame_no[i], 104 - RX_BACKLOG + i);
+    }
+
+    combiner_stats_t stats;
+    combiner_get_stats(comb, &stats);
+    assert_int_equal(stats.unaligned, 1);
+    assert_int_equal(stats.frames, RX_BACKLOG + 1);
+
+    combiner_destroy(comb);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_diversity),
+        unit_test(test_align),
+        unit_test(test_backlog),
+    };
+
+    return run_tests(tests);
+}
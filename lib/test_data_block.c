@@ -6,6 +6,70 @@
 // include, we are testing static methods
 #include "data_block.c"
 
+#include <tetrapol/bit_utils.h>
+#include <tetrapol/misc.h>
+
+// http://ghsi.de/CRC/index.php?Polynom=1010
+static void mk_crc3(uint8_t *res, const uint8_t *input, int input_len)
+{
+    uint8_t inv;
+    memset(res, 0, 3);
+
+    for (int i = 0; i < input_len; ++i)
+    {
+        inv = input[i] ^ res[0];
+
+        res[0] = res[1];
+        res[1] = res[2] ^ inv;
+        res[2] = inv;
+    }
+}
+
+// http://ghsi.de/CRC/index.php?Polynom=10010
+static void mk_crc5(uint8_t *res, const uint8_t *input, int input_len)
+{
+    uint8_t inv;
+    memset(res, 0, 5);
+
+    for (int i = 0; i < input_len; ++i)
+    {
+        inv = input[i] ^ res[0];
+
+        res[0] = res[1];
+        res[1] = res[2];
+        res[2] = res[3] ^ inv;
+        res[3] = res[4];
+        res[4] = inv;
+    }
+}
+
+// reference bit by bit implementation of decode_data_frame()
+static int decode_data_frame_bitwise(uint8_t *res, uint8_t *err,
+        const uint8_t *in, int res_len)
+{
+#define GET_IN_(x, y) in[((x) + (y)) % (2*res_len)]
+
+    int errs = 0;
+    for (int i = 0; i < res_len; ++i) {
+        res[i] = GET_IN_(2*i, 2) ^ GET_IN_(2*i, 3);
+        err[i] = GET_IN_(2*i, 5) ^ GET_IN_(2*i, 6) ^ GET_IN_(2*i, 7);
+
+        // we have 2 solutions, if match set to 0, 1 othervise
+        err[i] ^= res[i];
+        errs += err[i];
+    }
+#undef GET_IN_
+
+    return errs;
+}
+
+static void unpack_bits(uint8_t *bits, const uint64_t *words, int nbits)
+{
+    for (int i = 0; i < nbits; ++i) {
+        bits[i] = (words[i / 64] >> (63 - i % 64)) & 1;
+    }
+}
+
 // the goal is just to make sure the function provides the same results
 // after refactorization
 static void test_frame_decode_data(void **state)
@@ -34,7 +98,9 @@ static void test_frame_decode_data(void **state)
         data_block_t res;
         memset(&res, 3, sizeof(res));
         data_block_decode_frame(&res, data, FRAME_NO_UNKNOWN, FRAME_TYPE_DATA);
-        assert_memory_equal(res_exp, res.data, sizeof(res_exp));
+        uint8_t res_bits[sizeof(res_exp)];
+        unpack_bits(res_bits, res.data, sizeof(res_exp));
+        assert_memory_equal(res_exp, res_bits, sizeof(res_exp));
         assert_int_equal(res.nerrs, 0);
     }
     {
@@ -61,7 +127,9 @@ static void test_frame_decode_data(void **state)
         data_block_t res;
         memset(&res, 3, sizeof(res));
         data_block_decode_frame(&res, data, FRAME_NO_UNKNOWN, FRAME_TYPE_DATA);
-        assert_memory_equal(res_exp, res.data, sizeof(res_exp));
+        uint8_t res_bits[sizeof(res_exp)];
+        unpack_bits(res_bits, res.data, sizeof(res_exp));
+        assert_memory_equal(res_exp, res_bits, sizeof(res_exp));
         assert_int_equal(res.nerrs, 0);
     }
     {
@@ -88,7 +156,9 @@ static void test_frame_decode_data(void **state)
         data_block_t res;
         memset(&res, 3, sizeof(res));
         data_block_decode_frame(&res, data, FRAME_NO_UNKNOWN, FRAME_TYPE_DATA);
-        assert_memory_equal(res_exp, res.data, sizeof(res_exp));
+        uint8_t res_bits[sizeof(res_exp)];
+        unpack_bits(res_bits, res.data, sizeof(res_exp));
+        assert_memory_equal(res_exp, res_bits, sizeof(res_exp));
         assert_int_equal(res.nerrs, 0);
     }
 }
@@ -122,10 +192,168 @@ static void test_mk_crc5(void **state)
     }
 }
 
+// packed decoder must give the same results as the bit by bit one
+static void test_decode_data_frame_packed(void **state)
+{
+    (void) state;   // unused
+
+    uint32_t r = 2468;
+    for (int n = 0; n < 2000; ++n) {
+        uint8_t data[152];
+        for (int i = 0; i < ARRAY_LEN(data); ++i) {
+            r = r * 1103515245 + 12345;
+            data[i] = (r >> 16) & 1;
+        }
+
+        uint8_t res_exp[126];
+        uint8_t err_exp[76];
+        memset(err_exp, 0, sizeof(err_exp));
+        int nerrs = decode_data_frame_bitwise(res_exp, err_exp, data, 26);
+
+        const frame_type_t fr_type = (n % 2) ? FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
+        int nbits;
+        if (fr_type == FRAME_TYPE_DATA) {
+            nerrs += decode_data_frame_bitwise(
+                    res_exp + 26, err_exp + 26, data + 2*26, 50);
+            nbits = 76;
+        } else {
+            memcpy(res_exp + 26, data + 2*26, 100);
+            nbits = 126;
+        }
+
+        data_block_t data_blk;
+        data_block_decode_frame(&data_blk, data, n, fr_type);
+        assert_int_equal(data_blk.fr_type, fr_type);
+        assert_int_equal(data_blk.nerrs, nerrs);
+        assert_int_equal(data_blk.frame_no, n);
+
+        uint8_t res[126];
+        uint8_t err[126];
+        unpack_bits(res, data_blk.data, 128 - 2);
+        unpack_bits(err, data_blk.err, 76);
+        assert_memory_equal(res, res_exp, nbits);
+        assert_memory_equal(err, err_exp, 76);
+        for (int i = nbits; i < 126; ++i) {
+            assert_int_equal(res[i], 0);
+        }
+        for (int i = 0; i < nbits; ++i) {
+            assert_int_equal(data_block_get_bit(&data_blk, i), res_exp[i]);
+        }
+        for (int pos = 0; pos < nbits; pos += 7) {
+            const int len = (nbits - pos < 64) ? nbits - pos : 64;
+            uint64_t v = 0;
+            for (int i = 0; i < len; ++i) {
+                v = (v << 1) | res_exp[pos + i];
+            }
+            assert_true(data_block_get_bits(&data_blk, pos, len) == v);
+        }
+    }
+}
+
+// packed CRC check must give the same results as the bit by bit one
+static bool check_crc_bitwise(const uint8_t *blk, frame_type_t fr_type)
+{
+    if (fr_type == FRAME_TYPE_HR_DATA) {
+        uint8_t crc[5];
+
+        mk_crc5(crc, blk, HR_DATA_BLOCK_CRC_POS);
+        return blk[0] == FRAME_TYPE_DATA &&
+            !memcmp(blk + HR_DATA_BLOCK_CRC_POS, crc, 5) &&
+            cmpzero(blk + HR_DATA_BLOCK_CRC_POS + 5,
+                    HR_DATA_BLOCK_LEN - HR_DATA_BLOCK_CRC_POS - 5);
+    }
+
+    if (fr_type == FRAME_TYPE_AUTO) {
+        fr_type = blk[0];
+    } else if (fr_type != blk[0]) {
+        return false;
+    }
+
+    if (fr_type == FRAME_TYPE_DATA) {
+        uint8_t crc[5];
+
+        mk_crc5(crc, blk, 69);
+        return !memcmp(blk + 69, crc, 5);
+    }
+
+    uint8_t crc[3];
+    const uint8_t ok[3] = {0, 1, 0}; // residue accounting for inverted CRC bits
+
+    // discriminator + 22 voice protected bits + 3 CRC bits
+    mk_crc3(crc, blk, 26);
+    return !memcmp(crc, ok, 3);
+}
+
+static void test_check_crc_packed(void **state)
+{
+    (void) state;   // unused
+
+    uint32_t r = 1357;
+    for (int n = 0; n < 4000; ++n) {
+        uint8_t blk[126];
+        for (int i = 0; i < ARRAY_LEN(blk); ++i) {
+            r = r * 1103515245 + 12345;
+            blk[i] = (r >> 16) & 1;
+        }
+        const frame_type_t type = blk[0];
+        // make every 2nd block valid, every 4th data block is high rate
+        if (n % 2) {
+            uint8_t crc[5];
+            if (type == FRAME_TYPE_DATA && n % 4 == 3) {
+                memset(blk + HR_DATA_BLOCK_CRC_POS + 5, 0,
+                        HR_DATA_BLOCK_LEN - HR_DATA_BLOCK_CRC_POS - 5);
+                mk_crc5(crc, blk, HR_DATA_BLOCK_CRC_POS);
+                memcpy(blk + HR_DATA_BLOCK_CRC_POS, crc, 5);
+            } else if (type == FRAME_TYPE_DATA) {
+                mk_crc5(crc, blk, 69);
+                memcpy(blk + 69, crc, 5);
+            } else {
+                for (int i = 0; i < 8; ++i) {
+                    blk[23] = i & 1;
+                    blk[24] = (i >> 1) & 1;
+                    blk[25] = (i >> 2) & 1;
+                    mk_crc3(crc, blk, 26);
+                    if (!crc[0] && crc[1] && !crc[2]) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        data_block_t data_blk;
+        data_blk.data[0] = data_blk.data[1] = 0;
+        for (int i = 0; i < ARRAY_LEN(blk); ++i) {
+            data_blk.data[i / 64] |= (uint64_t)blk[i] << (63 - i % 64);
+        }
+
+        const frame_type_t fr_types[] = {
+            FRAME_TYPE_AUTO, FRAME_TYPE_DATA, FRAME_TYPE_VOICE,
+            FRAME_TYPE_HR_DATA,
+        };
+        for (int i = 0; i < ARRAY_LEN(fr_types); ++i) {
+            const bool ok = check_crc_bitwise(blk, fr_types[i]);
+            assert_int_equal(ok,
+                    data_block_check_crc_packed(data_blk.data, fr_types[i]));
+            data_blk.fr_type = fr_types[i];
+            assert_int_equal(ok, data_block_check_crc(&data_blk));
+            if (n % 4 == 3 && type == FRAME_TYPE_DATA) {
+                if (fr_types[i] == FRAME_TYPE_HR_DATA) {
+                    assert_true(ok);
+                }
+            } else if (n % 2 && fr_types[i] == FRAME_TYPE_AUTO) {
+                assert_true(ok);
+                assert_int_equal(data_blk.fr_type, type);
+            }
+        }
+    }
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_frame_decode_data),
+        unit_test(test_decode_data_frame_packed),
+        unit_test(test_check_crc_packed),
         unit_test(test_mk_crc5),
     };
 
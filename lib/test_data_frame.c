@@ -6,42 +6,167 @@
 // include, we are testing static methods
 #include "data_frame.c"
 
-static void test_pack_bits(void **state)
+// pack one bit per byte into integer, first bit is MSB
+static uint64_t mk_bits(const uint8_t *data, int nbits)
 {
-    {
-        const uint8_t data[] = {
-            1, 1, 0, 1,  0, 1, 0, 0,  0, 1, 1, 0,  1, 0, 1, 0,
-        };
-        const uint8_t res_exp[] = { 0x2b, 0x56, };
-
-        uint8_t res[2];
-        memset(res, 0, sizeof(res));
-        pack_bits(res, data, 0, sizeof(data));
-        assert_memory_equal(res_exp, res, sizeof(res_exp));
-    }
-
-    {
-        const uint8_t data1[] = {
-            1, 1, 0, 1,  0, 1, 0, 0,  0, 1, 1, 0,
-        };
-        const uint8_t data2[] = {
-            1, 0, 1, 0,
-            1, 0, 0, 1,  1, 1, 0, 1,  1, 0, 1, 0,  0, 0, 1, 1,
-        };
-        const uint8_t res_exp[] = { 0x2b, 0x56, 0xb9, 0xc5, };
-
-        uint8_t res[4];
-        memset(res, 0, sizeof(res));
-        pack_bits(res, data1, 0, sizeof(data1));
-        pack_bits(res, data2, sizeof(data1), sizeof(data2));
-        assert_memory_equal(res_exp, res, sizeof(res_exp));
+    uint64_t r = 0;
+    for (int i = 0; i < nbits; ++i) {
+        r = (r << 1) | data[i];
     }
+
+    return r;
+}
+
+static void test_pack_block(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t data[] = {
+        1, 1, 0, 1,  0, 1, 0, 0,  0, 1, 1, 0,  1, 0, 1, 0,
+        1, 0, 0, 1,  1, 1, 0, 1,  1, 0, 1, 0,  0, 0, 1, 1,
+    };
+    const uint8_t res_exp[8] = { 0x2b, 0x56, 0xb9, 0xc5, };
+
+    // data bits start after frame type and FN bits
+    const uint64_t bits = mk_bits(data, sizeof(data)) << 32;
+    const uint64_t blk[2] = { bits >> 3, bits << 61, };
+
+    data_frame_t *data_fr = data_frame_create();
+    assert_non_null(data_fr);
+    memset(data_fr->bytes, 0xff, sizeof(data_fr->bytes));
+    pack_block(data_fr, blk, 1);
+    assert_memory_equal(&data_fr->bytes[8], res_exp, sizeof(res_exp));
+    assert_int_equal(data_fr->bytes[7], 0xff);
+    assert_int_equal(data_fr->bytes[16], 0xff);
+    data_frame_destroy(data_fr);
+}
+
+static void set_bits(data_block_t *data_blk, uint64_t bits, int pos, int len)
+{
+    for (int i = 0; i < len; ++i) {
+        const int j = pos + i;
+        const uint64_t mask = 1ULL << (63 - j % 64);
+        data_blk->data[j / 64] &= ~mask;
+        if ((bits >> (len - 1 - i)) & 1) {
+            data_blk->data[j / 64] |= mask;
+        }
+    }
+}
+
+// set FN and payload (bits 3-66) of data block and find valid CRC
+static void mk_block(data_block_t *data_blk, int fn, uint64_t payload)
+{
+    memset(data_blk, 0, sizeof(*data_blk));
+    data_blk->fr_type = FRAME_TYPE_DATA;
+    data_blk->frame_no = FRAME_NO_UNKNOWN;
+    set_bits(data_blk, FRAME_TYPE_DATA, 0, 1);
+    set_bits(data_blk, ((fn & 1) << 1) | (fn >> 1), 1, 2);
+    set_bits(data_blk, payload, 3, 64);
+    for (int crc = 0; crc < 32; ++crc) {
+        set_bits(data_blk, crc, 69, 5);
+        if (data_block_check_crc(data_blk)) {
+            return;
+        }
+    }
+    fail();
+}
+
+static void test_multiblock(void **state)
+{
+    (void) state;   // unused
+
+    // 4 blocks followed by parity block
+    const uint64_t payload[] = {
+        0x0123456789abcdefULL, 0xfedcba9876543210ULL,
+        0x5555aaaa3333ccccULL, 0x0f0f0f0ff0f0f0f0ULL,
+    };
+    const int fns[] = { FN_01, FN_10, FN_11, FN_10, FN_01, };
+    const int nblks = ARRAY_LEN(fns);
+    data_block_t blks[ARRAY_LEN(fns)];
+    uint64_t parity = 0;
+    for (int i = 0; i < nblks - 1; ++i) {
+        mk_block(&blks[i], fns[i], payload[i]);
+        parity ^= payload[i];
+    }
+    mk_block(&blks[nblks - 1], fns[nblks - 1], parity);
+
+    // TETRAPOL bit order, first bit is LSB
+    uint8_t exp[8 * ARRAY_LEN(payload)] = { 0, };
+    for (int i = 0; i < 64 * ARRAY_LEN(payload); ++i) {
+        exp[i / 8] |= ((payload[i / 64] >> (63 - i % 64)) & 1) << (i % 8);
+    }
+
+    data_frame_t *data_fr = data_frame_create();
+    assert_non_null(data_fr);
+
+    // correct frame, parity is checked
+    for (int i = 0; i < nblks; ++i) {
+        assert_int_equal(data_frame_push_data_block(data_fr, &blks[i]),
+                i == nblks - 1);
+    }
+    const uint8_t *data;
+    assert_int_equal(data_frame_get_bytes(data_fr, &data), 8 * sizeof(exp));
+    assert_memory_equal(data, exp, sizeof(exp));
+
+    // single broken block is repaired from parity block
+    for (int i = 0; i < nblks; ++i) {
+        data_block_t blk = blks[i];
+        if (i == 1) {
+            blk.data[0] ^= 0x00ff00ff00ff00ffULL;
+            blk.nerrs = 3;
+        }
+        assert_int_equal(data_frame_push_data_block(data_fr, &blk),
+                i == nblks - 1);
+    }
+    assert_int_equal(data_frame_get_bytes(data_fr, &data), 8 * sizeof(exp));
+    assert_memory_equal(data, exp, sizeof(exp));
+
+    // parity mismatch
+    for (int i = 0; i < nblks; ++i) {
+        data_block_t blk = blks[i];
+        if (i == 2) {
+            mk_block(&blk, fns[i], payload[i] ^ 1);
+        }
+        assert_false(data_frame_push_data_block(data_fr, &blk));
+    }
+
+    data_frame_stats_t stats;
+    data_frame_get_stats(data_fr, &stats);
+    assert_int_equal(stats.blocks, 3 * nblks);
+    assert_int_equal(stats.crc_errs, 1);
+    assert_int_equal(stats.frames, 2);
+    assert_int_equal(stats.parity_fixes, 1);
+    assert_int_equal(stats.parity_errs, 1);
+
+    // FN 01 after unfinished multiblock frame starts a new frame, for
+    // parity mismatch and for invalid sequence
+    const int garbage_fns[][4] = {
+        { FN_01, FN_10, FN_10, -1, },
+        { FN_01, FN_10, FN_11, FN_11, },
+    };
+    for (int g = 0; g < ARRAY_LEN(garbage_fns); ++g) {
+        data_frame_reset(data_fr);
+        for (int i = 0; i < 4 && garbage_fns[g][i] >= 0; ++i) {
+            data_block_t blk;
+            mk_block(&blk, garbage_fns[g][i], 0x1111111111111111ULL * (i + 1));
+            assert_false(data_frame_push_data_block(data_fr, &blk));
+        }
+        for (int i = 0; i < nblks; ++i) {
+            assert_int_equal(data_frame_push_data_block(data_fr, &blks[i]),
+                    i == nblks - 1);
+        }
+        assert_int_equal(data_frame_get_bytes(data_fr, &data), 8 * sizeof(exp));
+        assert_memory_equal(data, exp, sizeof(exp));
+    }
+
+    data_frame_destroy(data_fr);
 }
 
 int main(void)
 {
     const UnitTest tests[] = {
-        unit_test(test_pack_bits),
+        unit_test(test_pack_block),
+        unit_test(test_multiblock),
     };
 
     return run_tests(tests);
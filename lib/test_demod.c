@@ -0,0 +1,177 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "demod.c"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define NBITS 2000
+#define NSAMPLES (NBITS * DEMOD_SAMPLES_PER_SYMBOL)
+
+static uint8_t tx_bits[NBITS];
+static float iq[2 * NSAMPLES];
+
+/**
+  Generate MSK signal (GMSK without Gaussian filter) for random bits.
+
+  @param f_offs Frequency offset (Hz).
+  */
+static void mk_signal(float amp, float f_offs)
+{
+    uint32_t r = 4242;
+    double phase = 0.3;
+    for (int k = 0; k < NBITS; ++k) {
+        r = r * 1103515245 + 12345;
+        tx_bits[k] = (r >> 16) & 1;
+        for (int j = 0; j < DEMOD_SAMPLES_PER_SYMBOL; ++j) {
+            const int n = k * DEMOD_SAMPLES_PER_SYMBOL + j;
+            phase += (tx_bits[k] ? PI_F : -PI_F) / 2 / DEMOD_SAMPLES_PER_SYMBOL +
+                2 * PI_F * f_offs / DEMOD_SAMPLE_RATE;
+            iq[2 * n] = amp * cos(phase);
+            iq[2 * n + 1] = amp * sin(phase);
+        }
+    }
+}
+
+/// Number of bits which differ from transmitted, best alignment is used.
+static int count_errs(const uint8_t *bits, int nbits)
+{
+    // skip clock recovery convergence
+    const int skip = 50;
+    int best = NBITS;
+    for (int d = -4; d <= 4; ++d) {
+        int nerrs = 0;
+        for (int k = skip; k < NBITS - skip; ++k) {
+            if (k + d >= nbits || bits[k + d] != tx_bits[k]) {
+                ++nerrs;
+            }
+        }
+        best = (nerrs < best) ? nerrs : best;
+    }
+
+    return best;
+}
+
+static void test_atan2(void **state)
+{
+    (void) state;   // unused
+
+    float max_err = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const float a = 2 * PI_F * i / 1000 - PI_F + 1e-3;
+        const lanes_t y = { sinf(a), -sinf(a), 5 * sinf(a), 0, };
+        const lanes_t x = { cosf(a), cosf(a), 5 * cosf(a), cosf(a), };
+        const lanes_t r = lanes_atan2(y, x);
+        for (int l = 0; l < NLANES; ++l) {
+            const float err = fabsf(r[l] - atan2f(y[l], x[l]));
+            max_err = (err > max_err) ? err : max_err;
+        }
+    }
+    assert_true(max_err < 3e-4);
+
+    const lanes_t zero = { 0, 0, 0, 0, };
+    const lanes_t r = lanes_atan2(zero, zero);
+    assert_true(r[0] == 0 && r[3] == 0);
+}
+
+static void test_demod_cf32(void **state)
+{
+    (void) state;   // unused
+
+    static uint8_t bits[DEMOD_BITS_MAX(NSAMPLES)];
+    mk_signal(0.5, 150);
+
+    demod_t *demod = demod_create(DEMOD_INPUT_CF32);
+    assert_non_null(demod);
+    const int nbits = demod_process(demod, iq, NSAMPLES, bits);
+    assert_true(abs(nbits - NBITS) <= 2);
+    assert_int_equal(count_errs(bits, nbits), 0);
+    demod_destroy(demod);
+
+    assert_null(demod_create(7));
+}
+
+// state is kept between calls, output does not depend on input chunking
+static void test_demod_chunks(void **state)
+{
+    (void) state;   // unused
+
+    static uint8_t bits[DEMOD_BITS_MAX(NSAMPLES)];
+    static uint8_t bits_chunks[DEMOD_BITS_MAX(NSAMPLES)];
+    mk_signal(1000, -200);
+    static int16_t iq16[2 * NSAMPLES];
+    for (int i = 0; i < 2 * NSAMPLES; ++i) {
+        iq16[i] = lrintf(iq[i]);
+    }
+
+    demod_t *demod = demod_create(DEMOD_INPUT_CS16);
+    assert_non_null(demod);
+    assert_int_equal(demod_sample_size(demod), 4);
+    const int nbits = demod_process(demod, iq16, NSAMPLES, bits);
+    assert_int_equal(count_errs(bits, nbits), 0);
+    demod_destroy(demod);
+
+    demod = demod_create(DEMOD_INPUT_CS16);
+    assert_non_null(demod);
+    int nbits_chunks = 0;
+    for (int pos = 0, len = 1; pos < NSAMPLES; pos += len, len = len * 3 % 601) {
+        len = (pos + len > NSAMPLES) ? NSAMPLES - pos : len;
+        nbits_chunks += demod_process(demod, &iq16[2 * pos], len,
+                &bits_chunks[nbits_chunks]);
+    }
+    demod_destroy(demod);
+    assert_int_equal(nbits_chunks, nbits);
+    assert_memory_equal(bits_chunks, bits, nbits);
+}
+
+static void test_freq_offset(void **state)
+{
+    (void) state;   // unused
+
+    static uint8_t bits[DEMOD_BITS_MAX(NSAMPLES)];
+    mk_signal(0.5, 300);
+
+    demod_t *demod = demod_create(DEMOD_INPUT_CF32);
+    assert_non_null(demod);
+    demod_process(demod, iq, NSAMPLES, bits);
+    assert_true(fabsf(demod_get_freq_offset(demod) - 300) < 20);
+    assert_true(fabsf(demod_get_power(demod) + 6.02f) < 0.1f);
+
+    // estimate includes correction, bits are not affected by the offset
+    demod_set_freq_correction(demod, 250);
+    assert_true(demod_get_freq_correction(demod) == 250);
+    const int nbits = demod_process(demod, iq, NSAMPLES, bits);
+    assert_int_equal(count_errs(bits, nbits), 0);
+    assert_true(fabsf(demod_get_freq_offset(demod) - 300) < 20);
+    assert_true(fabsf(demod->freq_err * FM_DEV - 50) < 20);
+    demod_destroy(demod);
+
+    // full scale of CS16 is 32768
+    mk_signal(1000, -200);
+    static int16_t iq16[2 * NSAMPLES];
+    for (int i = 0; i < 2 * NSAMPLES; ++i) {
+        iq16[i] = lrintf(iq[i]);
+    }
+    demod = demod_create(DEMOD_INPUT_CS16);
+    assert_non_null(demod);
+    demod_process(demod, iq16, NSAMPLES, bits);
+    assert_true(fabsf(demod_get_freq_offset(demod) + 200) < 20);
+    assert_true(fabsf(demod_get_power(demod) + 30.31f) < 0.1f);
+    demod_destroy(demod);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_atan2),
+        unit_test(test_demod_cf32),
+        unit_test(test_demod_chunks),
+        unit_test(test_freq_offset),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,67 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "dup_cache.c"
+
+static void test_lookup(void **state)
+{
+    (void) state;   // unused
+
+    dup_cache_t dc;
+    dup_cache_init(&dc);
+
+    uint8_t data[DUP_CACHE_ENTRIES + 1][32];
+    for (int i = 0; i < ARRAY_LEN(data); ++i) {
+        memset(data[i], 0x55, sizeof(data[i]));
+        data[i][7] = i;
+    }
+    assert_true(payload_hash(data[0], 31) != payload_hash(data[0], 32));
+    assert_true(payload_hash(data[0], 32) != payload_hash(data[1], 32));
+
+    // payload is cached only when inserted after lookup
+    assert_null(dup_cache_lookup(&dc, data[0], sizeof(data[0])));
+    assert_null(dup_cache_lookup(&dc, data[0], sizeof(data[0])));
+    dup_cache_insert(&dc, 1);
+    dup_cache_entry_t *e = dup_cache_lookup(&dc, data[0], sizeof(data[0]));
+    assert_non_null(e);
+    assert_int_equal(e->repeats, 1);
+    assert_int_equal(e->tag, 1);
+    assert_true(e == dup_cache_lookup(&dc, data[0], sizeof(data[0])));
+    assert_int_equal(e->repeats, 2);
+
+    // alternating payloads (as D_SYSTEM_INFO) hit both
+    assert_null(dup_cache_lookup(&dc, data[1], sizeof(data[1])));
+    dup_cache_insert(&dc, 2);
+    for (int i = 0; i < 3; ++i) {
+        e = dup_cache_lookup(&dc, data[0], sizeof(data[0]));
+        assert_non_null(e);
+        assert_int_equal(e->tag, 1);
+        e = dup_cache_lookup(&dc, data[1], sizeof(data[1]));
+        assert_non_null(e);
+        assert_int_equal(e->tag, 2);
+    }
+
+    // the least recently seen payload is replaced
+    for (int i = 2; i < ARRAY_LEN(data); ++i) {
+        assert_null(dup_cache_lookup(&dc, data[i], sizeof(data[i])));
+        dup_cache_insert(&dc, i + 1);
+    }
+    assert_null(dup_cache_lookup(&dc, data[0], sizeof(data[0])));
+    for (int i = 1; i < ARRAY_LEN(data); ++i) {
+        e = dup_cache_lookup(&dc, data[i], sizeof(data[i]));
+        assert_non_null(e);
+        assert_int_equal(e->tag, i + 1);
+    }
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_lookup),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "event.c"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static const uint8_t group_list[] = {
+    D_GROUP_LIST,
+    0x20,               // REFERENCE_LIST revision 1
+    0x00,               // INDEX_LIST
+    0x82,               // 2x EMERGENCY
+    0x05, 0x60, 0x06, 0x70,
+    0xc1,               // 1x OPEN
+    0x12, 0x34, 0x56, 0x00, 0x78,
+    0x41,               // 1x TALK_GROUP
+    0x9a, 0x00, 0x0b, 0xcd,
+    0x00,               // END
+};
+
+static void test_tsdu_serialize(void **state)
+{
+    (void) state;   // unused
+
+    arena_t *arena = arena_create(256);
+    assert_non_null(arena);
+    tsdu_t *tsdu = tsdu_d_decode(arena, group_list, 8 * sizeof(group_list), 1, 2);
+    assert_non_null(tsdu);
+
+    const uint8_t exp[] = {
+        25, 0,              // len
+        EVENT_TYPE_TSDU,
+        D_GROUP_LIST, 1, 2, 1,
+        2, 5, 6, 6, 7,      // emergency
+        1, 0x9a, 0xcd, 0x0b, // talk group
+        1, 0x12, 3, 0x56, 0x04, 0, 0, 0x78, 0x00,   // open
+        0x20, 0x00,         // reference_list, index_list
+    };
+    uint8_t buf[64];
+    assert_int_equal(event_tsdu_serialize(tsdu, buf, sizeof(buf)), sizeof(exp));
+    assert_memory_equal(buf, exp, sizeof(exp));
+
+    // too small buffer
+    assert_int_equal(event_tsdu_serialize(tsdu, buf, sizeof(exp) - 1), -1);
+
+    arena_destroy(arena);
+}
+
+static void test_writer(void **state)
+{
+    (void) state;   // unused
+
+    const int nrecs = 6000;
+
+    FILE *f = tmpfile();
+    assert_non_null(f);
+
+    arena_t *arena = arena_create(256);
+    assert_non_null(arena);
+    tsdu_t *tsdu = tsdu_d_decode(arena, group_list, 8 * sizeof(group_list), 1, 2);
+    assert_non_null(tsdu);
+
+    event_writer_t *ew = event_writer_create(fileno(f));
+    assert_non_null(ew);
+    // more records than fits into all chunks
+    for (int i = 0; i < nrecs; ++i) {
+        tsdu->prio = i % 256;
+        assert_int_equal(event_write_tsdu(ew, tsdu), 0);
+    }
+    assert_true(lseek(fileno(f), 0, SEEK_CUR) > 0);
+    event_writer_destroy(ew);
+
+    const long size = lseek(fileno(f), 0, SEEK_CUR);
+    assert_int_equal(size, nrecs * 27);
+    uint8_t *data = malloc(size);
+    assert_non_null(data);
+    assert_int_equal(pread(fileno(f), data, size, 0), size);
+    for (int i = 0; i < nrecs; ++i) {
+        const uint8_t *rec = &data[i * 27];
+        assert_int_equal(rec[0] | (rec[1] << 8), 25);
+        assert_int_equal(rec[2], EVENT_TYPE_TSDU);
+        assert_int_equal(rec[3], D_GROUP_LIST);
+        assert_int_equal(rec[4], i % 256);
+    }
+
+    free(data);
+    arena_destroy(arena);
+    fclose(f);
+}
+
+static void test_writer_voice(void **state)
+{
+    (void) state;   // unused
+
+    FILE *f = tmpfile();
+    assert_non_null(f);
+    event_writer_t *ew = event_writer_create(fileno(f));
+    assert_non_null(ew);
+
+    const uint64_t data[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL, };
+    assert_int_equal(event_write_voice(ew, 0x0102030405060708LL, -1, true, data), 0);
+    assert_int_equal(event_writer_flush(ew), 0);
+    event_writer_destroy(ew);
+
+    const uint8_t exp[] = {
+        28, 0,
+        EVENT_TYPE_VOICE,
+        0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,
+        0xff, 0xff,
+        1,
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+    };
+    uint8_t buf[64];
+    assert_int_equal(pread(fileno(f), buf, sizeof(buf), 0), sizeof(exp));
+    assert_memory_equal(buf, exp, sizeof(exp));
+
+    fclose(f);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_tsdu_serialize),
+        unit_test(test_writer),
+        unit_test(test_writer_voice),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "event_ring.c"
+
+#include <stdio.h>
+
+#define RING_SIZE (4 * EVENT_REC_MAX)
+
+static void ring_name(char *name, int len)
+{
+    snprintf(name, len, "/tetrapol_test_%d", (int)getpid());
+}
+
+// record of unknown type, payload is derived from n
+static int mk_rec(uint8_t *rec, int n)
+{
+    const int len = 3 + (n * 37) % 300;
+    rec[0] = len - 2;
+    rec[1] = (len - 2) >> 8;
+    rec[2] = 0x80;
+    for (int i = 3; i < len; ++i) {
+        rec[i] = n + i;
+    }
+
+    return len;
+}
+
+static void test_put_read(void **state)
+{
+    (void) state;   // unused
+
+    char name[64];
+    ring_name(name, sizeof(name));
+    assert_null(event_ring_create(name, RING_SIZE - 1));
+    event_ring_t *ring = event_ring_create(name, RING_SIZE);
+    assert_non_null(ring);
+    event_ring_reader_t *reader = event_ring_reader_open(name);
+    assert_non_null(reader);
+
+    uint8_t buf[EVENT_REC_MAX];
+    assert_int_equal(0, event_ring_read(reader, buf, sizeof(buf)));
+
+    // the same record as written by event writer
+    const uint64_t data[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL, };
+    uint8_t exp[EVENT_VOICE_REC_LEN];
+    assert_int_equal(EVENT_VOICE_REC_LEN, event_voice_serialize(
+                0x0102030405060708LL, -1, true, data, exp, sizeof(exp)));
+    assert_int_equal(0, event_ring_write_voice(ring, 0x0102030405060708LL,
+                -1, true, data));
+    assert_int_equal(EVENT_VOICE_REC_LEN,
+            event_ring_read(reader, buf, sizeof(buf)));
+    assert_memory_equal(buf, exp, sizeof(exp));
+    assert_int_equal(0, event_ring_read(reader, buf, sizeof(buf)));
+
+    // inconsistent length
+    exp[0] ^= 1;
+    assert_int_equal(-1, event_ring_put(ring, exp, sizeof(exp)));
+
+    // too small buffer, record is not consumed
+    uint8_t rec[EVENT_REC_MAX];
+    const int len = mk_rec(rec, 7);
+    assert_int_equal(0, event_ring_put(ring, rec, len));
+    assert_int_equal(-1, event_ring_read(reader, buf, len - 1));
+    assert_int_equal(len, event_ring_read(reader, buf, sizeof(buf)));
+    assert_memory_equal(buf, rec, len);
+
+    // records wrap around the end of ring
+    for (int n = 0; n < 1000; ++n) {
+        const int len = mk_rec(rec, n);
+        assert_int_equal(0, event_ring_put(ring, rec, len));
+        if (n % 3) {
+            continue;
+        }
+        for (int m = n - 2; m <= n; ++m) {
+            if (m < 0) {
+                continue;
+            }
+            const int len = mk_rec(rec, m);
+            assert_int_equal(len, event_ring_read(reader, buf, sizeof(buf)));
+            assert_memory_equal(buf, rec, len);
+        }
+        assert_int_equal(0, event_ring_read(reader, buf, sizeof(buf)));
+    }
+    assert_true(ring->tail > 4 * RING_SIZE);
+    assert_true(event_ring_reader_lost(reader) == 0);
+
+    event_ring_reader_close(reader);
+    event_ring_destroy(ring);
+    assert_null(event_ring_reader_open(name));
+}
+
+// producer does not wait for slow consumer, consumer detects overrun
+static void test_overrun(void **state)
+{
+    (void) state;   // unused
+
+    char name[64];
+    ring_name(name, sizeof(name));
+    event_ring_t *ring = event_ring_create(name, RING_SIZE);
+    assert_non_null(ring);
+    event_ring_reader_t *fast = event_ring_reader_open(name);
+    assert_non_null(fast);
+    event_ring_reader_t *slow = event_ring_reader_open(name);
+    assert_non_null(slow);
+
+    uint8_t rec[EVENT_REC_MAX];
+    uint8_t buf[EVENT_REC_MAX];
+    int n = 0;
+    while (ring->tail < 2 * RING_SIZE) {
+        const int len = mk_rec(rec, n++);
+        assert_int_equal(0, event_ring_put(ring, rec, len));
+        assert_int_equal(len, event_ring_read(fast, buf, sizeof(buf)));
+        assert_memory_equal(buf, rec, len);
+    }
+
+    assert_int_equal(EVENT_RING_OVERRUN, event_ring_read(slow, buf, sizeof(buf)));
+    assert_true(event_ring_reader_lost(slow) == ring->tail);
+    assert_int_equal(0, event_ring_read(slow, buf, sizeof(buf)));
+    const int len = mk_rec(rec, n);
+    assert_int_equal(0, event_ring_put(ring, rec, len));
+    assert_int_equal(len, event_ring_read(slow, buf, sizeof(buf)));
+    assert_memory_equal(buf, rec, len);
+    assert_true(event_ring_reader_lost(fast) == 0);
+
+    // record is being overwritten while reader copies it
+    for (int i = 0; i < RING_SIZE / 64; ++i) {
+        assert_int_equal(0, event_ring_put(ring, rec, len));
+    }
+    const uint64_t cursor = slow->cursor;
+    atomic_store(&ring->shm->tail_intent, cursor + RING_SIZE + 8);
+    atomic_store(&ring->shm->tail, cursor + RING_SIZE - 8);
+    assert_int_equal(EVENT_RING_OVERRUN, event_ring_read(slow, buf, sizeof(buf)));
+
+    event_ring_reader_close(slow);
+    event_ring_reader_close(fast);
+    event_ring_destroy(ring);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_put_read),
+        unit_test(test_overrun),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,141 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "ingest.c"
+
+#include <string.h>
+
+static void test_hdr(void **state)
+{
+    (void) state;   // unused
+
+    const ingest_hdr_t hdr = {
+        .ch_id = 0x1234,
+        .len = 4,
+        .seq = 0xfedcba98,
+        .timestamp = 0x0102030405060708LL,
+    };
+    uint8_t buf[INGEST_HDR_LEN + 4];
+    ingest_hdr_write(&hdr, buf);
+    const uint8_t exp[INGEST_HDR_LEN] = {
+        'T', 'P', INGEST_VERSION, 0,
+        0x12, 0x34,
+        0x00, 0x04,
+        0xfe, 0xdc, 0xba, 0x98,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+    };
+    assert_memory_equal(buf, exp, sizeof(exp));
+
+    ingest_hdr_t h;
+    assert_int_equal(0, ingest_hdr_parse(&h, buf, sizeof(buf)));
+    assert_int_equal(h.ch_id, hdr.ch_id);
+    assert_int_equal(h.len, hdr.len);
+    assert_true(h.seq == hdr.seq);
+    assert_true(h.timestamp == hdr.timestamp);
+
+    // length mismatch
+    assert_int_equal(-1, ingest_hdr_parse(&h, buf, sizeof(buf) - 1));
+    assert_int_equal(-1, ingest_hdr_parse(&h, buf, INGEST_HDR_LEN - 1));
+
+    uint8_t bad[sizeof(buf)];
+    for (int i = 0; i < 4; ++i) {
+        memcpy(bad, buf, sizeof(bad));
+        bad[i] ^= 0x01;
+        assert_int_equal(-1, ingest_hdr_parse(&h, bad, sizeof(bad)));
+    }
+}
+
+static void test_seq(void **state)
+{
+    (void) state;   // unused
+
+    ingest_seq_t seq = { .started = false, };
+
+    assert_int_equal(0, ingest_seq_check(&seq, 0xfffffffd));
+    assert_int_equal(0, ingest_seq_check(&seq, 0xfffffffe));
+    // gap over wrap of sequence number
+    assert_int_equal(2, ingest_seq_check(&seq, 1));
+    assert_int_equal(0, ingest_seq_check(&seq, 2));
+    // duplicated and reordered datagrams are dropped
+    assert_int_equal(-1, ingest_seq_check(&seq, 2));
+    assert_int_equal(-1, ingest_seq_check(&seq, 0xffffffff));
+    assert_int_equal(0, ingest_seq_check(&seq, 3));
+}
+
+static void test_feedback(void **state)
+{
+    (void) state;   // unused
+
+    const ingest_feedback_t fb = {
+        .ch_id = 0x1234,
+        .flags = INGEST_FEEDBACK_SYNC | INGEST_FEEDBACK_FREQ,
+        .seq = 7,
+        .timestamp = 0x0102030405060708LL,
+        .sync_errs = 0.25,
+        .nerrs = 1.5,
+        .crc_errs = 0.125,
+        .power = -32.5,
+        .freq_offset = -312.25,
+    };
+    uint8_t buf[INGEST_FEEDBACK_LEN];
+    ingest_feedback_write(&fb, buf);
+    const uint8_t exp[INGEST_FEEDBACK_LEN] = {
+        'T', 'F', INGEST_VERSION, 0x03,
+        0x12, 0x34,
+        0x00, 0x00,
+        0x00, 0x00, 0x00, 0x07,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x00, 0xfa,
+        0x05, 0xdc,
+        0x04, 0xe2,
+        0xf3, 0x4e,
+        0xff, 0xfb, 0x3c, 0x46,
+    };
+    assert_memory_equal(buf, exp, sizeof(exp));
+
+    ingest_feedback_t f;
+    assert_int_equal(0, ingest_feedback_parse(&f, buf, sizeof(buf)));
+    assert_int_equal(f.ch_id, fb.ch_id);
+    assert_int_equal(f.flags, fb.flags);
+    assert_true(f.seq == fb.seq);
+    assert_true(f.timestamp == fb.timestamp);
+    assert_true(f.sync_errs == fb.sync_errs);
+    assert_true(f.nerrs == fb.nerrs);
+    assert_true(f.crc_errs == fb.crc_errs);
+    assert_true(f.power == fb.power);
+    assert_true(f.freq_offset == fb.freq_offset);
+
+    assert_int_equal(-1, ingest_feedback_parse(&f, buf, sizeof(buf) - 1));
+    uint8_t bad[sizeof(buf)];
+    const int fields[] = { 0, 1, 2, 6, 7, };
+    for (int i = 0; i < 5; ++i) {
+        memcpy(bad, buf, sizeof(bad));
+        bad[fields[i]] ^= 0x01;
+        assert_int_equal(-1, ingest_feedback_parse(&f, bad, sizeof(bad)));
+    }
+
+    // values out of range are saturated
+    ingest_feedback_t sat = fb;
+    sat.nerrs = 1e6;
+    sat.crc_errs = -1;
+    sat.power = -1e6;
+    ingest_feedback_write(&sat, buf);
+    assert_int_equal(0, ingest_feedback_parse(&f, buf, sizeof(buf)));
+    assert_true(f.nerrs == UINT16_MAX / 1000.0f);
+    assert_true(f.crc_errs == 0);
+    assert_true(f.power == INT16_MIN / 100.0f);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_hdr),
+        unit_test(test_seq),
+        unit_test(test_feedback),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// debug messages must be eliminated at compile time
+#define LOG_MIN_LVL INFO
+
+// include, we are testing static methods
+#include "log.c"
+
+static int ncalls;
+
+static int count_call(void)
+{
+    return ++ncalls;
+}
+
+static void test_min_lvl(void **state)
+{
+    (void) state;   // unused
+
+    char buf[64] = { 0, };
+    log_stream = fmemopen(buf, sizeof(buf), "w");
+    assert_non_null(log_stream);
+    log_set_lvl(DBG);
+
+    ncalls = 0;
+    LOG(DBG, "%d", count_call());
+    IF_LOG(DBG) {
+        count_call();
+    }
+    LOG(INFO, "%d", count_call());
+    fclose(log_stream);
+    log_stream = NULL;
+    log_set_lvl(INFO);
+
+    assert_int_equal(ncalls, 1);
+    assert_true(strstr(buf, " 1\n") != NULL);
+}
+
+static void *log_from_thread(void *arg)
+{
+    log_stream = arg;
+    log_printf("%s", "thread ");
+
+    return NULL;
+}
+
+static void log_messages(FILE *f)
+{
+    log_stream = f;
+    char s[8] = "str";
+    log_printf("%d %03x %ld %lld %zu %c %%", -1, 0xab, -2L, 1LL << 40,
+            (size_t)3, 'c');
+    log_printf(" %s|%-5s|%.2s ", s, "ab", "xyz");
+    // string argument is copied
+    strcpy(s, "bad");
+    // fixed pointer, output into two streams is compared
+    log_printf("%.1f %p %s\n", 0.25, (void *)0x1234, (char *)NULL);
+    // not supported by records, preformatted
+    log_printf("%*d %d %d %d %d %d %d %d %d\n", 3, 0, 1, 2, 3, 4, 5, 6, 7, 8);
+    log_printf("no args\n");
+
+    // order is kept for messages from more threads into same stream
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, log_from_thread, f), 0);
+    pthread_join(thread, NULL);
+    log_printf("main\n");
+    log_stream = NULL;
+}
+
+static void test_async(void **state)
+{
+    (void) state;   // unused
+
+    char buf[1024] = { 0, };
+    char exp[1024] = { 0, };
+    FILE *f_exp = fmemopen(exp, sizeof(exp) - 1, "w");
+    assert_non_null(f_exp);
+    log_messages(f_exp);
+    fclose(f_exp);
+
+    FILE *f = fmemopen(buf, sizeof(buf) - 1, "w");
+    assert_non_null(f);
+    assert_int_equal(log_async_start(), 0);
+    log_messages(f);
+    log_async_flush();
+    assert_int_equal(atomic_load(&async.nwritten), atomic_load(&async.seq));
+    log_async_stop();
+    fclose(f);
+
+    assert_true(strstr(exp, " str|ab   |xy ") != NULL);
+    assert_true(strstr(exp, "(null)\n  0 1 2") != NULL);
+    assert_true(strstr(exp, "thread main\n") != NULL);
+    assert_int_equal(strlen(buf), strlen(exp));
+    assert_memory_equal(buf, exp, strlen(exp));
+}
+
+static void test_drop(void **state)
+{
+    (void) state;   // unused
+
+    FILE *f = fopen("/dev/null", "w");
+    assert_non_null(f);
+    log_stream = f;
+
+    assert_int_equal(log_async_start(), 0);
+    for (int i = 0; i < 10 * LOG_RING_LEN; ++i) {
+        log_printf("%d\n", i);
+    }
+    log_async_flush();
+    // logging thread never waits for formatter, messages might be dropped
+    assert_true(atomic_load(&async.nwritten) <= 10 * LOG_RING_LEN);
+    assert_int_equal(atomic_load(&async.nwritten), atomic_load(&async.seq));
+    log_async_stop();
+    assert_null(atomic_load(&async.rings));
+
+    log_stream = NULL;
+    fclose(f);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_min_lvl),
+        unit_test(test_async),
+        unit_test(test_drop),
+    };
+
+    return run_tests(tests);
+}
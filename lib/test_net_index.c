@@ -0,0 +1,167 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "net_index.c"
+
+static void test_table(void **state)
+{
+    (void) state;   // unused
+
+    table_t t;
+    assert_true(table_init(&t, sizeof(uint32_t), TABLE_MIN_CAP));
+
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        // keys are clustered, as cell ids and addresses are
+        uint32_t *v = table_get(&t, i * 16);
+        assert_non_null(v);
+        assert_int_equal(*v, 0);
+        *v = i;
+    }
+    assert_int_equal(t.n, n);
+    assert_true(2 * t.n <= t.cap);
+    assert_true(table_get(&t, 16) == table_find(&t, 16));
+    assert_int_equal(t.n, n);
+
+    for (int i = 0; i < n; i += 2) {
+        const int slot = table_probe(&t, i * 16);
+        assert_true(t.keys[slot] != 0);
+        table_remove_at(&t, slot);
+    }
+    assert_int_equal(t.n, n / 2);
+    for (int i = 0; i < n; ++i) {
+        const uint32_t *v = table_find(&t, i * 16);
+        if (i % 2) {
+            assert_non_null(v);
+            assert_int_equal(*v, i);
+        } else {
+            assert_null(v);
+        }
+    }
+
+    int cnt = 0;
+    int it = 0;
+    while (table_next(&t, &it)) {
+        ++cnt;
+    }
+    assert_int_equal(cnt, n / 2);
+
+    table_free(&t);
+}
+
+static void test_update(void **state)
+{
+    (void) state;   // unused
+
+    net_index_t *idx = net_index_create();
+    assert_non_null(idx);
+
+    tsdu_d_neighbouring_cell_t nc = {
+        .base = { .codop = D_NEIGHBOURING_CELL, .downlink = true, },
+        .ccr_config = { .number = 2, },
+        .adj_cells = {
+            { .bn_nb = 1, .channel_id = 100, },
+            { .bn_nb = 2, .channel_id = 200, },
+        },
+    };
+    // ignored without current cell
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&nc));
+    assert_int_equal(net_index_ncells(idx), 0);
+
+    uint8_t country_code;
+    system_id_t system_id;
+    assert_false(net_index_get_network(idx, &country_code, &system_id));
+    const tsdu_d_system_info_t si = {
+        .base = { .codop = D_SYSTEM_INFO, .downlink = true, },
+        .country_code = 33,
+        .system_id = { .network = 5, },
+        .bn_id = 7,
+        .cell_id = { .bs_id = 1, .rws_id = 2, },
+        .cell_bn = 0x123,
+    };
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&si));
+    assert_true(net_index_get_network(idx, &country_code, &system_id));
+    assert_int_equal(country_code, 33);
+    assert_int_equal(system_id.network, 5);
+    const net_cell_t *cell = net_index_get_current_cell(idx);
+    assert_non_null(cell);
+    assert_true(cell->has_sysinfo);
+    assert_int_equal(cell->bn_id, 7);
+    assert_int_equal(cell->cell_bn, 0x123);
+
+    cell_id_list_t *cell_ids = malloc(sizeof(cell_id_list_t) + sizeof(cell_id_t));
+    assert_non_null(cell_ids);
+    cell_ids->len = 1;
+    cell_ids->cell_ids[0] = (cell_id_t){ .bs_id = 3, .rws_id = 4, };
+    nc.cell_ids = cell_ids;
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&nc));
+    free(cell_ids);
+    assert_int_equal(net_index_ncells(idx), 2);
+    cell = net_index_get_current_cell(idx);
+    assert_int_equal(cell->nneighbours, 2);
+    assert_true(cell->neighbours[0].has_cell_id);
+    assert_false(cell->neighbours[1].has_cell_id);
+    assert_int_equal(cell->neighbours[1].channel_id, 200);
+    const cell_id_t nb_id = { .bs_id = 3, .rws_id = 4, };
+    const net_cell_t *nb = net_index_get_cell(idx, &nb_id);
+    assert_non_null(nb);
+    assert_false(nb->has_sysinfo);
+    assert_int_equal(nb->channel_id, 100);
+
+    const tsdu_d_group_composition_t gc = {
+        .base = { .codop = D_GROUP_COMPOSITION, .downlink = true, },
+        .group_id = 0x456,
+        .og_nb = 2,
+        .group_ids = { 0x10, 0x20, },
+    };
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&gc));
+    tsdu_d_group_activation_t ga = {
+        .base = { .codop = D_GROUP_ACTIVATION, .downlink = true, },
+        .group_id = 0x456,
+        .channel_id = 300,
+        .has_addr_tti = true,
+        .addr_tti = { .z = 0, .y = 7, .x = 0x456, },
+    };
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&ga));
+    const net_group_t *group = net_index_get_group(idx, 0x456);
+    assert_non_null(group);
+    assert_true(group->has_composition);
+    assert_int_equal(group->group_ids[1], 0x20);
+    assert_true(group->is_active);
+    assert_int_equal(group->activation.channel_id, 300);
+    const net_call_t *call = net_index_get_call(idx, &ga.addr_tti);
+    assert_non_null(call);
+    assert_int_equal(call->group_id, 0x456);
+    const addr_t addr = call->addr;
+
+    // snapshot is not affected by later updates
+    net_index_t *snap = net_index_clone(idx);
+    assert_non_null(snap);
+    const uint64_t seq = net_index_seq(idx);
+    ga.addr_tti.x = 0x789;
+    assert_int_equal(0, net_index_update(idx, (tsdu_t *)&ga));
+    assert_int_equal(net_index_ncalls(idx), 2);
+    assert_int_equal(net_index_ncalls(snap), 1);
+
+    // only call updated after the snapshot remains
+    assert_int_equal(1, net_index_expire_calls(idx, seq + 1));
+    assert_null(net_index_get_call(idx, &addr));
+    assert_non_null(net_index_get_call(idx, &ga.addr_tti));
+    assert_non_null(net_index_get_call(snap, &addr));
+
+    net_index_destroy(snap);
+    net_index_destroy(idx);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_table),
+        unit_test(test_update),
+    };
+
+    return run_tests(tests);
+}
@@ -5,6 +5,9 @@
 
 // include, we are testing static methods
 #include "phys_ch.c"
+#include "frame_enc.c"
+
+#include <math.h>
 
 // the goal is just to make sure the function provides the same results
 // after refactorization
@@ -68,11 +71,973 @@ static void test_frame_diff_dec(void **state)
     assert_memory_equal(data_exp, data_in.data, FRAME_DATA_LEN);
 }
 
+// generate pseudo-random stream of 'nframes' frames with valid frame
+// synchronization, stream starts by 'skip' bits of garbage
+static void mk_bit_stream(uint8_t *bits, int skip, int nframes)
+{
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    uint32_t r = 12345;
+
+    for (int i = 0; i < skip + nframes * FRAME_LEN; ++i) {
+        r = r * 1103515245 + 12345;
+        bits[i] = (r >> 16) & 1;
+    }
+    for (int i = 0; i < nframes; ++i) {
+        memcpy(bits + skip + i * FRAME_LEN, frame_sync, FRAME_HDR_LEN);
+    }
+}
+
+// packed and unpacked input must provide the same frames
+static void test_recv_packed(void **state)
+{
+    (void) state;   // unused
+
+    const int skip = 5;
+    const int nframes = 4;
+    uint8_t bits[skip + nframes * FRAME_LEN];
+    mk_bit_stream(bits, skip, nframes);
+
+    uint8_t packed[nframes * FRAME_LEN / 8];
+    memset(packed, 0, sizeof(packed));
+    for (int i = 0; i < nframes * FRAME_LEN; ++i) {
+        packed[i / 8] |= bits[skip + i] << (7 - i % 8);
+    }
+
+    phys_ch_t *phys_ch_u = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    phys_ch_t *phys_ch_p = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch_u);
+    assert_non_null(phys_ch_p);
+
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch_u, bits, sizeof(bits)));
+
+    // unaligned start of packed data
+    assert_int_equal(skip, tetrapol_phys_ch_recv(phys_ch_p, bits, skip));
+    assert_true(tetrapol_phys_ch_set_input_fmt(phys_ch_p, PHYS_CH_INPUT_PACKED));
+    assert_int_equal(PHYS_CH_INPUT_PACKED, tetrapol_phys_ch_get_input_fmt(phys_ch_p));
+    assert_false(tetrapol_phys_ch_set_input_fmt(phys_ch_p, 3));
+    for (int i = 0; i < sizeof(packed); i += 7) {
+        const int n = (sizeof(packed) - i < 7) ? sizeof(packed) - i : 7;
+        assert_int_equal(n, tetrapol_phys_ch_recv(phys_ch_p, packed + i, n));
+    }
+
+    assert_int_equal(1, find_frame_sync(phys_ch_u));
+    assert_int_equal(1, find_frame_sync(phys_ch_p));
+    assert_int_equal(skip, phys_ch_u->data_begin - DATA_OFFS);
+    assert_int_equal(skip, phys_ch_p->data_begin - DATA_OFFS);
+
+    for (int fn = 0; fn < nframes; ++fn) {
+        frame_t frame_u, frame_p;
+        assert_int_equal(1, get_frame(phys_ch_u, &frame_u));
+        assert_int_equal(1, get_frame(phys_ch_p, &frame_p));
+
+        uint8_t frame_exp[FRAME_DATA_LEN];
+        uint8_t last_bit = 0;
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            last_bit ^= bits[skip + fn * FRAME_LEN + FRAME_HDR_LEN + i];
+            frame_exp[i] = last_bit;
+        }
+
+        assert_memory_equal(frame_exp, frame_u.data, FRAME_DATA_LEN);
+        assert_memory_equal(frame_exp, frame_p.data, FRAME_DATA_LEN);
+    }
+
+    tetrapol_phys_ch_destroy(phys_ch_u);
+    tetrapol_phys_ch_destroy(phys_ch_p);
+}
+
+// frames must survive wrapping of ring buffer, input is written
+// into borrowed buffer
+static void test_recv_buf(void **state)
+{
+    (void) state;   // unused
+
+    const int nframes = 3 * RING_BITS / FRAME_LEN;
+    static uint8_t bits[8 + 3 * RING_BITS];
+    static uint8_t packed[3 * RING_SIZE];
+
+    // skip 0 writes directly into ring, skip 5 uses staging buffer
+    const int skips[] = { 0, 5, };
+    for (int s = 0; s < ARRAY_LEN(skips); ++s) {
+        const int skip = skips[s];
+        mk_bit_stream(bits, skip, nframes);
+        memset(packed, 0, sizeof(packed));
+        for (int i = 0; i < nframes * FRAME_LEN; ++i) {
+            packed[i / 8] |= bits[skip + i] << (7 - i % 8);
+        }
+
+        phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+                TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+        assert_non_null(phys_ch);
+        assert_int_equal(skip, tetrapol_phys_ch_recv(phys_ch, bits, skip));
+        assert_true(tetrapol_phys_ch_set_input_fmt(phys_ch, PHYS_CH_INPUT_PACKED));
+
+        int in_pos = 0;
+        int fn = 0;
+        while (fn < nframes) {
+            uint8_t *buf;
+            int len = tetrapol_phys_ch_recv_buf(phys_ch, &buf);
+            assert_true(len > 0 || in_pos == nframes * FRAME_LEN / 8);
+            // odd chunk size to hit all positions in ring
+            len = (len > 77) ? 77 : len;
+            if (len > nframes * FRAME_LEN / 8 - in_pos) {
+                len = nframes * FRAME_LEN / 8 - in_pos;
+            }
+            memcpy(buf, packed + in_pos, len);
+            tetrapol_phys_ch_recv_commit(phys_ch, len);
+            in_pos += len;
+
+            if (!phys_ch->has_frame_sync) {
+                phys_ch->has_frame_sync = find_frame_sync(phys_ch);
+                if (!phys_ch->has_frame_sync) {
+                    continue;
+                }
+                assert_int_equal(skip, phys_ch->data_begin - DATA_OFFS);
+            }
+
+            frame_t frame;
+            while (get_frame(phys_ch, &frame) > 0) {
+                uint8_t frame_exp[FRAME_DATA_LEN];
+                uint8_t last_bit = 0;
+                for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                    last_bit ^= bits[skip + fn * FRAME_LEN + FRAME_HDR_LEN + i];
+                    frame_exp[i] = last_bit;
+                }
+                assert_memory_equal(frame_exp, frame.data, FRAME_DATA_LEN);
+                ++fn;
+            }
+        }
+
+        tetrapol_phys_ch_destroy(phys_ch);
+    }
+}
+
+// bit-parallel sync search must give the same results as bit by bit search
+static void test_find_frame_sync(void **state)
+{
+    (void) state;   // unused
+
+    uint8_t bits[DATA_LEN - DATA_OFFS];
+    uint32_t r = 4321;
+    for (int i = 0; i < sizeof(bits); ++i) {
+        r = r * 1103515245 + 12345;
+        bits[i] = (r >> 16) & 1;
+    }
+
+    // plant synchronization with 0, 1 and 2 errors
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int sync_pos[] = { 300, 300 + FRAME_LEN, 700, 700 + FRAME_LEN,
+        1000, 1000 + FRAME_LEN, };
+    for (int i = 0; i < ARRAY_LEN(sync_pos); ++i) {
+        memcpy(bits + sync_pos[i], frame_sync, FRAME_HDR_LEN);
+    }
+    bits[700 + 3] ^= 1;
+    bits[1000 + 2] ^= 1;
+    bits[1000 + FRAME_LEN + 6] ^= 1;
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch, bits, sizeof(bits)));
+
+    // bitsliced counters match scalar comparison
+    for (int pos = DATA_OFFS; pos < DATA_OFFS + 400; pos += 64) {
+        uint64_t cnt[FRAME_SYNC_CNT_BITS] = { 0, };
+        cmp_frame_sync64(phys_ch->data, pos, cnt);
+        cmp_frame_sync64(phys_ch->data, pos + FRAME_LEN, cnt);
+        for (int i = 0; i < 64; ++i) {
+            int c = 0;
+            for (int j = 0; j < FRAME_SYNC_CNT_BITS; ++j) {
+                c |= ((cnt[j] >> (63 - i)) & 1) << j;
+            }
+            assert_int_equal(c, cmp_frame_sync(phys_ch->data, pos + i) +
+                    cmp_frame_sync(phys_ch->data, pos + i + FRAME_LEN));
+        }
+    }
+
+    const int end = phys_ch->data_end - FRAME_LEN - FRAME_HDR_LEN;
+    for (int begin = DATA_OFFS; begin <= end + 1; begin += 37) {
+        int begin_exp = begin;
+        int found_exp = 0;
+        for ( ; begin_exp <= end; ++begin_exp) {
+            const int e = cmp_frame_sync(phys_ch->data, begin_exp) +
+                cmp_frame_sync(phys_ch->data, begin_exp + FRAME_LEN);
+            if (e <= MAX_FRAME_SYNC_ERR) {
+                found_exp = 1;
+                break;
+            }
+        }
+
+        phys_ch->data_begin = begin;
+        assert_int_equal(found_exp, find_frame_sync(phys_ch));
+        assert_int_equal(begin_exp, phys_ch->data_begin);
+    }
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+// sync tracking follows bit slips and skips fades without losing sync
+static void test_track_frame_sync(void **state)
+{
+    (void) state;   // unused
+
+    const int nframes = 40;
+    const int fade_first = 10;
+    const int fade_last = 19;
+    // frame 24 loses 3 bits, 2 extra bits are received after frame 31
+    const int slip_early = 24;
+    const int slip_late = 31;
+    static uint8_t orig[40 * FRAME_LEN];
+    static uint8_t bits[40 * FRAME_LEN + 2];
+    int frame_pos[40];
+    mk_bit_stream(orig, 0, nframes);
+
+    uint32_t r = 97531;
+    int len = 0;
+    for (int n = 0; n < nframes; ++n) {
+        frame_pos[n] = len;
+        if (n >= fade_first && n <= fade_last) {
+            for (int i = 0; i < FRAME_LEN; ++i) {
+                r = r * 1103515245 + 12345;
+                bits[len++] = (r >> 16) & 1;
+            }
+            continue;
+        }
+        const int n_bits = (n == slip_early) ? FRAME_LEN - 3 : FRAME_LEN;
+        memcpy(&bits[len], &orig[n * FRAME_LEN], n_bits);
+        len += n_bits;
+        if (n == slip_late) {
+            bits[len++] = 1;
+            bits[len++] = 0;
+        }
+    }
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    assert_int_equal(len, tetrapol_phys_ch_recv(phys_ch, bits, len));
+    assert_int_equal(1, find_frame_sync(phys_ch));
+
+    int nfades = 0;
+    for (int n = 0; n < nframes; ++n) {
+        frame_t frame;
+        const int ret = get_frame(phys_ch, &frame);
+        if (n >= fade_first && n <= fade_last) {
+            // noise might occasionally look like synchronization
+            assert_true(ret == 1 || ret == GET_FRAME_FADE);
+            nfades += ret == GET_FRAME_FADE;
+            continue;
+        }
+        assert_int_equal(1, ret);
+        assert_int_equal(frame_pos[n] + DATA_OFFS + FRAME_LEN,
+                phys_ch->data_begin);
+        if (n == slip_early) {
+            continue;
+        }
+        uint8_t last_bit = 0;
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            last_bit ^= orig[n * FRAME_LEN + FRAME_HDR_LEN + i];
+            assert_int_equal(last_bit, frame.data[i]);
+        }
+    }
+    assert_true(nfades >= fade_last - fade_first - 1);
+    assert_int_equal(phys_ch->stats.fade_frames, nfades);
+    assert_int_equal(phys_ch->stats.sync_recovered, 2);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+
+    // sync is lost in long fade
+    phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    mk_bit_stream(bits, 0, 2);
+    for (int i = 2 * FRAME_LEN; i < nframes * FRAME_LEN; ++i) {
+        r = r * 1103515245 + 12345;
+        bits[i] = (r >> 16) & 1;
+    }
+    assert_int_equal(nframes * FRAME_LEN,
+            tetrapol_phys_ch_recv(phys_ch, bits, nframes * FRAME_LEN));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    assert_true(phys_ch->has_frame_sync);
+    assert_true(phys_ch->stats.fade_frames > 0);
+    assert_int_equal(phys_ch->stats.sync_lost, 0);
+    for (int i = 0; i < TRACK_FADE_FRAMES; ++i) {
+        assert_int_equal(FRAME_LEN,
+                tetrapol_phys_ch_recv(phys_ch, bits + 4 * FRAME_LEN, FRAME_LEN));
+        assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    }
+    assert_int_equal(phys_ch->stats.sync_lost, 1);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+
+    // forced resync drops buffered bits, sync is found in data after gap
+    phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    mk_bit_stream(bits, 0, 4);
+    assert_int_equal(4 * FRAME_LEN - 100,
+            tetrapol_phys_ch_recv(phys_ch, bits, 4 * FRAME_LEN - 100));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    assert_true(phys_ch->has_frame_sync);
+    tetrapol_phys_ch_resync(phys_ch);
+    assert_false(phys_ch->has_frame_sync);
+    assert_int_equal(phys_ch->data_begin, phys_ch->data_end);
+    assert_int_equal(phys_ch->stats.resyncs, 1);
+    mk_bit_stream(bits, 10, 4);
+    assert_int_equal(4 * FRAME_LEN - 37,
+            tetrapol_phys_ch_recv(phys_ch, bits + 37, 4 * FRAME_LEN - 37));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    assert_true(phys_ch->has_frame_sync);
+    assert_int_equal(phys_ch->stats.sync_found, 2);
+    assert_int_equal(phys_ch->stats.sync_lost, 0);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+static void test_mem_size(void **state)
+{
+    (void) state;   // unused
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_VHF,
+            RADIO_CH_TYPE_TRAFFIC);
+    assert_non_null(phys_ch);
+    assert_true(tetrapol_phys_ch_get_mem_size(phys_ch) <=
+            PHYS_CH_MEM_SIZE_TRAFFIC);
+    tetrapol_phys_ch_destroy(phys_ch);
+
+    phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    const size_t size = tetrapol_phys_ch_get_mem_size(phys_ch);
+    assert_true(size <= PHYS_CH_MEM_SIZE_CONTROL);
+    // components are placed after phys_ch_t in the same allocation
+    assert_true((char *)phys_ch->sdch < (char *)phys_ch + phys_ch->mem_size);
+
+    uint8_t bits[4 * FRAME_LEN];
+    mk_bit_stream(bits, 0, 4);
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch, bits, sizeof(bits)));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    assert_true(phys_ch->has_frame_sync);
+
+    // channel is decoded again after hibernation
+    tetrapol_phys_ch_hibernate(phys_ch);
+    assert_false(phys_ch->has_frame_sync);
+    assert_int_equal(tetrapol_phys_ch_get_mem_size(phys_ch), size);
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch, bits, sizeof(bits)));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    assert_true(phys_ch->has_frame_sync);
+    assert_int_equal(phys_ch->stats.sync_found, 2);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+// original, one SCR at time, evaluation used by detect_scr()
+static bool detect_scr_scalar(int band, const frame_t *f, int scr)
+{
+    frame_t f_;
+    frame_type_t type;
+    memcpy(&f_, f, sizeof(f_));
+
+    frame_descramble(&f_, scr);
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_diff_dec(&f_);
+    }
+    type = (f_.data[38] ^ f_.data[114]) ? FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
+    if (band == TETRAPOL_BAND_UHF) {
+        frame_deinterleave(&f_, type == FRAME_TYPE_DATA ? interleave_data_UHF : interleave_voice_UHF);
+    } else {
+        frame_deinterleave(&f_, interleave_voice_data_VHF);
+    }
+
+    data_block_t data_blk;
+    data_block_decode_frame(&data_blk, f_.data, f_.frame_no, type);
+
+    return !data_blk.nerrs && data_block_check_crc(&data_blk);
+}
+
+// bitsliced SCR detection must provide the same results as scalar version,
+// sequential search must lock in a few frames
+static void test_detect_scr(void **state)
+{
+    (void) state;   // unused
+
+    const int bands[] = { TETRAPOL_BAND_UHF, TETRAPOL_BAND_VHF, };
+    const int scrs[] = { 0, 1, 7, 64, 126, 127, };
+    const int scr_searches[] = {
+        PHYS_CH_SCR_SEARCH_EXHAUSTIVE, PHYS_CH_SCR_SEARCH_SEQUENTIAL,
+    };
+    const scr_lanes_t all = { ~0ULL, ~0ULL, };
+    uint32_t r = 98765;
+
+    for (int b = 0; b < ARRAY_LEN(bands); ++b) {
+        const int band = bands[b];
+        for (int s = 0; s < ARRAY_LEN(scrs); ++s) {
+          for (int m = 0; m < ARRAY_LEN(scr_searches); ++m) {
+            phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+                    band, RADIO_CH_TYPE_CONTROL);
+            assert_non_null(phys_ch);
+            tetrapol_phys_ch_set_scr_confidence(phys_ch, 20);
+            assert_true(tetrapol_phys_ch_set_scr_search(phys_ch,
+                        scr_searches[m]));
+            assert_int_equal(scr_searches[m],
+                    tetrapol_phys_ch_get_scr_search(phys_ch));
+            int lock_frame = -1;
+
+            for (int n = 0; n < 80; ++n) {
+                frame_t f;
+                uint8_t blk[126];
+                if (n % 8 == 1) {
+                    // random frame
+                    for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                        r = r * 1103515245 + 12345;
+                        f.data[i] = (r >> 16) & 1;
+                    }
+                } else {
+                    const frame_type_t type = (n % 2) ?
+                        FRAME_TYPE_VOICE : FRAME_TYPE_DATA;
+                    assert_true(mk_data_block(blk, type, &r));
+                    mk_frame(&f, blk, type, band, scrs[s]);
+                }
+
+                const scr_lanes_t ok =
+                    band_dec_select(band)->detect_scr_lanes(&f, all);
+                for (int scr = 0; scr < 128; ++scr) {
+                    assert_int_equal(detect_scr_scalar(band, &f, scr),
+                            (ok[scr / 64] >> (scr % 64)) & 1);
+                }
+                if (n % 8 != 1) {
+                    assert_true((ok[scrs[s] / 64] >> (scrs[s] % 64)) & 1);
+                }
+
+                detect_scr(phys_ch, &f);
+                if (lock_frame < 0 &&
+                        tetrapol_phys_ch_get_scr(phys_ch) != PHYS_CH_SCR_DETECT) {
+                    lock_frame = n;
+                }
+            }
+
+            assert_int_equal(scrs[s], tetrapol_phys_ch_get_scr(phys_ch));
+            if (scr_searches[m] == PHYS_CH_SCR_SEARCH_SEQUENTIAL) {
+                // 3 valid frames and 1 random frame
+                assert_int_equal(lock_frame, 3);
+                // only detected SCR is left
+                scr_lanes_t cand = {
+                    phys_ch->scr_cand[0], phys_ch->scr_cand[1],
+                };
+                cand[scrs[s] / 64] &= ~(1ULL << (scrs[s] % 64));
+                assert_false(cand[0] | cand[1]);
+            } else {
+                assert_true(lock_frame > 20);
+            }
+            tetrapol_phys_ch_destroy(phys_ch);
+          }
+        }
+    }
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+    assert_false(tetrapol_phys_ch_set_scr_search(phys_ch, 2));
+    assert_int_equal(PHYS_CH_SCR_SEARCH_SEQUENTIAL,
+            tetrapol_phys_ch_get_scr_search(phys_ch));
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+static void test_preload_scr(void **state)
+{
+    (void) state;   // unused
+
+    const int band = TETRAPOL_BAND_UHF;
+    uint32_t r = 13579;
+    frame_t f;
+    uint8_t blk[126];
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(band, RADIO_CH_TYPE_CONTROL);
+    assert_non_null(phys_ch);
+
+    // verified by valid frame
+    tetrapol_phys_ch_preload_scr(phys_ch, 7);
+    assert_int_equal(tetrapol_phys_ch_get_scr(phys_ch), 7);
+    phys_ch_stats_t stats;
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_int_equal(stats.scr_lock_time, -1);
+    for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+        r = r * 1103515245 + 12345;
+        f.data[i] = (r >> 16) & 1;
+    }
+    verify_scr(phys_ch, &f);
+    assert_int_equal(phys_ch->scr_preload, 7);
+    assert_true(mk_data_block(blk, FRAME_TYPE_DATA, &r));
+    mk_frame(&f, blk, FRAME_TYPE_DATA, band, 7);
+    verify_scr(phys_ch, &f);
+    assert_int_equal(phys_ch->scr_preload, PHYS_CH_SCR_DETECT);
+    assert_int_equal(tetrapol_phys_ch_get_scr(phys_ch), 7);
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_true(stats.scr_lock_time >= 0);
+
+    // mismatch starts detection
+    tetrapol_phys_ch_preload_scr(phys_ch, 7);
+    for (int n = 0; n < 3; ++n) {
+        const frame_type_t type = (n % 2) ? FRAME_TYPE_VOICE : FRAME_TYPE_DATA;
+        assert_true(mk_data_block(blk, type, &r));
+        mk_frame(&f, blk, type, band, 64);
+        if (n == 0) {
+            verify_scr(phys_ch, &f);
+            assert_int_equal(phys_ch->scr_preload, PHYS_CH_SCR_DETECT);
+            assert_int_equal(tetrapol_phys_ch_get_scr(phys_ch),
+                    PHYS_CH_SCR_DETECT);
+        } else {
+            detect_scr(phys_ch, &f);
+        }
+    }
+    assert_int_equal(tetrapol_phys_ch_get_scr(phys_ch), 64);
+
+    assert_false(tetrapol_phys_ch_set_cch_mux_type(phys_ch, 2));
+    assert_int_equal(tetrapol_phys_ch_get_cch_mux_type(phys_ch),
+            CELL_CONFIG_MUX_TYPE_DEFAULT);
+    assert_true(tetrapol_phys_ch_set_cch_mux_type(phys_ch,
+                CELL_CONFIG_MUX_TYPE_TYPE_2));
+    assert_int_equal(tetrapol_phys_ch_get_cch_mux_type(phys_ch),
+            CELL_CONFIG_MUX_TYPE_TYPE_2);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+// fused frame decoding must match descramble, diff. dec. and deinterleave
+static void test_frame_dec(void **state)
+{
+    (void) state;   // unused
+
+    const int bands[] = { TETRAPOL_BAND_UHF, TETRAPOL_BAND_VHF, };
+    const int scrs[] = { 0, 1, 7, 64, 126, 127, };
+    uint32_t r = 13579;
+
+    for (int b = 0; b < ARRAY_LEN(bands); ++b) {
+        const int band = bands[b];
+        for (int s = 0; s < ARRAY_LEN(scrs); ++s) {
+            frame_dec_t frame_dec;
+            frame_dec_init(&frame_dec, band, scrs[s]);
+
+            for (int n = 0; n < 100; ++n) {
+                frame_t f, f_;
+                for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                    r = r * 1103515245 + 12345;
+                    f.data[i] = (r >> 16) & 1;
+                }
+                f.data[FRAME_DATA_LEN] = 0;
+                memcpy(&f_, &f, sizeof(f_));
+
+                frame_descramble(&f_, scrs[s]);
+                if (band == TETRAPOL_BAND_UHF) {
+                    frame_diff_dec(&f_);
+                }
+                const frame_type_t type = (f_.data[38] ^ f_.data[114]) ?
+                    FRAME_TYPE_DATA : FRAME_TYPE_VOICE;
+                if (band == TETRAPOL_BAND_UHF) {
+                    frame_deinterleave(&f_, type == FRAME_TYPE_DATA ?
+                            interleave_data_UHF : interleave_voice_UHF);
+                } else {
+                    frame_deinterleave(&f_, interleave_voice_data_VHF);
+                }
+
+                uint8_t data[FRAME_DATA_LEN];
+                assert_int_equal(type,
+                        band_dec_select(band)->frame_decode(&frame_dec, &f, data));
+                assert_memory_equal(f_.data, data, FRAME_DATA_LEN);
+            }
+        }
+    }
+}
+
+typedef struct {
+    int n;
+    voice_frame_t frames[16];
+} voice_frames_t;
+
+static void voice_sink(const voice_frame_t *vf, void *ptr)
+{
+    voice_frames_t *vfs = ptr;
+
+    if (vfs->n < ARRAY_LEN(vfs->frames)) {
+        vfs->frames[vfs->n] = *vf;
+    }
+    ++vfs->n;
+}
+
+// each voice frame is passed to sink as soon as it is received
+static void test_traffic_ch(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int nframes = 8;
+    const int bad_frame = 5;
+    uint8_t blks[nframes][126];
+    uint8_t bits[nframes * FRAME_LEN];
+    uint32_t r = 2468;
+
+    for (int n = 0; n < nframes; ++n) {
+        assert_true(mk_data_block(blks[n], FRAME_TYPE_VOICE, &r));
+        if (n == bad_frame) {
+            blks[n][7] ^= 1;
+        }
+        frame_t f;
+        mk_frame(&f, blks[n], FRAME_TYPE_VOICE, TETRAPOL_BAND_UHF, 0);
+        uint8_t *b = &bits[n * FRAME_LEN];
+        memcpy(b, frame_sync, FRAME_HDR_LEN);
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+        }
+    }
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_TRAFFIC);
+    assert_non_null(phys_ch);
+    tetrapol_phys_ch_set_scr(phys_ch, 0);
+    voice_frames_t vfs = { .n = 0, };
+    tetrapol_phys_ch_set_voice_sink(phys_ch, voice_sink, &vfs);
+
+    // frame sync requires 2 frames, then each frame is passed into sink
+    // as soon as it is received
+    for (int n = 0; n < nframes; ++n) {
+        assert_int_equal(FRAME_LEN, tetrapol_phys_ch_recv(
+                    phys_ch, &bits[n * FRAME_LEN], FRAME_LEN));
+        assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+        assert_int_equal(vfs.n, n ? n + 1 : 0);
+    }
+    assert_int_equal(vfs.n, nframes);
+
+    for (int n = 0; n < vfs.n; ++n) {
+        const voice_frame_t *vf = &vfs.frames[n];
+        assert_int_equal(vf->crc_ok, n != bad_frame);
+        if (n) {
+            assert_int_equal(vf->timestamp - vf[-1].timestamp, 20000);
+        }
+        for (int i = 0; i < 126; ++i) {
+            assert_int_equal((vf->data[i / 64] >> (63 - i % 64)) & 1, blks[n][i]);
+        }
+    }
+
+    phys_ch_stats_t stats;
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_int_equal(stats.frames, nframes);
+    assert_int_equal(stats.sync_found, 1);
+    assert_int_equal(stats.sync_lost, 0);
+    assert_int_equal(stats.scr, 0);
+    assert_int_equal(stats.voice_frames, nframes);
+    assert_int_equal(stats.data_frames, 0);
+    assert_int_equal(stats.tch_data_frames, 0);
+    assert_int_equal(stats.crc_ok, nframes - 1);
+    assert_int_equal(stats.nerrs_hist[0], nframes);
+    uint64_t ntimes = 0;
+    for (int i = 0; i < STATS_TIME_BINS; ++i) {
+        ntimes += stats.time_hist[i];
+    }
+    assert_int_equal(ntimes, nframes);
+
+    // data frames are counted, not passed into voice sink
+    const frame_info_t fi = {
+        .timestamp = nframes * 20000,
+        .frame_no = FRAME_NO_UNKNOWN,
+        .fr_type = FRAME_TYPE_DATA,
+    };
+    const data_block_t data_blk = {
+        .fr_type = FRAME_TYPE_DATA,
+        .frame_no = FRAME_NO_UNKNOWN,
+    };
+    assert_int_equal(0, tetrapol_phys_ch_push_data_block(phys_ch, &fi,
+                &data_blk));
+    assert_int_equal(vfs.n, nframes);
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_int_equal(stats.data_frames, 1);
+    assert_int_equal(stats.tch_data_frames, 1);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+// frames are timestamped by input time, channel time follows input bits
+static void test_timestamps(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int nframes = 4;
+    // bits of noise before the first frame
+    const int noise = 37;
+    uint8_t bits[noise + nframes * FRAME_LEN];
+    uint32_t r = 1234;
+
+    memset(bits, 0, noise);
+    for (int n = 0; n < nframes; ++n) {
+        uint8_t blk[126];
+        assert_true(mk_data_block(blk, FRAME_TYPE_VOICE, &r));
+        frame_t f;
+        mk_frame(&f, blk, FRAME_TYPE_VOICE, TETRAPOL_BAND_UHF, 0);
+        uint8_t *b = &bits[noise + n * FRAME_LEN];
+        memcpy(b, frame_sync, FRAME_HDR_LEN);
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+        }
+    }
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(
+            TETRAPOL_BAND_UHF, RADIO_CH_TYPE_TRAFFIC);
+    assert_non_null(phys_ch);
+    tetrapol_phys_ch_set_scr(phys_ch, 0);
+    voice_frames_t vfs = { .n = 0, };
+    tetrapol_phys_ch_set_voice_sink(phys_ch, voice_sink, &vfs);
+
+    // input was received 1 s ago
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    const int64_t t0 = now.tv_sec * 1000000LL + now.tv_nsec / 1000 - 1000000;
+    tetrapol_phys_ch_set_time(phys_ch, t0);
+    assert_int_equal(noise, tetrapol_phys_ch_recv(phys_ch, bits, noise));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    // time can be set for each buffer
+    tetrapol_phys_ch_set_time(phys_ch, t0 + noise * BIT_US);
+    assert_int_equal(nframes * FRAME_LEN, tetrapol_phys_ch_recv(
+                phys_ch, bits + noise, nframes * FRAME_LEN));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+
+    assert_int_equal(vfs.n, nframes);
+    for (int n = 0; n < vfs.n; ++n) {
+        assert_true(vfs.frames[n].timestamp ==
+                t0 + (noise + n * FRAME_LEN) * BIT_US);
+    }
+    assert_int_equal(timer_now(phys_ch->timer),
+            (phys_ch->data_begin - DATA_OFFS) * BIT_US);
+
+    // frames were on air 0.8 s - 1 s before the sink call
+    phys_ch_stats_t stats;
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_int_equal(stats.latency_hist[19], nframes);
+    assert_true(stats.latency_sum >= nframes * 800000ULL);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
+#define BATCH_CHS 130
+#define BATCH_FRAMES 12
+
+typedef struct {
+    int n;
+    frame_info_t fi[BATCH_FRAMES];
+    data_block_t data_blk[BATCH_FRAMES];
+} blocks_t;
+
+static void block_sink(const frame_info_t *fi, const data_block_t *data_blk,
+        void *ptr)
+{
+    blocks_t *blks = ptr;
+
+    if (blks->n < BATCH_FRAMES) {
+        blks->fi[blks->n] = *fi;
+        blks->data_blk[blks->n] = *data_blk;
+    }
+    ++blks->n;
+}
+
+// batch and single channel processing gives the same data blocks
+static void test_process_batch(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    static uint8_t bits[BATCH_CHS][BATCH_FRAMES * FRAME_LEN];
+    static blocks_t blks[2][BATCH_CHS];
+    phys_ch_t *chs[2][BATCH_CHS];
+    const frame_type_t types[] = {
+        FRAME_TYPE_VOICE, FRAME_TYPE_DATA, FRAME_TYPE_HR_DATA,
+    };
+    uint32_t r = 97531;
+
+    memset(blks, 0, sizeof(blks));
+    for (int c = 0; c < BATCH_CHS; ++c) {
+        const int band = (c % 2) ? TETRAPOL_BAND_VHF : TETRAPOL_BAND_UHF;
+        const int scr = (7 * c) % 128;
+        for (int n = 0; n < BATCH_FRAMES; ++n) {
+            const frame_type_t type = types[(r >> 8) % ARRAY_LEN(types)];
+            uint8_t blk[126];
+            assert_true(mk_data_block(blk, type, &r));
+            frame_t f;
+            mk_frame(&f, blk, type, band, scr);
+            uint8_t *b = &bits[c][n * FRAME_LEN];
+            memcpy(b, frame_sync, FRAME_HDR_LEN);
+            for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+                b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+            }
+            // some frames with errors
+            r = r * 1103515245 + 12345;
+            if ((r >> 16) % 4 == 0) {
+                b[FRAME_HDR_LEN + (r >> 4) % FRAME_DATA_LEN] ^= 1;
+            }
+        }
+
+        for (int k = 0; k < 2; ++k) {
+            chs[k][c] = tetrapol_phys_ch_create(band, RADIO_CH_TYPE_TRAFFIC);
+            assert_non_null(chs[k][c]);
+            // the last channel is still detecting SCR
+            if (c != BATCH_CHS - 1) {
+                tetrapol_phys_ch_set_scr(chs[k][c], scr);
+            }
+            tetrapol_phys_ch_set_block_sink(chs[k][c], block_sink,
+                    &blks[k][c]);
+            assert_int_equal(sizeof(bits[c]),
+                    tetrapol_phys_ch_recv(chs[k][c], bits[c], sizeof(bits[c])));
+        }
+        assert_int_equal(0, tetrapol_phys_ch_process(chs[0][c]));
+    }
+    assert_int_equal(0, tetrapol_phys_ch_process_batch(chs[1], BATCH_CHS));
+
+    int nerrs = 0, nhr = 0;
+    for (int c = 0; c < BATCH_CHS; ++c) {
+        const blocks_t *b0 = &blks[0][c];
+        const blocks_t *b1 = &blks[1][c];
+        assert_true(b0->n >= BATCH_FRAMES - 2);
+        assert_int_equal(b0->n, b1->n);
+        for (int n = 0; n < b0->n; ++n) {
+            const frame_info_t *fi0 = &b0->fi[n];
+            const frame_info_t *fi1 = &b1->fi[n];
+            assert_true(fi0->timestamp == fi1->timestamp);
+            assert_int_equal(fi0->frame_no, fi1->frame_no);
+            assert_int_equal(fi0->fr_type, fi1->fr_type);
+            assert_int_equal(fi0->nerrs, fi1->nerrs);
+            assert_int_equal(fi0->crc_ok, fi1->crc_ok);
+            const data_block_t *d0 = &b0->data_blk[n];
+            const data_block_t *d1 = &b1->data_blk[n];
+            assert_int_equal(d0->fr_type, d1->fr_type);
+            assert_int_equal(d0->frame_no, d1->frame_no);
+            assert_int_equal(d0->nerrs, d1->nerrs);
+            assert_true(d0->timestamp == d1->timestamp);
+            assert_memory_equal(d0->data, d1->data, sizeof(d0->data));
+            assert_memory_equal(d0->err, d1->err, sizeof(d0->err));
+            nerrs += !b0->fi[n].crc_ok;
+            // high rate data frames are not decoded
+            assert_int_not_equal(fi0->fr_type, FRAME_TYPE_HR_DATA);
+        }
+
+        phys_ch_stats_t st0, st1;
+        tetrapol_phys_ch_get_stats(chs[0][c], &st0);
+        tetrapol_phys_ch_get_stats(chs[1][c], &st1);
+        assert_int_equal(st0.frames, st1.frames);
+        assert_int_equal(st0.crc_ok, st1.crc_ok);
+        assert_int_equal(st0.scr, st1.scr);
+        assert_int_equal(st0.hr_data_frames, st1.hr_data_frames);
+        nhr += st0.hr_data_frames;
+        assert_int_equal(timer_now(chs[0][c]->timer),
+                timer_now(chs[1][c]->timer));
+        tetrapol_phys_ch_destroy(chs[0][c]);
+        tetrapol_phys_ch_destroy(chs[1][c]);
+    }
+    // errors are present, but most frames are valid
+    assert_true(nerrs > 0);
+    assert_true(nerrs < BATCH_CHS * BATCH_FRAMES / 2);
+    // high rate data frames are recognized
+    assert_true(nhr > BATCH_CHS * BATCH_FRAMES / 6);
+}
+
+// averages of sync errors, FEC errors and CRC failures
+static void test_quality(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int nframes = 40;
+    static uint8_t bits[40 * FRAME_LEN];
+    uint32_t r = 8642;
+
+    for (int n = 0; n < nframes; ++n) {
+        uint8_t blk[126];
+        assert_true(mk_data_block(blk, FRAME_TYPE_DATA, &r));
+        frame_t f;
+        mk_frame(&f, blk, FRAME_TYPE_DATA, TETRAPOL_BAND_UHF, 5);
+        // corrected error in every 4th frame, single bit error causes two
+        // errors after differential decoding of UHF
+        if (n % 4 == 3) {
+            f.data[30] ^= 1;
+        }
+        uint8_t *b = &bits[n * FRAME_LEN];
+        memcpy(b, frame_sync, FRAME_HDR_LEN);
+        // error in frame synchronization of every 4th frame
+        if (n % 4 == 1) {
+            b[3] ^= 1;
+        }
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+        }
+    }
+
+    phys_ch_t *phys_ch = tetrapol_phys_ch_create(TETRAPOL_BAND_UHF,
+            RADIO_CH_TYPE_TRAFFIC);
+    assert_non_null(phys_ch);
+    tetrapol_phys_ch_set_scr(phys_ch, 5);
+    phys_ch_quality_t q;
+    tetrapol_phys_ch_get_quality(phys_ch, &q);
+    assert_false(q.has_frame_sync);
+    assert_int_equal(q.nframes, 0);
+
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch, bits, sizeof(bits)));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    tetrapol_phys_ch_get_quality(phys_ch, &q);
+    assert_true(q.has_frame_sync);
+    assert_int_equal(q.nframes, PHYS_CH_QUALITY_FRAMES);
+    assert_true(fabsf(q.sync_errs - 0.25f) < 0.1f);
+    assert_true(fabsf(q.nerrs - 0.5f) < 0.15f);
+    assert_true(fabsf(q.crc_errs - 0.25f) < 0.1f);
+
+    // frames lost in fade count as errors
+    static uint8_t noise[3 * FRAME_LEN];
+    assert_int_equal(sizeof(noise),
+            tetrapol_phys_ch_recv(phys_ch, noise, sizeof(noise)));
+    assert_int_equal(sizeof(bits),
+            tetrapol_phys_ch_recv(phys_ch, bits, sizeof(bits)));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    phys_ch_stats_t stats;
+    tetrapol_phys_ch_get_stats(phys_ch, &stats);
+    assert_int_equal(stats.sync_found, 1);
+    assert_int_equal(stats.fade_frames, 3);
+
+    // averages restart with new frame sync
+    tetrapol_phys_ch_resync(phys_ch);
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    tetrapol_phys_ch_get_quality(phys_ch, &q);
+    assert_false(q.has_frame_sync);
+    assert_int_equal(3 * FRAME_LEN,
+            tetrapol_phys_ch_recv(phys_ch, bits, 3 * FRAME_LEN));
+    assert_int_equal(0, tetrapol_phys_ch_process(phys_ch));
+    tetrapol_phys_ch_get_quality(phys_ch, &q);
+    assert_true(q.has_frame_sync);
+    // the next frame has error in frame sync, more frames are required
+    // to track it
+    assert_int_equal(q.nframes, 1);
+    assert_true(q.sync_errs == 0);
+    assert_true(q.nerrs == 0);
+    assert_true(q.crc_errs == 0);
+
+    tetrapol_phys_ch_destroy(phys_ch);
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_frame_deinterleave),
         unit_test(test_frame_diff_dec),
+        unit_test(test_recv_packed),
+        unit_test(test_recv_buf),
+        unit_test(test_find_frame_sync),
+        unit_test(test_track_frame_sync),
+        unit_test(test_mem_size),
+        unit_test(test_detect_scr),
+        unit_test(test_preload_scr),
+        unit_test(test_frame_dec),
+        unit_test(test_traffic_ch),
+        unit_test(test_timestamps),
+        unit_test(test_process_batch),
+        unit_test(test_quality),
     };
 
     return run_tests(tests);
@@ -0,0 +1,118 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, frame encoder requires internals of phys_ch
+#include "phys_ch.c"
+#include "frame_enc.c"
+#undef LOG_PREFIX
+#include "tetrapol.c"
+
+typedef struct {
+    int nframes[2];
+    int nvoice[2];
+    int ntsdus;
+    int64_t last_timestamp;
+} counters_t;
+
+static void frame_cb(int ch, const frame_info_t *fi, void *ptr)
+{
+    counters_t *cnt = ptr;
+
+    assert_true(ch >= 0 && ch < 2);
+    assert_int_equal(fi->fr_type, FRAME_TYPE_VOICE);
+    ++cnt->nframes[ch];
+}
+
+static void voice_cb(int ch, const voice_frame_t *vf, void *ptr)
+{
+    counters_t *cnt = ptr;
+
+    assert_true(ch >= 0 && ch < 2);
+    assert_true(vf->crc_ok);
+    ++cnt->nvoice[ch];
+    cnt->last_timestamp = vf->timestamp;
+}
+
+static void tsdu_cb(int ch, const tsdu_t *tsdu, void *ptr)
+{
+    counters_t *cnt = ptr;
+
+    ++cnt->ntsdus;
+}
+
+// decoded data are delivered into callbacks tagged by channel index
+static void test_callbacks(void **state)
+{
+    (void) state;   // unused
+
+    const uint8_t frame_sync[FRAME_HDR_LEN] = { 0, 1, 0, 1, 0, 0, 1, 1, };
+    const int nframes = 6;
+    uint8_t bits[nframes * FRAME_LEN];
+    uint32_t r = 1357;
+
+    for (int n = 0; n < nframes; ++n) {
+        uint8_t blk[126];
+        assert_true(mk_data_block(blk, FRAME_TYPE_VOICE, &r));
+        frame_t f;
+        mk_frame(&f, blk, FRAME_TYPE_VOICE, TETRAPOL_BAND_UHF, 0);
+        uint8_t *b = &bits[n * FRAME_LEN];
+        memcpy(b, frame_sync, FRAME_HDR_LEN);
+        for (int i = 0; i < FRAME_DATA_LEN; ++i) {
+            b[FRAME_HDR_LEN + i] = f.data[i] ^ (i ? f.data[i - 1] : 0);
+        }
+    }
+
+    counters_t cnt = { .ntsdus = 0, };
+    const tpol_callbacks_t cbs = {
+        .frame = frame_cb,
+        .tsdu = tsdu_cb,
+        .voice = voice_cb,
+    };
+    tpol_t *tpol = tpol_create(&cbs, &cnt);
+    assert_non_null(tpol);
+    assert_int_equal(tpol_phys_chs(tpol), 0);
+    assert_int_equal(tpol_add_phys_ch(tpol, TETRAPOL_BAND_UHF,
+                RADIO_CH_TYPE_TRAFFIC), 0);
+    assert_int_equal(tpol_add_phys_ch(tpol, TETRAPOL_BAND_UHF,
+                RADIO_CH_TYPE_TRAFFIC), 1);
+    assert_int_equal(tpol_phys_chs(tpol), 2);
+    assert_null(tpol_get_phys_ch(tpol, 2));
+    assert_int_equal(tpol_recv(tpol, -1, bits, FRAME_LEN), -1);
+
+    for (int ch = 0; ch < 2; ++ch) {
+        phys_ch_t *phys_ch = tpol_get_phys_ch(tpol, ch);
+        assert_non_null(phys_ch);
+        tetrapol_phys_ch_set_scr(phys_ch, 0);
+    }
+
+    // whole input at once into channel 1, frame by frame into channel 0
+    assert_int_equal(tpol_recv(tpol, 1, bits, sizeof(bits)), 0);
+    assert_int_equal(cnt.nvoice[0], 0);
+    assert_int_equal(cnt.nvoice[1], nframes);
+    assert_int_equal(cnt.nframes[1], nframes);
+    assert_int_equal(cnt.last_timestamp, (nframes - 1) * 20000);
+    for (int n = 0; n < nframes; ++n) {
+        assert_int_equal(tpol_recv(tpol, 0, &bits[n * FRAME_LEN], FRAME_LEN), 0);
+    }
+    assert_int_equal(cnt.nvoice[0], nframes);
+    assert_int_equal(cnt.nframes[0], nframes);
+    assert_int_equal(cnt.ntsdus, 0);
+
+    phys_ch_stats_t stats;
+    tpol_get_stats(tpol, 1, &stats);
+    assert_int_equal(stats.voice_frames, nframes);
+    assert_int_equal(stats.crc_ok, nframes);
+
+    tpol_destroy(tpol);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_callbacks),
+    };
+
+    return run_tests(tests);
+}
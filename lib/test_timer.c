@@ -63,10 +63,140 @@ static void test_t1(void **state)
     timer_destroy(timer);
 }
 
+static int64_t fired[4];
+static int nfired[4];
+
+static void deadline_cb(const timeval_t *tv, void *ptr)
+{
+    const int i = (int *)ptr - nfired;
+    fired[i] = tv->tv_sec * 1000000LL + tv->tv_usec;
+    ++nfired[i];
+}
+
+static timer_deadline_t *dl_to_stop;
+static void deadline_stop_cb(const timeval_t *tv, void *ptr)
+{
+    deadline_cb(tv, ptr);
+    timer_stop(dl_to_stop);
+}
+
+static void test_wheel(void **state)
+{
+    (void) state;   // unused
+
+    memset(fired, 0, sizeof(fired));
+    memset(nfired, 0, sizeof(nfired));
+
+    timer_t *timer = timer_create();
+    assert_non_null(timer);
+
+    timer_deadline_t dl[4];
+    for (int i = 0; i < 4; ++i) {
+        timer_deadline_init(&dl[i], deadline_cb, &nfired[i]);
+        assert_false(timer_deadline_pending(&dl[i]));
+    }
+
+    // one-shot, periodic, longer than wheel, stopped
+    timer_start(timer, &dl[0], 50000, 0);
+    timer_start(timer, &dl[1], 0, 30000);
+    timer_start(timer, &dl[2], 10 * 1000000 + 10000, 0);
+    timer_start(timer, &dl[3], 40000, 0);
+    timer_stop(&dl[3]);
+    timer_stop(&dl[3]);
+    assert_false(timer_deadline_pending(&dl[3]));
+
+    // sub-slot ticks, as done when searching for sync
+    for (int i = 0; i < 10; ++i) {
+        timer_tick(timer, 2000);
+    }
+    assert_int_equal(nfired[1], 1);
+    assert_int_equal(fired[1], 2000);
+    assert_int_equal(nfired[0], 0);
+
+    for (int t = 20000; t < 10 * 1000000; t += 20000) {
+        timer_tick(timer, 20000);
+        if (t < 40000) {
+            assert_int_equal(nfired[0], 0);
+        } else {
+            assert_int_equal(nfired[0], 1);
+            assert_int_equal(fired[0], 60000);
+        }
+    }
+    assert_false(timer_deadline_pending(&dl[0]));
+    assert_int_equal(nfired[2], 0);
+    assert_true(timer_deadline_pending(&dl[2]));
+    // periodic deadline fires once per 30 ms, ticks are 20 ms apart
+    assert_int_equal(nfired[1], 10000000 / 30000 + 1);
+    assert_int_equal(nfired[3], 0);
+
+    timer_tick(timer, 20000);
+    assert_int_equal(nfired[2], 1);
+    assert_int_equal(fired[2], 10000000 + 20000);
+    assert_false(timer_deadline_pending(&dl[2]));
+
+    // jump over whole wheel, periodic deadline fires only once
+    const int n = nfired[1];
+    timer_start(timer, &dl[0], 3 * TIMER_SLOT_US * TIMER_WHEEL_SLOTS, 0);
+    timer_tick(timer, 2 * TIMER_SLOT_US * TIMER_WHEEL_SLOTS);
+    assert_int_equal(nfired[1], n + 1);
+    assert_int_equal(nfired[0], 1);
+    timer_tick(timer, 2 * TIMER_SLOT_US * TIMER_WHEEL_SLOTS);
+    assert_int_equal(nfired[0], 2);
+
+    // callback stops deadline which is due at the same time
+    timer_stop(&dl[1]);
+    timer_deadline_init(&dl[0], deadline_stop_cb, &nfired[0]);
+    dl_to_stop = &dl[3];
+    timer_start(timer, &dl[0], 1000, 0);
+    timer_start(timer, &dl[3], 1000, 0);
+    timer_tick(timer, 1000);
+    assert_int_equal(nfired[0], 3);
+    assert_int_equal(nfired[3], 0);
+    assert_false(timer_deadline_pending(&dl[3]));
+
+    timer_destroy(timer);
+}
+
+// pending deadlines are unlinked by destruction of timer
+static void test_fini(void **state)
+{
+    (void) state;   // unused
+
+    // constructed in caller memory, as done by phys_ch
+    const int nslots = 4;
+    _Alignas(max_align_t) char mem[256];
+    assert_true(timer_sizeof(nslots) <= sizeof(mem));
+    timer_t *timer = (timer_t *)mem;
+    timer_init(timer, nslots);
+
+    // two deadlines share slot, one is periodic
+    timer_deadline_t dl[3];
+    for (int i = 0; i < 3; ++i) {
+        timer_deadline_init(&dl[i], deadline_cb, &nfired[i]);
+    }
+    timer_start(timer, &dl[0], 0, TIMER_SLOT_US);
+    timer_start(timer, &dl[1], nslots * TIMER_SLOT_US, 0);
+    timer_start(timer, &dl[2], TIMER_SLOT_US, 0);
+    timer_fini(timer);
+    for (int i = 0; i < 3; ++i) {
+        assert_false(timer_deadline_pending(&dl[i]));
+    }
+
+    timer = timer_create();
+    assert_non_null(timer);
+    timer_start(timer, &dl[0], 0, TIMER_SLOT_US);
+    timer_start(timer, &dl[1], 0, 0);
+    timer_destroy(timer);
+    assert_false(timer_deadline_pending(&dl[0]));
+    assert_false(timer_deadline_pending(&dl[1]));
+}
+
 int main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_t1),
+        unit_test(test_wheel),
+        unit_test(test_fini),
     };
 
     return run_tests(tests);
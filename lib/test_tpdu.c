@@ -0,0 +1,332 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+// include, we are testing static methods
+#include "tpdu.c"
+
+/// number of TSDU bytes in test segments (D_EXPLICIT_SHORT_DATA + 24 bytes)
+#define TSDU_LEN 25
+
+/**
+  Make segment of UI DU carrying bytes 10*packet_num ... of test TSDU.
+  Segments 0 and 1 have 10 bytes, segment 2 is the last with 5 bytes.
+  */
+static void mk_seg(hdlc_frame_t *hdlc_fr, int seg_ref, int packet_num)
+{
+    // segment data are copied by TPDU, buffer can be reused
+    static uint8_t data[HDLC_DATA_LEN_MAX];
+    const bool last = packet_num == 2;
+    const int len = last ? 5 : 10;
+
+    memset(hdlc_fr, 0, sizeof(*hdlc_fr));
+    memset(data, 0, sizeof(data));
+    hdlc_fr->data = data;
+    // EXT=1, SEG, PRIO=2, ID_TSAP=5
+    data[0] = 0x80 | (last ? 0 : 0x40) | (2 << 4) | 5;
+    data[1] = 0x80 | seg_ref;
+    data[2] = packet_num;
+    uint8_t *d = &data[3];
+    if (last) {
+        *d++ = len;
+    }
+    for (int i = 0; i < len; ++i) {
+        const int n = 10 * packet_num + i;
+        d[i] = n ? n : D_EXPLICIT_SHORT_DATA;
+    }
+    // use whole frame for last segment, lenght is given explicitly
+    hdlc_fr->nbits = last ?
+        8 * sizeof(data) : 8 * (d - data + len);
+}
+
+static void check_tsdu(tpdu_ui_t *tpdu)
+{
+    const tsdu_d_explicit_short_data_t *tsdu =
+        (const tsdu_d_explicit_short_data_t *)tpdu_ui_get_tsdu(tpdu);
+    assert_non_null(tsdu);
+    assert_int_equal(tsdu->base.codop, D_EXPLICIT_SHORT_DATA);
+    assert_int_equal(tsdu->base.prio, 2);
+    assert_int_equal(tsdu->base.id_tsap, 5);
+    assert_int_equal(tsdu->len, TSDU_LEN - 1);
+    for (int i = 0; i < tsdu->len; ++i) {
+        assert_int_equal(tsdu->data[i], i + 1);
+    }
+}
+
+static int nfree_segs(const tpdu_ui_t *tpdu)
+{
+    int n = 0;
+    for (const seg_buf_t *buf = tpdu->seg_free; buf; buf = buf->next) {
+        ++n;
+    }
+
+    return n;
+}
+
+static void test_reassembly(void **state)
+{
+    (void) state;   // unused
+
+    hdlc_frame_t hdlc_fr;
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_DATA);
+    assert_non_null(tpdu);
+
+    // in order
+    for (int i = 0; i < 3; ++i) {
+        mk_seg(&hdlc_fr, 7, i);
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr), i == 2);
+    }
+    check_tsdu(tpdu);
+    assert_null(tpdu->du_first);
+
+    // out of order, with duplicates, interleaved with other DU
+    const int order[][2] = {
+        { 1, 2 }, { 3, 1 }, { 1, 2 }, { 1, 1 }, { 3, 0 }, { 3, 2 }, { 1, 0 },
+    };
+    for (int i = 0; i < ARRAY_LEN(order); ++i) {
+        mk_seg(&hdlc_fr, order[i][0], order[i][1]);
+        const bool done = tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr);
+        assert_int_equal(done, i == 5 || i == 6);
+        if (done) {
+            check_tsdu(tpdu);
+        }
+        if (i == 3) {
+            assert_int_equal(nfree_segs(tpdu), SEG_SLAB_SIZE - 3);
+        }
+    }
+    assert_null(tpdu->du_first);
+    assert_int_equal(nfree_segs(tpdu), SEG_SLAB_SIZE);
+
+    // segmented frames are not allowed
+    mk_seg(&hdlc_fr, 1, 0);
+    assert_false(tpdu_ui_push_hdlc_frame2(tpdu, &hdlc_fr));
+    assert_null(tpdu->du_first);
+
+    tpdu_ui_destroy(tpdu);
+}
+
+static void test_t454(void **state)
+{
+    (void) state;   // unused
+
+    hdlc_frame_t hdlc_fr;
+    timeval_t tv = { .tv_sec = 100, .tv_usec = 0, };
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_DATA);
+    assert_non_null(tpdu);
+    tpdu_du_tick(&tv, tpdu);
+
+    mk_seg(&hdlc_fr, 1, 0);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    tv.tv_sec += 5;
+    tpdu_du_tick(&tv, tpdu);
+    mk_seg(&hdlc_fr, 2, 2);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    assert_true(tpdu->du_first == &tpdu->seg->seg_du[1]);
+    assert_true(tpdu->du_last == &tpdu->seg->seg_du[2]);
+
+    // DU 1 receives segment, T454 restarts, expires after DU 2
+    tv.tv_sec += 1;
+    tpdu_du_tick(&tv, tpdu);
+    mk_seg(&hdlc_fr, 1, 2);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    assert_true(tpdu->du_first == &tpdu->seg->seg_du[2]);
+    assert_true(tpdu->du_last == &tpdu->seg->seg_du[1]);
+
+    tv.tv_sec += 8;
+    tv.tv_usec = 999999;
+    tpdu_du_tick(&tv, tpdu);
+    assert_true(tpdu->du_first == &tpdu->seg->seg_du[2]);
+
+    tv.tv_sec += 1;
+    tv.tv_usec = 0;
+    tpdu_du_tick(&tv, tpdu);
+    assert_true(tpdu->du_first == &tpdu->seg->seg_du[1]);
+    assert_false(tpdu->seg->seg_du[2].active);
+
+    tv.tv_sec += 1;
+    tpdu_du_tick(&tv, tpdu);
+    assert_null(tpdu->du_first);
+    assert_null(tpdu->du_last);
+    assert_int_equal(nfree_segs(tpdu), SEG_SLAB_SIZE);
+
+    // segments received before expiration are lost
+    mk_seg(&hdlc_fr, 1, 1);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    mk_seg(&hdlc_fr, 1, 2);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    mk_seg(&hdlc_fr, 1, 0);
+    assert_true(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    check_tsdu(tpdu);
+
+    tpdu_ui_destroy(tpdu);
+}
+
+// memory for reassembly and TSDU is allocated on demand
+static void test_hibernate(void **state)
+{
+    (void) state;   // unused
+
+    hdlc_frame_t hdlc_fr;
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_DATA);
+    assert_non_null(tpdu);
+    assert_int_equal(tpdu_ui_get_heap_size(tpdu), 0);
+
+    mk_seg(&hdlc_fr, 3, 1);
+    assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    assert_non_null(tpdu->seg);
+    assert_true(tpdu_ui_get_heap_size(tpdu) >= sizeof(seg_state_t));
+    assert_null(tpdu->arena);
+
+    // pending DU is dropped
+    tpdu_ui_hibernate(tpdu);
+    assert_int_equal(tpdu_ui_get_heap_size(tpdu), 0);
+    assert_null(tpdu->du_first);
+
+    for (int i = 0; i < 3; ++i) {
+        mk_seg(&hdlc_fr, 3, i);
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr), i == 2);
+    }
+    assert_true(tpdu_ui_get_heap_size(tpdu) >=
+            sizeof(seg_state_t) + TSDU_ARENA_SIZE);
+    check_tsdu(tpdu);
+    tpdu_ui_hibernate(tpdu);
+    assert_int_equal(tpdu_ui_get_heap_size(tpdu), 0);
+    assert_null(tpdu_ui_get_tsdu(tpdu));
+
+    tpdu_ui_destroy(tpdu);
+}
+
+static void test_filter(void **state)
+{
+    (void) state;   // unused
+
+    hdlc_frame_t hdlc_fr;
+    tsdu_filter_t filter;
+    tsdu_filter_set_all(&filter, true);
+    tsdu_filter_set(&filter, D_EXPLICIT_SHORT_DATA, false);
+    assert_false(tsdu_filter_has(&filter, D_EXPLICIT_SHORT_DATA));
+    assert_true(tsdu_filter_has(&filter, D_GROUP_LIST));
+
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_DATA);
+    assert_non_null(tpdu);
+    tpdu_ui_set_filter(tpdu, &filter);
+
+    // DU is reassembled, but not decoded
+    for (int i = 0; i < 3; ++i) {
+        mk_seg(&hdlc_fr, 7, i);
+        assert_false(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    }
+    assert_null(tpdu_ui_get_tsdu(tpdu));
+    assert_null(tpdu->du_first);
+    assert_int_equal(tpdu_ui_get_tsdu_errs(tpdu), 0);
+
+    // filter is not copied, subscription takes effect immediately
+    tsdu_filter_set(&filter, D_EXPLICIT_SHORT_DATA, true);
+    for (int i = 0; i < 3; ++i) {
+        mk_seg(&hdlc_fr, 7, i);
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr), i == 2);
+    }
+    check_tsdu(tpdu);
+
+    tpdu_ui_destroy(tpdu);
+}
+
+static void test_hr_data(void **state)
+{
+    (void) state;   // unused
+
+    hdlc_frame_t hdlc_fr;
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_HR_DATA);
+    assert_non_null(tpdu);
+
+    // segments are framed as in data frames
+    for (int i = 0; i < 3; ++i) {
+        mk_seg(&hdlc_fr, 7, i);
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr), i == 2);
+    }
+    check_tsdu(tpdu);
+
+    // unsegmented DU longer than 6 bytes has explicit length
+    static uint8_t data[HDLC_DATA_LEN_MAX];
+    memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+    hdlc_fr.data = data;
+    // EXT=0, SEG=0, PRIO=2, ID_TSAP=5
+    data[0] = (2 << 4) | 5;
+    data[1] = TSDU_LEN;
+    for (int i = 0; i < TSDU_LEN; ++i) {
+        data[2 + i] = i ? i : D_EXPLICIT_SHORT_DATA;
+    }
+    hdlc_fr.nbits = 8 * sizeof(data);
+    assert_true(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr));
+    check_tsdu(tpdu);
+
+    tpdu_ui_destroy(tpdu);
+}
+
+// segments of the longest HDLC frame (8 high rate blocks) are kept while
+// waiting for their predecessors
+static void test_hr_segment_out_of_order(void **state)
+{
+    (void) state;   // unused
+
+    // payload of non-final segments fills whole HDLC frame
+    const int seg_len = HDLC_DATA_LEN_MAX - 3;
+    const int last_len = 20;
+    static uint8_t data[HDLC_DATA_LEN_MAX];
+    hdlc_frame_t hdlc_fr;
+    tpdu_ui_t *tpdu = tpdu_ui_create(FRAME_TYPE_HR_DATA);
+    assert_non_null(tpdu);
+
+    const int order[] = { 1, 2, 0, };
+    for (int i = 0; i < ARRAY_LEN(order); ++i) {
+        const int packet_num = order[i];
+        const bool last = packet_num == 2;
+        memset(&hdlc_fr, 0, sizeof(hdlc_fr));
+        memset(data, 0, sizeof(data));
+        hdlc_fr.data = data;
+        // EXT=1, SEG, PRIO=2, ID_TSAP=5, SEGM_REF=3
+        data[0] = 0x80 | (last ? 0 : 0x40) | (2 << 4) | 5;
+        data[1] = 0x80 | 3;
+        data[2] = packet_num;
+        uint8_t *d = &data[3];
+        if (last) {
+            *d++ = last_len;
+        }
+        const int len = last ? last_len : seg_len;
+        for (int j = 0; j < len; ++j) {
+            const int n = seg_len * packet_num + j;
+            d[j] = n ? n : D_EXPLICIT_SHORT_DATA;
+        }
+        // 8 * 92 bits of high rate blocks - HDLC header and FCS
+        hdlc_fr.nbits = 8 * 92 - 40;
+        assert_int_equal(8 * sizeof(data), hdlc_fr.nbits);
+        assert_int_equal(tpdu_ui_push_hdlc_frame(tpdu, &hdlc_fr), i == 2);
+    }
+
+    const tsdu_d_explicit_short_data_t *tsdu =
+        (const tsdu_d_explicit_short_data_t *)tpdu_ui_get_tsdu(tpdu);
+    assert_non_null(tsdu);
+    assert_int_equal(tsdu->base.codop, D_EXPLICIT_SHORT_DATA);
+    assert_int_equal(tsdu->len, 2 * seg_len + last_len - 1);
+    for (int i = 0; i < tsdu->len; ++i) {
+        assert_int_equal(tsdu->data[i], i + 1);
+    }
+    assert_int_equal(nfree_segs(tpdu), SEG_SLAB_SIZE);
+
+    tpdu_ui_destroy(tpdu);
+}
+
+int main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_reassembly),
+        unit_test(test_t454),
+        unit_test(test_hibernate),
+        unit_test(test_filter),
+        unit_test(test_hr_data),
+        unit_test(test_hr_segment_out_of_order),
+    };
+
+    return run_tests(tests);
+}
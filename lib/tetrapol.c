@@ -0,0 +1,184 @@
+#define LOG_PREFIX "tpol"
+#include <tetrapol/log.h>
+#include <tetrapol/tetrapol.h>
+
+#include <stdlib.h>
+
+typedef struct {
+    tpol_t *tpol;
+    int idx;
+    phys_ch_t *phys_ch;
+} tpol_phys_ch_t;
+
+struct _tpol_t {
+    tpol_callbacks_t cbs;
+    void *cbs_ptr;
+    event_writer_t *event_writer;
+    int nphys_chs;
+    tpol_phys_ch_t *phys_chs[TPOL_PHYS_CHS_MAX];
+};
+
+tpol_t *tpol_create(const tpol_callbacks_t *cbs, void *ptr)
+{
+    tpol_t *tpol = calloc(1, sizeof(tpol_t));
+    if (!tpol) {
+        return NULL;
+    }
+
+    if (cbs) {
+        tpol->cbs = *cbs;
+    }
+    tpol->cbs_ptr = ptr;
+
+    return tpol;
+}
+
+void tpol_destroy(tpol_t *tpol)
+{
+    if (!tpol) {
+        return;
+    }
+
+    for (int i = 0; i < tpol->nphys_chs; ++i) {
+        tetrapol_phys_ch_destroy(tpol->phys_chs[i]->phys_ch);
+        free(tpol->phys_chs[i]);
+    }
+    free(tpol);
+}
+
+static void tpol_frame_sink(const frame_info_t *fi, void *ptr)
+{
+    tpol_phys_ch_t *ch = ptr;
+    tpol_t *tpol = ch->tpol;
+
+    tpol->cbs.frame(ch->idx, fi, tpol->cbs_ptr);
+}
+
+static void tpol_tsdu_sink(const tsdu_t *tsdu, void *ptr)
+{
+    tpol_phys_ch_t *ch = ptr;
+    tpol_t *tpol = ch->tpol;
+
+    if (tpol->event_writer && event_write_tsdu(tpol->event_writer, tsdu)) {
+        LOG(ERR, "failed to write TSDU event");
+    }
+    if (tpol->cbs.tsdu) {
+        tpol->cbs.tsdu(ch->idx, tsdu, tpol->cbs_ptr);
+    }
+}
+
+static void tpol_pch_sink(const pch_data_t *pch_data, void *ptr)
+{
+    tpol_phys_ch_t *ch = ptr;
+    tpol_t *tpol = ch->tpol;
+
+    tpol->cbs.pch(ch->idx, pch_data, tpol->cbs_ptr);
+}
+
+static void tpol_rch_sink(const rch_data_t *rch_data, void *ptr)
+{
+    tpol_phys_ch_t *ch = ptr;
+    tpol_t *tpol = ch->tpol;
+
+    tpol->cbs.rch(ch->idx, rch_data, tpol->cbs_ptr);
+}
+
+static void tpol_voice_sink(const voice_frame_t *vf, void *ptr)
+{
+    tpol_phys_ch_t *ch = ptr;
+    tpol_t *tpol = ch->tpol;
+
+    if (tpol->event_writer && event_write_voice(tpol->event_writer,
+                vf->timestamp, vf->frame_no, vf->crc_ok, vf->data)) {
+        LOG(ERR, "failed to write voice event");
+    }
+    if (tpol->cbs.voice) {
+        tpol->cbs.voice(ch->idx, vf, tpol->cbs_ptr);
+    }
+}
+
+int tpol_add_phys_ch(tpol_t *tpol, int band, int radio_ch_type)
+{
+    if (tpol->nphys_chs >= TPOL_PHYS_CHS_MAX) {
+        LOG(ERR, "too many physical channels");
+        return -1;
+    }
+
+    tpol_phys_ch_t *ch = malloc(sizeof(tpol_phys_ch_t));
+    if (!ch) {
+        return -1;
+    }
+    ch->phys_ch = tetrapol_phys_ch_create(band, radio_ch_type);
+    if (!ch->phys_ch) {
+        free(ch);
+        return -1;
+    }
+    ch->tpol = tpol;
+    ch->idx = tpol->nphys_chs;
+
+    // TSDU and voice sinks are required also for event output,
+    // others are registered only when used to keep the decoding path short
+    if (tpol->cbs.frame) {
+        tetrapol_phys_ch_set_frame_sink(ch->phys_ch, tpol_frame_sink, ch);
+    }
+    tetrapol_phys_ch_set_tsdu_sink(ch->phys_ch, tpol_tsdu_sink, ch);
+    if (tpol->cbs.pch) {
+        tetrapol_phys_ch_set_pch_sink(ch->phys_ch, tpol_pch_sink, ch);
+    }
+    if (tpol->cbs.rch) {
+        tetrapol_phys_ch_set_rch_sink(ch->phys_ch, tpol_rch_sink, ch);
+    }
+    tetrapol_phys_ch_set_voice_sink(ch->phys_ch, tpol_voice_sink, ch);
+
+    tpol->phys_chs[tpol->nphys_chs] = ch;
+
+    return tpol->nphys_chs++;
+}
+
+int tpol_phys_chs(const tpol_t *tpol)
+{
+    return tpol->nphys_chs;
+}
+
+phys_ch_t *tpol_get_phys_ch(tpol_t *tpol, int ch)
+{
+    if (ch < 0 || ch >= tpol->nphys_chs) {
+        return NULL;
+    }
+
+    return tpol->phys_chs[ch]->phys_ch;
+}
+
+void tpol_set_event_writer(tpol_t *tpol, event_writer_t *ew)
+{
+    tpol->event_writer = ew;
+}
+
+int tpol_recv(tpol_t *tpol, int ch, uint8_t *buf, int len)
+{
+    phys_ch_t *phys_ch = tpol_get_phys_ch(tpol, ch);
+    if (!phys_ch) {
+        LOG(ERR, "tpol_recv() invalid param 'ch'");
+        return -1;
+    }
+
+    while (len > 0) {
+        const int rsize = tetrapol_phys_ch_recv(phys_ch, buf, len);
+        if (rsize < 0) {
+            return -1;
+        }
+        buf += rsize;
+        len -= rsize;
+
+        if (tetrapol_phys_ch_process(phys_ch)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void tpol_get_stats(tpol_t *tpol, int ch, phys_ch_stats_t *stats)
+{
+    tetrapol_phys_ch_get_stats(tpol_get_phys_ch(tpol, ch), stats);
+}
@@ -56,4 +56,11 @@ inline void addr_parse(addr_t *addr, const uint8_t *buf, int skip)
     addr->x = get_bits(12, buf, 4 + skip);
 }
 
+inline void addr_read(addr_t *addr, bit_reader_t *br)
+{
+    addr->z = bit_reader_get(br, 1);
+    addr->y = bit_reader_get(br, 3);
+    addr->x = bit_reader_get(br, 12);
+}
+
 void addr_print(const addr_t *addr);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+  Bump allocator, memory is released all at once by arena_reset().
+
+  Blocks allocated by arena are kept on reset, so once the arena grows
+  to the required size no more malloc/free is done.
+  */
+typedef struct _arena_t arena_t;
+
+/**
+  Create arena.
+
+  @param block_size Size of first block, further blocks are allocated
+    when required.
+  */
+arena_t *arena_create(size_t block_size);
+void arena_destroy(arena_t *arena);
+
+/// Release all allocations, memory is kept for reuse.
+void arena_reset(arena_t *arena);
+
+/// Allocate memory, aligned for any type, NULL is returned when OOM.
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+  Change size of allocation.
+
+  Last allocation is resized in place when possible, otherwise new memory
+  is allocated and data are copied. Old memory is released on arena reset.
+
+  @param ptr Allocation from this arena or NULL.
+  */
+void *arena_realloc(arena_t *arena, void *ptr, size_t size);
+
+/// Get size of allocation made by arena_alloc() or arena_realloc().
+size_t arena_alloc_size(const void *ptr);
+
+/// Get total size of memory allocated by arena, including all blocks.
+size_t arena_mem_size(const arena_t *arena);
+
+/// Get space occupied in arena block by allocation of 'size' bytes.
+size_t arena_alloc_space(size_t size);
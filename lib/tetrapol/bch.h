@@ -1,11 +1,34 @@
 #pragma once
 
 #include <tetrapol/data_block.h>
+#include <tetrapol/stats.h>
 #include <tetrapol/tsdu.h>
 
+#include <stddef.h>
+
 typedef struct _bch_t bch_t;
 
 bch_t *bch_create(void);
 void bch_destroy(bch_t *bch);
+/// Construct in memory provided by caller, bch_sizeof() bytes aligned for
+/// any type, the BCH components are placed in the same memory.
+void bch_init(bch_t *bch);
+/// Release BCH constructed by bch_init(), memory is owned by caller.
+void bch_fini(bch_t *bch);
+size_t bch_sizeof(void);
+/// Release memory allocated on demand, pending data are dropped.
+void bch_hibernate(bch_t *bch);
+/// Get size of memory allocated on demand, not included in bch_sizeof().
+size_t bch_get_heap_size(const bch_t *bch);
+/// Skip decoding of recently decoded payloads, see tetrapol/dup_cache.h
+void bch_set_dup_suppress(bch_t *bch, bool suppress);
 bool bch_push_data_block(bch_t *bch, data_block_t* data_blk);
+/// TSDU is valid until next data block is pushed, see tsdu_clone()
 tsdu_d_system_info_t *bch_get_tsdu(bch_t *bch);
+/**
+  @return how many times was the payload repeated when its decoding was
+    skipped by the last bch_push_data_block() returning true (no TSDU),
+    0 when it was decoded
+  */
+int bch_get_repeats(const bch_t *bch);
+void bch_get_stats(const bch_t *bch, log_ch_stats_t *stats);
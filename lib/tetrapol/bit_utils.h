@@ -4,6 +4,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 /// PAS 0001-3-3 7.4.1.1
 /**
@@ -38,6 +39,117 @@ inline uint32_t get_bits(int len, const uint8_t *data, int skip)
     return r;
 }
 
+/**
+ * Bit reader cursor over byte array (bytes of TETRAPOL data frame), bits
+ * are read MSB first.
+ *
+ * Reads are bounded by the end of data, read past the end returns zero
+ * and sets sticky overflow flag, so decoder can read all fields and check
+ * for too short data just once.
+ */
+typedef struct {
+    const uint8_t *data;
+    int end;        ///< index of the first bit after the end of data
+    int pos;        ///< index of the next bit
+    bool overflow;  ///< some read was past the end of data
+} bit_reader_t;
+
+inline void bit_reader_init(bit_reader_t *br, const uint8_t *data, int nbits)
+{
+    br->data = data;
+    br->end = nbits;
+    br->pos = 0;
+    br->overflow = false;
+}
+
+/// Get number of bits left.
+inline int bit_reader_left(const bit_reader_t *br)
+{
+    return br->end - br->pos;
+}
+
+/**
+ * Load 64 bits starting at byte 'i' as big-endian integer, bytes after
+ * the end of data are read as zero.
+ */
+inline uint64_t bit_reader_load(const bit_reader_t *br, int i)
+{
+    const int nbytes = (br->end + 7) / 8;
+    uint64_t r = 0;
+
+    if (i + (int)sizeof(r) <= nbytes) {
+        memcpy(&r, &br->data[i], sizeof(r));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        r = __builtin_bswap64(r);
+#endif
+        return r;
+    }
+
+    // tail of data, the last 8 bytes shifted into place
+    if (i < nbytes && nbytes >= (int)sizeof(r)) {
+        memcpy(&r, &br->data[nbytes - sizeof(r)], sizeof(r));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        r = __builtin_bswap64(r);
+#endif
+        return r << (8 * (i + sizeof(r) - nbytes));
+    }
+
+    // short data
+    for (int k = 0; k < (int)sizeof(r); ++k) {
+        r = (r << 8) | ((i + k < nbytes) ? br->data[i + k] : 0);
+    }
+
+    return r;
+}
+
+/**
+ * @brief bit_reader_get Read integer and advance cursor.
+ * @param len Number of bits, 1 - 32.
+ * @return Integer value, 0 if there is not enough data.
+ */
+inline uint32_t bit_reader_get(bit_reader_t *br, int len)
+{
+    if (len > bit_reader_left(br)) {
+        br->overflow = true;
+        br->pos = br->end;
+        return 0;
+    }
+
+    // 7 bits in first byte skipped at most, 64 - 7 >= 32
+    const uint64_t r = bit_reader_load(br, br->pos / 8) << (br->pos % 8);
+    br->pos += len;
+
+    return r >> (64 - len);
+}
+
+inline void bit_reader_skip(bit_reader_t *br, int len)
+{
+    if (len > bit_reader_left(br)) {
+        br->overflow = true;
+        br->pos = br->end;
+        return;
+    }
+    br->pos += len;
+}
+
+/**
+ * Split next 'len' bits into reader 'sub' and skip them in 'br'.
+ */
+inline void bit_reader_split(bit_reader_t *br, bit_reader_t *sub, int len)
+{
+    *sub = *br;
+    bit_reader_skip(br, len);
+    sub->end = br->pos;
+}
+
+/**
+ * Get pointer to the byte at cursor, for byte aligned cursor only.
+ */
+inline const uint8_t *bit_reader_ptr(const bit_reader_t *br)
+{
+    return &br->data[br->pos / 8];
+}
+
 inline int cmpzero(const void *data, int len)
 {
     for (int i = 0; i < len; ++i) {
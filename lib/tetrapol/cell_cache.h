@@ -0,0 +1,62 @@
+#pragma once
+
+#include <tetrapol/tsdu.h>
+
+#include <stdbool.h>
+
+/**
+  Persistent cache of channel configuration used for warm start.
+
+  Entries are keyed by channel identifier (input path, frequency, ...),
+  key must not contain white space. Cache is stored in text file, one
+  line per channel:
+
+    KEY scr=SCR mux=MUX_TYPE [sysinfo=HEX]
+
+  where unknown values are -1 and HEX is fixed layout of
+  tsdu_d_system_info_t fields. Lines starting with '#' and unknown fields
+  are ignored.
+  */
+
+typedef struct {
+    int scr;            ///< SCR, -1 if unknown
+    int mux_type;       ///< CELL_CONFIG_MUX_TYPE_*, -1 if unknown
+    bool has_sysinfo;
+    /// last system information, base is not initialized
+    tsdu_d_system_info_t sysinfo;
+} cell_cache_entry_t;
+
+typedef struct _cell_cache_t cell_cache_t;
+
+/**
+  Load cache from file.
+
+  @return cache, empty cache for nonexisting file, NULL on error
+  */
+cell_cache_t *cell_cache_load(const char *path);
+void cell_cache_destroy(cell_cache_t *cache);
+
+/**
+  Get cache entry.
+
+  Entries are not moved by creating other entries, entry can be updated
+  by other thread when caller ensures no entry is created meanwhile.
+
+  @param create Create new entry (with unknown values) when missing.
+  @return entry or NULL
+  */
+cell_cache_entry_t *cell_cache_get(cell_cache_t *cache, const char *key,
+        bool create);
+
+/**
+  Store entry values from system information (mux_type and sysinfo).
+  */
+void cell_cache_set_sysinfo(cell_cache_entry_t *entry,
+        const tsdu_d_system_info_t *tsdu);
+
+/**
+  Save cache into file, file is replaced atomically.
+
+  @return 0 on success, -1 on error
+  */
+int cell_cache_save(const cell_cache_t *cache, const char *path);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+  Polyphase filter bank channelizer, replacement of GNU Radio
+  pfb.channelizer_ccf used by demod/tetrapol_rx.py.
+
+  Wideband input at rate fs is split into 'nchs' channels spaced by
+  fs / nchs, each channel is low-pass filtered and decimated by 'decim'.
+  Decimation can be lower than number of channels (oversampled filter
+  bank), e.g. 2.4 MS/s input, 192 channels by 12.5 kHz and decimation 150
+  produces 16 kS/s per channel as required by demod_t.
+
+  Channel k is centered at k * fs / nchs, channels k > nchs / 2 are
+  negative frequencies (k - nchs) * fs / nchs as for FFT.
+
+  Output samples for multiple time instants are computed in parallel
+  by internal threads, each of them does polyphase filtering and FFT
+  for its share of output samples.
+  */
+
+/** Format of samples passed into channelizer_process(). */
+enum {
+    CHANNELIZER_INPUT_CF32 = 0, ///< interleaved float I, Q
+    CHANNELIZER_INPUT_CS16 = 1, ///< interleaved int16_t I, Q
+};
+
+typedef struct _channelizer_t channelizer_t;
+
+/**
+  Create channelizer.
+
+  @param nchs Number of channels, multiple of 4.
+  @param decim Decimation, 1 <= decim <= nchs.
+  @param cutoff Cut-off frequency of channel filter relative to input
+    sample rate, e.g. 4650 / 2.4e6.
+  @param transition Transition width of filter relative to input sample rate.
+  @param input_fmt CHANNELIZER_INPUT_CF32 or CHANNELIZER_INPUT_CS16.
+  @param nthreads Number of threads used by channelizer_process()
+    (including the calling thread).
+  @return new instance or NULL
+  */
+channelizer_t *channelizer_create(int nchs, int decim, double cutoff,
+        double transition, int input_fmt, int nthreads);
+void channelizer_destroy(channelizer_t *chzr);
+
+/// Get number of taps of prototype filter.
+int channelizer_ntaps(const channelizer_t *chzr);
+
+/// Get max. number of output samples (per channel) for 'nsamples' on input.
+int channelizer_out_max(const channelizer_t *chzr, int nsamples);
+
+/**
+  Process wideband samples.
+
+  All samples are consumed, state is kept between calls.
+
+  @param samples Input samples in format set by channelizer_create().
+  @param nsamples Number of complex input samples.
+  @param out Output, channel k starts at out + 2 * k * stride, samples
+    are interleaved float I, Q (as DEMOD_INPUT_CF32).
+  @param stride Distance of channels in 'out' (complex samples), must be
+    at least channelizer_out_max(nsamples).
+  @return number of output samples per channel
+  */
+int channelizer_process(channelizer_t *chzr, const void *samples,
+        int nsamples, float *out, int stride);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <tetrapol/phys_ch.h>
+
+#include <stdint.h>
+
+/**
+  Selection of the best copy of frames of single channel received by
+  several receivers (e.g. SDRs with overlapping coverage).
+
+  Each receiver has own phys_ch_t (combiner_get_rx()) fed by caller, it
+  keeps frame sync, detects SCR, decodes frames and numbers them by BCH.
+  Logical channels are decoded only once by the output phys_ch_t
+  (combiner_get_phys_ch()), set sinks there. Decoding work of upper
+  layers does not grow with number of receivers.
+
+  Frames are aligned by frame number (control channel) extended by
+  timestamp, receiver clocks must not differ by more than
+  COMBINER_MAX_SKEW_US, see combiner_set_rx_offset(). The last frames
+  received before numbering (BCH) are numbered back by the first numbered
+  one. Traffic channel frames are not numbered and are aligned by
+  timestamp only. The copy with valid CRC and the least errors is
+  selected.
+
+  Frame is passed to output when all receivers delivered it or when it is
+  COMBINER_DEPTH frames behind the newest frame, receivers should be fed
+  by chunks shorter than that. Receiver which misses frame passed by
+  depth is waited for again when it delivers next frame.
+  */
+
+#define COMBINER_RX_MAX 8
+/// frames waiting for copies from other receivers
+#define COMBINER_DEPTH 64
+/// max. difference of receiver clocks (us), half of frame number cycle
+#define COMBINER_MAX_SKEW_US (100 * 20000)
+
+typedef struct {
+    uint64_t frames;    ///< frames passed to output
+    /// frames with valid CRC from some receivers only
+    uint64_t recovered;
+    uint64_t late;      ///< copies received after frame was passed
+    /// copies which could not be numbered (control channel), dropped
+    uint64_t unaligned;
+    uint64_t rx_best[COMBINER_RX_MAX];  ///< frames passed from receiver
+} combiner_stats_t;
+
+typedef struct _combiner_t combiner_t;
+
+/**
+  Create combiner of 'nrx' receivers.
+
+  @param band VHF or UHF
+  @param radio_ch_type Radio channel type, control or traffic.
+  @param nrx Number of receivers, 1 to COMBINER_RX_MAX.
+
+  @return new instance or NULL
+  */
+combiner_t *combiner_create(int band, int radio_ch_type, int nrx);
+void combiner_destroy(combiner_t *comb);
+
+/// Get decoder of receiver 'rx', feed it by tetrapol_phys_ch_recv().
+phys_ch_t *combiner_get_rx(combiner_t *comb, int rx);
+
+/// Get decoder of selected frames.
+phys_ch_t *combiner_get_phys_ch(combiner_t *comb);
+
+/**
+  Set offset of receiver clock.
+
+  @param offset Added to timestamps of receiver frames (us).
+  */
+void combiner_set_rx_offset(combiner_t *comb, int rx, int64_t offset);
+
+/// Pass all pending frames to output, e.g. at the end of input.
+void combiner_flush(combiner_t *comb);
+
+void combiner_get_stats(const combiner_t *comb, combiner_stats_t *stats);
@@ -5,6 +5,25 @@
 
 #define FRAME_NO_UNKNOWN -1
 
+/**
+  Assumed layout of high rate data block, it is not verified against
+  specification nor real signal, it is used only to recognize (and count)
+  high rate data frames, blocks are not decoded.
+
+  The first 26 bits (frame type, FN and 23 data bits) have the coding and
+  interleaving of data block, the remaining 100 bits are not coded as in
+  voice block. The frame type bit is the same as for data block, block is
+  recognized by CRC.
+
+    bit  0      frame type, 1
+    bits 1-2    FN
+    bits 3-94   data
+    bits 95-99  CRC5 of bits 0-94, as for data block
+    bits 100-125 stuffing, 0
+  */
+#define HR_DATA_BLOCK_CRC_POS 95
+#define HR_DATA_BLOCK_LEN 126
+
 typedef enum {
     FRAME_TYPE_AUTO = -1,
     FRAME_TYPE_VOICE = 0,
@@ -21,26 +40,74 @@ typedef struct {
     frame_type_t fr_type;
     int frame_no;
     int nerrs;      ///< nonzero value indicate uncorrected errors in block
-    // 74 bytes is required for data frame, but 2 extra bits are reqired
-    // because they are used by decoding algorithm
-    // 126 bits for voice frame
+    int64_t timestamp;  ///< start of frame (us), see frame_info_t
+    // Bits are packed MSB first, bit 0 (frame type) is MSB of data[0].
+    // 74 bits is required for data frame, 2 extra stuffing bits are
+    // decoded too, 126 bits for voice frame.
     // TODO: 152 bits for high rate data frames? (or use BCH and reduce it to 96)
     // TODO: 152 bits for RACH frames?
     // TODO: 152 bits for training frame?
     // TODO: 152 bits for SCH/TI frame?
-    uint8_t data[126];
-    union {
-        uint8_t err[74];
-        uint8_t _tmpe[76];  // extra space, data frame have 2 stuffing bist
-    };
+    uint64_t data[2];
+    uint64_t err[2];    ///< error flags of decoded bits, same layout as data
 } data_block_t;
 
+/**
+  Get single bit of data block.
+
+  @param pos Bit position, 0 is the frame type bit.
+  */
+inline int data_block_get_bit(const data_block_t *data_blk, int pos)
+{
+    return (data_blk->data[pos / 64] >> (63 - pos % 64)) & 1;
+}
+
+/**
+  Get up to 64 bits of data block as integer, first bit is MSB.
+
+  @param pos Position of first bit.
+  @param len Number of bits, 1 to 64.
+  */
+inline uint64_t data_block_get_bits(const data_block_t *data_blk, int pos,
+        int len)
+{
+    uint64_t r = data_blk->data[pos / 64] << (pos % 64);
+    if (pos % 64 && pos / 64 == 0) {
+        r |= data_blk->data[1] >> (64 - pos % 64);
+    }
+
+    return r >> (64 - len);
+}
+
 bool data_block_check_crc(data_block_t *data_blk);
 
+/**
+  Check CRC of data or voice block with bits packed MSB first.
+
+  @param bits Block bits, first bit (frame type) is MSB of bits[0],
+    at least 74 bits for data, 26 bits for voice and 126 bits for high
+    rate data block.
+  @param fr_type Expected frame type or FRAME_TYPE_AUTO, high rate data
+    block is checked only for FRAME_TYPE_HR_DATA.
+  */
+bool data_block_check_crc_packed(const uint64_t *bits, frame_type_t fr_type);
+
+/**
+  Check if data frame is high rate data frame, see HR_DATA_BLOCK_CRC_POS.
+
+  @param data_blk Block decoded from 'data' as FRAME_TYPE_DATA.
+  @param data Deinterleaved frame data, one bit per byte.
+  @return true when the first 26 bits are decoded without errors and CRC
+    of high rate data block is valid
+  */
+bool data_block_check_hr_data(const data_block_t *data_blk,
+        const uint8_t *data);
+
 /**
   Decode data from frame.
 
-  @param data Should contains frame data (withought synchronization block).
+  @param data Should contains frame data (withought synchronization block),
+    one bit per byte.
   */
 void data_block_decode_frame(data_block_t *data_blk, const uint8_t *data,
         int frame_no, frame_type_t fr_type);
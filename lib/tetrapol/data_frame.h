@@ -1,11 +1,22 @@
 #pragma once
 
 #include <tetrapol/data_block.h>
+#include <tetrapol/stats.h>
+
+#include <stddef.h>
 
 typedef struct _data_frame_t data_frame_t;
 
 data_frame_t *data_frame_create(void);
 
+/**
+  Construct data frame decoder in memory provided by caller,
+  data_frame_sizeof() bytes aligned for any type. It owns no other memory
+  so no destruction is required.
+  */
+void data_frame_init(data_frame_t *data_fr);
+size_t data_frame_sizeof(void);
+
 /**
   Reset internal state of data frame decoder.
 
@@ -27,11 +38,17 @@ bool data_frame_push_data_block(data_frame_t *data_fr, data_block_t *data_blk);
 
 /**
   Get data from data_frame, data are packe into bytes.
-  Unused bites in last byte are set to zero.
+  Blocks are packed when pushed, no data are copied.
 
-  @return number of bites writen into output array
+  @param data Set to internal buffer of data_frame, it is valid until
+    next block is pushed.
+  @return number of bites in buffer
   */
-int data_frame_get_bytes(data_frame_t *data_fr, uint8_t *data);
+int data_frame_get_bytes(data_frame_t *data_fr, const uint8_t **data);
+
+/** Get statistics, counters are not cleared by data_frame_reset(). */
+void data_frame_get_stats(const data_frame_t *data_fr,
+        data_frame_stats_t *stats);
 
 void data_frame_destroy(data_frame_t *data_fr);
 
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+  GMSK demodulator, replacement of GNU Radio gmsk_demod used by
+  demod/tetrapol_rx.py: FM discriminator, Mueller-Muller clock recovery
+  and binary slicer.
+
+  Input is complex baseband of single channel at DEMOD_SAMPLE_RATE
+  (2 samples per symbol), output is one bit per byte as accepted by
+  tetrapol_phys_ch_recv() with PHYS_CH_INPUT_UNPACKED format.
+  */
+
+#define DEMOD_SAMPLE_RATE 16000
+#define DEMOD_SAMPLES_PER_SYMBOL 2
+
+/// estimate of frequency offset is averaged over about 4 frames
+#define DEMOD_AVG_SYMBOLS 640
+/// input power is averaged over about 4 frames
+#define DEMOD_AVG_SAMPLES (DEMOD_AVG_SYMBOLS * DEMOD_SAMPLES_PER_SYMBOL)
+
+/// max. number of bits produced by demod_process() for 'nsamples',
+/// clock recovery can run slightly faster than nominal symbol rate
+#define DEMOD_BITS_MAX(nsamples) \
+    ((nsamples) / DEMOD_SAMPLES_PER_SYMBOL + (nsamples) / 128 + 2)
+
+/** Format of samples passed into demod_process(). */
+enum {
+    DEMOD_INPUT_CF32 = 0,   ///< interleaved float I, Q
+    DEMOD_INPUT_CS16 = 1,   ///< interleaved int16_t I, Q
+};
+
+typedef struct _demod_t demod_t;
+
+/**
+  Create new demodulator.
+
+  @param input_fmt DEMOD_INPUT_CF32 or DEMOD_INPUT_CS16.
+  @return new instance or NULL
+  */
+demod_t *demod_create(int input_fmt);
+void demod_destroy(demod_t *demod);
+
+/// Get size (bytes) of one complex sample for format used by demodulator.
+int demod_sample_size(const demod_t *demod);
+
+/**
+  Demodulate samples.
+
+  All samples are consumed, state is kept between calls, so input can be
+  split at any sample boundary.
+
+  @param samples Input samples, see DEMOD_INPUT_*.
+  @param nsamples Number of complex samples.
+  @param bits Output buffer, must have space for DEMOD_BITS_MAX(nsamples)
+    bits.
+  @return number of bits written into 'bits'
+  */
+int demod_process(demod_t *demod, const void *samples, int nsamples,
+        uint8_t *bits);
+
+/**
+  Get estimate of carrier frequency offset relative to channel center,
+  including correction set by demod_set_freq_correction().
+
+  Decision directed estimate, symbols are compared with sliced symbols
+  and difference is averaged over about DEMOD_AVG_SYMBOLS symbols. It is
+  valid only when demodulated bits are valid, e.g. while decoder keeps
+  frame sync.
+
+  @return frequency offset (Hz)
+  */
+float demod_get_freq_offset(const demod_t *demod);
+
+/**
+  Set correction of carrier frequency offset.
+
+  Correction is applied at output of FM discriminator, it is equivalent
+  to frequency shift of input (channel filter is not retuned).
+
+  @param freq Offset (Hz) as returned by demod_get_freq_offset().
+  */
+void demod_set_freq_correction(demod_t *demod, float freq);
+
+float demod_get_freq_correction(const demod_t *demod);
+
+/**
+  Get power of input averaged over about DEMOD_AVG_SAMPLES samples.
+
+  @return mean power (dB) relative to full scale, amplitude 1.0 for
+    DEMOD_INPUT_CF32, 32768 for DEMOD_INPUT_CS16
+  */
+float demod_get_power(const demod_t *demod);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  Cache of recently decoded payloads of broadcast channels.
+
+  BCH, PCH and RCH repeat the same content over and over (D_SYSTEM_INFO
+  alternates between two payloads differing in cell_state.bch only).
+  Payload, the assembled data frame, is identified by 64-bit hash, for
+  payload found in cache the decoding can be skipped.
+
+  Only successfully decoded payloads are inserted by dup_cache_insert(),
+  the least recently seen entry is replaced.
+  */
+
+#define DUP_CACHE_ENTRIES 4
+
+typedef struct {
+    uint64_t hash;
+    uint64_t seen;      ///< value of dup_cache_t.clock at last lookup, 0 empty
+    int repeats;        ///< number of lookups since insertion
+    int tag;            ///< any value derived from decoded payload
+} dup_cache_entry_t;
+
+typedef struct {
+    dup_cache_entry_t entries[DUP_CACHE_ENTRIES];
+    uint64_t clock;
+    uint64_t hash;      ///< hash of payload from the last lookup
+} dup_cache_t;
+
+void dup_cache_init(dup_cache_t *dc);
+
+/**
+  Find payload in cache.
+
+  @param len Length of data in bytes.
+  @return entry with incremented repeats, NULL when payload is not cached
+  */
+dup_cache_entry_t *dup_cache_lookup(dup_cache_t *dc, const uint8_t *data,
+        int len);
+
+/**
+  Insert payload from the last (unsuccessful) dup_cache_lookup().
+
+  @param tag Stored into entry.
+  */
+void dup_cache_insert(dup_cache_t *dc, int tag);
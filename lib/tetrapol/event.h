@@ -0,0 +1,102 @@
+#pragma once
+
+#include <tetrapol/tsdu.h>
+
+#include <stdint.h>
+
+/**
+  Binary event stream, compact alternative to text output of tsdu_print().
+
+  Stream is sequence of records, all multi-byte values are little endian.
+
+    uint16_t len;       // number of bytes following this field
+    uint8_t type;       // EVENT_TYPE_*
+    uint8_t payload[len - 1];
+
+  Payload of EVENT_TYPE_TSDU starts by TSDU header
+
+    uint8_t codop, prio, id_tsap, flags;  // flags: bit 0 = downlink
+
+  followed by TSDU specific fields in the order of declaration in tsdu.h.
+  Bit-field unions (cell_state_t, key_reference_t, ...) are stored as
+  received (_data). Variable length arrays are prefixed by number of items,
+  uint8_t for lists and uint16_t for data bytes. Optional items are
+  prefixed by uint8_t presence flag.
+
+  Payload of EVENT_TYPE_VOICE is
+
+    int64_t timestamp;  // start of frame (us)
+    int16_t frame_no;   // -1 if unknown
+    uint8_t crc_ok;
+    uint8_t data[16];   // 126 bits of voice block, MSB first
+
+  Readers should skip records of unknown type (and unknown trailing
+  payload bytes) using the len field.
+  */
+
+enum {
+    EVENT_TYPE_TSDU = 1,
+    EVENT_TYPE_VOICE = 2,
+};
+
+/// max. size of single record
+#define EVENT_REC_MAX 4096
+
+/**
+  Serialize TSDU into buffer as single record.
+
+  @param buf Output buffer.
+  @param len Size of buffer.
+  @return Length of record, -1 when buffer is too small.
+  */
+int event_tsdu_serialize(const tsdu_t *tsdu, uint8_t *buf, int len);
+
+/// length of voice frame record
+#define EVENT_VOICE_REC_LEN (2 + 1 + 8 + 2 + 1 + 16)
+
+/**
+  Serialize voice frame into buffer as single record, see
+  event_write_voice().
+
+  @return EVENT_VOICE_REC_LEN, -1 when buffer is too small.
+  */
+int event_voice_serialize(int64_t timestamp, int frame_no, bool crc_ok,
+        const uint64_t *data, uint8_t *buf, int len);
+
+/**
+  Records are batched in memory and written by single writev() on flush.
+  */
+typedef struct _event_writer_t event_writer_t;
+
+/**
+  Create writer.
+
+  @param fd Output file descriptor, it is not closed by writer.
+  */
+event_writer_t *event_writer_create(int fd);
+
+/// Flush pending records and destroy writer.
+void event_writer_destroy(event_writer_t *ew);
+
+/**
+  Add TSDU into batch, batch is flushed when full.
+
+  @return 0 on success, -1 on error
+  */
+int event_write_tsdu(event_writer_t *ew, const tsdu_t *tsdu);
+
+/**
+  Add voice frame into batch, see voice_frame_t in phys_ch.h.
+
+  @param data Voice block bits packed into 2 words MSB first.
+  @return 0 on success, -1 on error
+  */
+int event_write_voice(event_writer_t *ew, int64_t timestamp, int frame_no,
+        bool crc_ok, const uint64_t *data);
+
+/**
+  Write all batched records.
+
+  @return 0 on success, -1 on error
+  */
+int event_writer_flush(event_writer_t *ew);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <tetrapol/tsdu.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  Fan-out of binary event records (see tetrapol/event.h) to many
+  processes through a ring in POSIX shared memory.
+
+  Ring has single producer (the decoding thread) and any number of
+  consumers, consumers only read the shared memory, each one keeps its
+  own read cursor. Producer never waits for consumers, slow consumer is
+  overrun and detects it on the next read.
+
+  Shared memory starts by header followed by data area of 2^k bytes.
+  Records are stored in data area as in event stream, each one is padded
+  to multiple of 8 bytes. Record which does not fit before the end of
+  data area is preceded by EVENT_RING_PAD record which fills the rest
+  of data area.
+
+  Positions in ring are 64-bit byte counters which never wrap. Producer
+  publishes 'tail_intent' (end of record being written) before writing
+  and 'tail' (end of written data) after that. Consumer copies record
+  at its cursor and then checks by 'tail_intent' that the copied data were
+  not overwritten in the meantime.
+  */
+
+/// type of padding record, never returned by event_ring_read()
+#define EVENT_RING_PAD 0
+
+/// returned by event_ring_read() when consumer was overrun by producer
+#define EVENT_RING_OVERRUN (-2)
+
+typedef struct _event_ring_t event_ring_t;
+
+/**
+  Create shared memory ring, existing ring of the same name is replaced.
+
+  @param name Name of POSIX shared memory object, e.g. "/tetrapol".
+  @param size Size of data area in bytes, power of 2, at least
+    4 * EVENT_REC_MAX.
+  @return ring or NULL on error
+  */
+event_ring_t *event_ring_create(const char *name, int size);
+
+/**
+  Destroy ring, shared memory object is unlinked, attached consumers
+  keep their mapping.
+  */
+void event_ring_destroy(event_ring_t *ring);
+
+/**
+  Publish single record, it must be complete record of event stream
+  (starting by uint16_t length).
+
+  @return 0 on success, -1 for invalid record
+  */
+int event_ring_put(event_ring_t *ring, const uint8_t *rec, int len);
+
+/// Serialize and publish TSDU, see event_tsdu_serialize().
+int event_ring_write_tsdu(event_ring_t *ring, const tsdu_t *tsdu);
+
+/// Serialize and publish voice frame, see event_write_voice().
+int event_ring_write_voice(event_ring_t *ring, int64_t timestamp,
+        int frame_no, bool crc_ok, const uint64_t *data);
+
+typedef struct _event_ring_reader_t event_ring_reader_t;
+
+/**
+  Attach consumer to existing ring, reading starts by the next published
+  record.
+
+  @return reader or NULL on error
+  */
+event_ring_reader_t *event_ring_reader_open(const char *name);
+
+void event_ring_reader_close(event_ring_reader_t *reader);
+
+/**
+  Read next record.
+
+  @param buf Output buffer, EVENT_REC_MAX bytes is always enough.
+  @return Record length, 0 when no record is available,
+    EVENT_RING_OVERRUN when records were lost (reading continues by
+    records published after that), -1 on error (too small buffer, corrupted ring).
+  */
+int event_ring_read(event_ring_reader_t *reader, uint8_t *buf, int len);
+
+/// Number of bytes lost by overruns.
+uint64_t event_ring_reader_lost(const event_ring_reader_t *reader);
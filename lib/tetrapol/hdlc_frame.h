@@ -63,15 +63,24 @@ typedef struct {
     };
 } command_t;
 
+/// max. length of HDLC frame data
+/// max_block_size * max_blocks_per_frame - addr - command - FCS
+#define HDLC_DATA_LEN_MAX (SYS_PAR_N200_BYTES_MAX - 2 - 1 - 2)
+
 typedef struct {
     addr_t addr;
     command_t command;
     int nbits;          ///< lenght is in bits
-    /// data packed into bytes
-    /// [max_block_size * max_blocks_per_frame - addr - command - FCS]
-    uint8_t data[SYS_PAR_N200_BYTES_MAX - 2 - 1 - 2];
+    /// data packed into bytes, points into buffer passed to
+    /// hdlc_frame_parse() (data are not copied)
+    const uint8_t *data;
 } hdlc_frame_t;
 
 extern const addr_t addr_all;
 
+/**
+  Parse HDLC frame, frame keeps reference to data.
+
+  @param len Frame length in bits, including FCS.
+  */
 bool hdlc_frame_parse(hdlc_frame_t *hdlc_frame, const uint8_t *data, int len);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  Framing of bit streams received over network from remote SDR nodes.
+
+  Each datagram carries part of bit stream of single channel and starts by
+  fixed header, all fields are big endian:
+
+    offset  size  field
+         0     2  magic, "TP"
+         2     1  version, INGEST_VERSION
+         3     1  flags, reserved, must be 0
+         4     2  channel id
+         6     2  payload length in bytes
+         8     4  sequence number, incremented by 1 for each datagram
+                  of the channel, wraps at 2^32
+        12     8  timestamp of the first payload bit (ns since epoch)
+
+  Payload follows the header, its format (packed or unpacked bits) is
+  given by receiver configuration.
+  */
+
+#define INGEST_MAGIC 0x5450
+#define INGEST_VERSION 1
+#define INGEST_HDR_LEN 20
+/// max. payload length, fits into UDP datagram without fragmentation
+#define INGEST_PAYLOAD_MAX 1400
+
+typedef struct {
+    uint16_t ch_id;
+    uint16_t len;       ///< payload length
+    uint32_t seq;
+    int64_t timestamp;
+} ingest_hdr_t;
+
+/**
+  Parse header of datagram.
+
+  @param len Length of whole datagram.
+  @return 0 on success, -1 for invalid datagram
+  */
+int ingest_hdr_parse(ingest_hdr_t *hdr, const uint8_t *buf, int len);
+
+/**
+  Write header, buf must have at least INGEST_HDR_LEN bytes.
+  */
+void ingest_hdr_write(const ingest_hdr_t *hdr, uint8_t *buf);
+
+/// Sequence tracking of single channel.
+typedef struct {
+    bool started;       ///< any datagram received
+    uint32_t next;      ///< expected sequence number
+} ingest_seq_t;
+
+/**
+  Check sequence number of received datagram.
+
+  @return number of lost datagrams before this one, 0 when datagram is
+    in sequence, -1 for duplicated or reordered datagram which should be
+    dropped
+  */
+int64_t ingest_seq_check(ingest_seq_t *seq, uint32_t n);
+
+/**
+  Feedback from decoder to receiver of channel, e.g. for AFC, gain control
+  or calibration of receiver oscillator. Datagram of INGEST_FEEDBACK_LEN
+  bytes, all fields are big endian:
+
+    offset  size  field
+         0     2  magic, "TF"
+         2     1  version, INGEST_VERSION
+         3     1  flags, INGEST_FEEDBACK_*
+         4     2  channel id
+         6     2  reserved, must be 0
+         8     4  sequence number, incremented by 1 for each datagram
+                  of the channel, wraps at 2^32
+        12     8  timestamp of report (ns since epoch)
+        20     2  errors in frame synchronization per frame, 1/1000
+        22     2  FEC errors per data block, 1/1000
+        24     2  ratio of invalid data blocks, 1/10000
+        26     2  input power (dBFS), 1/100, signed
+        28     4  carrier frequency offset (Hz), 1/1000, signed
+
+  Error rates are short-term averages, see phys_ch_quality_t, they are
+  valid only with INGEST_FEEDBACK_SYNC. Frequency offset and power are
+  provided only by decoder which does demodulation.
+  */
+
+#define INGEST_FEEDBACK_MAGIC 0x5446
+#define INGEST_FEEDBACK_LEN 32
+
+enum {
+    INGEST_FEEDBACK_SYNC = 0x01,    ///< decoder is in frame sync
+    INGEST_FEEDBACK_FREQ = 0x02,    ///< freq_offset is valid
+    INGEST_FEEDBACK_POWER = 0x04,   ///< power is valid
+};
+
+typedef struct {
+    uint16_t ch_id;
+    uint8_t flags;
+    uint32_t seq;
+    int64_t timestamp;
+    float sync_errs;
+    float nerrs;
+    float crc_errs;
+    float power;        ///< dBFS
+    float freq_offset;  ///< Hz
+} ingest_feedback_t;
+
+/**
+  Parse feedback datagram.
+
+  @return 0 on success, -1 for invalid datagram
+  */
+int ingest_feedback_parse(ingest_feedback_t *fb, const uint8_t *buf, int len);
+
+/**
+  Write feedback, buf must have INGEST_FEEDBACK_LEN bytes. Values out of
+  range of fields are saturated.
+  */
+void ingest_feedback_write(const ingest_feedback_t *fb, uint8_t *buf);
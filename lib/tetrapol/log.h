@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdio.h>
 
 /**
@@ -10,6 +11,9 @@
   #define LOG_PREFIX "some_prefix"  // prefix used for logging (optional)
   #define LOG_LVL DBG               // override log level for this file
 
+  LOG_MIN_LVL is least important level compiled in, messages above it are
+  eliminated at compile time, e.g. build with -DLOG_MIN_LVL=INFO to drop
+  all debug messages from production build.
   */
 
 #define WTF 0
@@ -19,6 +23,49 @@
 
 extern int log_global_lvl;
 
+/**
+  Output stream for logging, stdout is used when NULL.
+
+  It is thread local, so each thread can direct output of the phys_ch_t
+  instance it is processing to its own stream.
+  */
+extern _Thread_local FILE *log_stream;
+
+/**
+  Write message to log_stream.
+
+  When asynchronous backend is running, message is stored into ring buffer
+  of calling thread and formatted later by formatter thread. Format string
+  must be static in that case (string literal), arguments are copied.
+  */
+int log_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+  Start asynchronous logging backend.
+
+  Each thread logs into its own lock-free ring buffer, messages are
+  written by background thread in the order they were logged.
+  Messages are dropped (and the number of them reported) when ring is full,
+  the logging thread is never blocked.
+
+  @return 0 on success, -1 on error
+  */
+int log_async_start(void);
+
+/// Wait until all messages logged so far are written to their streams.
+void log_async_flush(void);
+
+/**
+  Write pending messages and stop asynchronous backend.
+
+  Should be called when other threads are not logging anymore.
+  */
+void log_async_stop(void);
+
+#ifndef LOG_MIN_LVL
+#define LOG_MIN_LVL DBG
+#endif
+
 // define LOG_LVL to override log level for single file
 #ifndef LOG_LVL
 #define LOG_LOCAL_LVL(lvl) false
@@ -33,21 +80,25 @@ extern int log_global_lvl;
 #define LOG_STR_(s) #s
 
 #define LOG__(line, msg, ...) \
-    printf(LOG_PREFIX ":" LOG_STR_(line) " " msg , ##__VA_ARGS__)
+    log_printf(LOG_PREFIX ":" LOG_STR_(line) " " msg , ##__VA_ARGS__)
 
 #define LOG_(msg, ...) \
     LOG__(__LINE__, msg , ##__VA_ARGS__)
 
+#define LOG_ENABLED(lvl) \
+    (lvl <= LOG_MIN_LVL && (LOG_LOCAL_LVL(lvl) || lvl <= log_global_lvl))
+
 #define IF_LOG(lvl) \
-    if (LOG_LOCAL_LVL(lvl) || lvl <= log_global_lvl)
+    if (LOG_ENABLED(lvl))
 
 #define LOG(lvl, msg, ...) \
     do { \
-    if (LOG_LOCAL_LVL(lvl) || lvl <= log_global_lvl) { \
+    if (LOG_ENABLED(lvl)) { \
             LOG_(msg "\n", ##__VA_ARGS__); \
         } \
     } while(false)
 
+/// not thread safe, should be called before processing starts
 inline void log_set_lvl(int lvl)
 {
     log_global_lvl = lvl;
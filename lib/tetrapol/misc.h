@@ -1,8 +1,15 @@
 #pragma once
 
+#include <stdalign.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define ARRAY_LEN(a) (sizeof(a) / sizeof(a[0]))
 
+/// Round size up to alignment for any type, used for placement of objects
+/// into single allocation, see e.g. bch_sizeof().
+#define MEM_ALIGN_UP(x) \
+    (((x) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
 // TODO: transfer to log.h
 void print_hex(const uint8_t *bytes, int n);
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <tetrapol/addr.h>
+#include <tetrapol/tsdu.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  In-memory index of network configuration learned from decoded TSDUs.
+
+  Index is updated incrementally by net_index_update() with every decoded
+  TSDU, TSDU is not referenced after the call. Entries are stored in open
+  addressing hash tables (linear probing), lookup is O(1).
+
+  Cells are keyed by cell_id. Cell decoded by its D_SYSTEM_INFO is the
+  current cell, its neighbours (D_NEIGHBOURING_CELL) are stored within it
+  and neighbours with known cell_id are indexed too. Groups are keyed by
+  group id (D_GROUP_COMPOSITION, D_GROUP_LIST open channels,
+  D_GROUP_ACTIVATION) and active calls by address of called talkgroup
+  (D_GROUP_ACTIVATION with TTI).
+
+  Each entry has 'updated', value of net_index_seq() when the entry was
+  changed last time, calls which are not refreshed by activation can be
+  removed by net_index_expire_calls().
+
+  Pointers returned by queries are valid until next modification of the
+  index. Index is not thread-safe, use net_index_clone() to get snapshot
+  which can be passed to another thread.
+  */
+
+/// max. number of neighbours per cell, ccr_config.number has 4 bits
+#define NET_INDEX_NEIGHBOURS_MAX 16
+
+typedef struct {
+    uint8_t bn_nb;
+    uint16_t channel_id;
+    adjacent_param_t adjacent_param;
+    bool has_cell_id;
+    cell_id_t cell_id;
+    bool has_bn;
+    addr_t bn;
+} net_neighbour_t;
+
+typedef struct {
+    cell_id_t cell_id;
+    /// the cell was the current cell, fields below are valid
+    bool has_sysinfo;
+    cell_state_t cell_state;
+    cell_config_t cell_config;
+    loc_area_id_t loc_area_id;
+    uint8_t bn_id;
+    uint16_t cell_bn;
+    /// control channel from neighbour list of another cell, 0 if unknown
+    uint16_t channel_id;
+    uint8_t nneighbours;
+    net_neighbour_t neighbours[NET_INDEX_NEIGHBOURS_MAX];
+    uint64_t updated;
+} net_cell_t;
+
+/// Channel allocated to the group or call by D_GROUP_ACTIVATION.
+typedef struct {
+    activation_mode_t activation_mode;
+    uint8_t coverage_id;
+    uint16_t channel_id;
+    uint8_t u_ch_scrambling;
+    uint8_t d_ch_scrambling;
+    key_reference_t key_reference;
+} net_activation_t;
+
+typedef struct {
+    uint16_t group_id;
+    bool has_composition;
+    uint8_t og_nb;
+    uint16_t group_ids[16];
+    /// group has open channel (D_GROUP_LIST)
+    bool is_open;
+    tsdu_d_group_list_open_t open;
+    bool is_active;
+    net_activation_t activation;    ///< the last one
+    uint64_t updated;
+} net_group_t;
+
+typedef struct {
+    addr_t addr;
+    uint16_t group_id;
+    net_activation_t activation;
+    uint64_t updated;
+} net_call_t;
+
+typedef struct _net_index_t net_index_t;
+
+net_index_t *net_index_create(void);
+void net_index_destroy(net_index_t *idx);
+
+/**
+  Create snapshot, a deep copy of index.
+
+  @return copy or NULL
+  */
+net_index_t *net_index_clone(const net_index_t *idx);
+
+/**
+  Update index by TSDU, TSDUs which do not carry indexed information are
+  ignored.
+
+  @return 0 on success, -1 on allocation failure
+  */
+int net_index_update(net_index_t *idx, const tsdu_t *tsdu);
+
+/// Number of updates with TSDU changing the index.
+uint64_t net_index_seq(const net_index_t *idx);
+
+/**
+  Get network identification from the last D_SYSTEM_INFO.
+
+  @return false when no D_SYSTEM_INFO was received yet
+  */
+bool net_index_get_network(const net_index_t *idx, uint8_t *country_code,
+        system_id_t *system_id);
+
+/// Get the cell decoded right now (by the last D_SYSTEM_INFO) or NULL.
+const net_cell_t *net_index_get_current_cell(const net_index_t *idx);
+
+const net_cell_t *net_index_get_cell(const net_index_t *idx,
+        const cell_id_t *cell_id);
+const net_group_t *net_index_get_group(const net_index_t *idx,
+        uint16_t group_id);
+const net_call_t *net_index_get_call(const net_index_t *idx,
+        const addr_t *addr);
+
+int net_index_ncells(const net_index_t *idx);
+int net_index_ngroups(const net_index_t *idx);
+int net_index_ncalls(const net_index_t *idx);
+
+/**
+  Iterate over entries in unspecified order.
+
+  @param it Iterator, must be initialized to 0.
+  @return next entry or NULL when all entries were returned
+  */
+const net_cell_t *net_index_next_cell(const net_index_t *idx, int *it);
+const net_group_t *net_index_next_group(const net_index_t *idx, int *it);
+const net_call_t *net_index_next_call(const net_index_t *idx, int *it);
+
+/**
+  Remove calls not updated since 'seq'.
+
+  @return number of removed calls
+  */
+int net_index_expire_calls(net_index_t *idx, uint64_t seq);
@@ -1,15 +1,45 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
+#include <tetrapol/addr.h>
 #include <tetrapol/data_frame.h>
+#include <tetrapol/stats.h>
+
+#include <stdint.h>
+
+/// Paging message received on PCH.
+typedef struct {
+    uint8_t act_bitmap[8];  ///< activation bitmap
+    uint8_t naddrs;
+    addr_t addrs[4];        ///< paged addresses
+    int64_t timestamp;      ///< start of the last frame of message (us)
+} pch_data_t;
 
 typedef struct _pch_t pch_t;
 
 pch_t *pch_create(void);
 void pch_destroy(pch_t *pch);
+/// Construct in memory provided by caller, pch_sizeof() bytes aligned for
+/// any type, no destruction is required.
+void pch_init(pch_t *pch);
+size_t pch_sizeof(void);
 
 /** Should be called when some frames are missing. */
 void pch_reset(pch_t *pch);
+/// Skip decoding of recently decoded payloads, see tetrapol/dup_cache.h
+void pch_set_dup_suppress(pch_t *pch, bool suppress);
 bool pch_push_data_block(pch_t *pch, data_block_t* data_blk);
-void pch_print(pch_t *pch);
+void pch_get_stats(const pch_t *pch, log_ch_stats_t *stats);
+
+/// Get last message, valid after pch_push_data_block() returns true
+/// and pch_get_repeats() returns 0.
+const pch_data_t *pch_get_data(const pch_t *pch);
+/**
+  @return how many times was the payload repeated when its decoding was
+    skipped by the last pch_push_data_block() returning true, 0 when it
+    was decoded
+  */
+int pch_get_repeats(const pch_t *pch);
+void pch_print(const pch_data_t *pch_data);
@@ -1,12 +1,119 @@
 #pragma once
 
-#include <stdint.h>
+#include <tetrapol/data_block.h>
+#include <tetrapol/pch.h>
+#include <tetrapol/rch.h>
+#include <tetrapol/stats.h>
+#include <tetrapol/tsdu.h>
+
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define PHYS_CH_SCR_DETECT -1
 
+/** Format of data passed into tetrapol_phys_ch_recv(). */
+enum {
+    PHYS_CH_INPUT_UNPACKED = 0, ///< one bit per byte (default)
+    PHYS_CH_INPUT_PACKED = 1,   ///< 8 bits per byte, MSB first
+};
+
+/** SCR search strategy, see tetrapol_phys_ch_set_scr_search(). */
+enum {
+    /// candidates without valid frames are pruned, SCR is detected
+    /// by likelihood ratio in a few valid frames (default)
+    PHYS_CH_SCR_SEARCH_SEQUENTIAL = 0,
+    /// all candidates are evaluated for each frame, SCR is detected
+    /// when it leads by scr_confidence
+    PHYS_CH_SCR_SEARCH_EXHAUSTIVE = 1,
+};
+
+/** Logical channels of control channel, see dup_sink_t. */
+enum {
+    PHYS_CH_LOG_CH_BCH = 0,
+    PHYS_CH_LOG_CH_PCH = 1,
+    PHYS_CH_LOG_CH_RCH = 2,
+};
+
+/**
+  Upper bound of memory used by decoder instance (bytes) after creation
+  and after tetrapol_phys_ch_hibernate(), see
+  tetrapol_phys_ch_get_mem_size(). Control channel allocates about 4 kB
+  for TSDUs of each BCH and SDCH by the first decoded TSDU and 15 kB for
+  reassembly of segmented DUs if any is received.
+  */
+#define PHYS_CH_MEM_SIZE_CONTROL (7 * 1024)
+#define PHYS_CH_MEM_SIZE_TRAFFIC (5 * 1024)
+
 typedef struct _phys_ch_t phys_ch_t;
 
+/** Voice frame received on traffic channel. */
+typedef struct {
+    int64_t timestamp;  ///< start of frame (us), see tetrapol_phys_ch_set_time()
+    int frame_no;       ///< frame number or FRAME_NO_UNKNOWN
+    bool crc_ok;        ///< false for corrupted frame (codec should conceal it)
+    /// 26 protected (including frame type and CRC) and 100 unprotected
+    /// bits packed MSB first, same layout as data_block_t
+    uint64_t data[2];
+} voice_frame_t;
+
+/**
+  Receiver of voice frames.
+
+  Called once for each voice frame as soon as it is decoded, frames are
+  not buffered. Frame is valid only during the call.
+  */
+typedef void (*voice_sink_t)(const voice_frame_t *vf, void *ptr);
+
+/** Summary of single decoded frame. */
+typedef struct {
+    int64_t timestamp;  ///< start of frame (us), see tetrapol_phys_ch_set_time()
+    int frame_no;       ///< frame number or FRAME_NO_UNKNOWN
+    frame_type_t fr_type;
+    int nerrs;          ///< number of errors corrected by FEC
+    bool crc_ok;        ///< no uncorrected errors and valid CRC
+} frame_info_t;
+
+/**
+  Receivers of decoded data.
+
+  Receivers are called from tetrapol_phys_ch_process() as soon as data are
+  decoded, data are valid only during the call. Decoder does not print
+  any decoded data, printing (if required) is up to the receivers.
+  */
+typedef void (*frame_sink_t)(const frame_info_t *fi, void *ptr);
+/// all decoded TSDUs, including D_SYSTEM_INFO from BCH
+typedef void (*tsdu_sink_t)(const tsdu_t *tsdu, void *ptr);
+typedef void (*pch_sink_t)(const pch_data_t *pch_data, void *ptr);
+typedef void (*rch_sink_t)(const rch_data_t *rch_data, void *ptr);
+
+/**
+  Receiver of system information decoded from BCH.
+
+  Called for each received D_SYSTEM_INFO, TSDU is valid only during the call.
+  */
+typedef void (*sysinfo_sink_t)(const tsdu_d_system_info_t *tsdu, void *ptr);
+
+/**
+  Receiver of notifications about repeated messages.
+
+  Called instead of sysinfo/tsdu, pch or rch sink when decoding of
+  repeated message is skipped, see tetrapol_phys_ch_set_dup_suppress().
+
+  @param log_ch PHYS_CH_LOG_CH_BCH, PHYS_CH_LOG_CH_PCH or PHYS_CH_LOG_CH_RCH
+  @param repeats How many times was the message repeated since it was
+    decoded.
+  */
+typedef void (*dup_sink_t)(int log_ch, int repeats, void *ptr);
+
+/**
+  Receiver of decoded data blocks, see tetrapol_phys_ch_set_block_sink().
+
+  @param fi Summary of frame, frame_no is set by BCH when known.
+  */
+typedef void (*block_sink_t)(const frame_info_t *fi,
+        const data_block_t *data_blk, void *ptr);
+
 /**
   Create new TETRAPOL physical cahnnel instance.
   @param band VHF or UHF
@@ -18,22 +125,293 @@ phys_ch_t *tetrapol_phys_ch_create(int band, int radio_ch_type);
 void tetrapol_phys_ch_destroy(phys_ch_t *phys_ch);
 int tetrapol_phys_ch_process(phys_ch_t *phys_ch);
 
+/**
+  Process several channels, equivalent of tetrapol_phys_ch_process() for
+  each of them.
+
+  Channels are processed in rounds, single frame is taken from each
+  channel with complete frame. Frames of up to 128 channels with known SCR
+  are descrambled per channel, then differential decoding, deinterleaving,
+  FEC decoding and CRC check are done at once in bitsliced lanes and each
+  block is passed to logical channels of its channel. Channels
+  can differ in band and radio channel type, but each channel must be
+  listed only once. Output of channels is interleaved (log_stream can
+  not be set per channel). Uses about 40 kB of stack.
+
+  @param chs Channels fed by tetrapol_phys_ch_recv*().
+  @param n Number of channels.
+  @return 0
+  */
+int tetrapol_phys_ch_process_batch(phys_ch_t **chs, int n);
+
+/**
+  Notify decoder about discontinuity of input (e.g. lost network packets).
+  Buffered data are dropped and frame synchronization is searched again,
+  SCR and multiplexing type are kept.
+  */
+void tetrapol_phys_ch_resync(phys_ch_t *phys_ch);
+
 /** Get SCR, scrambling constant parameter. */
 int tetrapol_phys_ch_get_scr(phys_ch_t *phys_ch);
 
 /** Set SCR, scrambling constant parameter. */
 void tetrapol_phys_ch_set_scr(phys_ch_t *phys_ch, int scr);
 
+/**
+  Set SCR known from previous run (e.g. from cache), it is used for
+  decoding immediately and verified by the first frame valid for any SCR.
+  SCR detection is started when the frame is valid for another SCR.
+  */
+void tetrapol_phys_ch_preload_scr(phys_ch_t *phys_ch, int scr);
+
+/**
+  Get control channel multiplexing type (CELL_CONFIG_MUX_TYPE_*),
+  updated by each D_SYSTEM_INFO.
+  */
+int tetrapol_phys_ch_get_cch_mux_type(phys_ch_t *phys_ch);
+
+/**
+  Preset control channel multiplexing type (e.g. from cache), used until
+  D_SYSTEM_INFO is received.
+
+  @return false for unsupported type
+  */
+bool tetrapol_phys_ch_set_cch_mux_type(phys_ch_t *phys_ch, int mux_type);
+
 /** Get confidence for SRC detection (~ no. of valid frames). */
 int tetrapol_phys_ch_get_scr_confidence(phys_ch_t *phys_ch);
 
-/** Set confidence for SRC detection (~ no. of valid frames). */
+/**
+  Set confidence for SRC detection (~ no. of valid frames), used by
+  PHYS_CH_SCR_SEARCH_EXHAUSTIVE.
+  */
 void tetrapol_phys_ch_set_scr_confidence(phys_ch_t *phys_ch, int scr_confidence);
 
+/** Get SCR search strategy, PHYS_CH_SCR_SEARCH_*. */
+int tetrapol_phys_ch_get_scr_search(phys_ch_t *phys_ch);
+
+/**
+  Set SCR search strategy, SCR statistics collected so far are reset.
+
+  @return false for invalid strategy
+  */
+bool tetrapol_phys_ch_set_scr_search(phys_ch_t *phys_ch, int scr_search);
+
+/**
+  Get decoder statistics, see tetrapol/stats.h.
+
+  Must be called from the thread which calls tetrapol_phys_ch_process().
+  */
+void tetrapol_phys_ch_get_stats(phys_ch_t *phys_ch, phys_ch_stats_t *stats);
+
+/// frames averaged by quality estimate, see phys_ch_quality_t
+#define PHYS_CH_QUALITY_FRAMES 16
+
+/**
+  Short-term estimate of signal quality, e.g. feedback for frequency
+  correction and gain control of receiver.
+
+  Values are moving averages over about PHYS_CH_QUALITY_FRAMES frames
+  received in frame sync, frames lost in fade are included. Averages are
+  restarted when frame sync is found.
+  */
+typedef struct {
+    bool has_frame_sync;
+    int nframes;        ///< frames averaged, up to PHYS_CH_QUALITY_FRAMES
+    float sync_errs;    ///< errors in frame synchronization (0 - 7 bits)
+    float nerrs;        ///< FEC errors per data block
+    float crc_errs;     ///< ratio of invalid blocks and frames lost in fade
+} phys_ch_quality_t;
+
+/**
+  Get short-term quality estimate.
+
+  Must be called from the thread which calls tetrapol_phys_ch_process().
+  */
+void tetrapol_phys_ch_get_quality(const phys_ch_t *phys_ch,
+        phys_ch_quality_t *quality);
+
+/**
+  Set receiver of voice frames, used for traffic channel.
+
+  @param sink Callback or NULL to disable voice output.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_voice_sink(phys_ch_t *phys_ch, voice_sink_t sink,
+        void *ptr);
+
+/**
+  Set receiver of frame summaries, called for each frame in frame sync.
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_frame_sink(phys_ch_t *phys_ch, frame_sink_t sink,
+        void *ptr);
+
+/**
+  Pass decoded data blocks into sink instead of logical channels.
+
+  Only BCH is decoded for frame numbering, other logical channels and
+  sinks (except frame sink) are not used. Data blocks can be decoded
+  later (e.g. the best copy from several receivers, see
+  tetrapol/combiner.h) by tetrapol_phys_ch_push_data_block().
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_block_sink(phys_ch_t *phys_ch, block_sink_t sink,
+        void *ptr);
+
+/**
+  Decode data block received by another instance (see
+  tetrapol_phys_ch_set_block_sink()) by logical channels of this one.
+
+  Time of channel is advanced to fi->timestamp, frame statistics and frame
+  sink are updated as for frame received by this instance.
+
+  @return 0 on success, -1 on decoding error
+  */
+int tetrapol_phys_ch_push_data_block(phys_ch_t *phys_ch,
+        const frame_info_t *fi, const data_block_t *data_blk);
+
+/**
+  Set receiver of TSDUs, used for control channel.
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_tsdu_sink(phys_ch_t *phys_ch, tsdu_sink_t sink,
+        void *ptr);
+
+/**
+  Set receiver of paging messages, used for control channel.
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_pch_sink(phys_ch_t *phys_ch, pch_sink_t sink,
+        void *ptr);
+
+/**
+  Set receiver of random access acknowledgements, used for control channel.
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_rch_sink(phys_ch_t *phys_ch, rch_sink_t sink,
+        void *ptr);
+
+/**
+  Set receiver of system information, used for control channel.
+
+  @param sink Callback or NULL to disable.
+  @param ptr User pointer, passed into sink.
+  */
+void tetrapol_phys_ch_set_sysinfo_sink(phys_ch_t *phys_ch,
+        sysinfo_sink_t sink, void *ptr);
+
+/**
+  Decode only BCH on control channel, other logical channels (PCH, RCH,
+  SDCH) are skipped. Useful for fast identification of control channels.
+  */
+void tetrapol_phys_ch_set_bch_only(phys_ch_t *phys_ch, bool bch_only);
+
+/**
+  Put channel without signal into low-footprint state.
+
+  Buffered bits are dropped, frame sync is lost and memory allocated on
+  demand (TSDU decoding, reassembly of segmented DUs) is released.
+  Configuration, SCR and statistics are kept, decoding continues with
+  the next received data.
+  */
+void tetrapol_phys_ch_hibernate(phys_ch_t *phys_ch);
+
+/**
+  Get memory used by decoder instance (bytes).
+
+  All fixed state of the instance is in single allocation, see
+  PHYS_CH_MEM_SIZE_CONTROL and PHYS_CH_MEM_SIZE_TRAFFIC, memory allocated
+  on demand is included.
+  */
+size_t tetrapol_phys_ch_get_mem_size(const phys_ch_t *phys_ch);
+
+/**
+  Skip decoding of BCH, PCH and RCH messages which were decoded recently.
+
+  Broadcast channels repeat the same messages (e.g. D_SYSTEM_INFO in each
+  superframe), repeated message is identified by hash of received data
+  frame and it is not passed to any sink. Receiver set by
+  tetrapol_phys_ch_set_dup_sink() is notified instead (if any).
+  Disabled by default.
+  */
+void tetrapol_phys_ch_set_dup_suppress(phys_ch_t *phys_ch, bool suppress);
+
+void tetrapol_phys_ch_set_dup_sink(phys_ch_t *phys_ch, dup_sink_t sink,
+        void *ptr);
+
+/**
+  Subscribe (or unsubscribe) TSDUs with given codop.
+
+  All codops are subscribed by default. TSDUs which are not subscribed
+  are not decoded nor passed to TSDU receiver, only their codop is read. System information on BCH is always decoded.
+  */
+void tetrapol_phys_ch_subscribe(phys_ch_t *phys_ch, codop_t codop,
+        bool subscribe);
+
+/// Subscribe (or unsubscribe) all codops.
+void tetrapol_phys_ch_subscribe_all(phys_ch_t *phys_ch, bool subscribe);
+
+/** Get format of data accepted by tetrapol_phys_ch_recv(). */
+int tetrapol_phys_ch_get_input_fmt(phys_ch_t *phys_ch);
+
+/**
+  Set format of data accepted by tetrapol_phys_ch_recv().
+
+  @param input_fmt PHYS_CH_INPUT_UNPACKED or PHYS_CH_INPUT_PACKED
+  @return false for invalid format, true otherwise
+  */
+bool tetrapol_phys_ch_set_input_fmt(phys_ch_t *phys_ch, int input_fmt);
+
 /**
   Eat some data from buf into channel decoder.
 
+  Data format is set by tetrapol_phys_ch_set_input_fmt().
+
   @return number of bytes consumed
 */
 int tetrapol_phys_ch_recv(phys_ch_t *phys_ch, uint8_t *buf, int len);
 
+/**
+  Set time of the next bit passed to tetrapol_phys_ch_recv*() (us since
+  epoch, UTC), e.g. host receive time or time of SDR sample counter.
+  Timestamps of following bits are derived from the bit rate until the next
+  call, so it can be set for each received buffer.
+
+  Without that timestamps of frames and messages are relative to channel
+  start. Once the time is set, latency from air to each TSDU, paging,
+  RCH and voice sink call is measured by host clock, see
+  phys_ch_stats_t.latency_hist.
+  */
+void tetrapol_phys_ch_set_time(phys_ch_t *phys_ch, int64_t timestamp);
+
+/**
+  Borrow buffer for zero-copy input, e.g. read() can be done directly into it.
+
+  Packed input with byte aligned stream is written directly into the decoder
+  input buffer, otherwise internal staging buffer is used. Written data must
+  be passed into the decoder by tetrapol_phys_ch_recv_commit() before any
+  other call of tetrapol_phys_ch_recv*().
+
+  @param buf Set to the borrowed buffer.
+  @return maximal number of bytes which can be written, 0 when buffer is full
+  */
+int tetrapol_phys_ch_recv_buf(phys_ch_t *phys_ch, uint8_t **buf);
+
+/**
+  Pass data written into buffer borrowed by tetrapol_phys_ch_recv_buf().
+
+  @param len Number of written bytes.
+  */
+void tetrapol_phys_ch_recv_commit(phys_ch_t *phys_ch, int len);
+
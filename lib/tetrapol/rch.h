@@ -1,12 +1,40 @@
 #pragma once
 
+#include <tetrapol/addr.h>
 #include <tetrapol/data_block.h>
+#include <tetrapol/stats.h>
 
 #include <stdbool.h>
+#include <stddef.h>
+
+/// Random access acknowledgements received on RCH.
+typedef struct {
+    int naddrs;
+    /// acknowledged addresses, NACK when addr.z is set (addr.y is reason)
+    addr_t addrs[3];
+    int64_t timestamp;      ///< start of the last frame of message (us)
+} rch_data_t;
 
 typedef struct _rch_t rch_t;
 
 rch_t *rch_create(void);
 void rch_destroy(rch_t *rch);
+/// Construct in memory provided by caller, rch_sizeof() bytes aligned for
+/// any type, no destruction is required.
+void rch_init(rch_t *rch);
+size_t rch_sizeof(void);
+/// Skip decoding of recently decoded payloads, see tetrapol/dup_cache.h
+void rch_set_dup_suppress(rch_t *rch, bool suppress);
 bool rch_push_data_block(rch_t *rch, data_block_t *data_blk);
-void rch_print(const rch_t *rch);
+void rch_get_stats(const rch_t *rch, log_ch_stats_t *stats);
+
+/// Get last message, valid after rch_push_data_block() returns true
+/// and rch_get_repeats() returns 0.
+const rch_data_t *rch_get_data(const rch_t *rch);
+/**
+  @return how many times was the payload repeated when its decoding was
+    skipped by the last rch_push_data_block() returning true, 0 when it
+    was decoded
+  */
+int rch_get_repeats(const rch_t *rch);
+void rch_print(const rch_data_t *rch_data);
@@ -1,15 +1,31 @@
 #pragma once
 
 #include <tetrapol/data_block.h>
+#include <tetrapol/stats.h>
 #include <tetrapol/tsdu.h>
 #include <tetrapol/timer.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct _sdch_t sdch_t;
 
 sdch_t *sdch_create(void);
 void sdch_destroy(sdch_t *sdch);
+/// Construct in memory provided by caller, sdch_sizeof() bytes aligned for
+/// any type, the SDCH components are placed in the same memory.
+void sdch_init(sdch_t *sdch);
+/// Release SDCH constructed by sdch_init(), memory is owned by caller.
+void sdch_fini(sdch_t *sdch);
+size_t sdch_sizeof(void);
+/// Release memory allocated on demand, pending data are dropped.
+void sdch_hibernate(sdch_t *sdch);
+/// Get size of memory allocated on demand, not included in sdch_sizeof().
+size_t sdch_get_heap_size(const sdch_t *sdch);
 bool sdch_dl_push_data_frame(sdch_t *sdch, data_block_t *data_blk);
+/// TSDU is valid until next data block is pushed, see tsdu_clone()
 tsdu_t *sdch_get_tsdu(sdch_t *sdch);
+/// Decode only TSDUs with codop in filter, see tpdu_ui_set_filter().
+void sdch_set_filter(sdch_t *sdch, const tsdu_filter_t *filter);
+void sdch_get_stats(const sdch_t *sdch, log_ch_stats_t *stats);
 void sdch_tick(const timeval_t *tv, void *sdch);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+  Decoder statistics.
+
+  Counters are updated by the decoding thread without any locking,
+  statistics must be read by the same thread which calls
+  tetrapol_phys_ch_process() (or when processing is paused).
+  All counters are cumulative since the creation of the decoder.
+  */
+
+/// histogram of FEC errors per data block, last bin counts all larger values
+#define STATS_NERRS_BINS 16
+
+/// log2 histogram of frame processing time, bin i counts times
+/// <2^i, 2^(i+1)) ns, last bin counts all larger values
+#define STATS_TIME_BINS 24
+
+/// log2 histogram of latency from the end of the last frame of message on
+/// air to the call of its sink, bin i counts <2^i, 2^(i+1)) us (bin 0
+/// includes negative values), last bin counts all larger values
+#define STATS_LATENCY_BINS 24
+
+/// Data frame reassembly, see data_frame_t.
+typedef struct {
+    uint64_t blocks;        ///< data blocks pushed
+    uint64_t crc_errs;      ///< blocks with CRC failure or uncorrected errors
+    uint64_t frames;        ///< completed data frames
+    uint64_t parity_fixes;  ///< multiblock frames recovered by parity block
+    uint64_t parity_errs;   ///< multiblock frames with parity error
+    uint64_t seq_errs;      ///< invalid FN sequence in multiblock frame
+} data_frame_stats_t;
+
+/// Logical channel (BCH, PCH, RCH, SDCH).
+typedef struct {
+    data_frame_stats_t data_fr;
+    uint64_t fcs_errs;      ///< HDLC frames (or RCH blocks) with invalid FCS
+    uint64_t msgs;          ///< decoded messages (TSDU, paging, ACKs)
+    uint64_t tsdu_errs;     ///< TSDU decoding failures
+    uint64_t dups;          ///< repeated messages, decoding skipped
+} log_ch_stats_t;
+
+/// Physical channel, includes statistics of all logical channels.
+typedef struct {
+    uint64_t frames;        ///< frames received while in frame sync
+    uint64_t sync_found;    ///< frame synchronization acquired
+    uint64_t sync_lost;     ///< frame synchronization lost
+    uint64_t sync_recovered;    ///< sync restored at shifted position
+    uint64_t resyncs;       ///< forced by tetrapol_phys_ch_resync()
+    uint64_t fade_frames;   ///< frames skipped in fade while in sync
+    int scr;                ///< detected (or configured) SCR, -1 unknown
+    /// time (us from channel start) when SCR was detected, -1 if not yet
+    int64_t scr_lock_time;
+    uint64_t voice_frames;
+    uint64_t data_frames;
+    /// data frames on traffic channel, passed only to block sink
+    uint64_t tch_data_frames;
+    /// data frames recognized as high rate data, they are not decoded
+    uint64_t hr_data_frames;
+    uint64_t crc_ok;        ///< frames without errors and with valid CRC
+    uint64_t nerrs_hist[STATS_NERRS_BINS];
+    uint64_t time_hist[STATS_TIME_BINS];
+    uint64_t time_sum;      ///< total frame processing time (ns)
+    /// measured only when time is set by tetrapol_phys_ch_set_time()
+    uint64_t latency_hist[STATS_LATENCY_BINS];
+    uint64_t latency_sum;   ///< total latency (us)
+    log_ch_stats_t bch;
+    log_ch_stats_t pch;
+    log_ch_stats_t rch;
+    log_ch_stats_t sdch;
+} phys_ch_stats_t;
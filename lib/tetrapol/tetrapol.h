@@ -1,5 +1,8 @@
 #pragma once
 
+#include <tetrapol/event.h>
+#include <tetrapol/phys_ch.h>
+
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -17,6 +20,87 @@ enum {
     RADIO_CH_TYPE_TRAFFIC = 2,
 };
 
+/**
+  High level interface, container of physical channels.
+
+  Decoded data of all channels are delivered into callbacks registered
+  by tpol_create(), nothing is printed by the decoder. Channels are
+  identified by index returned by tpol_add_phys_ch(). All calls
+  (including callbacks) are done from the thread calling tpol_recv(),
+  instance must not be shared between threads.
+  */
+typedef struct _tpol_t tpol_t;
+
+/// max. number of physical channels in single tpol_t instance
+#define TPOL_PHYS_CHS_MAX 256
+
+/**
+  Receivers of decoded data, see phys_ch.h, unused receivers can be NULL.
+
+  @param ch Index of physical channel.
+  @param ptr User pointer passed into tpol_create().
+  */
+typedef struct {
+    void (*frame)(int ch, const frame_info_t *fi, void *ptr);
+    void (*tsdu)(int ch, const tsdu_t *tsdu, void *ptr);
+    void (*pch)(int ch, const pch_data_t *pch_data, void *ptr);
+    void (*rch)(int ch, const rch_data_t *rch_data, void *ptr);
+    void (*voice)(int ch, const voice_frame_t *vf, void *ptr);
+} tpol_callbacks_t;
+
+/**
+  Create new container.
+
+  @param cbs Callbacks, copied into instance, can be NULL.
+  @param ptr User pointer, passed into callbacks.
+  @return new instance or NULL
+  */
+tpol_t *tpol_create(const tpol_callbacks_t *cbs, void *ptr);
+
+/// Destroy container including all physical channels.
+void tpol_destroy(tpol_t *tpol);
+
+/**
+  Add new physical channel.
+
+  @param band TETRAPOL_BAND_VHF or TETRAPOL_BAND_UHF
+  @param radio_ch_type RADIO_CH_TYPE_CONTROL or RADIO_CH_TYPE_TRAFFIC
+  @return channel index, -1 on error
+  */
+int tpol_add_phys_ch(tpol_t *tpol, int band, int radio_ch_type);
+
+/// Get number of physical channels.
+int tpol_phys_chs(const tpol_t *tpol);
+
+/**
+  Get physical channel for configuration (SCR, input format, TSDU
+  subscriptions, ...). Sinks of channel are owned by container and must
+  not be changed.
+  */
+phys_ch_t *tpol_get_phys_ch(tpol_t *tpol, int ch);
+
+/**
+  Set shared binary event output, TSDUs and voice frames of all channels
+  are written into it (before callbacks are called).
+
+  @param ew Writer owned by caller or NULL to disable event output,
+    flushing is up to the caller.
+  */
+void tpol_set_event_writer(tpol_t *tpol, event_writer_t *ew);
+
+/**
+  Pass received data into channel and decode them.
+
+  @param ch Channel index.
+  @param buf Data in format set by tetrapol_phys_ch_set_input_fmt().
+  @param len Number of bytes in buf.
+  @return 0 on success, -1 on error
+  */
+int tpol_recv(tpol_t *tpol, int ch, uint8_t *buf, int len);
+
+/// Get statistics of single channel, see tetrapol_phys_ch_get_stats().
+void tpol_get_stats(tpol_t *tpol, int ch, phys_ch_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/time.h>
 
 typedef struct timeval timeval_t;
@@ -8,9 +10,74 @@ typedef struct _timer_t timer_t;
 
 typedef void (*timer_callback_t)(const timeval_t *tv, void *ptr);
 
+/// resolution of timer wheel, one frame
+#define TIMER_SLOT_US 20000
+/// number of wheel slots, longer deadlines wait for more wheel rotations
+#define TIMER_WHEEL_SLOTS 256
+
+/**
+  Deadline in timer wheel, storage is provided by caller.
+
+  Initialize by timer_deadline_init(), fields are private.
+  */
+typedef struct _timer_deadline_t timer_deadline_t;
+struct _timer_deadline_t {
+    timer_deadline_t *prev;
+    timer_deadline_t *next;     ///< NULL when deadline is not pending
+    int64_t expires;            ///< absolute time (us)
+    int period;                 ///< 0 for one-shot deadline (us)
+    timer_callback_t func;
+    void *ptr;
+};
+
+/// Create timer with TIMER_WHEEL_SLOTS slots.
 timer_t *timer_create(void);
 void timer_destroy(timer_t *timer);
+
+/**
+  Construct timer in memory provided by caller (part of larger object).
+
+  Timer with a few deadlines does not need many slots, any number of
+  slots is valid, deadlines beyond the wheel wait for more rotations.
+
+  @param timer Memory of timer_sizeof(nslots) bytes, aligned for any type.
+  */
+void timer_init(timer_t *timer, int nslots);
+/// Release timer constructed by timer_init(), memory is owned by caller.
+void timer_fini(timer_t *timer);
+size_t timer_sizeof(int nslots);
+
+/**
+ * @brief timer_tick Advance time, calls due callbacks.
+ *
+ * Only deadlines in wheel slots the time passes through are checked.
+ */
 void timer_tick(timer_t *timer, int usec);
+
+/// Get time elapsed by timer_tick() calls (us).
+int64_t timer_now(const timer_t *timer);
+
+void timer_deadline_init(timer_deadline_t *dl, timer_callback_t func, void *ptr);
+
+/**
+ * @brief timer_start Start (or restart) deadline.
+ * @param usec Callback is called after 'usec' elapses.
+ * @param period Callback is called repeatedly with 'period' (us),
+ *   use 0 for one-shot deadline.
+ */
+void timer_start(timer_t *timer, timer_deadline_t *dl, int usec, int period);
+
+/// Cancel pending deadline, no-op if is not pending.
+void timer_stop(timer_deadline_t *dl);
+
+inline bool timer_deadline_pending(const timer_deadline_t *dl)
+{
+    return dl->next != NULL;
+}
+
+/**
+ * Simple API, callback is called on every timer_tick().
+ */
 bool timer_register(timer_t *timer, timer_callback_t timer_func, void *ptr);
 void timer_cancel(timer_t *timer, timer_callback_t timer_func, void *ptr);
 
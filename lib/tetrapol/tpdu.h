@@ -12,14 +12,61 @@ typedef struct _tpdu_t tpdu_t;
 typedef struct _tpdu_ui_t tpdu_ui_t;
 
 tpdu_t *tpdu_create(void);
+/// Construct in memory provided by caller, tpdu_sizeof() bytes aligned
+/// for any type, no destruction is required.
+void tpdu_init(tpdu_t *tpdu);
+size_t tpdu_sizeof(void);
 bool tpdu_push_hdlc_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_fr);
 void tpdu_destroy(tpdu_t *tpdu);
+/**
+ * @brief tpdu_ui_get_tsdu Get last decoded TSDU.
+ *
+ * TSDU is allocated from arena of tpdu_ui and is valid until next TSDU is
+ * decoded, use tsdu_clone() to keep it longer.
+ * @return TSDU or NULL
+ */
 tsdu_t *tpdu_ui_get_tsdu(tpdu_ui_t *tpdu);
+
+/**
+ * @brief tpdu_ui_set_filter Decode only TSDUs with codop in filter.
+ *
+ * TSDUs filtered out are silently dropped (they are not decoding errors).
+ * @param filter Filter owned by caller, it is read for each TSDU,
+ *   NULL to decode all TSDUs.
+ */
+void tpdu_ui_set_filter(tpdu_ui_t *tpdu, const tsdu_filter_t *filter);
+
+/// Number of TSDUs which failed to decode, since creation of tpdu_ui.
+uint64_t tpdu_ui_get_tsdu_errs(const tpdu_ui_t *tpdu);
 void tpdu_du_tick(const timeval_t *tv, void *tpdu_du);
 
+/**
+  Create TPDU UI decoder.
+
+  Only the decoder itself is allocated, memory for TSDUs and reassembly
+  of segmented DUs is allocated when required.
+  */
 tpdu_ui_t *tpdu_ui_create(frame_type_t fr_type);
 void tpdu_ui_destroy(tpdu_ui_t *tpdu);
 
+/**
+  Construct in memory provided by caller, tpdu_ui_sizeof() bytes aligned
+  for any type. Release by tpdu_ui_hibernate().
+
+  @param fr_type FRAME_TYPE_DATA or FRAME_TYPE_HR_DATA
+  */
+void tpdu_ui_init(tpdu_ui_t *tpdu, frame_type_t fr_type);
+size_t tpdu_ui_sizeof(void);
+
+/**
+  Release memory allocated on demand (TSDU, segmented DUs), pending
+  segmented DUs are dropped. Counters are kept.
+  */
+void tpdu_ui_hibernate(tpdu_ui_t *tpdu);
+
+/// Get size of memory allocated on demand, not included in tpdu_ui_sizeof().
+size_t tpdu_ui_get_heap_size(const tpdu_ui_t *tpdu);
+
 /**
  * @brief tpdu_ui_push_hdlc_frame
  * Process HDLC frame, optionaly compose frame from segments.
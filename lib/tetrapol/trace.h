@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+  Static tracepoints (USDT) at stage boundaries of decoder.
+
+  Probes are compiled in by build with -DTETRAPOL_USDT=ON (requires
+  sys/sdt.h from systemtap SDT headers), otherwise TRACE() expands to
+  nothing and its arguments are not evaluated. Compiled in probe is single
+  nop until tracer attaches, arguments are read by tracer from registers
+  or stack. Probes of provider "tetrapol", e.g. for perf or bpftrace
+
+    bpftrace -e 'usdt:./tetrapol_dump:tetrapol:block_decoded
+        { @nerrs = lhist(arg2, 0, 16, 1); }'
+
+    frame_acquired(frame_no, offs, fade_frames)
+        frame found at offset 'offs' from expected position after
+        'fade_frames' frames lost in fade
+    scr_scored(frame_no, scr, score, diff, nvalid)
+        SCR search, the best candidate 'scr' leads by 'diff', frame was
+        valid for 'nvalid' candidates
+    block_decoded(frame_no, fr_type, nerrs)
+        data_block_decode_frame() done
+    data_frame_complete(frame_no, nblks, nerrs)
+        data frame completed by block 'frame_no', 'nerrs' blocks were
+        fixed by parity
+    hdlc_parsed(frame_no, cmd, nbits, fcs_ok)
+        HDLC frame of SDCH
+    tpdu_reassembled(nbits, prio, tsdu_ok)
+        unit data TPDU complete (including all segments) and TSDU decoded,
+        it follows hdlc_parsed of the same thread
+    tsdu_delivered(frame_no, codop, timestamp)
+        TSDU passed to sink, 'timestamp' is start of its last frame (us),
+        see tetrapol_phys_ch_set_time()
+
+  All frame numbers are FRAME_NO_UNKNOWN (-1) until BCH is decoded.
+  */
+
+#ifdef TETRAPOL_USDT
+#include <sys/sdt.h>
+
+#define TRACE(name, ...) STAP_PROBEV(tetrapol, name, ##__VA_ARGS__)
+
+#else
+
+#define TRACE(name, ...) do { } while (0)
+
+#endif
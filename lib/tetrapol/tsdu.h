@@ -1,6 +1,7 @@
 #pragma once
 
 #include <tetrapol/addr.h>
+#include <tetrapol/arena.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -133,9 +134,13 @@ typedef struct {
     uint8_t id_tsap;
     bool downlink;      ///< set to true for downlink TSDU, false  otherwise
     int noptionals;     ///< number of optionals
+    /// start of the last frame of TSDU (us), set by phys_ch_t before the sink
+    int64_t timestamp;
+    arena_t *arena;     ///< private arena of TSDU created by tsdu_clone()
     /**
       In subclassed TSDU structure, noptionals pointers should be present.
-      Those are initialized to NULL by tsdu_base_init and freed by tsdu_destroy.
+      Those are initialized to NULL by tsdu_base_set_nopts, optionals are
+      allocated from the same arena as TSDU.
       */
     void *optionals[];
 } tsdu_base_t;
@@ -623,16 +628,61 @@ typedef struct {
 // this might change in future
 typedef tsdu_base_t tsdu_t;
 
+/**
+ * @brief tsdu_destroy Release TSDU created by tsdu_clone().
+ *
+ * TSDU returned by tsdu_d_decode() is owned by arena, call is a no-op.
+ */
 void tsdu_destroy(tsdu_base_t *tsdu);
 
+/**
+ * @brief tsdu_clone Copy TSDU (including optionals) out of arena.
+ *
+ * Use it when TSDU should outlive the arena reset.
+ * @return TSDU which must be released by tsdu_destroy() or NULL
+ */
+tsdu_t *tsdu_clone(const tsdu_t *tsdu);
+
 /**
  * @brief tsdu_d_decode Decode TSDU structure.
+ * @param arena TSDU and all its optionals are allocated from arena.
  * @param data Data packed into bytes.
  * @param nbits Number of bits used in 'data'
  * @param prio Priority from TPDU
  * @param id_tsap TSAP-id
  * @return TSDU or NULL
  */
-tsdu_t *tsdu_d_decode(const uint8_t *data, int nbits, int prio, int id_tsap);
+tsdu_t *tsdu_d_decode(arena_t *arena, const uint8_t *data, int nbits,
+        int prio, int id_tsap);
+
+/// Set of codops, used for selection of TSDUs which are decoded.
+typedef struct {
+    uint64_t bits[4];
+} tsdu_filter_t;
+
+inline bool tsdu_filter_has(const tsdu_filter_t *filter, codop_t codop)
+{
+    return (filter->bits[codop / 64] >> (codop % 64)) & 1;
+}
+
+inline void tsdu_filter_set(tsdu_filter_t *filter, codop_t codop, bool set)
+{
+    const uint64_t mask = 1ULL << (codop % 64);
+    filter->bits[codop / 64] = set ?
+        (filter->bits[codop / 64] | mask) : (filter->bits[codop / 64] & ~mask);
+}
+
+/// Add (set = true) or remove all codops.
+void tsdu_filter_set_all(tsdu_filter_t *filter, bool set);
+
+/**
+ * @brief tsdu_filter_match Check codop of TSDU without decoding it.
+ * @param data Data passed to tsdu_d_decode().
+ * @param nbits Number of bits used in 'data'
+ * @return true if TSDU should be decoded (including too short TSDU, it is
+ *   reported as error by tsdu_d_decode())
+ */
+bool tsdu_filter_match(const tsdu_filter_t *filter, const uint8_t *data,
+        int nbits);
 
-void tsdu_print(tsdu_t *tsdu);
+void tsdu_print(const tsdu_t *tsdu);
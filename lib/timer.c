@@ -5,23 +5,89 @@
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct {
+// callback registered by timer_register()
+typedef struct _callback_t callback_t;
+struct _callback_t {
+    callback_t *next;
     timer_callback_t func;
     void *ptr;
-} callback_t;
+};
 
 struct _timer_t {
-    int ncallbacks;
     callback_t *callbacks;
     timeval_t tv;
+    int64_t now;                ///< tv in us
+    int nslots;
+    /**
+      List heads, deadlines hashed by expiration time, placed right after
+      timer (see timer_sizeof()).
+
+      Intentionally not a flexible array member: GCC 12 at -O2 assumes that
+      store through 'dl->prev->next' in list_del() does not modify
+      'timer->slots[i].next' when slots[] is a flexible array member, and
+      compiled the loop in timer_fini() into infinite loop writing to NULL
+      (fixed by -fno-strict-aliasing). Pointer makes every access to list
+      heads a plain access through timer_deadline_t.
+      */
+    timer_deadline_t *slots;
 };
 
+extern inline bool timer_deadline_pending(const timer_deadline_t *dl);
+
+static void list_init(timer_deadline_t *head)
+{
+    head->prev = head->next = head;
+}
+
+static void list_add_tail(timer_deadline_t *head, timer_deadline_t *dl)
+{
+    dl->prev = head->prev;
+    dl->next = head;
+    head->prev->next = dl;
+    head->prev = dl;
+}
+
+static void list_del(timer_deadline_t *dl)
+{
+    dl->prev->next = dl->next;
+    dl->next->prev = dl->prev;
+    dl->prev = dl->next = NULL;
+}
+
+static int64_t slot_no(int64_t t)
+{
+    return t / TIMER_SLOT_US;
+}
+
+static void wheel_add(timer_t *timer, timer_deadline_t *dl)
+{
+    // already expired deadline is fired by next tick
+    const int64_t t = (dl->expires > timer->now) ? dl->expires : timer->now;
+    list_add_tail(&timer->slots[slot_no(t) % timer->nslots], dl);
+}
+
+size_t timer_sizeof(int nslots)
+{
+    return sizeof(timer_t) + nslots * sizeof(timer_deadline_t);
+}
+
+void timer_init(timer_t *timer, int nslots)
+{
+    memset(timer, 0, sizeof(timer_t));
+    timer->nslots = nslots;
+    timer->slots = (timer_deadline_t *)(timer + 1);
+    for (int i = 0; i < nslots; ++i) {
+        list_init(&timer->slots[i]);
+    }
+}
+
 timer_t *timer_create(void)
 {
-    timer_t *timer = calloc(1, sizeof(timer_t));
+    timer_t *timer = malloc(timer_sizeof(TIMER_WHEEL_SLOTS));
     if (!timer) {
         return NULL;
     }
+    timer_init(timer, TIMER_WHEEL_SLOTS);
 
     return timer;
 }
@@ -31,53 +97,132 @@ void timer_destroy(timer_t *timer)
     if (!timer) {
         return;
     }
-    free(timer->callbacks);
+    timer_fini(timer);
     free(timer);
 }
 
+void timer_fini(timer_t *timer)
+{
+    while (timer->callbacks) {
+        callback_t *next = timer->callbacks->next;
+        free(timer->callbacks);
+        timer->callbacks = next;
+    }
+    // deadlines are owned by callers, just make them not pending
+    for (int i = 0; i < timer->nslots; ++i) {
+        while (timer->slots[i].next != &timer->slots[i]) {
+            list_del(timer->slots[i].next);
+        }
+    }
+}
+
 void timer_tick(timer_t *timer, int usec)
 {
+    const int64_t slot_first = slot_no(timer->now);
+
     timer->tv.tv_usec += usec;
     timer->tv.tv_sec += timer->tv.tv_usec / 1000000;
     timer->tv.tv_usec %= 1000000;
+    timer->now += usec;
+
+    for (callback_t *cb = timer->callbacks, *next; cb; cb = next) {
+        // callback might cancel itself
+        next = cb->next;
+        cb->func(&timer->tv, cb->ptr);
+    }
+
+    // collect due deadlines first, callbacks might start/stop deadlines
+    timer_deadline_t due;
+    list_init(&due);
+    int64_t slot_last = slot_no(timer->now);
+    if (slot_last - slot_first >= timer->nslots) {
+        slot_last = slot_first + timer->nslots - 1;
+    }
+    for (int64_t i = slot_first; i <= slot_last; ++i) {
+        timer_deadline_t *head = &timer->slots[i % timer->nslots];
+        timer_deadline_t *dl = head->next;
+        while (dl != head) {
+            timer_deadline_t *next = dl->next;
+            if (dl->expires <= timer->now) {
+                list_del(dl);
+                list_add_tail(&due, dl);
+            }
+            dl = next;
+        }
+    }
+
+    while (due.next != &due) {
+        timer_deadline_t *dl = due.next;
+        list_del(dl);
+        if (dl->period) {
+            dl->expires += dl->period;
+            if (dl->expires <= timer->now) {
+                dl->expires = timer->now + dl->period;
+            }
+            wheel_add(timer, dl);
+        }
+        dl->func(&timer->tv, dl->ptr);
+    }
+}
 
-    for (int i = 0; i < timer->ncallbacks; ++i) {
-        timer->callbacks[i].func(&timer->tv, timer->callbacks[i].ptr);
+int64_t timer_now(const timer_t *timer)
+{
+    return timer->now;
+}
+
+void timer_deadline_init(timer_deadline_t *dl, timer_callback_t func, void *ptr)
+{
+    dl->prev = dl->next = NULL;
+    dl->func = func;
+    dl->ptr = ptr;
+}
+
+void timer_start(timer_t *timer, timer_deadline_t *dl, int usec, int period)
+{
+    timer_stop(dl);
+    dl->expires = timer->now + usec;
+    dl->period = period;
+    wheel_add(timer, dl);
+}
+
+void timer_stop(timer_deadline_t *dl)
+{
+    if (timer_deadline_pending(dl)) {
+        list_del(dl);
     }
 }
 
 bool timer_register(timer_t *timer, timer_callback_t timer_func, void *ptr)
 {
     // check for double-registration
-    for (int i = 0; i < timer->ncallbacks; ++i) {
-        if (timer->callbacks[i].func == timer_func &&
-                timer->callbacks[i].ptr == ptr) {
+    callback_t **p = &timer->callbacks;
+    for ( ; *p; p = &(*p)->next) {
+        if ((*p)->func == timer_func && (*p)->ptr == ptr) {
             LOG(WTF, "double registration of callback");
             return false;
         }
     }
 
-    ++timer->ncallbacks;
-    callback_t *p = realloc(timer->callbacks, sizeof(callback_t) * timer->ncallbacks);
-    if (!p) {
+    callback_t *cb = malloc(sizeof(callback_t));
+    if (!cb) {
         LOG(ERR, "ERR OOM");
         return false;
     }
-    timer->callbacks = p;
-    timer->callbacks[timer->ncallbacks - 1].func = timer_func;
-    timer->callbacks[timer->ncallbacks - 1].ptr = ptr;
+    cb->next = NULL;
+    cb->func = timer_func;
+    cb->ptr = ptr;
+    *p = cb;
 
     return true;
 }
 
 void timer_cancel(timer_t *timer, timer_callback_t timer_func, void *ptr)
 {
-    for (int i = 0; i < timer->ncallbacks; ++i) {
-        if (timer->callbacks[i].func == timer_func &&
-                timer->callbacks[i].ptr == ptr) {
-            memmove(&timer->callbacks[i], &timer->callbacks[i + 1],
-                    sizeof(callback_t) * (timer->ncallbacks - i - 1));
-            --timer->ncallbacks;
+    for (callback_t **p = &timer->callbacks; *p; p = &(*p)->next) {
+        if ((*p)->func == timer_func && (*p)->ptr == ptr) {
+            callback_t *cb = *p;
+            *p = cb->next;
+            free(cb);
             return;
         }
     }
@@ -1,8 +1,10 @@
 #define LOG_PREFIX "tpdu"
 #include <tetrapol/log.h>
+#include <tetrapol/arena.h>
 #include <tetrapol/misc.h>
 #include <tetrapol/tsdu.h>
 #include <tetrapol/tpdu.h>
+#include <tetrapol/trace.h>
 #include <tetrapol/misc.h>
 
 #include <stdlib.h>
@@ -21,13 +23,41 @@ enum {
 
 #define TPDU_CODE_PREFIX_MASK (0x18)
 
-typedef struct {
-    timeval_t tv;
+// enough for any common TSDU, arena grows for longer ones
+#define TSDU_ARENA_SIZE 4096
+
+// max. HDLC frame data - the shortest TPDU_DU_header (single octet),
+// frame of 8 high rate blocks carries more than data frame
+#define SEG_DATA_LEN (HDLC_DATA_LEN_MAX - 1)
+// segments received out of order, shared by all DUs of tpdu_ui
+#define SEG_SLAB_SIZE SYS_PAR_N452
+
+/// payload of segment waiting for its predecessors
+typedef struct _seg_buf_t seg_buf_t;
+struct _seg_buf_t {
+    seg_buf_t *next;        ///< next pending segment of DU or next free one
+    uint8_t packet_num;
+    int nbits;
+    uint8_t data[SEG_DATA_LEN];
+};
+
+typedef struct _segmented_du_t segmented_du_t;
+struct _segmented_du_t {
+    /// active DUs are listed in order of T454 expiration
+    segmented_du_t *prev;
+    segmented_du_t *next;
+    int64_t deadline;       ///< T454 expiration (us)
+    bool active;
     uint8_t id_tsap;
     uint8_t prio;
-    uint8_t nsegments;  ///< total amount of segments (HDLC frames) in DU
-    hdlc_frame_t *hdlc_frs[SYS_PAR_N452];
-} segmented_du_t;
+    uint8_t nsegments;      ///< total amount of segments (HDLC frames) in DU
+    uint8_t nappended;      ///< segments already appended into data
+    uint64_t received;      ///< bitmap of received segments
+    seg_buf_t *pending;     ///< out of order segments sorted by packet_num
+    int nbits;              ///< length of reassembled data
+    int size;               ///< allocated size of data
+    uint8_t *data;          ///< reassembled data, kept for reuse
+};
 
 typedef struct {
     uint8_t tsap_id;
@@ -40,22 +70,47 @@ struct _tpdu_t {
     connection_t *conns_fast[16];  // listed by TSAP id
 };
 
+/// reassembly state, most channels (BCH) never receive segmented DU
+typedef struct {
+    segmented_du_t seg_du[128];
+    seg_buf_t seg_bufs[SEG_SLAB_SIZE];
+} seg_state_t;
+
 struct _tpdu_ui_t {
     frame_type_t fr_type;
-    segmented_du_t *seg_du[128];
+    seg_state_t *seg;           ///< allocated by the first segment
+    segmented_du_t *du_first;   ///< active DU which expires first
+    segmented_du_t *du_last;
+    seg_buf_t *seg_free;
+    int64_t now;                ///< time of last tick (us)
+    /// memory for TSDU, reset on each decoding, allocated by the first one
+    arena_t *arena;
     tsdu_t *tsdu;           ///< contains last decoded TSDU
+    uint64_t tsdu_errs;     ///< number of TSDU decoding failures
+    const tsdu_filter_t *filter;    ///< decoded codops, NULL for all
 };
 
 tpdu_t *tpdu_create(void)
 {
-    tpdu_t *tpdu = calloc(1, sizeof(tpdu_t));
+    tpdu_t *tpdu = malloc(sizeof(tpdu_t));
     if (!tpdu) {
         return NULL;
     }
+    tpdu_init(tpdu);
 
     return tpdu;
 }
 
+void tpdu_init(tpdu_t *tpdu)
+{
+    memset(tpdu, 0, sizeof(tpdu_t));
+}
+
+size_t tpdu_sizeof(void)
+{
+    return sizeof(tpdu_t);
+}
+
 static bool tpdu_push_supervision_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_fr)
 {
     IF_LOG(INFO) {
@@ -73,9 +128,9 @@ static bool tpdu_push_supervision_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_f
                 break;
         }
         addr_print(&hdlc_fr->addr);
-        printf("\n\trecv_seq_no: %d P: %d\n",
-               hdlc_fr->command.supervision.recv_seq_no,
-               hdlc_fr->command.supervision.p_e);
+        log_printf("\n\trecv_seq_no: %d P: %d\n",
+                   hdlc_fr->command.supervision.recv_seq_no,
+                   hdlc_fr->command.supervision.p_e);
     }
 
     if (!cmpzero(hdlc_fr->data, hdlc_fr->nbits / 8)) {
@@ -122,12 +177,12 @@ static bool tpdu_push_information_frame(tpdu_t *tpdu, const hdlc_frame_t *hdlc_f
 
     IF_LOG(INFO) {
         LOG_("information cmd\n");
-        printf("\taddr: ");
+        log_printf("\taddr: ");
         addr_print(&hdlc_fr->addr);
-        printf("\n\trecv_seq_no: %d send_seq_no: %d P: %d\n",
-               hdlc_fr->command.information.recv_seq_no,
-               hdlc_fr->command.information.send_seq_no,
-               hdlc_fr->command.information.p_e);
+        log_printf("\n\trecv_seq_no: %d send_seq_no: %d P: %d\n",
+                   hdlc_fr->command.information.recv_seq_no,
+                   hdlc_fr->command.information.send_seq_no,
+                   hdlc_fr->command.information.p_e);
     }
 
     const uint8_t code_prefix   = code & TPDU_CODE_PREFIX_MASK;
@@ -215,12 +270,74 @@ void tpdu_destroy(tpdu_t *tpdu)
     free(tpdu);
 }
 
-void tpdu_ui_segments_destroy(segmented_du_t *du)
+static void seg_du_unlink(tpdu_ui_t *tpdu, segmented_du_t *du)
 {
-    for (int i = 0; i < SYS_PAR_N452; ++i) {
-        free(du->hdlc_frs[i]);
+    if (du->prev) {
+        du->prev->next = du->next;
+    } else {
+        tpdu->du_first = du->next;
+    }
+    if (du->next) {
+        du->next->prev = du->prev;
+    } else {
+        tpdu->du_last = du->prev;
     }
-    free(du);
+    du->prev = du->next = NULL;
+}
+
+/// T454 is (re)started, new deadline is always the latest one
+static void seg_du_restart_t454(tpdu_ui_t *tpdu, segmented_du_t *du)
+{
+    if (du->active) {
+        seg_du_unlink(tpdu, du);
+    }
+    du->active = true;
+    du->deadline = tpdu->now + SYS_PAR_T454;
+    du->prev = tpdu->du_last;
+    if (tpdu->du_last) {
+        tpdu->du_last->next = du;
+    } else {
+        tpdu->du_first = du;
+    }
+    tpdu->du_last = du;
+}
+
+static void seg_du_release(tpdu_ui_t *tpdu, segmented_du_t *du)
+{
+    seg_du_unlink(tpdu, du);
+    while (du->pending) {
+        seg_buf_t *buf = du->pending;
+        du->pending = buf->next;
+        buf->next = tpdu->seg_free;
+        tpdu->seg_free = buf;
+    }
+    du->active = false;
+    du->nsegments = 0;
+    du->nappended = 0;
+    du->received = 0;
+    du->nbits = 0;
+}
+
+static bool seg_du_append(segmented_du_t *du, const uint8_t *data, int nbits)
+{
+    const int len = du->nbits / 8 + nbits / 8;
+    if (len > du->size) {
+        const int size = (2 * du->size > len) ? 2 * du->size : len;
+        uint8_t *p = realloc(du->data, size);
+        if (!p) {
+            LOG(ERR, "ERR OOM");
+            return false;
+        }
+        du->data = p;
+        du->size = size;
+    }
+    if (nbits >= 8) {
+        memcpy(du->data + du->nbits / 8, data, nbits / 8);
+    }
+    du->nbits += nbits;
+    ++du->nappended;
+
+    return true;
 }
 
 tpdu_ui_t *tpdu_ui_create(frame_type_t fr_type)
@@ -230,27 +347,111 @@ tpdu_ui_t *tpdu_ui_create(frame_type_t fr_type)
         return NULL;
     }
 
-    tpdu_ui_t *tpdu = calloc(1, sizeof(tpdu_ui_t));
+    tpdu_ui_t *tpdu = malloc(sizeof(tpdu_ui_t));
     if (!tpdu) {
         return NULL;
     }
-    tpdu->fr_type = fr_type;
+    tpdu_ui_init(tpdu, fr_type);
 
     return tpdu;
 }
 
-void tpdu_ui_destroy(tpdu_ui_t *tpdu)
+void tpdu_ui_init(tpdu_ui_t *tpdu, frame_type_t fr_type)
+{
+    memset(tpdu, 0, sizeof(tpdu_ui_t));
+    tpdu->fr_type = fr_type;
+}
+
+size_t tpdu_ui_sizeof(void)
+{
+    return sizeof(tpdu_ui_t);
+}
+
+void tpdu_ui_hibernate(tpdu_ui_t *tpdu)
+{
+    if (tpdu->seg) {
+        for (int i = 0; i < ARRAY_LEN(tpdu->seg->seg_du); ++i) {
+            free(tpdu->seg->seg_du[i].data);
+        }
+        free(tpdu->seg);
+        tpdu->seg = NULL;
+    }
+    tpdu->du_first = tpdu->du_last = NULL;
+    tpdu->seg_free = NULL;
+    arena_destroy(tpdu->arena);
+    tpdu->arena = NULL;
+    tpdu->tsdu = NULL;
+}
+
+size_t tpdu_ui_get_heap_size(const tpdu_ui_t *tpdu)
 {
-    tsdu_destroy(tpdu->tsdu);
-    for (int i = 0; i < ARRAY_LEN(tpdu->seg_du); ++i) {
-        if (!tpdu->seg_du[i]) {
-            continue;
+    size_t size = 0;
+    if (tpdu->seg) {
+        size += sizeof(seg_state_t);
+        for (int i = 0; i < ARRAY_LEN(tpdu->seg->seg_du); ++i) {
+            size += tpdu->seg->seg_du[i].size;
         }
-        tpdu_ui_segments_destroy(tpdu->seg_du[i]);
     }
+    if (tpdu->arena) {
+        size += arena_mem_size(tpdu->arena);
+    }
+
+    return size;
+}
+
+void tpdu_ui_destroy(tpdu_ui_t *tpdu)
+{
+    tpdu_ui_hibernate(tpdu);
     free(tpdu);
 }
 
+static bool seg_state_alloc(tpdu_ui_t *tpdu)
+{
+    tpdu->seg = calloc(1, sizeof(seg_state_t));
+    if (!tpdu->seg) {
+        LOG(ERR, "ERR OOM");
+        return false;
+    }
+    for (int i = 0; i < ARRAY_LEN(tpdu->seg->seg_bufs); ++i) {
+        tpdu->seg->seg_bufs[i].next = tpdu->seg_free;
+        tpdu->seg_free = &tpdu->seg->seg_bufs[i];
+    }
+
+    return true;
+}
+
+/**
+  Decode TSDU from (reassembled) DU unless its codop is filtered out.
+
+  @return true if TSDU is decoded
+  */
+static bool tpdu_ui_decode(tpdu_ui_t *tpdu, const uint8_t *data, int nbits,
+        int prio, int id_tsap)
+{
+    tpdu->tsdu = NULL;
+    if (tpdu->filter && !tsdu_filter_match(tpdu->filter, data, nbits)) {
+        return false;
+    }
+    if (tpdu->arena) {
+        arena_reset(tpdu->arena);
+    } else {
+        tpdu->arena = arena_create(TSDU_ARENA_SIZE);
+        if (!tpdu->arena) {
+            LOG(ERR, "ERR OOM");
+            return false;
+        }
+    }
+
+    tpdu->tsdu = tsdu_d_decode(tpdu->arena, data, nbits, prio, id_tsap);
+    TRACE(tpdu_reassembled, nbits, prio, tpdu->tsdu != NULL);
+    if (!tpdu->tsdu) {
+        ++tpdu->tsdu_errs;
+        return false;
+    }
+
+    return true;
+}
+
 static bool tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_fr,
                                      bool allow_seg)
 {
@@ -266,18 +467,15 @@ static bool tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_f
 
     LOG(DBG, "DU EXT=%d SEG=%d PRIO=%d ID_TSAP=%d", ext, seg, prio, id_tsap);
     if (ext == 0 && seg == 0) {
-        tsdu_destroy(tpdu->tsdu);
-
         // PAS 0001-3-3 9.5.1.2
         if ((tpdu->fr_type == FRAME_TYPE_DATA && hdlc_fr->nbits > (3*8)) ||
-                (tpdu->fr_type == FRAME_TYPE_DATA && hdlc_fr->nbits > (6*8))) {
+                (tpdu->fr_type == FRAME_TYPE_HR_DATA && hdlc_fr->nbits > (6*8))) {
             const int nbits     = get_bits(8, hdlc_fr->data + 1, 0) * 8;
-            tpdu->tsdu = tsdu_d_decode(hdlc_fr->data + 2, nbits, prio, id_tsap);
-        } else {
-            const int nbits = hdlc_fr->nbits - 8;
-            tpdu->tsdu = tsdu_d_decode(hdlc_fr->data + 1, nbits, prio, id_tsap);
+            return tpdu_ui_decode(tpdu, hdlc_fr->data + 2, nbits,
+                    prio, id_tsap);
         }
-        return tpdu->tsdu != NULL;
+        const int nbits = hdlc_fr->nbits - 8;
+        return tpdu_ui_decode(tpdu, hdlc_fr->data + 1, nbits, prio, id_tsap);
     }
 
     if (ext != 1) {
@@ -309,82 +507,99 @@ static bool tpdu_ui_push_hdlc_frame_(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_f
     }
     LOG(DBG, "UI SEGM_REF=%d, PACKET_NUM=%d", seg_ref, packet_num);
 
-    segmented_du_t *seg_du = tpdu->seg_du[seg_ref];
-    if (seg_du == NULL) {
-        seg_du = calloc(1, sizeof(segmented_du_t));
-        if (!seg_du) {
-            return false;
-        }
-        tpdu->seg_du[seg_ref] = seg_du;
+    if (packet_num >= SYS_PAR_N452) {
+        LOG(WTF, "too many segments (%d)", packet_num);
+        return false;
+    }
+
+    if (!tpdu->seg && !seg_state_alloc(tpdu)) {
+        return false;
+    }
+    segmented_du_t *seg_du = &tpdu->seg->seg_du[seg_ref];
+    if (!seg_du->active) {
         seg_du->id_tsap = id_tsap;
         seg_du->prio = prio;
     }
 
-    if (seg_du->hdlc_frs[packet_num]) {
+    if (seg_du->received & (1ULL << packet_num)) {
         // segment already recieved
         return false;
     }
 
-    seg_du->hdlc_frs[packet_num] = malloc(sizeof(hdlc_frame_t));
-    if (!seg_du->hdlc_frs[packet_num]) {
-        LOG(ERR, "ERR OOM");
-        return false;
+    // payload of segment
+    int n_ext = 1;
+    // skip ext headers
+    while (get_bits(1, hdlc_fr->data + n_ext - 1, 0)) {
+        ++n_ext;
     }
-    memcpy(seg_du->hdlc_frs[packet_num], hdlc_fr, sizeof(hdlc_frame_t));
-
+    int nbits;
     if (seg == 0) {
-        seg_du->nsegments = packet_num + 1;
+        nbits = hdlc_fr->data[n_ext++] * 8;
+    } else {
+        nbits = hdlc_fr->nbits - 8 * n_ext;
     }
-
-    // reset T454 timer
-    seg_du->tv.tv_sec = 0;
-    seg_du->tv.tv_usec = 0;
-
-    // last segment is still missing
-    if (!seg_du->nsegments) {
+    if (nbits < 0 || 8 * n_ext + nbits > hdlc_fr->nbits) {
+        LOG(WTF, "invalid segment length %d", nbits);
         return false;
     }
+    const uint8_t *data = &hdlc_fr->data[n_ext];
 
-    // check if we have all segments
-    for (int i = 0; i < seg_du->nsegments; ++i) {
-        if (!seg_du->hdlc_frs[i]) {
+    if (packet_num == seg_du->nappended) {
+        if (!seg_du_append(seg_du, data, nbits)) {
             return false;
         }
-    }
-
-    // max_segments * (sizeof(hdlc_frame_t->data) - TPDU_DU_header)
-    uint8_t data[SYS_PAR_N452 * (sizeof(((hdlc_frame_t*)NULL)->data) - 3)];
-    int nbits = 0;
-    // collect data from all segments
-    if (tpdu->fr_type == FRAME_TYPE_DATA) {
-        uint8_t *d = data;
-        for (int i = 0; i < seg_du->nsegments; ++i) {
-            hdlc_fr = seg_du->hdlc_frs[i];
-            int n_ext = 1;
-            // skip ext headers
-            while (get_bits(1, hdlc_fr->data + n_ext - 1, 0)) {
-                ++n_ext;
+        // append segments which were waiting for this one
+        while (seg_du->pending &&
+                seg_du->pending->packet_num == seg_du->nappended) {
+            seg_buf_t *buf = seg_du->pending;
+            if (!seg_du_append(seg_du, buf->data, buf->nbits)) {
+                return false;
             }
-            int n;
-            if (i == (seg_du->nsegments - 1)) {
-                n = hdlc_fr->data[n_ext++] * 8;
-            } else {
-                n = hdlc_fr->nbits - 8 * n_ext;
-            }
-            nbits += n;
-            memcpy(d, &hdlc_fr->data[n_ext], n / 8);
-            d += n / 8;
+            seg_du->pending = buf->next;
+            buf->next = tpdu->seg_free;
+            tpdu->seg_free = buf;
+        }
+    } else {
+        seg_buf_t *buf = tpdu->seg_free;
+        if (!buf) {
+            LOG(ERR, "no space for out of order segment");
+            return false;
         }
-    } else {    // FRAME_TYPE_HR_DATA
-        // TODO
+        if (nbits / 8 > SEG_DATA_LEN) {
+            LOG(WTF, "too long out of order segment %d", nbits);
+            return false;
+        }
+        tpdu->seg_free = buf->next;
+        buf->packet_num = packet_num;
+        buf->nbits = nbits;
+        memcpy(buf->data, data, nbits / 8);
+
+        seg_buf_t **p = &seg_du->pending;
+        while (*p && (*p)->packet_num < packet_num) {
+            p = &(*p)->next;
+        }
+        buf->next = *p;
+        *p = buf;
+    }
+    seg_du->received |= 1ULL << packet_num;
+
+    if (seg == 0) {
+        seg_du->nsegments = packet_num + 1;
     }
 
-    tpdu_ui_segments_destroy(seg_du);
-    tpdu->seg_du[seg_ref] = NULL;
+    // reset T454 timer
+    seg_du_restart_t454(tpdu, seg_du);
+
+    // check if we have all segments, last segment might be still missing
+    if (!seg_du->nsegments || seg_du->nappended < seg_du->nsegments) {
+        return false;
+    }
 
-    tpdu->tsdu = tsdu_d_decode(data, nbits, prio, id_tsap);
+    const bool ret = tpdu_ui_decode(tpdu, seg_du->data, seg_du->nbits,
+            seg_du->prio, seg_du->id_tsap);
+    seg_du_release(tpdu, seg_du);
 
-    return tpdu->tsdu != NULL;
+    return ret;
 }
 
 bool tpdu_ui_push_hdlc_frame(tpdu_ui_t *tpdu, const hdlc_frame_t *hdlc_fr)
@@ -404,28 +619,25 @@ tsdu_t *tpdu_ui_get_tsdu(tpdu_ui_t *tpdu)
     return tsdu;
 }
 
-void tpdu_du_tick(const timeval_t *tv, void *tpdu_du)
+void tpdu_ui_set_filter(tpdu_ui_t *tpdu, const tsdu_filter_t *filter)
 {
-    tpdu_ui_t *tpdu = tpdu_du;
+    tpdu->filter = filter;
+}
 
-    // set/check T454 timer
-    for (int i = 0; i < ARRAY_LEN(tpdu->seg_du); ++i) {
-        if (!tpdu->seg_du[i]) {
-            continue;
-        }
+uint64_t tpdu_ui_get_tsdu_errs(const tpdu_ui_t *tpdu)
+{
+    return tpdu->tsdu_errs;
+}
 
-        if (!tpdu->seg_du[i]->tv.tv_sec && !tpdu->seg_du[i]->tv.tv_usec) {
-            tpdu->seg_du[i]->tv.tv_sec = tv->tv_sec;
-            tpdu->seg_du[i]->tv.tv_usec = tv->tv_usec;
-            continue;
-        }
+void tpdu_du_tick(const timeval_t *tv, void *tpdu_du)
+{
+    tpdu_ui_t *tpdu = tpdu_du;
 
-        if (timeval_abs_delta(&tpdu->seg_du[i]->tv, tv) < SYS_PAR_T454) {
-            continue;
-        }
+    tpdu->now = tv->tv_sec * 1000000LL + tv->tv_usec;
 
+    // check T454 timer
+    while (tpdu->du_first && tpdu->du_first->deadline <= tpdu->now) {
         // TODO: report error to application layer
-        tpdu_ui_segments_destroy(tpdu->seg_du[i]);
-        tpdu->seg_du[i] = NULL;
+        seg_du_release(tpdu, tpdu->du_first);
     }
 }
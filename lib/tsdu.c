@@ -1,5 +1,6 @@
 #define LOG_PREFIX "tsdu"
 #include <tetrapol/log.h>
+#include <tetrapol/arena.h>
 #include <tetrapol/tsdu.h>
 #include <tetrapol/misc.h>
 #include <tetrapol/bit_utils.h>
@@ -10,9 +11,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define CHECK_LEN(len, min_len, tsdu) \
-    if ((len) < (min_len)) { \
-        LOG(ERR, "%d data too short %d < %d", __LINE__, (len), (min_len)); \
+#define CHECK_OVERFLOW(br, tsdu) \
+    if ((br)->overflow) { \
+        LOG(ERR, "%d data too short %d", __LINE__, (br)->end); \
         tsdu_destroy((tsdu_base_t *)tsdu); \
         return NULL; \
     }
@@ -292,126 +293,148 @@ void tsdu_destroy(tsdu_base_t *tsdu)
     if (!tsdu) {
         return;
     }
+    // TSDU allocated from channel arena is released by arena_reset()
+    arena_destroy(tsdu->arena);
+}
+
+tsdu_t *tsdu_clone(const tsdu_t *tsdu)
+{
+    size_t size = arena_alloc_space(arena_alloc_size(tsdu));
     for (int i = 0; i < tsdu->noptionals; ++i) {
-        free(tsdu->optionals[i]);
+        if (tsdu->optionals[i]) {
+            size += arena_alloc_space(arena_alloc_size(tsdu->optionals[i]));
+        }
     }
-    free(tsdu);
+
+    arena_t *arena = arena_create(size);
+    if (!arena) {
+        LOG(ERR, "ERR OOM");
+        return NULL;
+    }
+
+    tsdu_t *clone = arena_alloc(arena, arena_alloc_size(tsdu));
+    memcpy(clone, tsdu, arena_alloc_size(tsdu));
+    for (int i = 0; i < tsdu->noptionals; ++i) {
+        if (tsdu->optionals[i]) {
+            const size_t l = arena_alloc_size(tsdu->optionals[i]);
+            clone->optionals[i] = arena_alloc(arena, l);
+            memcpy(clone->optionals[i], tsdu->optionals[i], l);
+        }
+    }
+    clone->arena = arena;
+
+    return clone;
 }
 
 static void tsdu_base_set_nopts(tsdu_base_t *tsdu, int noptionals)
 {
+    tsdu->arena = NULL;
     tsdu->noptionals = noptionals;
     memset(tsdu->optionals, 0, noptionals * sizeof(void *));
 }
 
 static void tsdu_base_print(const tsdu_base_t *tsdu)
 {
-    printf("\tCODOP=0x%02x (%s)\n\tPRIO=%d\n\tID_TSAP=%d\n",
-           tsdu->codop, codop_str[tsdu->codop], tsdu->prio, tsdu->id_tsap);
+    log_printf("\tCODOP=0x%02x (%s)\n\tPRIO=%d\n\tID_TSAP=%d\n",
+               tsdu->codop, codop_str[tsdu->codop], tsdu->prio, tsdu->id_tsap);
     // TODO: print addr
 }
 
-static void activation_mode_decode(activation_mode_t *am, uint8_t data)
+static void activation_mode_read(activation_mode_t *am, bit_reader_t *br)
 {
-    am->hook = get_bits(2, &data, 0);
-    am->type = get_bits(2, &data, 2);
+    am->hook = bit_reader_get(br, 2);
+    am->type = bit_reader_get(br, 2);
 }
 
-static void cell_id_decode1(cell_id_t *cell_id, const uint8_t *data)
+static void cell_id_set(cell_id_t *cell_id, int type, int id6, int id4)
 {
-    int type = get_bits(2, data, 0);
     if (type == CELL_ID_FORMAT_0) {
-        cell_id->bs_id = get_bits(6, data, 2);
-        cell_id->rws_id = get_bits(4, data, 8);
+        cell_id->bs_id = id6;
+        cell_id->rws_id = id4;
     } else if (type == CELL_ID_FORMAT_1) {
-        cell_id->bs_id = get_bits(4, data, 8);
-        cell_id->rws_id = get_bits(6, data, 2);
+        cell_id->bs_id = id4;
+        cell_id->rws_id = id6;
     } else {
         LOG(WTF, "unknown cell_id_type (%d)", type);
     }
 }
 
-// specific for d_system_info - cell in offline mode
-static void cell_id_decode2(cell_id_t *cell_id, const uint8_t *data)
+static void cell_id_read(cell_id_t *cell_id, bit_reader_t *br)
 {
-    int type = get_bits(2, data, 8);
-    if (type == CELL_ID_FORMAT_0) {
-        cell_id->bs_id = get_bits(6, data, 10);
-        cell_id->rws_id = get_bits(4, data, 4);;
-    } else if (type == CELL_ID_FORMAT_1) {
-        cell_id->bs_id = get_bits(4, data, 4);;
-        cell_id->rws_id = get_bits(6, data, 10);;
-    } else {
-        LOG(WTF, "unknown cell_id_type (%d)", type);
-    }
+    const int type = bit_reader_get(br, 2);
+    const int id6 = bit_reader_get(br, 6);
+    const int id4 = bit_reader_get(br, 4);
+    cell_id_set(cell_id, type, id6, id4);
 }
 
 static tsdu_d_group_activation_t *
-d_group_activation_decode(const uint8_t *data, int nbits)
+d_group_activation_decode(arena_t *arena, bit_reader_t *br)
 {
-    tsdu_d_group_activation_t *tsdu = malloc(sizeof(tsdu_d_group_activation_t));
+    tsdu_d_group_activation_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_group_activation_t));
     if (!tsdu) {
         return NULL;
     }
 
     tsdu_base_set_nopts(&tsdu->base, 0);
-    CHECK_LEN(nbits, 9 * 8, tsdu);
 
     int _zero0;
-    activation_mode_decode(&tsdu->activation_mode, data[1]);
-    tsdu->group_id              = get_bits(12, data + 1, 4);
-    tsdu->coverage_id           = get_bits(8,  data + 3, 0);
-    _zero0                      = get_bits(4,  data + 4, 0);
-    tsdu->channel_id            = get_bits(12, data + 4, 4);
-    tsdu->u_ch_scrambling       = get_bits(8,  data + 6, 0);
-    tsdu->d_ch_scrambling       = get_bits(8,  data + 7, 0);
-    tsdu->key_reference._data   = get_bits(8,  data + 8, 0);
+    activation_mode_read(&tsdu->activation_mode, br);
+    tsdu->group_id              = bit_reader_get(br, 12);
+    tsdu->coverage_id           = bit_reader_get(br, 8);
+    _zero0                      = bit_reader_get(br, 4);
+    tsdu->channel_id            = bit_reader_get(br, 12);
+    tsdu->u_ch_scrambling       = bit_reader_get(br, 8);
+    tsdu->d_ch_scrambling       = bit_reader_get(br, 8);
+    tsdu->key_reference._data   = bit_reader_get(br, 8);
+    CHECK_OVERFLOW(br, tsdu);
 
     if (_zero0 != 0) {
         LOG(WTF, "nonzero padding: 0x%02x", _zero0);
     }
 
     tsdu->has_addr_tti = false;
-    if (nbits >= 12 * 8) {
+    if (bit_reader_left(br) >= 3 * 8) {
         // FIXME: proper IEI handling
-        uint8_t iei = get_bits(8, data + 9, 0);
+        uint8_t iei = bit_reader_get(br, 8);
         if (iei != IEI_TTI) {
             LOG(WTF, "expected IEI_TTI got %d", iei);
         } else {
             tsdu->has_addr_tti = true;
-            addr_parse(&tsdu->addr_tti, &data[10], 0);
+            addr_read(&tsdu->addr_tti, br);
         }
     }
 
-    if (nbits > 12*8) {
-        LOG(WTF, "unused bits (%d)", nbits);
+    if (br->end > 12*8) {
+        LOG(WTF, "unused bits (%d)", br->end);
     }
 
     return tsdu;
 }
 
-static void d_group_activation_print(tsdu_d_group_activation_t *tsdu)
+static void d_group_activation_print(const tsdu_d_group_activation_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tACTIVATION_MODE: HOOK=%d TYPE=%d\n",
-           tsdu->activation_mode.hook, tsdu->activation_mode.type);
-    printf("\t\tGROUP_ID=%d\n", tsdu->group_id);
-    printf("\t\tCOVERAGE_ID=%d\n", tsdu->coverage_id);
-    printf("\t\tCHANNEL_ID=%d\n", tsdu->channel_id);
-    printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
-    printf("\t\tD_CH_SCRAMBLING=%d\n", tsdu->d_ch_scrambling);
-    printf("\t\tKEY_REFERENCE: KEY_TYPE=%i KEY_INDEX=%i\n",
-           tsdu->key_reference.key_type, tsdu->key_reference.key_index);
+    log_printf("\t\tACTIVATION_MODE: HOOK=%d TYPE=%d\n",
+               tsdu->activation_mode.hook, tsdu->activation_mode.type);
+    log_printf("\t\tGROUP_ID=%d\n", tsdu->group_id);
+    log_printf("\t\tCOVERAGE_ID=%d\n", tsdu->coverage_id);
+    log_printf("\t\tCHANNEL_ID=%d\n", tsdu->channel_id);
+    log_printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
+    log_printf("\t\tD_CH_SCRAMBLING=%d\n", tsdu->d_ch_scrambling);
+    log_printf("\t\tKEY_REFERENCE: KEY_TYPE=%i KEY_INDEX=%i\n",
+               tsdu->key_reference.key_type, tsdu->key_reference.key_index);
     if (tsdu->has_addr_tti) {
-        printf("\t\tADDR_TTI=");
+        log_printf("\t\tADDR_TTI=");
         addr_print(&tsdu->addr_tti);
-        printf("\n");
+        log_printf("\n");
     }
 }
 
-static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int nbits)
+static tsdu_d_group_list_t *d_group_list_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_group_list_t *tsdu = malloc(sizeof(tsdu_d_group_list_t));
+    tsdu_d_group_list_t *tsdu = arena_alloc(arena, sizeof(tsdu_d_group_list_t));
     if (!tsdu) {
         return NULL;
     }
@@ -421,32 +444,27 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int nbits)
     tsdu->ngroup = 0;
     tsdu->nopen = 0;
 
-    int rlen = 2*8; ///< required data length
-    CHECK_LEN(nbits, rlen, tsdu);
-    tsdu->reference_list._data = get_bits(8, data + 1, 0);
+    tsdu->reference_list._data = bit_reader_get(br, 8);
+    CHECK_OVERFLOW(br, tsdu);
     if (tsdu->reference_list.revision == 0) {
         return tsdu;
     }
 
-    rlen += 1*8;
-    CHECK_LEN(nbits, rlen, tsdu);
-    tsdu->index_list._data = get_bits(8, data + 2, 0);
-    data += 3;
+    tsdu->index_list._data = bit_reader_get(br, 8);
     do {
-        rlen += 1*8;
-        CHECK_LEN(nbits, rlen, tsdu);
+        // gives TYPE_NB_TYPE_END when data are too short
         const type_nb_t type_nb = {
-            ._data = get_bits(8, data, 0),
+            ._data = bit_reader_get(br, 8),
         };
         if (type_nb.type == TYPE_NB_TYPE_END) {
             break;
         }
-        data += 1;
 
         if (type_nb.type == TYPE_NB_TYPE_EMERGENCY) {
             const int n = tsdu->nemergency + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_emergency_t) * n;
-            tsdu_d_group_list_emergency_t *p = realloc(tsdu->emergency, l);
+            tsdu_d_group_list_emergency_t *p = arena_realloc(arena,
+                    tsdu->emergency, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -454,20 +472,18 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int nbits)
             tsdu->emergency = p;
             for ( ; tsdu->nemergency < n; ++tsdu->nemergency) {
                 const int i = tsdu->nemergency;
-                cell_id_decode1(&tsdu->emergency[i].cell_id, data);
-                int zero = get_bits(4, data + 1, 4);
+                cell_id_read(&tsdu->emergency[i].cell_id, br);
+                int zero = bit_reader_get(br, 4);
                 if (zero != 0) {
                     LOG(WTF, "nonzero padding (%d)", zero);
                 }
-                data += 2;
-                rlen += 2*8;
             }
         }
 
         if (type_nb.type == TYPE_NB_TYPE_OPEN) {
             const int n = tsdu->nopen + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_open_t) * n;
-            tsdu_d_group_list_open_t *p = realloc(tsdu->open,l);
+            tsdu_d_group_list_open_t *p = arena_realloc(arena, tsdu->open, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -475,24 +491,23 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int nbits)
             tsdu->open = p;
             for ( ; tsdu->nopen < n; ++tsdu->nopen) {
                 const int i = tsdu->nopen;
-                tsdu->open[i].coverage_id           = get_bits(8, data, 0);
-                tsdu->open[i].call_priority         = get_bits(4, data + 1, 0);
-                tsdu->open[i].group_id              = get_bits(12, data + 1, 4);
-                uint8_t padding                     = get_bits(2, data + 3, 0);
+                tsdu->open[i].coverage_id           = bit_reader_get(br, 8);
+                tsdu->open[i].call_priority         = bit_reader_get(br, 4);
+                tsdu->open[i].group_id              = bit_reader_get(br, 12);
+                uint8_t padding                     = bit_reader_get(br, 2);
                 if (padding != 0) {
                     LOG(WTF, "nonzero padding (%d)", padding);
                 }
-                tsdu->open[i].och_parameters.add    = get_bits(1, data + 3, 2);
-                tsdu->open[i].och_parameters.mbn    = get_bits(1, data + 3, 3);
-                tsdu->open[i].neighbouring_cell     = get_bits(12, data + 3, 4);
-                data += 5;
-                rlen +=  5*8;
+                tsdu->open[i].och_parameters.add    = bit_reader_get(br, 1);
+                tsdu->open[i].och_parameters.mbn    = bit_reader_get(br, 1);
+                tsdu->open[i].neighbouring_cell     = bit_reader_get(br, 12);
             }
         }
         if (type_nb.type == TYPE_NB_TYPE_TALK_GROUP) {
             const int n = tsdu->ngroup + type_nb.number;
             const int l = sizeof(tsdu_d_group_list_talk_group_t) * n;
-            tsdu_d_group_list_talk_group_t *p = realloc(tsdu->group, l);
+            tsdu_d_group_list_talk_group_t *p = arena_realloc(arena,
+                    tsdu->group, l);
             if (!p) {
                 tsdu_destroy(&tsdu->base);
                 return NULL;
@@ -500,104 +515,100 @@ static tsdu_d_group_list_t *d_group_list_decode(const uint8_t *data, int nbits)
             tsdu->group = p;
             for ( ; tsdu->ngroup < n; ++tsdu->ngroup) {
                 const int i = tsdu->ngroup;
-                tsdu->group[i].coverage_id          = get_bits(8, data, 0);
-                uint8_t zero                        = get_bits(8, data + 1, 0);
+                tsdu->group[i].coverage_id          = bit_reader_get(br, 8);
+                uint8_t zero                        = bit_reader_get(br, 8);
                 if (zero != 0) {
                     LOG(WTF, "nonzero padding in talk group-1 (%d)", zero);
                 }
-                uint8_t padding                     = get_bits(4, data + 2, 0);
+                uint8_t padding                     = bit_reader_get(br, 4);
                 if (padding != 0) {
                     LOG(WTF, "nonzero padding in talk group-2 (%d)", padding);
                 }
-                tsdu->group[i].neighbouring_cell    = get_bits(12, data + 2, 4);
-                data += 4;
-                rlen += 4*8;
+                tsdu->group[i].neighbouring_cell    = bit_reader_get(br, 12);
             }
         }
     } while(true);
+    CHECK_OVERFLOW(br, tsdu);
 
     return tsdu;
 }
 
-static void d_group_list_print(tsdu_d_group_list_t *tsdu)
+static void d_group_list_print(const tsdu_d_group_list_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tREFERENCE_LIST REVISION=%d CSG=%d CSO=%d DC=%d\n",
-           tsdu->reference_list.revision, tsdu->reference_list.csg,
-           tsdu->reference_list.cso, tsdu->reference_list.dc);
+    log_printf("\t\tREFERENCE_LIST REVISION=%d CSG=%d CSO=%d DC=%d\n",
+               tsdu->reference_list.revision, tsdu->reference_list.csg,
+               tsdu->reference_list.cso, tsdu->reference_list.dc);
     if (tsdu->reference_list.revision == 0) {
         return;
     }
-    printf("\t\tINDEX_LIST MODE=%d INDEX=%d\n",
-           tsdu->index_list.mode, tsdu->index_list.index);
+    log_printf("\t\tINDEX_LIST MODE=%d INDEX=%d\n",
+               tsdu->index_list.mode, tsdu->index_list.index);
 
     if (tsdu->nopen) {
-        printf("\t\tOCH\n");
+        log_printf("\t\tOCH\n");
         for (int i = 0; i < tsdu->nopen; ++i) {
-            printf("\t\t\tCOVERAGE_ID=%d CALL_PRIORITY=%d GROUP_ID=%d "
-                   "OCH_PARAMETERS.ADD=%d OCH_PARAMETERS.MBN=%d "
-                   "NEIGBOURING_CELL=%d\n",
-                   tsdu->open[i].coverage_id,
-                   tsdu->open[i].call_priority,
-                   tsdu->open[i].group_id,
-                   tsdu->open[i].och_parameters.add,
-                   tsdu->open[i].och_parameters.mbn,
-                   tsdu->open[i].neighbouring_cell);
+            log_printf("\t\t\tCOVERAGE_ID=%d CALL_PRIORITY=%d GROUP_ID=%d "
+                       "OCH_PARAMETERS.ADD=%d OCH_PARAMETERS.MBN=%d "
+                       "NEIGBOURING_CELL=%d\n",
+                       tsdu->open[i].coverage_id,
+                       tsdu->open[i].call_priority,
+                       tsdu->open[i].group_id,
+                       tsdu->open[i].och_parameters.add,
+                       tsdu->open[i].och_parameters.mbn,
+                       tsdu->open[i].neighbouring_cell);
         }
     }
 
     if (tsdu->ngroup) {
-        printf("\t\tGROUP\n");
+        log_printf("\t\tGROUP\n");
         for (int i = 0; i < tsdu->ngroup; ++i) {
-            printf("\t\t\tCOVERAGE_ID=%d NEIGHBOURING_CALL=%d\n",
-                   tsdu->group[i].coverage_id, tsdu->group[i].neighbouring_cell);
+            log_printf("\t\t\tCOVERAGE_ID=%d NEIGHBOURING_CALL=%d\n",
+                       tsdu->group[i].coverage_id, tsdu->group[i].neighbouring_cell);
         }
     }
 
     if (tsdu->nemergency) {
-        printf("\t\t\tEMERGENCY\n");
+        log_printf("\t\t\tEMERGENCY\n");
         for (int i = 0; i < tsdu->nemergency; ++i) {
-            printf("\t\t\tCELL_ID.BS_ID=%d CELL_ID.RWS_ID=%d\n",
-                   tsdu->emergency[i].cell_id.bs_id, tsdu->emergency[i].cell_id.rws_id);
+            log_printf("\t\t\tCELL_ID.BS_ID=%d CELL_ID.RWS_ID=%d\n",
+                       tsdu->emergency[i].cell_id.bs_id, tsdu->emergency[i].cell_id.rws_id);
         }
     }
 }
 
-static tsdu_d_group_composition_t *d_group_composition_decode(const uint8_t *data, int nbits)
+static tsdu_d_group_composition_t *d_group_composition_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_group_composition_t *tsdu = malloc(sizeof(tsdu_d_group_composition_t));
+    tsdu_d_group_composition_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_group_composition_t));
     if (!tsdu) {
         return NULL;
     }
 
     tsdu_base_set_nopts(&tsdu->base, 0);
-    CHECK_LEN(nbits, 3*8, tsdu);
-
-    tsdu->group_id = get_bits(12, data + 1, 0);
-    tsdu->og_nb = get_bits(4, data + 2, 4);
 
-    CHECK_LEN(nbits, 3*8 + 12*tsdu->og_nb, tsdu);
-
-    int skip = 0;
+    tsdu->group_id = bit_reader_get(br, 12);
+    tsdu->og_nb = bit_reader_get(br, 4);
     for (int i = 0; i < tsdu->og_nb; ++i) {
-        tsdu->group_ids[i] = get_bits(12, data + 3, skip);
-        skip += 12;
+        tsdu->group_ids[i] = bit_reader_get(br, 12);
     }
+    CHECK_OVERFLOW(br, tsdu);
 
     return tsdu;
 }
 
-static void d_group_composition_print(tsdu_d_group_composition_t *tsdu)
+static void d_group_composition_print(const tsdu_d_group_composition_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tGROUP_ID=%d\n", tsdu->group_id);
+    log_printf("\t\tGROUP_ID=%d\n", tsdu->group_id);
     for (int i = 0; i < tsdu->og_nb; ++i) {
-        printf("\t\tGROUP_ID=%d\n", tsdu->group_ids[i]);
+        log_printf("\t\tGROUP_ID=%d\n", tsdu->group_ids[i]);
     }
 }
 
-static cell_id_list_t *iei_cell_id_list_decode(
-        cell_id_list_t *cell_ids, const uint8_t *data, int len)
+static cell_id_list_t *iei_cell_id_list_decode(arena_t *arena,
+        cell_id_list_t *cell_ids, bit_reader_t *br, int len)
 {
     int n = 0;
     if (cell_ids) {
@@ -605,7 +616,7 @@ static cell_id_list_t *iei_cell_id_list_decode(
     }
     n += len / 2;
     const int l = sizeof(cell_id_list_t) + n * sizeof(cell_id_t);
-    cell_id_list_t *p = realloc(cell_ids, l);
+    cell_id_list_t *p = arena_realloc(arena, cell_ids, l);
     if (!p) {
         LOG(ERR, "ERR OOM");
         return NULL;
@@ -616,14 +627,14 @@ static cell_id_list_t *iei_cell_id_list_decode(
     cell_ids = p;
 
     for ( ; cell_ids->len < n; ++cell_ids->len) {
-        cell_id_decode1(&cell_ids->cell_ids[cell_ids->len], data);
-        data += 2;
+        cell_id_read(&cell_ids->cell_ids[cell_ids->len], br);
+        bit_reader_skip(br, 4);
     }
 
     return cell_ids;
 }
 
-addr_list_t *iei_adjacent_bn_list_decode(
+static addr_list_t *iei_adjacent_bn_list_decode(arena_t *arena,
         addr_list_t *adj_cells, const uint8_t *data, int len)
 {
     int n = 0;
@@ -632,7 +643,7 @@ addr_list_t *iei_adjacent_bn_list_decode(
     }
     n +=  len * 2 / 3;
     const int l = sizeof(addr_list_t) + n * sizeof(addr_t);
-    addr_list_t *p = realloc(adj_cells, l);
+    addr_list_t *p = arena_realloc(arena, adj_cells, l);
     if (!p) {
         LOG(ERR, "ERR OOM");
         return NULL;
@@ -650,17 +661,19 @@ addr_list_t *iei_adjacent_bn_list_decode(
     return adj_cells;
 }
 
-static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *data, int nbits)
+static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_neighbouring_cell_t *tsdu = malloc(sizeof(tsdu_d_neighbouring_cell_t));
+    tsdu_d_neighbouring_cell_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_neighbouring_cell_t));
     if (!tsdu) {
         return NULL;
     }
     tsdu_base_set_nopts(&tsdu->base, 2);
-    CHECK_LEN(nbits, 2*8, tsdu);
 
-    uint8_t _zero                               = get_bits(4, data + 1, 0);
-    tsdu->ccr_config.number                     = get_bits(4, data + 1, 4);
+    uint8_t _zero                               = bit_reader_get(br, 4);
+    tsdu->ccr_config.number                     = bit_reader_get(br, 4);
+    CHECK_OVERFLOW(br, tsdu);
     if (_zero != 0) {
         LOG(WTF, "d_neighbouring_cell padding != 0 (%d)", _zero);
     }
@@ -669,41 +682,38 @@ static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *dat
         return tsdu;
     }
 
-    tsdu->ccr_param = data[2];
+    tsdu->ccr_param = bit_reader_get(br, 8);
     if (tsdu->ccr_param) {
         LOG(WTF, "d_neighbouring_cell ccr_param != 0 (%d)", tsdu->ccr_param);
     }
 
-    data += 3;
-    nbits -= 3 * 8;
-    CHECK_LEN(nbits, 3 * 8 * tsdu->ccr_config.number, tsdu);
     for (int i = 0; i < tsdu->ccr_config.number; ++i) {
-        tsdu->adj_cells[i].bn_nb                = get_bits(4,  data, 0);
-        tsdu->adj_cells[i].channel_id           = get_bits(12, data, 4);
-        tsdu->adj_cells[i].adjacent_param._data = get_bits(8,  data + 2, 0);
+        tsdu->adj_cells[i].bn_nb                = bit_reader_get(br, 4);
+        tsdu->adj_cells[i].channel_id           = bit_reader_get(br, 12);
+        tsdu->adj_cells[i].adjacent_param._data = bit_reader_get(br, 8);
         if (tsdu->adj_cells[i].adjacent_param._reserved) {
             LOG(WTF, "adjacent_param._reserved != 0");
         }
-        data += 3;
-        nbits -= 3 * 8;
     }
-
-    while (nbits > 7) {
-        CHECK_LEN(nbits, 2 * 8, tsdu);
-        const uint8_t iei                       = get_bits(8, data, 0);
-        const uint8_t len                       = get_bits(8, data + 1, 0);
-        data += 2;
-        nbits -= 2 * 8;
-        CHECK_LEN(nbits, len * 8, tsdu);
+    CHECK_OVERFLOW(br, tsdu);
+
+    while (bit_reader_left(br) > 7) {
+        const uint8_t iei                       = bit_reader_get(br, 8);
+        const uint8_t len                       = bit_reader_get(br, 8);
+        // IE is byte aligned
+        const uint8_t *data = bit_reader_ptr(br);
+        bit_reader_t ie;
+        bit_reader_split(br, &ie, len * 8);
+        CHECK_OVERFLOW(br, tsdu);
         if (iei == IEI_CELL_ID_LIST && len) {
-            cell_id_list_t *p = iei_cell_id_list_decode(
-                        tsdu->cell_ids, data, len);
+            cell_id_list_t *p = iei_cell_id_list_decode(arena,
+                        tsdu->cell_ids, &ie, len);
             if (!p) {
                 break;
             }
             tsdu->cell_ids = p;
         } else if (iei == IEI_ADJACENT_BN_LIST && len) {
-            addr_list_t *p = iei_adjacent_bn_list_decode(
+            addr_list_t *p = iei_adjacent_bn_list_decode(arena,
                         tsdu->cell_bns, data, len);
             if (!p) {
                 break;
@@ -714,81 +724,79 @@ static tsdu_d_neighbouring_cell_t *d_neighbouring_cell_decode(const uint8_t *dat
                 LOG(WTF, "d_neighbouring_cell unknown iei (0x%x)", iei);
             }
         }
-        data += len;
-        nbits -= len * 8;
     }
 
     return tsdu;
 }
 
-static void d_neighbouring_cell_print(tsdu_d_neighbouring_cell_t *tsdu)
+static void d_neighbouring_cell_print(const tsdu_d_neighbouring_cell_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tCCR_CONFIG=%d\n", tsdu->ccr_config.number);
+    log_printf("\t\tCCR_CONFIG=%d\n", tsdu->ccr_config.number);
     if (!tsdu->ccr_config.number) {
         return;
     }
-    printf("\t\tCCR_PARAM=%d\n", tsdu->ccr_param);
+    log_printf("\t\tCCR_PARAM=%d\n", tsdu->ccr_param);
     for (int i = 0; i < tsdu->ccr_config.number; ++i) {
-        printf("\t\t\tBN_NB=%d CHANNEL_ID=%d ADJACENT_PARAM=%d BN=%d LOC=%d EXP=%d RXLEV_ACCESS=%d\n",
-               tsdu->adj_cells[i].bn_nb,
-               tsdu->adj_cells[i].channel_id,
-               tsdu->adj_cells[i].adjacent_param._data,
-               tsdu->adj_cells[i].adjacent_param.bn,
-               tsdu->adj_cells[i].adjacent_param.loc,
-               tsdu->adj_cells[i].adjacent_param.exp,
-               tsdu->adj_cells[i].adjacent_param.rxlev_access);
+        log_printf("\t\t\tBN_NB=%d CHANNEL_ID=%d ADJACENT_PARAM=%d BN=%d LOC=%d EXP=%d RXLEV_ACCESS=%d\n",
+                   tsdu->adj_cells[i].bn_nb,
+                   tsdu->adj_cells[i].channel_id,
+                   tsdu->adj_cells[i].adjacent_param._data,
+                   tsdu->adj_cells[i].adjacent_param.bn,
+                   tsdu->adj_cells[i].adjacent_param.loc,
+                   tsdu->adj_cells[i].adjacent_param.exp,
+                   tsdu->adj_cells[i].adjacent_param.rxlev_access);
     }
     if (tsdu->cell_ids) {
-        printf("\t\tCELL_IDs\n");
+        log_printf("\t\tCELL_IDs\n");
         for (int i = 0; i < tsdu->cell_ids->len; ++i) {
-            printf("\t\t\tCELL_ID BS_ID=%d RSW_ID=%d\n",
-                   tsdu->cell_ids->cell_ids[i].bs_id,
-                   tsdu->cell_ids->cell_ids[i].rws_id);
+            log_printf("\t\t\tCELL_ID BS_ID=%d RSW_ID=%d\n",
+                       tsdu->cell_ids->cell_ids[i].bs_id,
+                       tsdu->cell_ids->cell_ids[i].rws_id);
         }
     }
     if (tsdu->cell_bns) {
-        printf("\t\tCELL_BNs\n");
+        log_printf("\t\tCELL_BNs\n");
         for (int i = 0; i < tsdu->cell_bns->len; ++i) {
-            printf("\t\t\tCELL_BN=");
+            log_printf("\t\t\tCELL_BN=");
             addr_print(&tsdu->cell_bns->addrs[i]);
-            printf("\n");
+            log_printf("\n");
         }
     }
 }
 
-static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int nbits)
+static tsdu_d_system_info_t *d_system_info_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_system_info_t *tsdu = malloc(sizeof(tsdu_d_system_info_t));
+    tsdu_d_system_info_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_system_info_t));
     if (!tsdu) {
         return NULL;
     }
 
+    // fields not present in current cell mode are serialized as 0
+    memset(tsdu, 0, sizeof(*tsdu));
     tsdu_base_set_nopts(&tsdu->base, 0);
 
-    // minimal size of disconnected mode
-    CHECK_LEN(nbits, 9*8, tsdu);
-
-    tsdu->cell_state._data = get_bits(8, data + 1, 0);
+    tsdu->cell_state._data = bit_reader_get(br, 8);
     switch (tsdu->cell_state.mode) {
         case CELL_STATE_MODE_NORMAL:
-            CHECK_LEN(nbits, (17 * 8), tsdu);
-            tsdu->cell_config._data                     = get_bits( 8, data + 2, 0);
-            tsdu->country_code                          = get_bits( 8, data + 3, 0);
-            tsdu->system_id._data                       = get_bits( 8, data + 4, 0);
-            tsdu->loc_area_id._data                     = get_bits( 8, data + 5, 0);
-            tsdu->bn_id                                 = get_bits( 8, data + 6, 0);
-            cell_id_decode1(&tsdu->cell_id, data + 7);
-            tsdu->cell_bn                               = get_bits(12, data + 7, 12);
-            tsdu->u_ch_scrambling                       = get_bits( 8, data + 10, 0);
-            tsdu->cell_radio_param.tx_max               = get_bits( 3, data + 11, 0);
-            tsdu->cell_radio_param.radio_link_timeout   = get_bits( 5, data + 11, 3);
-            tsdu->cell_radio_param.pwr_tx_adjust        = get_bits( 4, data + 12, 0);
-            tsdu->cell_radio_param.rx_lev_access        = get_bits( 4, data + 12, 4);
-            tsdu->system_time                           = get_bits( 8, data + 13, 0);
-            tsdu->cell_access._data                     = get_bits( 8, data + 14, 0);
-            tsdu->_unused_1                             = get_bits( 4, data + 15, 0);
-            tsdu->superframe_cpt                        = get_bits(12, data + 15, 4);
+            tsdu->cell_config._data                     = bit_reader_get(br, 8);
+            tsdu->country_code                          = bit_reader_get(br, 8);
+            tsdu->system_id._data                       = bit_reader_get(br, 8);
+            tsdu->loc_area_id._data                     = bit_reader_get(br, 8);
+            tsdu->bn_id                                 = bit_reader_get(br, 8);
+            cell_id_read(&tsdu->cell_id, br);
+            tsdu->cell_bn                               = bit_reader_get(br, 12);
+            tsdu->u_ch_scrambling                       = bit_reader_get(br, 8);
+            tsdu->cell_radio_param.tx_max               = bit_reader_get(br, 3);
+            tsdu->cell_radio_param.radio_link_timeout   = bit_reader_get(br, 5);
+            tsdu->cell_radio_param.pwr_tx_adjust        = bit_reader_get(br, 4);
+            tsdu->cell_radio_param.rx_lev_access        = bit_reader_get(br, 4);
+            tsdu->system_time                           = bit_reader_get(br, 8);
+            tsdu->cell_access._data                     = bit_reader_get(br, 8);
+            tsdu->_unused_1                             = bit_reader_get(br, 4);
+            tsdu->superframe_cpt                        = bit_reader_get(br, 12);
             break;
 
         default:
@@ -798,126 +806,137 @@ static tsdu_d_system_info_t *d_system_info_decode(const uint8_t *data, int nbits
         case CELL_STATE_MODE_DISC_MAIN_SWITCH:
         case CELL_STATE_MODE_DISC_RADIOSWITCH:
         case CELL_STATE_MODE_DISC_BSC:
-            tsdu->cell_state._data &= 0xf0;
-            cell_id_decode2(&tsdu->cell_id, data + 1);
-            tsdu->bn_id                                 = get_bits( 8, data + 3, 0);
-            tsdu->u_ch_scrambling                       = get_bits( 8, data + 4, 0);
-            tsdu->cell_radio_param.tx_max               = get_bits( 3, data + 5, 0);
-            tsdu->cell_radio_param.radio_link_timeout   = get_bits( 5, data + 5, 3);
-            tsdu->cell_radio_param.pwr_tx_adjust        = get_bits( 4, data + 6, 0);
-            tsdu->cell_radio_param.rx_lev_access        = get_bits( 4, data + 6, 4);
-            tsdu->band                                  = get_bits( 4, data + 7, 0);
-            tsdu->channel_id                            = get_bits(12, data + 7, 4);
+            {
+                // cell_id is split, RWS_ID/BS_ID shares byte with cell_state
+                const int id4 = tsdu->cell_state._data & 0x0f;
+                tsdu->cell_state._data &= 0xf0;
+                const int type = bit_reader_get(br, 2);
+                const int id6 = bit_reader_get(br, 6);
+                cell_id_set(&tsdu->cell_id, type, id6, id4);
+            }
+            tsdu->bn_id                                 = bit_reader_get(br, 8);
+            tsdu->u_ch_scrambling                       = bit_reader_get(br, 8);
+            tsdu->cell_radio_param.tx_max               = bit_reader_get(br, 3);
+            tsdu->cell_radio_param.radio_link_timeout   = bit_reader_get(br, 5);
+            tsdu->cell_radio_param.pwr_tx_adjust        = bit_reader_get(br, 4);
+            tsdu->cell_radio_param.rx_lev_access        = bit_reader_get(br, 4);
+            tsdu->band                                  = bit_reader_get(br, 4);
+            tsdu->channel_id                            = bit_reader_get(br, 12);
             break;
     }
+    CHECK_OVERFLOW(br, tsdu);
 
     return tsdu;
 }
 
-static void d_system_info_print(tsdu_d_system_info_t *tsdu)
+static void d_system_info_print(const tsdu_d_system_info_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tCELL_STATE\n");
-    printf("\t\t\tMODE=%03x\n", tsdu->cell_state.mode);
+    log_printf("\t\tCELL_STATE\n");
+    log_printf("\t\t\tMODE=%03x\n", tsdu->cell_state.mode);
     if (tsdu->cell_state.mode == CELL_STATE_MODE_NORMAL) {
-        printf("\t\t\tBCH=%d\n", tsdu->cell_state.bch);
-        printf("\t\t\tROAM=%d\n", tsdu->cell_state.roam);
-        printf("\t\t\tEXP=%d\n", tsdu->cell_state.exp);
-        printf("\t\t\tRSERVED=%d\n", tsdu->cell_state._reserved_00);
-
-        printf("\t\tCELL_CONFIG\n");
-        printf("\t\t\tECCH=%d\n", tsdu->cell_config.eccch);
-        printf("\t\t\tATTA=%d\n", tsdu->cell_config.atta);
-        printf("\t\t\tRESERVED=%d\n", tsdu->cell_config._reserved_0);
-        printf("\t\t\tMUX_TYPE=%d\n", tsdu->cell_config.mux_type);
-        printf("\t\t\tSIM=%d\n", tsdu->cell_config.sim);
-        printf("\t\t\tDC=%d\n", tsdu->cell_config.dc);
-        printf("\t\tCOUNTRY_CODE=%d\n", tsdu->country_code);
-        printf("\t\tSYSTEM_ID\n");
-        printf("\t\t\tVERSION=%d\n", tsdu->system_id.version);
-        printf("\t\t\tNETWORK=%d\n", tsdu->system_id.network);
-        printf("\t\tLOC_AREA_ID\n");
-        printf("\t\t\tLOC_ID=%d\n", tsdu->loc_area_id.loc_id);
-        printf("\t\t\tMODE=%d\n", tsdu->loc_area_id.mode);
-        printf("\t\tBN_ID=%d\n", tsdu->bn_id);
-        printf("\t\tCELL_ID: BS_ID=%d RWS_ID=%d\n",
-               tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
-        printf("\t\tCELL_BN=%d\n", tsdu->cell_bn);
-        printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
-        printf("\t\tCELL_RADIO_PARAM\n");
-        printf("\t\t\tTX_MAX=%d\n", tsdu->cell_radio_param.tx_max);
-        printf("\t\t\tRADIO_LINK_TIMEOUT=%d\n",
+        log_printf("\t\t\tBCH=%d\n", tsdu->cell_state.bch);
+        log_printf("\t\t\tROAM=%d\n", tsdu->cell_state.roam);
+        log_printf("\t\t\tEXP=%d\n", tsdu->cell_state.exp);
+        log_printf("\t\t\tRSERVED=%d\n", tsdu->cell_state._reserved_00);
+
+        log_printf("\t\tCELL_CONFIG\n");
+        log_printf("\t\t\tECCH=%d\n", tsdu->cell_config.eccch);
+        log_printf("\t\t\tATTA=%d\n", tsdu->cell_config.atta);
+        log_printf("\t\t\tRESERVED=%d\n", tsdu->cell_config._reserved_0);
+        log_printf("\t\t\tMUX_TYPE=%d\n", tsdu->cell_config.mux_type);
+        log_printf("\t\t\tSIM=%d\n", tsdu->cell_config.sim);
+        log_printf("\t\t\tDC=%d\n", tsdu->cell_config.dc);
+        log_printf("\t\tCOUNTRY_CODE=%d\n", tsdu->country_code);
+        log_printf("\t\tSYSTEM_ID\n");
+        log_printf("\t\t\tVERSION=%d\n", tsdu->system_id.version);
+        log_printf("\t\t\tNETWORK=%d\n", tsdu->system_id.network);
+        log_printf("\t\tLOC_AREA_ID\n");
+        log_printf("\t\t\tLOC_ID=%d\n", tsdu->loc_area_id.loc_id);
+        log_printf("\t\t\tMODE=%d\n", tsdu->loc_area_id.mode);
+        log_printf("\t\tBN_ID=%d\n", tsdu->bn_id);
+        log_printf("\t\tCELL_ID: BS_ID=%d RWS_ID=%d\n",
+                   tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
+        log_printf("\t\tCELL_BN=%d\n", tsdu->cell_bn);
+        log_printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
+        log_printf("\t\tCELL_RADIO_PARAM\n");
+        log_printf("\t\t\tTX_MAX=%d\n", tsdu->cell_radio_param.tx_max);
+        log_printf("\t\t\tRADIO_LINK_TIMEOUT=%d\n",
                 tsdu->cell_radio_param.radio_link_timeout);
-        printf("\t\t\tPWR_TX_ADJUST=%d dBm\n",
+        log_printf("\t\t\tPWR_TX_ADJUST=%d dBm\n",
                 CELL_RADIO_PARAM_PWR_TX_ADJUST_TO_DBM[
                     tsdu->cell_radio_param.pwr_tx_adjust]);
-        printf("\t\t\tRX_LEV_ACCESS=%d dBm\n",
+        log_printf("\t\t\tRX_LEV_ACCESS=%d dBm\n",
                 CELL_RADIO_PARAM_RX_LEV_ACCESS_TO_DBM[
                     tsdu->cell_radio_param.rx_lev_access]);
-        printf("\t\tSYSTEM_TIME=%d\n", tsdu->system_time);
-        printf("\t\tCELL_ACCESS\n");
-        printf("\t\t\tMIN_SERVICE_CLASS=%d\n",
+        log_printf("\t\tSYSTEM_TIME=%d\n", tsdu->system_time);
+        log_printf("\t\tCELL_ACCESS\n");
+        log_printf("\t\t\tMIN_SERVICE_CLASS=%d\n",
                 tsdu->cell_access.min_service_class);
-        printf("\t\t\tMIN_REG_CLASS=%d\n",
+        log_printf("\t\t\tMIN_REG_CLASS=%d\n",
                 tsdu->cell_access.min_reg_class);
-        printf("\t\tSUPERFRAME_CPT=%d\n", tsdu->superframe_cpt);
+        log_printf("\t\tSUPERFRAME_CPT=%d\n", tsdu->superframe_cpt);
     } else {
-        printf("\t\tCELL_ID BS_ID=%d RWS_ID=%d\n",
-               tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
-        printf("\t\tCELL_BN=%d\n", tsdu->cell_bn);
-        printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
-        printf("\t\tCELL_RADIO_PARAM\n");
-        printf("\t\t\tTX_MAX=%d\n", tsdu->cell_radio_param.tx_max);
-        printf("\t\t\tRADIO_LINK_TIMEOUT=%d\n",
+        log_printf("\t\tCELL_ID BS_ID=%d RWS_ID=%d\n",
+                   tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
+        log_printf("\t\tCELL_BN=%d\n", tsdu->cell_bn);
+        log_printf("\t\tU_CH_SCRAMBLING=%d\n", tsdu->u_ch_scrambling);
+        log_printf("\t\tCELL_RADIO_PARAM\n");
+        log_printf("\t\t\tTX_MAX=%d\n", tsdu->cell_radio_param.tx_max);
+        log_printf("\t\t\tRADIO_LINK_TIMEOUT=%d\n",
                 tsdu->cell_radio_param.radio_link_timeout);
-        printf("\t\t\tPWR_TX_ADJUST=%d dBm\n",
+        log_printf("\t\t\tPWR_TX_ADJUST=%d dBm\n",
                 CELL_RADIO_PARAM_PWR_TX_ADJUST_TO_DBM[
                     tsdu->cell_radio_param.pwr_tx_adjust]);
-        printf("\t\t\tRX_LEV_ACCESS=%d dBm\n",
+        log_printf("\t\t\tRX_LEV_ACCESS=%d dBm\n",
                 CELL_RADIO_PARAM_RX_LEV_ACCESS_TO_DBM[
                     tsdu->cell_radio_param.rx_lev_access]);
-        printf("\t\tBAND=%d\n", tsdu->band);
-        printf("\t\tCHANNEL_ID=%d\n", tsdu->channel_id);
+        log_printf("\t\tBAND=%d\n", tsdu->band);
+        log_printf("\t\tCHANNEL_ID=%d\n", tsdu->channel_id);
     }
 }
 
-static tsdu_d_ech_overload_id_t *d_ech_overload_id_decode(const uint8_t *data, int nbits)
+static tsdu_d_ech_overload_id_t *d_ech_overload_id_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_ech_overload_id_t *tsdu = malloc(sizeof(tsdu_d_ech_overload_id_t));
+    tsdu_d_ech_overload_id_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_ech_overload_id_t));
     if (!tsdu) {
         return NULL;
     }
     tsdu_base_set_nopts(&tsdu->base, 0);
 
-    CHECK_LEN(nbits, 6*8, tsdu);
-
-    tsdu->activation_mode.hook = get_bits(2, data + 1, 0);
-    tsdu->activation_mode.type = get_bits(2, data + 1, 2);
-    tsdu->group_id = get_bits(12, data + 1, 4);
-    cell_id_decode1(&tsdu->cell_id, data + 3);
-    tsdu->organisation = get_bits(8, data + 5, 0);
+    activation_mode_read(&tsdu->activation_mode, br);
+    tsdu->group_id = bit_reader_get(br, 12);
+    cell_id_read(&tsdu->cell_id, br);
+    bit_reader_skip(br, 4);
+    tsdu->organisation = bit_reader_get(br, 8);
+    CHECK_OVERFLOW(br, tsdu);
 
     return tsdu;
 }
 
 static void d_ech_overload_id_print(const tsdu_d_ech_overload_id_t *tsdu)
 {
-    printf("\tCODOP=0x%0x (D_ECH_OVERLOAD_ID)\n", tsdu->base.codop);
-    printf("\t\tACTIVATION_MODE: hook=%d type=%d\n",
-           tsdu->activation_mode.hook, tsdu->activation_mode.type);
-    printf("\t\tGROUP_ID=%d", tsdu->group_id);
-    printf("\t\tCELL_ID: BS_ID=%d RWS_ID=%d\n",
-           tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
-    printf("\t\tORGANISATION=%d\n", tsdu->organisation);
+    log_printf("\tCODOP=0x%0x (D_ECH_OVERLOAD_ID)\n", tsdu->base.codop);
+    log_printf("\t\tACTIVATION_MODE: hook=%d type=%d\n",
+               tsdu->activation_mode.hook, tsdu->activation_mode.type);
+    log_printf("\t\tGROUP_ID=%d", tsdu->group_id);
+    log_printf("\t\tCELL_ID: BS_ID=%d RWS_ID=%d\n",
+               tsdu->cell_id.bs_id, tsdu->cell_id.rws_id);
+    log_printf("\t\tORGANISATION=%d\n", tsdu->organisation);
 }
 
-static tsdu_seecret_codop_t *d_seecret_parse(const uint8_t *data, int nbits)
+static tsdu_seecret_codop_t *d_seecret_parse(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_seecret_codop_t *tsdu = malloc(sizeof(tsdu_seecret_codop_t));
+    tsdu_seecret_codop_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_seecret_codop_t));
     if (!tsdu) {
         return NULL;
     }
 
+    const int nbits = br->end;
     tsdu->nbits = nbits;
     if (!nbits) {
         tsdu_base_set_nopts(&tsdu->base, 0);
@@ -926,13 +945,13 @@ static tsdu_seecret_codop_t *d_seecret_parse(const uint8_t *data, int nbits)
 
     tsdu_base_set_nopts(&tsdu->base, 1);
 
-    tsdu->data = malloc((nbits + 7) / 8);
+    tsdu->data = arena_alloc(arena, (nbits + 7) / 8);
     if (!tsdu->data) {
         tsdu_destroy(&tsdu->base);
         return NULL;
     }
 
-    memcpy(tsdu->data, data, (nbits + 7) / 8);
+    memcpy(tsdu->data, br->data, (nbits + 7) / 8);
 
     return tsdu;
 }
@@ -940,20 +959,20 @@ static tsdu_seecret_codop_t *d_seecret_parse(const uint8_t *data, int nbits)
 static void d_seecret_print(const tsdu_seecret_codop_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tnbits=%d data=", tsdu->nbits);
+    log_printf("\t\tnbits=%d data=", tsdu->nbits);
     print_hex(tsdu->data, (tsdu->nbits + 7) / 8);
 }
 
-static tsdu_d_data_end_t *d_data_end_decode(const uint8_t *data, int nbits)
+static tsdu_d_data_end_t *d_data_end_decode(arena_t *arena, bit_reader_t *br)
 {
-    tsdu_d_data_end_t *tsdu = malloc(sizeof(tsdu_d_data_end_t));
+    tsdu_d_data_end_t *tsdu = arena_alloc(arena, sizeof(tsdu_d_data_end_t));
     if (!tsdu) {
         return NULL;
     }
 
     tsdu_base_set_nopts(&tsdu->base, 0);
-    CHECK_LEN(nbits, 2*8, tsdu);
-    tsdu->cause = data[1];
+    tsdu->cause = bit_reader_get(br, 8);
+    CHECK_OVERFLOW(br, tsdu);
 
     return tsdu;
 }
@@ -961,25 +980,36 @@ static tsdu_d_data_end_t *d_data_end_decode(const uint8_t *data, int nbits)
 static void d_data_end_print(const tsdu_d_data_end_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tCAUSE=0x%02x\n", tsdu->cause);
+    log_printf("\t\tCAUSE=0x%02x\n", tsdu->cause);
+}
+
+/// Read 16 bit little endian integer.
+static int bit_reader_get_le16(bit_reader_t *br)
+{
+    const int lo = bit_reader_get(br, 8);
+
+    return lo | (bit_reader_get(br, 8) << 8);
 }
 
-static tsdu_d_datagram_notify_t *d_datagram_notify_decode(const uint8_t *data, int nbits)
+static tsdu_d_datagram_notify_t *d_datagram_notify_decode(arena_t *arena,
+        bit_reader_t *br)
 {
-    tsdu_d_datagram_notify_t *tsdu = malloc(sizeof(tsdu_d_datagram_notify_t));
+    tsdu_d_datagram_notify_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_datagram_notify_t));
     if (!tsdu) {
         return NULL;
     }
 
     tsdu_base_set_nopts(&tsdu->base, 0);
-    CHECK_LEN(nbits, 5*8, tsdu);
 
-    tsdu->call_priority         = get_bits(4, data + 1, 4);
-    tsdu->message_reference     = data[2] | (data[3] << 8);
-    tsdu->key_reference._data   = data[4];
+    bit_reader_skip(br, 4);
+    tsdu->call_priority         = bit_reader_get(br, 4);
+    tsdu->message_reference     = bit_reader_get_le16(br);
+    tsdu->key_reference._data   = bit_reader_get(br, 8);
+    CHECK_OVERFLOW(br, tsdu);
 
-    if (nbits >= 7 * 8) {
-        tsdu->destination_port  = data[5] | (data[6] << 8);
+    if (bit_reader_left(br) >= 2 * 8) {
+        tsdu->destination_port  = bit_reader_get_le16(br);
     } else {
         tsdu->destination_port = -1;
     }
@@ -990,35 +1020,37 @@ static tsdu_d_datagram_notify_t *d_datagram_notify_decode(const uint8_t *data, i
 static void d_datagram_notify_print(const tsdu_d_datagram_notify_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tCALL_PRIORITY=%d\n", tsdu->call_priority);
-    printf("\t\tMESSAGE_REFERENCE=%d\n", tsdu->message_reference);
-    printf("\t\tKEY_REFERENCE: key_index=%d key_type=%d\n",
-           tsdu->key_reference.key_index, tsdu->key_reference.key_type);
+    log_printf("\t\tCALL_PRIORITY=%d\n", tsdu->call_priority);
+    log_printf("\t\tMESSAGE_REFERENCE=%d\n", tsdu->message_reference);
+    log_printf("\t\tKEY_REFERENCE: key_index=%d key_type=%d\n",
+               tsdu->key_reference.key_index, tsdu->key_reference.key_type);
     if (tsdu->destination_port != -1) {
-        printf("\t\tDESTINATION_PORT=%d\n", tsdu->destination_port);
+        log_printf("\t\tDESTINATION_PORT=%d\n", tsdu->destination_port);
     }
 }
 
-static tsdu_d_datagram_t *d_datagram_decode(const uint8_t *data, int nbits)
+static tsdu_d_datagram_t *d_datagram_decode(arena_t *arena, bit_reader_t *br)
 {
-    const int len = nbits / 8 - 5;
+    const int len = br->end / 8 - 5;
     if (len < 0) {
         LOG(WTF, "too short");
         return NULL;
     }
 
-    tsdu_d_datagram_t *tsdu = malloc(sizeof(tsdu_d_datagram_t) + len);
+    tsdu_d_datagram_t *tsdu = arena_alloc(arena,
+            sizeof(tsdu_d_datagram_t) + len);
     if (!tsdu) {
         return NULL;
     }
 
     tsdu_base_set_nopts(&tsdu->base, 0);
 
-    tsdu->call_priority = get_bits(4, data + 1, 4);
-    tsdu->message_reference = data[2] | (data[3] << 8);
-    tsdu->key_reference._data = data[4];
+    bit_reader_skip(br, 4);
+    tsdu->call_priority = bit_reader_get(br, 4);
+    tsdu->message_reference = bit_reader_get_le16(br);
+    tsdu->key_reference._data = bit_reader_get(br, 8);
     tsdu->len = len;
-    memcpy(tsdu->data, data + 5, len);
+    memcpy(tsdu->data, bit_reader_ptr(br), len);
 
     return tsdu;
 }
@@ -1026,24 +1058,24 @@ static tsdu_d_datagram_t *d_datagram_decode(const uint8_t *data, int nbits)
 static void d_datagram_print(const tsdu_d_datagram_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tCALL_PRIORITY=%d\n", tsdu->call_priority);
-    printf("\t\tMESSAGE_REFERENCE=%d\n", tsdu->message_reference);
-    printf("\t\tKEY_REFERENCE: key_type=%d key_index=%d\n",
-           tsdu->key_reference.key_type, tsdu->key_reference.key_index);
-    printf("\t\tDATA: len=%d data=", tsdu->len);
+    log_printf("\t\tCALL_PRIORITY=%d\n", tsdu->call_priority);
+    log_printf("\t\tMESSAGE_REFERENCE=%d\n", tsdu->message_reference);
+    log_printf("\t\tKEY_REFERENCE: key_type=%d key_index=%d\n",
+               tsdu->key_reference.key_type, tsdu->key_reference.key_index);
+    log_printf("\t\tDATA: len=%d data=", tsdu->len);
     print_hex(tsdu->data, tsdu->len);
 }
 
 static tsdu_d_explicit_short_data_t *d_explicit_short_data_decode(
-        const uint8_t *data, int nbits)
+        arena_t *arena, bit_reader_t *br)
 {
-    const int len = nbits / 8 - 1;
+    const int len = br->end / 8 - 1;
     if (len < 0) {
         LOG(WTF, "too short");
         return NULL;
     }
 
-    tsdu_d_explicit_short_data_t *tsdu = malloc(
+    tsdu_d_explicit_short_data_t *tsdu = arena_alloc(arena,
                 sizeof(tsdu_d_explicit_short_data_t) + len);
     if (!tsdu) {
         LOG(ERR, "ERR OOM");
@@ -1052,7 +1084,7 @@ static tsdu_d_explicit_short_data_t *d_explicit_short_data_decode(
     tsdu_base_set_nopts(&tsdu->base, 0);
 
     tsdu->len = len;
-    memcpy(tsdu->data, data + 1, len);
+    memcpy(tsdu->data, bit_reader_ptr(br), len);
 
     return tsdu;
 }
@@ -1060,61 +1092,85 @@ static tsdu_d_explicit_short_data_t *d_explicit_short_data_decode(
 static void d_explicit_short_data_print(const tsdu_d_explicit_short_data_t *tsdu)
 {
     tsdu_base_print(&tsdu->base);
-    printf("\t\tDATA: len=%d data=", tsdu->len);
+    log_printf("\t\tDATA: len=%d data=", tsdu->len);
     print_hex(tsdu->data, tsdu->len);
 }
 
-tsdu_t *tsdu_d_decode(const uint8_t *data, int nbits, int prio, int id_tsap)
+extern inline bool tsdu_filter_has(const tsdu_filter_t *filter, codop_t codop);
+extern inline void tsdu_filter_set(tsdu_filter_t *filter, codop_t codop,
+        bool set);
+
+void tsdu_filter_set_all(tsdu_filter_t *filter, bool set)
 {
-    CHECK_LEN(nbits, 8, NULL);
+    memset(filter->bits, set ? 0xff : 0, sizeof(filter->bits));
+}
+
+bool tsdu_filter_match(const tsdu_filter_t *filter, const uint8_t *data,
+        int nbits)
+{
+    if (nbits < 8) {
+        return true;
+    }
 
-    const codop_t codop = get_bits(8, data, 0);
+    return tsdu_filter_has(filter, get_bits(8, data, 0));
+}
+
+tsdu_t *tsdu_d_decode(arena_t *arena, const uint8_t *data, int nbits,
+        int prio, int id_tsap)
+{
+    bit_reader_t br;
+    bit_reader_init(&br, data, nbits);
+    const codop_t codop = bit_reader_get(&br, 8);
+    if (br.overflow) {
+        LOG(ERR, "data too short %d", nbits);
+        return NULL;
+    }
 
     tsdu_t *tsdu = NULL;
     switch (codop) {
         case D_DATA_END:
-            tsdu = (tsdu_t *)d_data_end_decode(data, nbits);
+            tsdu = (tsdu_t *)d_data_end_decode(arena, &br);
             break;
 
         case D_DATAGRAM:
-            tsdu = (tsdu_t *)d_datagram_decode(data, nbits);
+            tsdu = (tsdu_t *)d_datagram_decode(arena, &br);
             break;
 
         case D_DATAGRAM_NOTIFY:
-            tsdu = (tsdu_t *)d_datagram_notify_decode(data, nbits);
+            tsdu = (tsdu_t *)d_datagram_notify_decode(arena, &br);
             break;
 
         case D_ECH_OVERLOAD_ID:
-            tsdu = (tsdu_t *)d_ech_overload_id_decode(data, nbits);
+            tsdu = (tsdu_t *)d_ech_overload_id_decode(arena, &br);
             break;
 
         case D_EXPLICIT_SHORT_DATA:
-            tsdu = (tsdu_t *)d_explicit_short_data_decode(data, nbits);
+            tsdu = (tsdu_t *)d_explicit_short_data_decode(arena, &br);
             break;
 
         case D_GROUP_ACTIVATION:
-            tsdu = (tsdu_t *)d_group_activation_decode(data, nbits);
+            tsdu = (tsdu_t *)d_group_activation_decode(arena, &br);
             break;
 
         case D_GROUP_COMPOSITION:
-            tsdu = (tsdu_t *)d_group_composition_decode(data, nbits);
+            tsdu = (tsdu_t *)d_group_composition_decode(arena, &br);
             break;
 
         case D_GROUP_LIST:
-            tsdu = (tsdu_t *)d_group_list_decode(data, nbits);
+            tsdu = (tsdu_t *)d_group_list_decode(arena, &br);
             break;
 
         case D_NEIGHBOURING_CELL:
-            tsdu = (tsdu_t *)d_neighbouring_cell_decode(data, nbits);
+            tsdu = (tsdu_t *)d_neighbouring_cell_decode(arena, &br);
             break;
 
         case D_SYSTEM_INFO:
-            tsdu = (tsdu_t *)d_system_info_decode(data, nbits);
+            tsdu = (tsdu_t *)d_system_info_decode(arena, &br);
             break;
 
         case D_SEECRET_0x47:
         case D_RESERVED_0x97:
-            tsdu = (tsdu_t *)d_seecret_parse(data, nbits);
+            tsdu = (tsdu_t *)d_seecret_parse(arena, &br);
             break;
 
         default:
@@ -1155,28 +1211,28 @@ static void tsdu_d_print(const tsdu_t *tsdu)
             break;
 
         case D_GROUP_ACTIVATION:
-            d_group_activation_print((tsdu_d_group_activation_t *)tsdu);
+            d_group_activation_print((const tsdu_d_group_activation_t *)tsdu);
             break;
 
         case D_GROUP_COMPOSITION:
-            d_group_composition_print((tsdu_d_group_composition_t *)tsdu);
+            d_group_composition_print((const tsdu_d_group_composition_t *)tsdu);
             break;
 
         case D_GROUP_LIST:
-            d_group_list_print((tsdu_d_group_list_t *)tsdu);
+            d_group_list_print((const tsdu_d_group_list_t *)tsdu);
             break;
 
         case D_NEIGHBOURING_CELL:
-            d_neighbouring_cell_print((tsdu_d_neighbouring_cell_t *)tsdu);
+            d_neighbouring_cell_print((const tsdu_d_neighbouring_cell_t *)tsdu);
             break;
 
         case D_SYSTEM_INFO:
-            d_system_info_print((tsdu_d_system_info_t *)tsdu);
+            d_system_info_print((const tsdu_d_system_info_t *)tsdu);
             break;
 
         case D_SEECRET_0x47:
         case D_RESERVED_0x97:
-            d_seecret_print((tsdu_seecret_codop_t *)tsdu);
+            d_seecret_print((const tsdu_seecret_codop_t *)tsdu);
             break;
 
         default:
@@ -1194,7 +1250,7 @@ static void tsdu_u_print(const tsdu_t *tsdu)
     }
 }
 
-void tsdu_print(tsdu_t *tsdu)
+void tsdu_print(const tsdu_t *tsdu)
 {
     if (tsdu->downlink) {
         tsdu_d_print(tsdu);